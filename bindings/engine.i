@@ -283,6 +283,7 @@ SplitList * qof_query_last_run (QofQuery *q);
 SplitList * qof_query_run_subquery (QofQuery *q, const QofQuery *q);
 
 %typemap(in) QofQueryParamList * "$1 = gnc_query_scm2path($input);"
+%newobject qof_query_explain;
 
 %include <gnc-session.h>
 %include <Query.h>
@@ -128,6 +128,8 @@ struct _GncTreeModelPrice
                                      *   change increments this number. */
     QofBook *book;
     GNCPriceDB *price_db;
+    GHashTable *snapshots;          /**< The prices of the commodities shown,
+                                     *   by commodity. */
     gint event_handler_id;
     GNCPrintAmountInfo print_info;
 };
@@ -192,6 +194,12 @@ gnc_tree_model_price_dispose (GObject *object)
         model->event_handler_id = 0;
     }
 
+    if (model->snapshots)
+    {
+        g_hash_table_destroy (model->snapshots);
+        model->snapshots = NULL;
+    }
+
     G_OBJECT_CLASS (gnc_tree_model_price_parent_class)->dispose (object);
     LEAVE(" ");
 }
@@ -220,6 +228,8 @@ gnc_tree_model_price_new (QofBook *book, GNCPriceDB *price_db)
 
     model->book = book;
     model->price_db = price_db;
+    model->snapshots = g_hash_table_new_full (NULL, NULL, NULL,
+                                              (GDestroyNotify)gnc_price_snapshot_free);
 
     model->event_handler_id =
         qof_event_register_handler (gnc_tree_model_price_event_handler, model);
@@ -228,6 +238,42 @@ gnc_tree_model_price_new (QofBook *book, GNCPriceDB *price_db)
     return GTK_TREE_MODEL (model);
 }
 
+/** Get the prices of a commodity as the model shows them.  The snapshot
+ *  is taken the first time it's needed and kept until the commodity's
+ *  prices change, so rows can be found by index without going through
+ *  all the commodity's prices each time.
+ *
+ *  @internal
+ */
+static GNCPriceSnapshot *
+gnc_tree_model_price_get_snapshot (GncTreeModelPrice *model,
+                                   gnc_commodity *commodity)
+{
+    GNCPriceSnapshot *snapshot = g_hash_table_lookup (model->snapshots, commodity);
+
+    if (!snapshot)
+    {
+        snapshot = gnc_pricedb_snapshot_new (model->price_db, commodity);
+        g_hash_table_insert (model->snapshots, commodity, snapshot);
+    }
+    return snapshot;
+}
+
+/** Drop the snapshot of a commodity's prices after they changed, or of
+ *  all commodities if commodity is NULL.
+ *
+ *  @internal
+ */
+static void
+gnc_tree_model_price_forget_prices (GncTreeModelPrice *model,
+                                    gnc_commodity *commodity)
+{
+    if (commodity)
+        g_hash_table_remove (model->snapshots, commodity);
+    else
+        g_hash_table_remove_all (model->snapshots);
+}
+
 gboolean
 gnc_tree_model_price_iter_is_namespace (GncTreeModelPrice *model,
                                         GtkTreeIter *iter)
@@ -528,7 +574,7 @@ gnc_tree_model_price_get_iter (GtkTreeModel *tree_model,
 
     /* Verify the third part of the path: the price. */
     i = gtk_tree_path_get_indices (path)[2];
-    price = gnc_pricedb_nth_price(model->price_db, commodity, i);
+    price = gnc_price_snapshot_nth (gnc_tree_model_price_get_snapshot (model, commodity), i);
     /* There's a race condition here that I can't resolve.
      * Comment this check out for now, and we'll handle the
      * resulting problem elsewhere. */
@@ -794,7 +840,7 @@ gnc_tree_model_price_iter_next (GtkTreeModel *tree_model,
     {
         commodity = gnc_price_get_commodity((GNCPrice*)iter->user_data2);
         n = GPOINTER_TO_INT(iter->user_data3) + 1;
-        iter->user_data2 = gnc_pricedb_nth_price(model->price_db, commodity, n);
+        iter->user_data2 = gnc_price_snapshot_nth (gnc_tree_model_price_get_snapshot (model, commodity), n);
         if (iter->user_data2 == NULL)
         {
             LEAVE("no next iter");
@@ -870,7 +916,7 @@ gnc_tree_model_price_iter_children (GtkTreeModel *tree_model,
     {
         GNCPrice *price;
         commodity = (gnc_commodity *)parent->user_data2;
-        price = gnc_pricedb_nth_price(model->price_db, commodity, 0);
+        price = gnc_price_snapshot_nth (gnc_tree_model_price_get_snapshot (model, commodity), 0);
         if (price == NULL)
         {
             LEAVE("no prices");
@@ -972,7 +1018,7 @@ gnc_tree_model_price_iter_n_children (GtkTreeModel *tree_model,
     if (iter->user_data == ITER_IS_COMMODITY)
     {
         commodity = (gnc_commodity *)iter->user_data2;
-        n = gnc_pricedb_num_prices(model->price_db, commodity);
+        n = gnc_price_snapshot_length (gnc_tree_model_price_get_snapshot (model, commodity));
         LEAVE("price list length %d", n);
         return n;
     }
@@ -1034,7 +1080,7 @@ gnc_tree_model_price_iter_nth_child (GtkTreeModel *tree_model,
 
         iter->stamp      = model->stamp;
         iter->user_data  = ITER_IS_PRICE;
-        iter->user_data2 = gnc_pricedb_nth_price(model->price_db, commodity, n);
+        iter->user_data2 = gnc_price_snapshot_nth (gnc_tree_model_price_get_snapshot (model, commodity), n);
         iter->user_data3 = GINT_TO_POINTER(n);
         LEAVE("price iter %p (%s)", iter, iter_to_string(model, iter));
         return iter->user_data2 != NULL;
@@ -1113,7 +1159,6 @@ gnc_tree_model_price_get_iter_from_price (GncTreeModelPrice *model,
         GtkTreeIter *iter)
 {
     gnc_commodity *commodity;
-    GList *list;
     gint n;
 
     ENTER("model %p, price %p, iter %p", model, price, iter);
@@ -1128,17 +1173,10 @@ gnc_tree_model_price_get_iter_from_price (GncTreeModelPrice *model,
         return FALSE;
     }
 
-    list = gnc_pricedb_get_prices(model->price_db, commodity, NULL);
-    if (list == NULL)
-    {
-        LEAVE("empty list");
-        return FALSE;
-    }
-
-    n = g_list_index(list, price);
+    n = gnc_price_snapshot_index (gnc_tree_model_price_get_snapshot (model, commodity),
+                                  price);
     if (n == -1)
     {
-        gnc_price_list_destroy(list);
         LEAVE("not in list");
         return FALSE;
     }
@@ -1147,7 +1185,6 @@ gnc_tree_model_price_get_iter_from_price (GncTreeModelPrice *model,
     iter->user_data  = ITER_IS_PRICE;
     iter->user_data2 = price;
     iter->user_data3 = GINT_TO_POINTER(n);
-    gnc_price_list_destroy(list);
     LEAVE("iter %s", iter_to_string(model, iter));
     return TRUE;
 }
@@ -1468,7 +1505,7 @@ gnc_tree_model_price_do_deletions (gpointer price_db)
 
             /* Remove the path. */
             gnc_tree_model_price_row_delete(data->model, data->path);
-            gnc_pricedb_nth_price_reset_cache (price_db);
+            gnc_tree_model_price_forget_prices (data->model, NULL);
 
             gtk_tree_path_free(data->path);
             g_free(data);
@@ -1481,6 +1518,40 @@ gnc_tree_model_price_do_deletions (gpointer price_db)
 }
 
 
+/** Add the rows of prices that were added to the pricedb together.  The
+ *  model must report new rows in order, so the paths of all of them are
+ *  found before any is reported.
+ *
+ *  @param model A pointer to the tree model.
+ *
+ *  @param prices The list of added prices.
+ */
+static void
+gnc_tree_model_price_add_prices (GncTreeModelPrice *model, GList *prices)
+{
+    GtkTreeModel *tree_model = GTK_TREE_MODEL(model);
+    GtkTreeIter iter;
+    GList *paths = NULL, *node;
+
+    for (node = prices; node; node = g_list_next (node))
+        gnc_tree_model_price_forget_prices (model,
+                                            gnc_price_get_commodity (node->data));
+    for (node = prices; node; node = g_list_next (node))
+    {
+        if (gnc_tree_model_price_get_iter_from_price (model, node->data, &iter))
+            paths = g_list_prepend (paths, gtk_tree_model_get_path (tree_model, &iter));
+    }
+
+    paths = g_list_sort (paths, (GCompareFunc)gtk_tree_path_compare);
+    for (node = paths; node; node = g_list_next (node))
+    {
+        if (gtk_tree_model_get_iter (tree_model, &iter, node->data))
+            gnc_tree_model_price_row_add (model, &iter);
+    }
+    g_list_free_full (paths, (GDestroyNotify)gtk_tree_path_free);
+}
+
+
 /** This function is the handler for all event messages from the engine.
  *  Its purpose is to update the tree model any time a price, commodity, or
  *  namespace is added to the engine, modified, or deleted from the engine.
@@ -1566,12 +1637,26 @@ gnc_tree_model_price_event_handler (QofInstance *entity,
             }
         }
     }
+    else if (GNC_IS_PRICEDB(entity))
+    {
+        /* gnc_pricedb_add_prices sends one event for all the prices. */
+        if (event_type == QOF_EVENT_ADD && event_data &&
+            GNC_PRICEDB(entity) == model->price_db)
+            gnc_tree_model_price_add_prices (model, event_data);
+        LEAVE(" ");
+        return;
+    }
     else if (GNC_IS_PRICE(entity))
     {
         GNCPrice *price;
 
         price = GNC_PRICE(entity);
         name = "price";
+        /* A price being removed is still in the pricedb, so its row is
+         * found from the prices as they were. */
+        if (event_type != QOF_EVENT_REMOVE)
+            gnc_tree_model_price_forget_prices (model,
+                                                gnc_price_get_commodity (price));
         if (event_type != QOF_EVENT_DESTROY)
         {
             if (!gnc_tree_model_price_get_iter_from_price (model, price, &iter))
@@ -1592,7 +1677,6 @@ gnc_tree_model_price_event_handler (QofInstance *entity,
     case QOF_EVENT_ADD:
         /* Tell the filters/views where the new price was added. */
         DEBUG("add %s", name);
-        gnc_pricedb_nth_price_reset_cache (model->price_db);
         gnc_tree_model_price_row_add (model, &iter);
         break;
 
@@ -1606,6 +1690,10 @@ gnc_tree_model_price_event_handler (QofInstance *entity,
             return;
         }
 
+        if (GNC_IS_PRICE(entity))
+            gnc_tree_model_price_forget_prices (model,
+                                                gnc_price_get_commodity (GNC_PRICE(entity)));
+
         data = g_new0 (remove_data, 1);
         data->model = model;
         data->path = path;
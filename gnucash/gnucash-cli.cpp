@@ -66,6 +66,8 @@ namespace Gnucash {
         boost::optional <std::string> m_report_name;
         boost::optional <std::string> m_export_type;
         boost::optional <std::string> m_output_file;
+
+        boost::optional <std::string> m_convert_to;
     };
 
 }
@@ -124,6 +126,13 @@ may be specified to describe some saved options.\n"
     m_opt_desc_display->add (report_options);
     m_opt_desc_all.add (report_options);
 
+    bpo::options_description convert_options(_("Conversion Options"));
+    convert_options.add_options()
+    ("convert", bpo::value (&m_convert_to),
+     _("Save the given GnuCash datafile to this URI, e.g. sqlite3:///path/to/copy.gnucash or xml:///path/to/copy.gnucash. The whole book is loaded into memory and saved as File->Save As does, except that an sqlite3 datafile is copied to an sqlite3 URI without loading it.\n"));
+    m_opt_desc_display->add (convert_options);
+    m_opt_desc_all.add (convert_options);
+
 }
 
 int
@@ -217,6 +226,18 @@ Gnucash::GnucashCli::start ([[maybe_unused]] int argc, [[maybe_unused]] char **a
         }
     }
 
+    if (m_convert_to)
+    {
+        if (!m_file_to_load || m_file_to_load->empty())
+        {
+            std::cerr << _("Missing data file parameter") << "\n\n"
+                      << *m_opt_desc_display.get() << std::endl;
+            return 1;
+        }
+        else
+            return Gnucash::convert_file (m_file_to_load, m_convert_to);
+    }
+
     std::cerr << _("Missing command or option") << "\n\n"
               << *m_opt_desc_display.get() << std::endl;
 
@@ -433,3 +433,49 @@ Gnucash::report_list (void)
     scm_boot_guile (0, nullptr, scm_report_list, NULL);
     return 0;
 }
+
+/* Not a streaming converter: apart from the sqlite3 to sqlite3 copy the
+ * whole book is loaded and then saved, so it has to fit in memory. */
+int
+Gnucash::convert_file (const bo_str& uri, const bo_str& output_uri)
+{
+    gnc_prefs_init ();
+    qof_event_suspend();
+
+    auto session = qof_session_new (qof_book_new());
+    qof_session_begin (session, uri->c_str(), SESSION_READ_ONLY);
+    if (qof_session_get_error (session) != ERR_BACKEND_NO_ERR)
+        return cleanup_and_exit_with_failure (session);
+
+    /* An sqlite3 file can be copied to another without loading it. */
+    if (qof_session_copy_to (session, output_uri->c_str()))
+    {
+        qof_session_destroy (session);
+        qof_event_resume();
+        return 0;
+    }
+
+    qof_session_load (session, report_session_percentage);
+    if (qof_session_get_error (session) != ERR_BACKEND_NO_ERR)
+        return cleanup_and_exit_with_failure (session);
+
+    auto new_session = qof_session_new (nullptr);
+    qof_session_begin (new_session, output_uri->c_str(), SESSION_NEW_OVERWRITE);
+    if (qof_session_get_error (new_session) != ERR_BACKEND_NO_ERR)
+    {
+        qof_session_destroy (session);
+        return cleanup_and_exit_with_failure (new_session);
+    }
+
+    /* As File->Save As does it: the new session gets the loaded book. */
+    qof_session_swap_data (session, new_session);
+    qof_book_mark_session_dirty (qof_session_get_book (new_session));
+    qof_session_save (new_session, report_session_percentage);
+    qof_session_destroy (session);
+    if (qof_session_get_error (new_session) != ERR_BACKEND_NO_ERR)
+        return cleanup_and_exit_with_failure (new_session);
+
+    qof_session_destroy (new_session);
+    qof_event_resume();
+    return 0;
+}
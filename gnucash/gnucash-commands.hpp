@@ -46,5 +46,6 @@ namespace Gnucash {
     int report_list (void);
     int report_show (const bo_str& file_to_load,
                      const bo_str& run_report);
+    int convert_file (const bo_str& uri, const bo_str& output_uri);
 }
 #endif
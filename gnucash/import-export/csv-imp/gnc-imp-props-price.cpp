@@ -289,7 +289,8 @@ std::string GncImportPrice::verify_essentials (void)
         return std::string();
 }
 
-Result GncImportPrice::create_price (QofBook* book, GNCPriceDB *pdb, bool over)
+Result GncImportPrice::create_price (QofBook* book, GNCPriceDB *pdb, bool over,
+                                     std::vector<GNCPrice*>& new_prices)
 {
     /* Gently refuse to create the price if the basics are not set correctly
      * This should have been tested before calling this function though!
@@ -347,12 +348,7 @@ Result GncImportPrice::create_price (QofBook* book, GNCPriceDB *pdb, bool over)
         gnc_price_set_typestr (price, PRICE_TYPE_LAST);
         gnc_price_commit_edit (price);
 
-        bool perr = gnc_pricedb_add_price (pdb, price);
-
-        gnc_price_unref (price);
-
-        if (perr == false)
-            throw std::invalid_argument (_("Failed to create price from selected columns."));
+        new_prices.push_back (price);
     }
     else
     {
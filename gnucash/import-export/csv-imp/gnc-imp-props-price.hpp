@@ -37,6 +37,7 @@
 #include <map>
 #include <memory>
 #include <optional>
+#include <vector>
 #include <gnc-datetime.hpp>
 #include <gnc-numeric.hpp>
 
@@ -91,7 +92,10 @@ public:
     void set_currency_format (int currency_format) { m_currency_format = currency_format ;}
     void reset (GncPricePropType prop_type);
     std::string verify_essentials (void);
-    Result create_price (QofBook* book, GNCPriceDB *pdb, bool over);
+    /* The new price is appended to new_prices instead of being added to
+       the pricedb; adding it is left to the caller. */
+    Result create_price (QofBook* book, GNCPriceDB *pdb, bool over,
+                         std::vector<GNCPrice*>& new_prices);
 
     gnc_commodity* get_from_commodity () { if (m_from_commodity) return *m_from_commodity; else return nullptr; }
     void set_from_commodity (gnc_commodity* comm) { if (comm) m_from_commodity = comm; else m_from_commodity.reset(); }
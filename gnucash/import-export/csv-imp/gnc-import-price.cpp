@@ -608,7 +608,34 @@ void GncPriceImport::create_price (std::vector<parse_line_t>::iterator& parsed_l
         GNCPriceDB *pdb = gnc_pricedb_get_db (book);
 
         /* If all went well, add this price to the list. */
-        auto price_created = price_props->create_price (book, pdb, m_over_write);
+        auto price_created = price_props->create_price (book, pdb, m_over_write,
+                                                        m_new_prices);
+        if (price_created == ADDED)
+        {
+            /* An earlier line may have made a price for the same day,
+             * which the pricedb doesn't know about yet. */
+            auto price = m_new_prices.back();
+            PriceDay day {gnc_price_get_commodity (price),
+                          gnc_price_get_currency (price),
+                          time64CanonicalDayTime (gnc_price_get_time64 (price))};
+            auto earlier = m_new_price_days.find (day);
+            if (earlier == m_new_price_days.end())
+                m_new_price_days.emplace (day, m_new_prices.size() - 1);
+            else if (m_over_write)
+            {
+                gnc_price_unref (m_new_prices[earlier->second]);
+                m_new_prices[earlier->second] = price;
+                m_new_prices.pop_back();
+                price_created = REPLACED;
+            }
+            else
+            {
+                gnc_price_unref (price);
+                m_new_prices.pop_back();
+                price_created = DUPLICATED;
+            }
+        }
+
         if (price_created == ADDED)
             m_prices_added++;
         else if (price_created == DUPLICATED)
@@ -640,6 +667,8 @@ void GncPriceImport::create_prices ()
     m_prices_added = 0;
     m_prices_duplicated = 0;
     m_prices_replaced = 0;
+    m_new_prices.clear();
+    m_new_price_days.clear();
 
     /* Iterate over all parsed lines */
     for (auto parsed_lines_it = m_parsed_lines.begin();
@@ -653,6 +682,13 @@ void GncPriceImport::create_prices ()
         /* Should not throw anymore, otherwise verify needs revision */
         create_price (parsed_lines_it);
     }
+
+    /* Add all the new prices in one go. */
+    auto pdb = gnc_pricedb_get_db (gnc_get_current_book());
+    gnc_pricedb_add_prices (pdb, m_new_prices.data(), m_new_prices.size());
+    std::for_each (m_new_prices.begin(), m_new_prices.end(), gnc_price_unref);
+    m_new_prices.clear();
+    m_new_price_days.clear();
     PINFO("Number of lines is %d, added %d, duplicated %d, replaced %d",
          (int)m_parsed_lines.size(), m_prices_added, m_prices_duplicated, m_prices_replaced);
 }
@@ -38,6 +38,7 @@
 #include <map>
 #include <memory>
 #include <optional>
+#include <tuple>
 #include <cstdint>
 
 #include "gnc-tokenizer.hpp"
@@ -153,6 +154,14 @@ private:
      */
     void create_price (std::vector<parse_line_t>::iterator& parsed_line);
 
+    /** The prices create_price made, added to the pricedb together once
+     *  all lines are done, and the index of each by commodity, currency
+     *  and day so that lines for the same day can be handled the way the
+     *  pricedb would handle them one by one. */
+    using PriceDay = std::tuple<gnc_commodity*, gnc_commodity*, time64>;
+    std::vector<GNCPrice*> m_new_prices;
+    std::map<PriceDay, size_t> m_new_price_days;
+
     void verify_column_selections (ErrorListPrice& error_msg);
 
     /* Internal helper function to force reparsing of columns subject to format changes */
@@ -785,14 +785,17 @@ void
 GncQuotesImpl::create_quotes (const bpt::ptree& pt, const CommVec& comm_vec)
 {
     auto pricedb{gnc_pricedb_get_db(m_book)};
+    std::vector<GNCPrice*> prices;
+    prices.reserve(comm_vec.size());
     for (auto comm : comm_vec)
     {
         auto price{parse_one_quote(pt, comm)};
         if (!price)
             continue;
-// See the comment at gnc_pricedb_add_price
-        gnc_pricedb_add_price(pricedb, price);
+        prices.push_back(price);
     }
+    gnc_pricedb_add_prices(pricedb, prices.data(), prices.size());
+    std::for_each(prices.begin(), prices.end(), gnc_price_unref);
 }
 
 static void
@@ -834,6 +834,7 @@ GncDbiBackend<Type>::session_end ()
 {
     ENTER (" ");
 
+    commit_pending ();
     finalize_version_info ();
     connect(nullptr);
 
@@ -1020,6 +1021,90 @@ GncDbiBackend<DbType::DBI_MYSQL>::safe_sync (QofBook* book)
     conn->table_operation (TableOpType::drop_backup);
     LEAVE ("book=%p", m_book);
 }
+
+template <DbType Type> bool
+GncDbiBackend<Type>::copy_to (const char* uri)
+{
+    return false;
+}
+
+/* Empty the lock table of the sqlite3 file at path, attached to this
+ * connection for the purpose. */
+template <> bool
+GncDbiBackend<DbType::DBI_SQLITE>::clear_copied_lock (const std::string& path)
+{
+    auto attach = create_statement_from_sql ("ATTACH DATABASE " +
+                                             quote_string (path) +
+                                             " AS gnc_copy");
+    if (attach == nullptr || execute_nonselect_statement (attach) < 0)
+        return false;
+    auto clear = create_statement_from_sql ("DELETE FROM gnc_copy.gnclock");
+    auto ok = clear != nullptr && execute_nonselect_statement (clear) >= 0;
+    auto detach = create_statement_from_sql ("DETACH DATABASE gnc_copy");
+    if (detach == nullptr || execute_nonselect_statement (detach) < 0)
+        ok = false;
+    return ok;
+}
+
+/**
+ * Copy an sqlite3 database to another sqlite3 file with VACUUM INTO, which
+ * SQLite does a page at a time without anything being loaded.  The copy is
+ * written next to the target and renamed over it once it's complete, so a
+ * failed copy leaves the target as it was.  VACUUM INTO needs SQLite 3.27;
+ * if it fails the caller has to load and save instead.
+ *
+ * @param uri: The sqlite3 URI to copy the database to.
+ */
+template <> bool
+GncDbiBackend<DbType::DBI_SQLITE>::copy_to (const char* uri)
+{
+    g_return_val_if_fail (uri != nullptr, false);
+    if (m_conn == nullptr)
+        return false;
+
+    auto scheme = gnc_uri_get_scheme (uri);
+    auto is_sqlite = g_strcmp0 (scheme, SQLITE3_URI_TYPE) == 0;
+    g_free (scheme);
+    if (!is_sqlite)
+        return false;
+
+    ENTER ("uri=%s", uri);
+    auto path = gnc_uri_get_path (uri);
+    std::string filepath{path};
+    g_free (path);
+    auto tmppath = filepath + ".tmp";
+    g_unlink (tmppath.c_str());
+
+    auto stmt = create_statement_from_sql ("VACUUM INTO " +
+                                           quote_string (tmppath));
+    if (stmt == nullptr || execute_nonselect_statement (stmt) < 0)
+    {
+        /* Not an error: the data can still be copied the long way. */
+        (void)get_error ();
+        g_unlink (tmppath.c_str());
+        LEAVE ("VACUUM INTO failed");
+        return false;
+    }
+    /* The copy has this session's lock, which would keep anyone from
+     * opening it. */
+    if (!clear_copied_lock (tmppath))
+    {
+        (void)get_error ();
+        g_unlink (tmppath.c_str());
+        LEAVE ("Couldn't clear the copy's lock");
+        return false;
+    }
+    if (g_rename (tmppath.c_str(), filepath.c_str()) != 0)
+    {
+        PERR ("Failed to rename %s to %s: %s", tmppath.c_str(),
+              filepath.c_str(), g_strerror (errno));
+        g_unlink (tmppath.c_str());
+        LEAVE ("rename failed");
+        return false;
+    }
+    LEAVE ("");
+    return true;
+}
 /* ================================================================= */
 
 /*
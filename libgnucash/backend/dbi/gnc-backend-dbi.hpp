@@ -95,6 +95,7 @@ public:
     void session_end() override;
     void load(QofBook*, QofBackendLoadType) override;
     void safe_sync(QofBook*) override;
+    bool copy_to(const char*) override;
     bool connected() const noexcept { return m_conn != nullptr; }
     /** FIXME: Just a pass-through to m_conn: */
     void set_dbi_error(QofBackendError error, unsigned int repeat,
@@ -114,6 +115,7 @@ private:
     bool conn_test_dbi_library(dbi_conn conn);
     bool set_standard_connection_options(dbi_conn conn, const UriStrings& uri);
     bool create_database(dbi_conn conn, const char* db);
+    bool clear_copied_lock(const std::string& path);
     bool m_exists;         // Does the database exist?
 };
 
@@ -82,6 +82,23 @@ GncDbiSqlResult::size() const noexcept
 {
     return dbi_result_get_numrows(m_dbi_result);
 }
+
+const GncDbiSqlResult::Column&
+GncDbiSqlResult::column (const char* col) const
+{
+    auto spot = m_columns.find (col);
+    if (spot != m_columns.end())
+        return spot->second;
+
+    Column column{dbi_result_get_field_idx (m_dbi_result, col), 0, 0};
+    if (column.idx)
+    {
+        column.type = dbi_result_get_field_type_idx (m_dbi_result, column.idx);
+        column.attribs = dbi_result_get_field_attribs_idx (m_dbi_result,
+                                                           column.idx);
+    }
+    return m_columns.emplace (col, column).first->second;
+}
 /* --------------------------------------------------------- */
 
 GncSqlRow&
@@ -101,23 +118,22 @@ GncDbiSqlResult::IteratorImpl::operator++()
 std::optional<int64_t>
 GncDbiSqlResult::IteratorImpl::get_int_at_col(const char* col) const
 {
-    auto type = dbi_result_get_field_type (m_inst->m_dbi_result, col);
-    if(type != DBI_TYPE_INTEGER)
+    auto& column = m_inst->column (col);
+    if(column.type != DBI_TYPE_INTEGER)
         return std::nullopt;
-    return std::optional<int64_t>{dbi_result_get_longlong (m_inst->m_dbi_result, col)};
+    return std::optional<int64_t>{dbi_result_get_longlong_idx (m_inst->m_dbi_result, column.idx)};
 }
 
 std::optional<double>
 GncDbiSqlResult::IteratorImpl::get_float_at_col(const char* col) const
 {
     constexpr double float_precision = 1000000.0;
-    auto type = dbi_result_get_field_type (m_inst->m_dbi_result, col);
-    auto attrs = dbi_result_get_field_attribs (m_inst->m_dbi_result, col);
-    if(type != DBI_TYPE_DECIMAL ||
-       (attrs & DBI_DECIMAL_SIZEMASK) != DBI_DECIMAL_SIZE4)
+    auto& column = m_inst->column (col);
+    if(column.type != DBI_TYPE_DECIMAL ||
+       (column.attribs & DBI_DECIMAL_SIZEMASK) != DBI_DECIMAL_SIZE4)
         return std::nullopt;
     auto locale = gnc_push_locale (LC_NUMERIC, "C");
-    auto interim =  dbi_result_get_float(m_inst->m_dbi_result, col);
+    auto interim =  dbi_result_get_float_idx(m_inst->m_dbi_result, column.idx);
     gnc_pop_locale (LC_NUMERIC, locale);
     double retval = static_cast<double>(round(interim * float_precision)) / float_precision;
     return std::optional<double>{retval};
@@ -126,13 +142,12 @@ GncDbiSqlResult::IteratorImpl::get_float_at_col(const char* col) const
 std::optional<double>
 GncDbiSqlResult::IteratorImpl::get_double_at_col(const char* col) const
 {
-    auto type = dbi_result_get_field_type (m_inst->m_dbi_result, col);
-    auto attrs = dbi_result_get_field_attribs (m_inst->m_dbi_result, col);
-    if(type != DBI_TYPE_DECIMAL ||
-       (attrs & DBI_DECIMAL_SIZEMASK) != DBI_DECIMAL_SIZE8)
+    auto& column = m_inst->column (col);
+    if(column.type != DBI_TYPE_DECIMAL ||
+       (column.attribs & DBI_DECIMAL_SIZEMASK) != DBI_DECIMAL_SIZE8)
         return std::nullopt;
     auto locale = gnc_push_locale (LC_NUMERIC, "C");
-    auto retval =  dbi_result_get_double(m_inst->m_dbi_result, col);
+    auto retval =  dbi_result_get_double_idx(m_inst->m_dbi_result, column.idx);
     gnc_pop_locale (LC_NUMERIC, locale);
     return std::optional<double>{retval};
 }
@@ -140,27 +155,39 @@ GncDbiSqlResult::IteratorImpl::get_double_at_col(const char* col) const
 std::optional<std::string>
 GncDbiSqlResult::IteratorImpl::get_string_at_col(const char* col) const
 {
-    auto type = dbi_result_get_field_type (m_inst->m_dbi_result, col);
-    dbi_result_get_field_attribs (m_inst->m_dbi_result, col);
-    if(type != DBI_TYPE_STRING)
+    auto& column = m_inst->column (col);
+    if(column.type != DBI_TYPE_STRING)
         return std::nullopt;
-    auto strval = dbi_result_get_string(m_inst->m_dbi_result, col);
+    auto strval = dbi_result_get_string_idx(m_inst->m_dbi_result, column.idx);
     return std::optional<std::string>{strval ? strval : ""};
 }
 
+std::optional<GncGUID>
+GncDbiSqlResult::IteratorImpl::get_guid_at_col (const char* col) const
+{
+    auto& column = m_inst->column (col);
+    if(column.type != DBI_TYPE_STRING)
+        return std::nullopt;
+    /* The field's own buffer, so there's nothing to copy. */
+    auto strval = dbi_result_get_string_idx(m_inst->m_dbi_result, column.idx);
+    GncGUID guid;
+    if (!strval || !string_to_guid (strval, &guid))
+        return std::nullopt;
+    return std::optional<GncGUID>{guid};
+}
+
 std::optional<time64>
 GncDbiSqlResult::IteratorImpl::get_time64_at_col (const char* col) const
 {
     auto result = (dbi_result_t*) (m_inst->m_dbi_result);
-    auto type = dbi_result_get_field_type (result, col);
-    dbi_result_get_field_attribs (result, col);
-    if (type != DBI_TYPE_DATETIME)
+    auto& column = m_inst->column (col);
+    if (column.type != DBI_TYPE_DATETIME)
         return std::nullopt;
 #if HAVE_LIBDBI_TO_LONGLONG
     /* A less evil hack than the one required by libdbi-0.8, but
      * still necessary to work around the same bug.
      */
-    auto timeval = dbi_result_get_as_longlong(result, col);
+    auto timeval = dbi_result_get_as_longlong_idx(result, column.idx);
 #else
     /* A seriously evil hack to work around libdbi bug #15
      * https://sourceforge.net/p/libdbi/bugs/15/. When libdbi
@@ -169,7 +196,7 @@ GncDbiSqlResult::IteratorImpl::get_time64_at_col (const char* col) const
      * Note: 0.9 is available in Debian Jessie and Fedora 21.
      */
     auto row = dbi_result_get_currow (result);
-    auto idx = dbi_result_get_field_idx (result, col) - 1;
+    auto idx = column.idx - 1;
     time64 timeval = result->rows[row]->field_values[idx].d_datetime;
 #endif //HAVE_LIBDBI_TO_LONGLONG
     if (timeval < MINTIME || timeval > MAXTIME)
@@ -177,6 +204,17 @@ GncDbiSqlResult::IteratorImpl::get_time64_at_col (const char* col) const
     return std::optional<time64>(timeval);
 }
 
+bool
+GncDbiSqlResult::IteratorImpl::is_col_null(const char* col) const noexcept
+{
+    auto& column = m_inst->column (col);
+    /* dbi_result_field_is_null reports a missing field as an error, which
+     * was taken to be null. */
+    if (!column.idx)
+        return true;
+    return dbi_result_field_is_null_idx(m_inst->m_dbi_result, column.idx);
+}
+
 
 /* --------------------------------------------------------- */
 
@@ -27,6 +27,9 @@
 
 #include <optional>
 #include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
 
 #include "gnc-backend-dbi.h"
 #include <gnc-sql-result.hpp>
@@ -61,21 +64,34 @@ protected:
         virtual std::optional<double> get_double_at_col (const char* col) const;
         virtual std::optional<std::string> get_string_at_col (const char* col)const;
         virtual std::optional<time64> get_time64_at_col (const char* col) const;
-        virtual bool is_col_null(const char* col) const noexcept
-        {
-            return dbi_result_field_is_null(m_inst->m_dbi_result, col);
-        }
+        virtual bool is_col_null(const char* col) const noexcept;
+        virtual std::optional<GncGUID> get_guid_at_col (const char* col) const;
     private:
         GncDbiSqlResult* m_inst = nullptr;
     };
 
 private:
+    /* What's needed to read a column by index rather than by name: libdbi
+     * finds a named field by comparing it with every field name, twice for
+     * each value read, and the columns are the same for every row. */
+    struct Column
+    {
+        /* Counting from 1 as libdbi does; 0 if there's no such column. */
+        unsigned int idx;
+        unsigned short type;
+        unsigned int attribs;
+    };
+    /* Look a column up by name the first time it's asked for and remember
+     * it for the rest of the rows. There are only a few columns, so the
+     * map is searched by the name itself without making a string of it. */
+    const Column& column (const char* col) const;
+
     const GncDbiSqlConnection* m_conn = nullptr;
     dbi_result m_dbi_result;
     IteratorImpl m_iter;
     GncSqlRow m_row;
     GncSqlRow m_sentinel;
-
+    mutable std::map<std::string, Column, std::less<>> m_columns;
 };
 
 #endif //__GNC_DBISQLRESULT_HPP__
@@ -39,6 +39,8 @@
 #include <gnc-uri-utils.h>
     /* For setup_business */
 #include "Account.h"
+#include <Account.hpp>
+#include <AccountP.hpp>
 #include <TransLog.h>
 #include "Transaction.h"
 #include "Split.h"
@@ -57,6 +59,7 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <functional>
 
 #include "test-dbi-stuff.h"
 #include "test-dbi-business-stuff.h"
@@ -241,6 +244,74 @@ setup_business (Fixture* fixture, gconstpointer pData)
         fixture->filename = NULL;
 }
 
+/* A book of a million splits for timing Save As. */
+static void
+setup_benchmark (Fixture* fixture, gconstpointer pData)
+{
+    gchar* url = (gchar*)pData;
+    gnc_module_init_backend_dbi ();
+    auto book = qof_book_new ();
+    auto session = qof_session_new (book);
+    auto table = gnc_commodity_table_get_table (book);
+    auto currency = gnc_commodity_table_lookup (table,
+                                                GNC_COMMODITY_NS_CURRENCY,
+                                                "USD");
+    auto root = gnc_book_get_root_account (book);
+    std::vector<Account*> accounts;
+
+    for (auto i = 0; i < 50; ++i)
+    {
+        auto account = xaccMallocAccount (book);
+        auto name = std::string{"Account "} + std::to_string (i);
+
+        xaccAccountBeginEdit (account);
+        xaccAccountSetName (account, name.c_str ());
+        xaccAccountSetType (account, i % 2 ? ACCT_TYPE_EXPENSE :
+                            ACCT_TYPE_BANK);
+        xaccAccountSetCommodity (account, currency);
+        gnc_account_append_child (root, account);
+        xaccAccountCommitEdit (account);
+        accounts.push_back (account);
+    }
+
+    auto rand = g_rand_new_with_seed (20261017);
+    for (auto i = 0; i < 500000; ++i)
+    {
+        auto trans = xaccMallocTransaction (book);
+        auto amount = gnc_numeric_create (g_rand_int_range (rand, 1, 1000000),
+                                          100);
+        auto date = 1262304000 + g_rand_int_range (rand, 0, 3650) * 86400;
+        auto num = std::to_string (i);
+
+        xaccTransBeginEdit (trans);
+        xaccTransSetCurrency (trans, currency);
+        xaccTransSetDatePostedSecsNormalized (trans, date);
+        xaccTransSetDateEnteredSecs (trans, date);
+        xaccTransSetNum (trans, num.c_str ());
+        xaccTransSetDescription (trans, "Benchmark transaction");
+        for (auto value : {amount, gnc_numeric_neg (amount)})
+        {
+            auto split = xaccMallocSplit (book);
+            auto account = accounts[g_rand_int_range (rand, 0,
+                                                      accounts.size ())];
+
+            xaccSplitSetParent (split, trans);
+            xaccSplitSetAccount (split, account);
+            xaccSplitSetMemo (split, "Benchmark split");
+            xaccSplitSetValue (split, value);
+            xaccSplitSetAmount (split, value);
+        }
+        xaccTransCommitEdit (trans);
+    }
+    g_rand_free (rand);
+
+    fixture->session = session;
+    if (g_strcmp0 (url, "sqlite3") == 0)
+        fixture->filename = g_strdup_printf ("/tmp/test-sqlite-%d", getpid ());
+    else
+        fixture->filename = NULL;
+}
+
 static void
 destroy_database (gchar* url)
 {
@@ -419,6 +490,583 @@ test_dbi_store_and_reload (Fixture* fixture, gconstpointer pData)
     qof_session_destroy (session_3);
 }
 
+/* Save the session as test_dbi_store_and_reload does, then load it back
+ * lazily: the balances have to be right before any transaction is loaded
+ * and stay right as they're loaded piecemeal. */
+static void
+test_dbi_lazy_load (Fixture* fixture, gconstpointer pData)
+{
+    const gchar* url = (const gchar*)pData;
+    auto msg = "[GncDbiSqlConnection::unlock_database()] There was no lock entry in the Lock table";
+    auto log_domain = nullptr;
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    if (fixture->filename)
+        url = fixture->filename;
+
+    auto book2{qof_book_new()};
+    auto session_2 = qof_session_new (book2);
+    qof_session_begin (session_2, url, SESSION_NEW_OVERWRITE);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    qof_session_swap_data (fixture->session, session_2);
+    qof_book_mark_session_dirty (qof_session_get_book (session_2));
+    qof_session_save (session_2, NULL);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    book2 = qof_session_get_book (session_2);
+
+    auto book3{qof_book_new()};
+    auto session_3 = qof_session_new (book3);
+    qof_session_begin (session_3, url, SESSION_READ_ONLY);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    auto sql_be = dynamic_cast<GncSqlBackend*> (qof_book_get_backend (book3));
+    g_assert_nonnull (sql_be);
+    sql_be->set_lazy_load (true);
+    qof_session_load (session_3, NULL);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    book3 = qof_session_get_book (session_3);
+    g_assert_true (sql_be->lazy_pending ());
+
+    auto root2 = gnc_book_get_root_account (book2);
+    auto lookup = [book3](Account* acc2)
+    {
+        auto acc3 = xaccAccountLookup (qof_instance_get_guid (acc2), book3);
+        g_assert_nonnull (acc3);
+        return acc3;
+    };
+    auto assert_balances = [lookup](Account* acc2)
+    {
+        auto acc3 = lookup (acc2);
+        g_assert_true (gnc_numeric_equal (xaccAccountGetBalance (acc2),
+                                          xaccAccountGetBalance (acc3)));
+        g_assert_true (gnc_numeric_equal (xaccAccountGetClearedBalance (acc2),
+                                          xaccAccountGetClearedBalance (acc3)));
+        g_assert_true (gnc_numeric_equal (xaccAccountGetReconciledBalance (acc2),
+                                          xaccAccountGetReconciledBalance (acc3)));
+    };
+
+    gnc_account_foreach_descendant (root2, assert_balances);
+
+    /* A balance as of a date only needs the splits from then on. */
+    gnc_account_foreach_descendant (root2, [lookup](Account* acc2)
+    {
+        const auto& splits{xaccAccountGetSplits (acc2)};
+        if (splits.empty ())
+            return;
+        auto date = xaccTransGetDate (xaccSplitGetParent (splits[splits.size () / 2]));
+        auto acc3 = lookup (acc2);
+        g_assert_true (gnc_numeric_equal (xaccAccountGetBalanceAsOfDate (acc2, date),
+                                          xaccAccountGetBalanceAsOfDate (acc3, date)));
+        g_assert_cmpint (gnc_account_get_splits_loaded_from (acc3), <=, date);
+    });
+    gnc_account_foreach_descendant (root2, assert_balances);
+
+    gnc_account_foreach_descendant (root2, [lookup](Account* acc2)
+    {
+        auto acc3 = lookup (acc2);
+        g_assert_cmpint (xaccAccountGetSplitsSize (acc2), == ,
+                         xaccAccountGetSplitsSize (acc3));
+        g_assert_cmpint (gnc_account_get_splits_loaded_from (acc3), == ,
+                         INT64_MIN);
+    });
+    gnc_account_foreach_descendant (root2, assert_balances);
+
+    qof_book_get_backend (book3)->load (book3, LOAD_TYPE_LOAD_ALL);
+    g_assert_false (sql_be->lazy_pending ());
+    compare_books (book2, book3);
+    qof_session_end (session_3);
+    qof_session_destroy (session_3);
+
+    auto book4{qof_book_new()};
+    auto session_4 = qof_session_new (book4);
+    qof_session_begin (session_4, url, SESSION_READ_ONLY);
+    g_assert_cmpint (qof_session_get_error (session_4), == , ERR_BACKEND_NO_ERR);
+    sql_be = dynamic_cast<GncSqlBackend*> (qof_book_get_backend (book4));
+    g_assert_nonnull (sql_be);
+    sql_be->set_lazy_load (true);
+    qof_session_load (session_4, NULL);
+    g_assert_cmpint (qof_session_get_error (session_4), == , ERR_BACKEND_NO_ERR);
+    book4 = qof_session_get_book (session_4);
+    auto lookup4 = [book4](Account* acc2)
+    {
+        auto acc4 = xaccAccountLookup (qof_instance_get_guid (acc2), book4);
+        g_assert_nonnull (acc4);
+        return acc4;
+    };
+
+    /* Loading a transaction again through another of its accounts mustn't
+     * read its slots back over an edit that isn't saved yet. */
+    Split* split2 = nullptr;
+    gnc_account_foreach_descendant (root2, [&split2](Account* acc2)
+    {
+        for (auto s : xaccAccountGetSplits (acc2))
+        {
+            auto other = xaccSplitGetOtherSplit (s);
+            if (!split2 && other && xaccSplitGetAccount (other) != acc2)
+                split2 = s;
+        }
+    });
+    if (split2)
+    {
+        auto other2 = xaccSplitGetOtherSplit (split2);
+        auto acc4 = lookup4 (xaccSplitGetAccount (split2));
+        g_assert_false (xaccAccountGetSplits (acc4).empty ());
+        auto trans4 = xaccTransLookup (qof_instance_get_guid (xaccSplitGetParent (split2)),
+                                       book4);
+        g_assert_nonnull (trans4);
+        xaccTransBeginEdit (trans4);
+        xaccTransSetNotes (trans4, "Not saved yet");
+        auto other4 = lookup4 (xaccSplitGetAccount (other2));
+        g_assert_cmpint (gnc_account_get_splits_loaded_from (other4), >, INT64_MIN);
+        g_assert_false (xaccAccountGetSplits (other4).empty ());
+        g_assert_cmpstr (xaccTransGetNotes (trans4), == , "Not saved yet");
+        xaccTransRollbackEdit (trans4);
+    }
+
+    /* An account whose splits aren't loaded yet isn't empty, and moving
+     * its splits moves all of them. */
+    std::vector<Account*> unloaded2;
+    gnc_account_foreach_descendant (root2, [&unloaded2, lookup4](Account* acc2)
+    {
+        if (unloaded2.size () < 2 && gnc_account_n_children (acc2) == 0 &&
+            !xaccAccountGetSplits (acc2).empty () &&
+            gnc_account_get_splits_loaded_from (lookup4 (acc2)) > INT64_MIN)
+            unloaded2.push_back (acc2);
+    });
+    if (unloaded2.size () == 2)
+    {
+        auto to4 = lookup4 (unloaded2[0]);
+        auto from4 = lookup4 (unloaded2[1]);
+        g_assert_false (gnc_account_and_descendants_empty (to4));
+        xaccAccountMoveAllSplits (from4, to4);
+        g_assert_cmpint (gnc_account_get_splits_loaded_from (from4), == ,
+                         INT64_MIN);
+        g_assert_true (xaccAccountGetSplits (from4).empty ());
+        g_assert_cmpint (xaccAccountGetSplitsSize (to4), == ,
+                         xaccAccountGetSplitsSize (unloaded2[0]) +
+                         xaccAccountGetSplitsSize (unloaded2[1]));
+    }
+
+    /* Destroying an account has to take the splits that aren't loaded yet
+     * with it, not leave them behind pointing at it. */
+    Account* victim2 = nullptr;
+    gnc_account_foreach_descendant (root2, [&victim2, lookup4](Account* acc2)
+    {
+        if (!victim2 && gnc_account_n_children (acc2) == 0 &&
+            !xaccAccountGetSplits (acc2).empty () &&
+            gnc_account_get_splits_loaded_from (lookup4 (acc2)) > INT64_MIN)
+            victim2 = acc2;
+    });
+    if (victim2)
+    {
+        std::vector<GncGUID> split_guids;
+        for (auto s : xaccAccountGetSplits (victim2))
+            split_guids.push_back (*qof_instance_get_guid (s));
+        auto victim4 = lookup4 (victim2);
+        xaccAccountBeginEdit (victim4);
+        xaccAccountDestroy (victim4);
+        for (const auto& guid : split_guids)
+            g_assert_null (xaccSplitLookup (&guid, book4));
+    }
+
+    qof_session_end (session_2);
+    qof_session_destroy (session_2);
+    qof_session_end (session_4);
+    qof_session_destroy (session_4);
+}
+
+/* Not run by default: run with -m perf to compare saving a big book into
+ * a new database, as Save As does, a row at a time and in batches. */
+static void
+test_dbi_save_as_perf (Fixture* fixture, gconstpointer pData)
+{
+    const gchar* url = (const gchar*)pData;
+    auto msg = "[GncDbiSqlConnection::unlock_database()] There was no lock entry in the Lock table";
+    auto log_domain = nullptr;
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    if (fixture->filename)
+        url = fixture->filename;
+
+    for (auto batch_size : {1u, 100u})
+    {
+        auto session_2 = qof_session_new (qof_book_new ());
+        qof_session_begin (session_2, url, SESSION_NEW_OVERWRITE);
+        g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+        qof_session_swap_data (fixture->session, session_2);
+        auto book = qof_session_get_book (session_2);
+        auto sql_be = dynamic_cast<GncSqlBackend*> (qof_book_get_backend (book));
+        g_assert_nonnull (sql_be);
+        sql_be->set_insert_batch_size (batch_size);
+
+        auto timer = g_timer_new ();
+        qof_book_mark_session_dirty (book);
+        qof_session_save (session_2, NULL);
+        auto elapsed = g_timer_elapsed (timer, NULL);
+        g_timer_destroy (timer);
+        g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+        g_test_message ("%u rows per INSERT: %.2fs", batch_size, elapsed);
+
+        qof_session_swap_data (session_2, fixture->session);
+        qof_session_end (session_2);
+        qof_session_destroy (session_2);
+    }
+}
+
+/* Not run by default: run with -m perf to time loading a big book, which
+ * reads every column of every row through GncDbiSqlResult. */
+static void
+test_dbi_load_perf (Fixture* fixture, gconstpointer pData)
+{
+    const gchar* url = (const gchar*)pData;
+    auto msg = "[GncDbiSqlConnection::unlock_database()] There was no lock entry in the Lock table";
+    auto log_domain = nullptr;
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    if (fixture->filename)
+        url = fixture->filename;
+
+    auto session_2 = qof_session_new (qof_book_new ());
+    qof_session_begin (session_2, url, SESSION_NEW_OVERWRITE);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    qof_session_swap_data (fixture->session, session_2);
+    qof_book_mark_session_dirty (qof_session_get_book (session_2));
+    qof_session_save (session_2, NULL);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    qof_session_swap_data (session_2, fixture->session);
+    qof_session_end (session_2);
+    qof_session_destroy (session_2);
+
+    for (auto run = 1; run <= 3; ++run)
+    {
+        auto session_3 = qof_session_new (qof_book_new ());
+        qof_session_begin (session_3, url, SESSION_READ_ONLY);
+        g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+
+        auto timer = g_timer_new ();
+        qof_session_load (session_3, NULL);
+        auto elapsed = g_timer_elapsed (timer, NULL);
+        g_timer_destroy (timer);
+        g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+        auto book3 = qof_session_get_book (session_3);
+        g_test_message ("Load %d: %.2fs for %u transactions", run, elapsed,
+                        qof_collection_count (qof_book_get_collection (book3,
+                                                                       GNC_ID_TRANS)));
+
+        qof_session_end (session_3);
+        qof_session_destroy (session_3);
+    }
+}
+
+static Transaction*
+add_transaction (QofBook* book, Account* account, gnc_commodity* currency,
+                 gint64 cents)
+{
+    auto trans = xaccMallocTransaction (book);
+    auto amount = gnc_numeric_create (cents, 100);
+
+    xaccTransBeginEdit (trans);
+    xaccTransSetCurrency (trans, currency);
+    xaccTransSetDatePostedSecsNormalized (trans, gnc_time (nullptr));
+    xaccTransSetDescription (trans, "Write behind");
+    for (auto value : {amount, gnc_numeric_neg (amount)})
+    {
+        auto split = xaccMallocSplit (book);
+        xaccSplitSetParent (split, trans);
+        xaccSplitSetAccount (split, account);
+        xaccSplitSetValue (split, value);
+        xaccSplitSetAmount (split, value);
+    }
+    xaccTransCommitEdit (trans);
+    return trans;
+}
+
+static Account*
+add_account (QofBook* book, gnc_commodity* currency)
+{
+    auto account = xaccMallocAccount (book);
+    xaccAccountBeginEdit (account);
+    xaccAccountSetName (account, "Write behind");
+    xaccAccountSetType (account, ACCT_TYPE_BANK);
+    xaccAccountSetCommodity (account, currency);
+    gnc_account_append_child (gnc_book_get_root_account (book), account);
+    xaccAccountCommitEdit (account);
+    return account;
+}
+
+/* The SQL backend only queues commits made while a main loop is running. */
+static void
+run_in_main_loop (std::function<void()> func)
+{
+    struct MainLoopCall
+    {
+        std::function<void()>& func;
+        GMainLoop* loop;
+    } call{func, g_main_loop_new (nullptr, FALSE)};
+    g_idle_add ([](gpointer data) -> gboolean
+                {
+                    auto call = static_cast<MainLoopCall*>(data);
+                    call->func();
+                    g_main_loop_quit (call->loop);
+                    return G_SOURCE_REMOVE;
+                }, &call);
+    g_main_loop_run (call.loop);
+    g_main_loop_unref (call.loop);
+}
+
+static void
+test_dbi_write_behind (Fixture* fixture, gconstpointer pData)
+{
+    const gchar* url = (const gchar*)pData;
+    auto msg = "[GncDbiSqlConnection::unlock_database()] There was no lock entry in the Lock table";
+    auto log_domain = nullptr;
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    if (fixture->filename)
+        url = fixture->filename;
+
+    auto session_2 = qof_session_new (qof_book_new ());
+    qof_session_begin (session_2, url, SESSION_NEW_OVERWRITE);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    qof_session_swap_data (fixture->session, session_2);
+    auto book2 = qof_session_get_book (session_2);
+    qof_book_mark_session_dirty (book2);
+    qof_session_save (session_2, NULL);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    auto sql_be = dynamic_cast<GncSqlBackend*> (qof_book_get_backend (book2));
+    g_assert_nonnull (sql_be);
+    /* Long enough that the queue is only written when the test says. */
+    sql_be->set_commit_delay (60000);
+
+    auto table = gnc_commodity_table_get_table (book2);
+    auto currency = gnc_commodity_table_lookup (table,
+                                                GNC_COMMODITY_NS_CURRENCY,
+                                                "USD");
+    std::vector<Transaction*> txns;
+    Account* account = nullptr;
+    run_in_main_loop ([&]()
+    {
+        account = add_account (book2, currency);
+        for (auto cents : {100, 200, 300})
+            txns.push_back (add_transaction (book2, account, currency, cents));
+        /* Nothing is written yet. */
+        g_assert_true (qof_instance_get_dirty_flag (QOF_INSTANCE (account)));
+        g_assert_true (qof_instance_get_dirty_flag (QOF_INSTANCE (txns[0])));
+
+        xaccTransBeginEdit (txns[0]);
+        xaccTransSetDescription (txns[0], "Edited while queued");
+        xaccTransCommitEdit (txns[0]);
+
+        /* Destroying a transaction can't wait, and takes the queue with it. */
+        xaccTransBeginEdit (txns[1]);
+        xaccTransDestroy (txns[1]);
+        xaccTransCommitEdit (txns[1]);
+        g_assert_false (qof_instance_get_dirty_flag (QOF_INSTANCE (txns[0])));
+        g_assert_false (qof_instance_get_infant (QOF_INSTANCE (txns[0])));
+
+        /* Written before, so this time it's an update. */
+        xaccTransBeginEdit (txns[2]);
+        xaccTransSetDescription (txns[2], "Edited after writing");
+        xaccTransCommitEdit (txns[2]);
+        g_assert_true (qof_instance_get_dirty_flag (QOF_INSTANCE (txns[2])));
+
+        /* Opened again while it waits, as the register does, it isn't
+         * written half edited; cancelling the edit leaves it waiting as it
+         * was. */
+        xaccTransBeginEdit (txns[2]);
+        xaccTransSetDescription (txns[2], "Cancelled");
+        g_assert_true (sql_be->commit_pending ());
+        g_assert_true (qof_instance_get_dirty_flag (QOF_INSTANCE (txns[2])));
+        xaccTransRollbackEdit (txns[2]);
+        g_assert_cmpstr (xaccTransGetDescription (txns[2]), == ,
+                         "Edited after writing");
+        g_assert_true (qof_instance_get_dirty_flag (QOF_INSTANCE (txns[2])));
+    });
+    /* The queue outlives the main loop run. */
+    g_assert_true (qof_instance_get_dirty_flag (QOF_INSTANCE (txns[2])));
+    g_assert_true (sql_be->commit_pending ());
+    g_assert_false (qof_instance_get_dirty_flag (QOF_INSTANCE (txns[2])));
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    {
+        auto session_r = qof_session_new (qof_book_new ());
+        qof_session_begin (session_r, url, SESSION_READ_ONLY);
+        g_assert_cmpint (qof_session_get_error (session_r), == , ERR_BACKEND_NO_ERR);
+        qof_session_load (session_r, NULL);
+        auto trans_r = xaccTransLookup (qof_instance_get_guid (txns[2]),
+                                        qof_session_get_book (session_r));
+        g_assert_nonnull (trans_r);
+        g_assert_cmpstr (xaccTransGetDescription (trans_r), == ,
+                         "Edited after writing");
+        qof_session_end (session_r);
+        qof_session_destroy (session_r);
+    }
+
+    /* Without a main loop there's nothing to write the queue later. */
+    xaccTransBeginEdit (txns[2]);
+    xaccTransSetDescription (txns[2], "Edited without a main loop");
+    xaccTransCommitEdit (txns[2]);
+    g_assert_false (qof_instance_get_dirty_flag (QOF_INSTANCE (txns[2])));
+
+    auto book3{qof_book_new()};
+    auto session_3 = qof_session_new (book3);
+    qof_session_begin (session_3, url, SESSION_READ_ONLY);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    qof_session_load (session_3, NULL);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    book3 = qof_session_get_book (session_3);
+    compare_books (book2, book3);
+
+    qof_session_end (session_2);
+    qof_session_destroy (session_2);
+    qof_session_end (session_3);
+    qof_session_destroy (session_3);
+}
+
+/* Not run by default: run with -m perf to compare committing 10000
+ * transactions each in a database transaction of its own and queued. */
+static void
+test_dbi_commit_perf (Fixture* fixture, gconstpointer pData)
+{
+    const gchar* url = (const gchar*)pData;
+    auto msg = "[GncDbiSqlConnection::unlock_database()] There was no lock entry in the Lock table";
+    auto log_domain = nullptr;
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    if (fixture->filename)
+        url = fixture->filename;
+
+    for (auto delay : {-1, 60000})
+    {
+        auto session_2 = qof_session_new (qof_book_new ());
+        qof_session_begin (session_2, url, SESSION_NEW_OVERWRITE);
+        g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+        auto book = qof_session_get_book (session_2);
+        qof_book_mark_session_dirty (book);
+        qof_session_save (session_2, NULL);
+        auto sql_be = dynamic_cast<GncSqlBackend*> (qof_book_get_backend (book));
+        g_assert_nonnull (sql_be);
+        sql_be->set_commit_delay (delay);
+
+        auto table = gnc_commodity_table_get_table (book);
+        auto currency = gnc_commodity_table_lookup (table,
+                                                    GNC_COMMODITY_NS_CURRENCY,
+                                                    "USD");
+        auto account = add_account (book, currency);
+        auto timer = g_timer_new ();
+        run_in_main_loop ([&]()
+        {
+            for (auto i = 0; i < 10000; ++i)
+                add_transaction (book, account, currency, i + 1);
+        });
+        g_assert_true (sql_be->commit_pending ());
+        auto elapsed = g_timer_elapsed (timer, NULL);
+        g_timer_destroy (timer);
+        g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+        g_test_message ("Commit delay %d: %.2fs", delay, elapsed);
+
+        qof_session_end (session_2);
+        qof_session_destroy (session_2);
+    }
+}
+
+/* Copy an sqlite3 file without loading it, straight from the backend and
+ * through qof_session_copy_to, and the long way when that can't be done.
+ * The source is kept locked the while: the copies mustn't be. */
+static void
+test_dbi_copy_to (Fixture* fixture, gconstpointer pData)
+{
+    auto msg = "[GncDbiSqlConnection::unlock_database()] There was no lock entry in the Lock table";
+    auto log_domain = nullptr;
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    g_assert_nonnull (fixture->filename);
+    auto url = fixture->filename;
+
+    auto session_1 = qof_session_new (qof_book_new ());
+    qof_session_begin (session_1, url, SESSION_NEW_OVERWRITE);
+    g_assert_cmpint (qof_session_get_error (session_1), == , ERR_BACKEND_NO_ERR);
+    qof_session_swap_data (fixture->session, session_1);
+    qof_book_mark_session_dirty (qof_session_get_book (session_1));
+    qof_session_save (session_1, NULL);
+    g_assert_cmpint (qof_session_get_error (session_1), == , ERR_BACKEND_NO_ERR);
+
+    auto session_2 = qof_session_new (qof_book_new ());
+    qof_session_begin (session_2, url, SESSION_READ_ONLY);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+
+    auto copy_path = [url](const char* suffix)
+    {
+        return std::string{url} + suffix;
+    };
+    auto check_copy = [session_1](const std::string& path)
+    {
+        auto session = qof_session_new (qof_book_new ());
+        qof_session_begin (session, path.c_str (), SESSION_NORMAL_OPEN);
+        g_assert_cmpint (qof_session_get_error (session), == , ERR_BACKEND_NO_ERR);
+        qof_session_load (session, NULL);
+        g_assert_cmpint (qof_session_get_error (session), == , ERR_BACKEND_NO_ERR);
+        compare_books (qof_session_get_book (session_1),
+                       qof_session_get_book (session));
+        qof_session_end (session);
+        qof_session_destroy (session);
+        g_unlink (path.c_str ());
+    };
+
+    auto backend_copy = copy_path ("-backend");
+    auto be = qof_book_get_backend (qof_session_get_book (session_2));
+    g_assert_true (be->copy_to (("sqlite3://" + backend_copy).c_str ()));
+    check_copy (backend_copy);
+
+    auto session_copy = copy_path ("-session");
+    g_assert_true (qof_session_copy_to (session_2,
+                                        ("sqlite3://" + session_copy).c_str ()));
+    check_copy (session_copy);
+
+    /* A copy that can't be made leaves nothing behind, and the data is
+     * loaded and saved instead. */
+    auto bad_copy = copy_path ("-missing/copy");
+    g_assert_false (qof_session_copy_to (session_2,
+                                         ("sqlite3://" + bad_copy).c_str ()));
+    g_assert_false (g_file_test (bad_copy.c_str (), G_FILE_TEST_EXISTS));
+    g_assert_false (g_file_test ((bad_copy + ".tmp").c_str (), G_FILE_TEST_EXISTS));
+
+    auto saved_copy = copy_path ("-saved");
+    qof_session_load (session_2, NULL);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    auto session_3 = qof_session_new (nullptr);
+    qof_session_begin (session_3, saved_copy.c_str (), SESSION_NEW_OVERWRITE);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    qof_session_swap_data (session_2, session_3);
+    qof_book_mark_session_dirty (qof_session_get_book (session_3));
+    qof_session_save (session_3, NULL);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    qof_session_end (session_3);
+    qof_session_destroy (session_3);
+    check_copy (saved_copy);
+
+    qof_session_end (session_2);
+    qof_session_destroy (session_2);
+    qof_session_end (session_1);
+    qof_session_destroy (session_1);
+}
+
 /** Test the safe_save mechanism.  Beware that this test used on its
  * own doesn't ensure that the resave is done safely, only that the
  * database is intact and unchanged after the save. To observe the
@@ -640,6 +1288,22 @@ create_dbi_test_suite (const char* dbm_name, const char* url)
     auto subsuite = g_strdup_printf ("%s/%s", suitename, dbm_name);
     GNC_TEST_ADD (subsuite, "store_and_reload", Fixture, url, setup,
                   test_dbi_store_and_reload, teardown);
+    GNC_TEST_ADD (subsuite, "lazy_load", Fixture, url, setup,
+                  test_dbi_lazy_load, teardown);
+    if (g_test_perf ())
+        GNC_TEST_ADD (subsuite, "save_as_perf", Fixture, url, setup_benchmark,
+                      test_dbi_save_as_perf, teardown);
+    if (g_test_perf ())
+        GNC_TEST_ADD (subsuite, "load_perf", Fixture, url, setup_benchmark,
+                      test_dbi_load_perf, teardown);
+    GNC_TEST_ADD (subsuite, "write_behind", Fixture, url, setup,
+                  test_dbi_write_behind, teardown);
+    if (g_test_perf ())
+        GNC_TEST_ADD (subsuite, "commit_perf", Fixture, url, setup_memory,
+                      test_dbi_commit_perf, teardown);
+    if (g_strcmp0 (url, "sqlite3") == 0)
+        GNC_TEST_ADD (subsuite, "copy_to", Fixture, url, setup,
+                      test_dbi_copy_to, teardown);
     GNC_TEST_ADD (subsuite, "safe_save", Fixture, url, setup_memory,
                   test_dbi_safe_save, teardown);
     GNC_TEST_ADD (subsuite, "version_control", Fixture, url, setup_memory,
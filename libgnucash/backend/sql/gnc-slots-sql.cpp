@@ -40,6 +40,8 @@
 #include <string>
 #include <sstream>
 #include <cstdint>
+#include <map>
+#include <optional>
 
 #include "gnc-sql-connection.hpp"
 #include "gnc-sql-backend.hpp"
@@ -58,7 +60,8 @@ typedef enum
 {
     NONE,
     FRAME,
-    LIST
+    LIST,
+    VALUE
 } context_t;
 
 struct slot_info_t
@@ -97,7 +100,6 @@ static void set_numeric_val (gpointer pObject, gnc_numeric value);
 static GDate* get_gdate_val (gpointer pObject);
 static void set_gdate_val (gpointer pObject, GDate* value);
 static slot_info_t* slot_info_copy (slot_info_t* pInfo, GncGUID* guid);
-static void slots_load_info (slot_info_t* pInfo);
 
 #define SLOT_MAX_PATHNAME_LEN 4096
 #define SLOT_MAX_STRINGVAL_LEN 4096
@@ -213,6 +215,11 @@ set_slot_from_value (slot_info_t* pInfo, KvpValue* pValue)
         pInfo->pList = g_list_append (pInfo->pList, pValue);
         break;
     }
+    case VALUE:
+    {
+        pInfo->pKvpValue = pValue;
+        break;
+    }
     case NONE:
     default:
     {
@@ -426,60 +433,10 @@ set_guid_val (gpointer pObject,  gpointer pValue)
     g_return_if_fail (pObject != NULL);
     if (pValue == NULL) return;
 
-    switch (pInfo->value_type)
-    {
-    case KvpValue::Type::GUID:
-    {
-        auto new_guid = guid_copy (static_cast<GncGUID*> (pValue));
-        set_slot_from_value (pInfo, new KvpValue {new_guid});
-        break;
-    }
-    case KvpValue::Type::GLIST:
-    {
-        slot_info_t* newInfo = slot_info_copy (pInfo, (GncGUID*)pValue);
-        KvpValue* pValue = NULL;
-        auto key = get_key (pInfo);
-
-        newInfo->context = LIST;
-
-        slots_load_info (newInfo);
-        pValue = new KvpValue {newInfo->pList};
-        pInfo->pKvpFrame->set ({key.c_str()}, pValue);
-	delete newInfo;
-        break;
-    }
-    case KvpValue::Type::FRAME:
-    {
-        slot_info_t* newInfo = slot_info_copy (pInfo, (GncGUID*)pValue) ;
-        auto newFrame = new KvpFrame;
-        newInfo->pKvpFrame = newFrame;
-
-        switch (pInfo->context)
-        {
-        case LIST:
-        {
-            auto value = new KvpValue {newFrame};
-            newInfo->path = get_key (pInfo);
-            pInfo->pList = g_list_append (pInfo->pList, value);
-            break;
-        }
-        case FRAME:
-        default:
-        {
-            auto key = get_key (pInfo);
-            pInfo->pKvpFrame->set ({key.c_str()}, new KvpValue {newFrame});
-            break;
-        }
-        }
-
-        newInfo->context = FRAME;
-        slots_load_info (newInfo);
-        delete newInfo;
-        break;
-    }
-    default:
-        break;
-    }
+    /* FRAME and GLIST slots are put together by load_slot. */
+    if (pInfo->value_type != KvpValue::Type::GUID) return;
+    auto new_guid = guid_copy (static_cast<GncGUID*> (pValue));
+    set_slot_from_value (pInfo, new KvpValue {new_guid});
 }
 
 static gnc_numeric
@@ -679,10 +636,9 @@ gnc_sql_slots_delete (GncSqlBackend* sql_be, const GncGUID* guid)
         {
             const GncSqlColumnTableEntryPtr table_row =
                     col_table[guid_val_col];
-            GncGUID child_guid;
-            auto val = row.get_string_at_col (table_row->name());
-            if (val && string_to_guid (val->c_str(), &child_guid))
-                gnc_sql_slots_delete (sql_be, &child_guid);
+            auto child_guid = row.get_guid_at_col (table_row->name());
+            if (child_guid)
+                gnc_sql_slots_delete (sql_be, &*child_guid);
         }
     }
 
@@ -696,104 +652,208 @@ gnc_sql_slots_delete (GncSqlBackend* sql_be, const GncGUID* guid)
     return slot_info.is_ok;
 }
 
-static void
-load_slot (slot_info_t* pInfo, GncSqlRow& row)
+/* The numeric_val column is stored as these two. */
+static const char* numeric_num_col_name = "numeric_val_num";
+static const char* numeric_denom_col_name = "numeric_val_denom";
+
+/* Where the slots stored under one obj_guid go: the frame of an object or of
+ * a FRAME slot, or the list of a GLIST slot. */
+struct SlotContainer
 {
-    slot_info_t* slot_info;
+    KvpFrame* frame;
+    KvpValue* list;
+    /* Slot names start with their parent slot's name and a '/'. */
+    std::string parent_path;
+};
 
-    g_return_if_fail (pInfo != NULL);
-    g_return_if_fail (pInfo->be != NULL);
-    g_return_if_fail (pInfo->pKvpFrame != NULL);
+struct GuidLess
+{
+    bool operator() (const GncGUID& a, const GncGUID& b) const noexcept
+    {
+        return guid_compare (&a, &b) < 0;
+    }
+};
+
+/* The containers of the FRAME and GLIST slots of one level, by the guid their
+ * own slots are stored under. */
+using SlotContainerMap = std::map<GncGUID, SlotContainer, GuidLess>;
+
+static KvpValue*
+load_slot_value (GncSqlBackend* sql_be, GncSqlRow& row, KvpValue::Type type)
+{
+    int col;
+
+    switch (type)
+    {
+    case KvpValue::Type::GUID:
+    {
+        auto guid = row.get_guid_at_col (col_table[guid_val_col]->name());
+        return guid ? new KvpValue {guid_copy (&*guid)} : nullptr;
+    }
+    case KvpValue::Type::NUMERIC:
+    {
+        auto num = row.get_int_at_col (numeric_num_col_name);
+        auto denom = row.get_int_at_col (numeric_denom_col_name);
+        if (!num || !denom)
+            return nullptr;
+        return new KvpValue {gnc_numeric_create (*num, *denom)};
+    }
+    case KvpValue::Type::INT64:
+        col = int64_val_col;
+        break;
+    case KvpValue::Type::STRING:
+        col = string_val_col;
+        break;
+    case KvpValue::Type::DOUBLE:
+        col = double_val_col;
+        break;
+    case KvpValue::Type::TIME64:
+        col = time_val_col;
+        break;
+    case KvpValue::Type::GDATE:
+        col = gdate_val_col;
+        break;
+    default:
+        return nullptr;
+    }
 
-    slot_info = slot_info_copy (pInfo, NULL);
+    /* Only the one column the value is in needs reading. */
+    slot_info_t slot_info = { sql_be, NULL, TRUE, NULL, type,
+                              NULL, VALUE, NULL, "" };
+    col_table[col]->load (sql_be, row, TABLE_NAME, &slot_info);
+    return slot_info.pKvpValue;
+}
 
-    gnc_sql_load_object (pInfo->be, row, TABLE_NAME, slot_info, col_table);
+static void
+load_slot (GncSqlBackend* sql_be, GncSqlRow& row, SlotContainer& container,
+           SlotContainerMap& children)
+{
+    auto name = row.get_string_at_col (col_table[name_col]->name());
+    auto slot_type = row.get_int_at_col (col_table[slot_type_col]->name());
+    if (!name || !slot_type)
+        return;
 
-    if (slot_info->pList != pInfo->pList)
+    auto type = static_cast<KvpValue::Type> (*slot_type);
+    KvpValue* value = nullptr;
+    if (type == KvpValue::Type::FRAME || type == KvpValue::Type::GLIST)
     {
-        if (pInfo->pList != NULL)
+        auto guid = row.get_guid_at_col (col_table[guid_val_col]->name());
+        if (!guid)
+            return;
+        SlotContainer child {nullptr, nullptr, *name + "/"};
+        if (type == KvpValue::Type::FRAME)
         {
-            PWARN ("Load slot returned a different list than the original");
+            child.frame = new KvpFrame;
+            value = new KvpValue {child.frame};
         }
         else
         {
-            pInfo->pList = slot_info->pList;
+            value = new KvpValue {static_cast<GList*> (nullptr)};
+            child.list = value;
         }
+        children.emplace (*guid, std::move (child));
+    }
+    else
+    {
+        value = load_slot_value (sql_be, row, type);
+        if (!value)
+            return;
     }
-    delete slot_info;
-}
-
-void
-gnc_sql_slots_load (GncSqlBackend* sql_be, QofInstance* inst)
-{
-    slot_info_t info = { NULL, NULL, TRUE, NULL, KvpValue::Type::INVALID,
-                         NULL, FRAME, NULL, "" };
-    g_return_if_fail (sql_be != NULL);
-    g_return_if_fail (inst != NULL);
-
-    info.be = sql_be;
-    info.guid = qof_instance_get_guid (inst);
-    info.pKvpFrame = qof_instance_get_slots (inst);
-    info.context = NONE;
 
-    slots_load_info (&info);
+    if (container.list)
+    {
+        auto list = container.list->get<GList*> ();
+        container.list->set (g_list_append (list, value));
+        return;
+    }
+    auto& parent_path = container.parent_path;
+    if (name->compare (0, parent_path.size(), parent_path) == 0)
+        name->erase (0, parent_path.size());
+    delete container.frame->set ({*name}, value);
 }
 
-static void
-slots_load_info (slot_info_t* pInfo)
+/* Load the slots stored under the guids the guid_sql selects, in one query.
+ * The rows come sorted by obj_guid so that container_for is asked once for
+ * each guid; slots of the guids it returns nullptr for are dropped.  The
+ * containers for the FRAME and GLIST slots found are put in children. */
+template <typename ContainerFn> static void
+load_slot_level (GncSqlBackend* sql_be, const std::string& guid_sql,
+                 ContainerFn container_for, SlotContainerMap& children)
 {
-    g_return_if_fail (pInfo != NULL);
-    g_return_if_fail (pInfo->be != NULL);
-    g_return_if_fail (pInfo->guid != NULL);
-    g_return_if_fail (pInfo->pKvpFrame != NULL);
-
-    gnc::GUID guid(*pInfo->guid);
-    std::string sql("SELECT * FROM " TABLE_NAME " WHERE obj_guid='");
-    sql += guid.to_string() + "'";
-    auto stmt = pInfo->be->create_statement_from_sql(sql);
-    if (stmt != nullptr)
+    std::string sql("SELECT * FROM " TABLE_NAME " WHERE ");
+    sql += std::string{obj_guid_col_table[0]->name()} + " IN (" + guid_sql +
+        ") ORDER BY " + obj_guid_col_table[0]->name() + ", " +
+        col_table[id_col]->name();
+    auto stmt = sql_be->create_statement_from_sql(sql);
+    if (stmt == nullptr)
     {
-        auto result = pInfo->be->execute_select_statement (stmt);
-        for (auto row : *result)
-            load_slot (pInfo, row);
-        delete result;
+        PERR ("stmt == NULL, SQL = '%s'\n", sql.c_str());
+        return;
+    }
+
+    auto result = sql_be->execute_select_statement(stmt);
+    std::optional<GncGUID> current;
+    SlotContainer* container = nullptr;
+    for (auto row : *result)
+    {
+        auto guid = row.get_guid_at_col (obj_guid_col_table[0]->name());
+        if (!guid)
+            continue;
+        if (!current || !guid_equal (&*guid, &*current))
+        {
+            current = guid;
+            container = container_for (*guid);
+        }
+        if (container)
+            load_slot (sql_be, row, *container, children);
     }
+    delete result;
 }
 
-static  const GncGUID*
-load_obj_guid (const GncSqlBackend* sql_be, GncSqlRow& row)
+/* Load the slots of the objects whose guids the guid_sql selects, a level of
+ * nested frames and lists at a time, rather than a query for each of them. */
+template <typename ContainerFn> static void
+load_slots (GncSqlBackend* sql_be, const std::string& guid_sql,
+            ContainerFn container_for)
 {
-    static GncGUID guid;
-
-    g_return_val_if_fail (sql_be != NULL, NULL);
-
-    gnc_sql_load_object (sql_be, row, NULL, &guid, obj_guid_col_table);
+    SlotContainerMap pending;
+    load_slot_level (sql_be, guid_sql, container_for, pending);
 
-    return &guid;
+    auto level_sql = guid_sql;
+    while (!pending.empty())
+    {
+        level_sql = std::string{"SELECT "} + col_table[guid_val_col]->name() +
+            " FROM " TABLE_NAME " WHERE " + obj_guid_col_table[0]->name() +
+            " IN (" + level_sql + ") AND " + col_table[slot_type_col]->name() +
+            " IN (" +
+            std::to_string (static_cast<int> (KvpValue::Type::FRAME)) + ", " +
+            std::to_string (static_cast<int> (KvpValue::Type::GLIST)) + ")";
+        SlotContainerMap children;
+        load_slot_level (sql_be, level_sql,
+                         [&pending](const GncGUID& guid) -> SlotContainer*
+                         {
+                             auto spot = pending.find (guid);
+                             if (spot == pending.end())
+                                 return nullptr;
+                             return &spot->second;
+                         }, children);
+        pending = std::move (children);
+    }
 }
 
-static void
-load_slot_for_book_object (GncSqlBackend* sql_be, GncSqlRow& row,
-                           BookLookupFn lookup_fn)
+void
+gnc_sql_slots_load (GncSqlBackend* sql_be, QofInstance* inst)
 {
-    slot_info_t slot_info = { NULL, NULL, TRUE, NULL, KvpValue::Type::INVALID,
-                              NULL, FRAME, NULL, "" };
-    const GncGUID* guid;
-    QofInstance* inst;
-
     g_return_if_fail (sql_be != NULL);
-    g_return_if_fail (lookup_fn != NULL);
-
-    guid = load_obj_guid (sql_be, row);
-    g_return_if_fail (guid != NULL);
-    inst = lookup_fn (guid, sql_be->book());
-    if (inst == NULL) return; /* Silently bail if the guid isn't loaded yet. */
-
-    slot_info.be = sql_be;
-    slot_info.pKvpFrame = qof_instance_get_slots (inst);
-    slot_info.path.clear();
+    g_return_if_fail (inst != NULL);
 
-    gnc_sql_load_object (sql_be, row, TABLE_NAME, &slot_info, col_table);
+    auto guid = qof_instance_get_guid (inst);
+    SlotContainer top {qof_instance_get_slots (inst), nullptr, ""};
+    load_slots (sql_be, "'" + gnc::GUID{*guid}.to_string() + "'",
+                [guid, &top](const GncGUID& obj_guid) -> SlotContainer*
+                {
+                    return guid_equal (&obj_guid, guid) ? &top : nullptr;
+                });
 }
 
 /**
@@ -810,25 +870,56 @@ void gnc_sql_slots_load_for_sql_subquery (GncSqlBackend* sql_be,
                                           BookLookupFn lookup_fn)
 {
     g_return_if_fail (sql_be != NULL);
+    g_return_if_fail (lookup_fn != NULL);
 
     // Ignore empty subquery
     if (subquery.empty()) return;
 
-    std::string pkey(obj_guid_col_table[0]->name());
-    std::string sql("SELECT * FROM " TABLE_NAME " WHERE ");
-    sql += pkey + " IN (" + subquery + ")";
+    /* Each object is looked up once, for the run of its rows. */
+    SlotContainer top {nullptr, nullptr, ""};
+    load_slots (sql_be, subquery,
+                [sql_be, lookup_fn, &top](const GncGUID& guid) -> SlotContainer*
+                {
+                    auto inst = lookup_fn (&guid, sql_be->book());
+                    if (inst == NULL)
+                        return nullptr; /* Silently bail if the guid isn't loaded yet. */
+                    top.frame = qof_instance_get_slots (inst);
+                    return &top;
+                });
+}
 
-    // Execute the query and load the slots
-    auto stmt = sql_be->create_statement_from_sql(sql);
-    if (stmt == nullptr)
-    {
-        PERR ("stmt == NULL, SQL = '%s'\n", sql.c_str());
-        return;
-    }
-    auto result = sql_be->execute_select_statement(stmt);
-    for (auto row : *result)
-        load_slot_for_book_object (sql_be, row, lookup_fn);
-    delete result;
+/**
+ * Loads slots for the instances whose guid is supplied by a subquery, as
+ * gnc_sql_slots_load_for_sql_subquery does, but only into those in instances:
+ * objects the subquery selects that were already loaded keep their frames.
+ *
+ * @param sql_be SQL backend
+ * @param subquery Subquery SQL string
+ * @param instances The instances to load the slots of
+ */
+void gnc_sql_slots_load_for_sql_subquery (GncSqlBackend* sql_be,
+                                          const std::string subquery,
+                                          const std::vector<QofInstance*>& instances)
+{
+    g_return_if_fail (sql_be != NULL);
+
+    if (subquery.empty() || instances.empty()) return;
+
+    std::map<GncGUID, KvpFrame*, GuidLess> frames;
+    for (auto inst : instances)
+        frames.emplace (*qof_instance_get_guid (inst),
+                        qof_instance_get_slots (inst));
+
+    SlotContainer top {nullptr, nullptr, ""};
+    load_slots (sql_be, subquery,
+                [&frames, &top](const GncGUID& guid) -> SlotContainer*
+                {
+                    auto spot = frames.find (guid);
+                    if (spot == frames.end())
+                        return nullptr;
+                    top.frame = spot->second;
+                    return &top;
+                });
 }
 
 /* ================================================================= */
@@ -90,6 +90,19 @@ void gnc_sql_slots_load_for_sql_subquery (GncSqlBackend* sql_be,
                                           const std::string subquery,
                                           BookLookupFn lookup_fn);
 
+/**
+ * Loads slots for the objects whose guid is supplied by a subquery, as above,
+ * but only into the given instances; the others the subquery selects are left
+ * alone.
+ *
+ * @param sql_be SQL backend
+ * @param subquery Subquery SQL string
+ * @param instances The instances to load the slots of
+ */
+void gnc_sql_slots_load_for_sql_subquery (GncSqlBackend* sql_be,
+                                          const std::string subquery,
+                                          const std::vector<QofInstance*>& instances);
+
 void gnc_sql_init_slots_handler (void);
 
 #endif /* GNC_SLOTS_SQL_H */
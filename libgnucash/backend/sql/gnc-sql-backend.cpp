@@ -78,9 +78,43 @@ static EntryVec version_table
     gnc_sql_make_table_entry<CT_INT>(VERSION_COL_NAME, 0, COL_NNUL)
 };
 
+static bool
+lazy_load_default () noexcept
+{
+    auto env = g_getenv ("GNC_SQL_LAZY_LOAD");
+    return env && g_ascii_strtoll (env, nullptr, 10) > 0;
+}
+
+/* SQLite 3.8.7 and older limit a VALUES list to 500 rows. */
+static const unsigned DEFAULT_INSERT_BATCH_SIZE = 100;
+/* Stay well below SQLite's default limit on the length of a statement and
+ * MySQL's on the size of a packet. */
+static const size_t MAX_INSERT_SQL_SIZE = 500000;
+
+static unsigned
+insert_batch_size_default () noexcept
+{
+    auto env = g_getenv ("GNC_SQL_INSERT_BATCH");
+    auto size = env ? g_ascii_strtoll (env, nullptr, 10) : 0;
+    return size > 0 ? size : DEFAULT_INSERT_BATCH_SIZE;
+}
+
+static int
+commit_delay_default () noexcept
+{
+    auto env = g_getenv ("GNC_SQL_COMMIT_DELAY");
+    if (!env || !*env)
+        return -1;
+    auto delay = g_ascii_strtoll (env, nullptr, 10);
+    return delay < 0 ? -1 : static_cast<int> (MIN (delay, G_MAXINT));
+}
+
 GncSqlBackend::GncSqlBackend(GncSqlConnection *conn, QofBook* book) :
     QofBackend {}, m_conn{conn}, m_book{book}, m_loading{false},
-    m_in_query{false}, m_is_pristine_db{false}
+    m_in_query{false}, m_is_pristine_db{false},
+    m_lazy_load{lazy_load_default ()},
+    m_insert_batch_size{insert_batch_size_default ()},
+    m_commit_delay{commit_delay_default ()}
 {
     if (conn != nullptr)
         connect (conn);
@@ -89,13 +123,24 @@ GncSqlBackend::GncSqlBackend(GncSqlConnection *conn, QofBook* book) :
 GncSqlBackend::~GncSqlBackend()
 {
     connect(nullptr);
+    if (m_commit_source)
+        g_source_remove (m_commit_source);
 }
 
 void
 GncSqlBackend::connect(GncSqlConnection *conn) noexcept
 {
     if (m_conn != nullptr && m_conn != conn)
+    {
+        /* Whatever can't be written now is lost with the connection; the
+         * objects stay dirty and the book is marked so. */
+        commit_pending();
+        if (!m_pending_commits.empty())
+            qof_book_mark_session_dirty (m_book);
+        m_pending_commits.clear();
+        m_pending_instances.clear();
         delete m_conn;
+    }
     finalize_version_info();
     m_conn = conn;
 }
@@ -115,6 +160,8 @@ GncSqlBackend::create_statement_from_sql(const std::string& str) const noexcept
 GncSqlResultPtr
 GncSqlBackend::execute_select_statement(const GncSqlStatementPtr& stmt) const noexcept
 {
+    if (!flush_inserts())
+        return nullptr;
     auto result = m_conn ? m_conn->execute_select_statement(stmt) : nullptr;
     if (result == nullptr)
     {
@@ -127,6 +174,8 @@ GncSqlBackend::execute_select_statement(const GncSqlStatementPtr& stmt) const no
 int
 GncSqlBackend::execute_nonselect_statement(const GncSqlStatementPtr& stmt) const noexcept
 {
+    if (!flush_inserts())
+        return -1;
     int result = m_conn ? m_conn->execute_nonselect_statement(stmt) : -1;
     if (result == -1)
     {
@@ -303,6 +352,9 @@ GncSqlBackend::load (QofBook* book, QofBackendLoadType loadType)
         for (const auto& type : fixed_load_order)
         {
             num_done++;
+            /* Lazily loaded transactions wait until they're asked for. */
+            if (m_lazy_load && type == GNC_ID_TRANS)
+                continue;
             auto obe = m_backend_registry.get_object_backend(type);
             if (obe)
             {
@@ -329,12 +381,19 @@ GncSqlBackend::load (QofBook* book, QofBackendLoadType loadType)
 
         gnc_account_foreach_descendant(root, (AccountCb)xaccAccountCommitEdit,
                                        nullptr);
+
+        if (m_lazy_load)
+        {
+            gnc_sql_transaction_load_balances (this);
+            m_lazy_pending = true;
+        }
     }
     else if (loadType == LOAD_TYPE_LOAD_ALL)
     {
         // Load all transactions
         auto obe = m_backend_registry.get_object_backend (GNC_ID_TRANS);
         obe->load_all (this);
+        m_lazy_pending = false;
     }
 
     m_loading = FALSE;
@@ -362,6 +421,38 @@ GncSqlBackend::load (QofBook* book, QofBackendLoadType loadType)
     LEAVE ("");
 }
 
+void
+GncSqlBackend::load_splits (QofInstance* inst, time64 since)
+{
+    g_return_if_fail (GNC_IS_ACCOUNT (inst));
+
+    if (!m_lazy_pending || m_loading)
+        return;
+
+    /* Transactions already loaded would be read back over their edits. */
+    commit_pending();
+    gnc_sql_transaction_load_tx_since (this, {{GNC_ACCOUNT (inst), since}});
+}
+
+void
+GncSqlBackend::load_for_query (QofQuery* query)
+{
+    g_return_if_fail (query != nullptr);
+
+    if (!m_lazy_pending || m_loading)
+        return;
+
+    commit_pending();
+    auto search_for = qof_query_get_search_for (query);
+    AccountDateVec accounts;
+    if (g_strcmp0 (search_for, GNC_ID_SPLIT) == 0 &&
+        gnc_sql_transaction_query_accounts (m_book, query, accounts))
+        gnc_sql_transaction_load_tx_since (this, accounts);
+    else if (g_strcmp0 (search_for, GNC_ID_SPLIT) == 0 ||
+             g_strcmp0 (search_for, GNC_ID_TRANS) == 0)
+        load (m_book, LOAD_TYPE_LOAD_ALL);
+}
+
 /* ================================================================= */
 
 bool
@@ -477,6 +568,13 @@ GncSqlBackend::sync(QofBook* book)
     g_return_if_fail (book != NULL);
     g_return_if_fail (m_conn != nullptr);
 
+    commit_pending();
+
+    /* Everything is about to be written out again, so it all has to be
+     * loaded first. */
+    if (m_lazy_pending && book == m_book)
+        load (book, LOAD_TYPE_LOAD_ALL);
+
     reset_version_info();
     ENTER ("book=%p, sql_be->book=%p", book, m_book);
     update_progress(101.0);
@@ -488,6 +586,7 @@ GncSqlBackend::sync(QofBook* book)
     /* Save all contents */
     m_book = book;
     auto is_ok = m_conn->begin_transaction();
+    m_batch_inserts = true;
 
     // FIXME: should write the set of commodities that are used
     // write_commodities(sql_be, book);
@@ -517,9 +616,10 @@ GncSqlBackend::sync(QofBook* book)
         for (auto entry : m_backend_registry)
             std::get<1>(entry)->write (this);
     }
+    m_batch_inserts = false;
     if (is_ok)
     {
-        is_ok = m_conn->commit_transaction();
+        is_ok = flush_inserts() && m_conn->commit_transaction();
     }
     if (is_ok)
     {
@@ -532,6 +632,7 @@ GncSqlBackend::sync(QofBook* book)
     }
     else
     {
+        m_insert_batches.clear();
         set_error (ERR_BACKEND_SERVER_ERR);
         m_conn->rollback_transaction ();
     }
@@ -554,10 +655,12 @@ GncSqlBackend::begin(QofInstance* inst)
 void
 GncSqlBackend::rollback(QofInstance* inst)
 {
-    //g_return_if_fail (inst != NULL);
+    g_return_if_fail (inst != NULL);
 
-    //ENTER (" ");
-    //LEAVE ("");
+    /* A waiting object is back as it was queued and can be written, and
+     * nothing else will set the queue going again. */
+    if (m_pending_instances.count (inst))
+        queue_commit (inst);
 }
 
 void
@@ -624,22 +727,10 @@ GncSqlBackend::commit (QofInstance* inst)
         return;
     }
 
-    if (!m_conn->begin_transaction ())
-    {
-        PERR ("begin_transaction failed\n");
-        LEAVE ("Rolled back - database transaction begin error");
-        return;
-    }
-
-    bool is_ok = true;
-
     auto obe = m_backend_registry.get_object_backend(std::string{inst->e_type});
-    if (obe != nullptr)
-        is_ok = obe->commit(this, inst);
-    else
+    if (obe == nullptr)
     {
         PERR ("Unknown object type '%s'\n", inst->e_type);
-        (void)m_conn->rollback_transaction ();
 
         // Don't let unknown items still mark the book as being dirty
         qof_book_mark_session_saved(m_book);
@@ -647,10 +738,42 @@ GncSqlBackend::commit (QofInstance* inst)
         LEAVE ("Rolled back - unknown object type");
         return;
     }
+
+    /* An object being destroyed is freed as soon as this returns, so it
+     * can't wait.  Nor can anything when there's no main loop running to
+     * write the queue later: the end of the outermost edit is all there
+     * is. */
+    if (m_commit_delay >= 0 && !is_destroying && g_main_depth () > 0)
+    {
+        queue_commit (inst);
+        LEAVE ("Queued");
+        return;
+    }
+
+    if (!m_conn->begin_transaction ())
+    {
+        PERR ("begin_transaction failed\n");
+        LEAVE ("Rolled back - database transaction begin error");
+        return;
+    }
+
+    /* Whatever is waiting goes in the same database transaction, without
+     * the object itself if it's waiting: its rows are about to go. */
+    if (m_pending_instances.erase (inst))
+        m_pending_commits.erase (std::find_if (m_pending_commits.begin(),
+                                               m_pending_commits.end(),
+                                               [inst](const auto& pending)
+                                               {
+                                                   return pending.first == inst;
+                                               }));
+    bool is_ok = write_pending_commits();
+    if (is_ok)
+        is_ok = obe->commit(this, inst);
     if (!is_ok)
     {
-        // Error - roll it back
+        // Error - roll it back, leaving whatever was waiting queued
         (void)m_conn->rollback_transaction();
+        finish_pending_commits (false);
 
         // This *should* leave things marked dirty
         LEAVE ("Rolled back - database error");
@@ -658,13 +781,177 @@ GncSqlBackend::commit (QofInstance* inst)
     }
 
     (void)m_conn->commit_transaction ();
+    finish_pending_commits (true);
 
-    qof_book_mark_session_saved(m_book);
+    if (m_pending_commits.empty())
+        qof_book_mark_session_saved(m_book);
     qof_instance_mark_clean (inst);
 
     LEAVE ("");
 }
 
+void
+GncSqlBackend::set_commit_delay(int delay) noexcept
+{
+    m_commit_delay = delay < 0 ? -1 : delay;
+    if (m_commit_delay < 0)
+        commit_pending();
+}
+
+void
+GncSqlBackend::queue_commit (QofInstance* inst) noexcept
+{
+    if (m_pending_instances.insert (inst).second)
+    {
+        std::string type{inst->e_type};
+        auto entry = std::find_if (m_backend_registry.begin(),
+                                   m_backend_registry.end(),
+                                   [&type](const OBEEntry& entry)
+                                   {
+                                       return type == std::get<0>(entry);
+                                   });
+        m_pending_commits.emplace_back (inst, entry - m_backend_registry.begin());
+    }
+
+    if (m_commit_source)
+        g_source_remove (m_commit_source);
+    /* Restarted with each commit, so that it only runs once a whole batch
+     * of edits is done. */
+    if (m_commit_delay > 0)
+        m_commit_source = g_timeout_add (m_commit_delay, commit_pending_cb,
+                                         this);
+    else
+        m_commit_source = g_idle_add (commit_pending_cb, this);
+}
+
+gboolean
+GncSqlBackend::commit_pending_cb (gpointer data)
+{
+    auto sql_be = static_cast<GncSqlBackend*>(data);
+    sql_be->m_commit_source = 0;
+    sql_be->commit_pending();
+    return G_SOURCE_REMOVE;
+}
+
+/* An object that has been opened for editing again since it was queued is
+ * only half edited: it waits for the end of that edit, which queues it again,
+ * or for its rollback. */
+static bool
+pending_being_edited (QofInstance* inst)
+{
+    if (qof_instance_get_editlevel (inst) > 0)
+        return true;
+    if (GNC_IS_SPLIT (inst))
+    {
+        auto trans = xaccSplitGetParent (GNC_SPLIT (inst));
+        return trans && qof_instance_get_editlevel (QOF_INSTANCE (trans)) > 0;
+    }
+    return false;
+}
+
+bool
+GncSqlBackend::write_pending_commits() noexcept
+{
+    std::stable_sort (m_pending_commits.begin(), m_pending_commits.end(),
+                      [](const auto& a, const auto& b)
+                      {
+                          return a.second < b.second;
+                      });
+    for (const auto& pending : m_pending_commits)
+    {
+        auto inst = pending.first;
+        /* Something else may have saved it in the meantime. */
+        if (!qof_instance_get_dirty_flag (inst) || pending_being_edited (inst))
+            continue;
+        auto obe = m_backend_registry.get_object_backend(std::string{inst->e_type});
+        if (!obe->commit(this, inst))
+        {
+            PERR ("Failed to commit %s\n", inst->e_type);
+            return false;
+        }
+    }
+    return true;
+}
+
+void
+GncSqlBackend::finish_pending_commits(bool is_ok) noexcept
+{
+    if (m_commit_source)
+    {
+        g_source_remove (m_commit_source);
+        m_commit_source = 0;
+    }
+    /* Objects that failed stay queued, so that the next commit, sync or
+     * closing the session tries them again. */
+    if (!is_ok)
+        return;
+    auto written = std::stable_partition (m_pending_commits.begin(),
+                                          m_pending_commits.end(),
+                                          [](const auto& pending)
+                                          {
+                                              return pending_being_edited (pending.first);
+                                          });
+    for (auto it = written; it != m_pending_commits.end(); ++it)
+    {
+        /* qof_commit_edit_part2 would have done this had the object been
+         * written then. */
+        qof_instance_mark_clean (it->first);
+        qof_instance_set_infant (it->first, FALSE);
+        m_pending_instances.erase (it->first);
+    }
+    m_pending_commits.erase (written, m_pending_commits.end());
+}
+
+void
+GncSqlBackend::report_pending_error() noexcept
+{
+    /* The backend error alone would be cleared by the next
+     * qof_commit_edit_part2 before anyone sees it. */
+    set_error (ERR_BACKEND_SERVER_ERR);
+    qof_book_mark_session_dirty (m_book);
+    gnc_engine_signal_commit_error (ERR_BACKEND_SERVER_ERR);
+}
+
+bool
+GncSqlBackend::commit_pending() noexcept
+{
+    if (m_pending_commits.empty())
+        return true;
+    if (m_conn == nullptr)
+    {
+        finish_pending_commits (false);
+        report_pending_error();
+        return false;
+    }
+
+    ENTER ("%zu objects", m_pending_commits.size());
+    if (!m_conn->begin_transaction ())
+    {
+        PERR ("begin_transaction failed\n");
+        finish_pending_commits (false);
+        report_pending_error();
+        LEAVE ("Rolled back - database transaction begin error");
+        return false;
+    }
+
+    if (!write_pending_commits())
+    {
+        (void)m_conn->rollback_transaction();
+        finish_pending_commits (false);
+        report_pending_error();
+        LEAVE ("Rolled back - database error");
+        return false;
+    }
+
+    (void)m_conn->commit_transaction ();
+    finish_pending_commits (true);
+    if (m_pending_commits.empty())
+        qof_book_mark_session_saved(m_book);
+    LEAVE ("");
+    return true;
+}
+
+/* ================================================================= */
 
 /**
  * Sees if the version table exists, and if it does, loads the info into
@@ -867,6 +1154,8 @@ GncSqlBackend::do_db_operation (E_DB_OPERATION op, const char* table_name,
     switch(op)
     {
         case  OP_DB_INSERT:
+        if (m_batch_inserts && m_insert_batch_size > 1)
+            return queue_insert (table_name, obj_name, pObject, table);
         stmt = build_insert_statement (table_name, obj_name, pObject, table);
         break;
         case OP_DB_UPDATE:
@@ -928,6 +1217,90 @@ GncSqlBackend::build_insert_statement (const char* table_name,
     return stmt;
 }
 
+bool
+GncSqlBackend::queue_insert (const char* table_name, QofIdTypeConst obj_name,
+                             gpointer pObject,
+                             const EntryVec& table) const noexcept
+{
+    g_return_val_if_fail (table_name != nullptr, false);
+    g_return_val_if_fail (obj_name != nullptr, false);
+    g_return_val_if_fail (pObject != nullptr, false);
+    PairVec values{get_object_values(obj_name, pObject, table)};
+
+    /* Columns whose value is NULL are left out, so a table can have a batch
+     * for each set of columns that occurs. */
+    auto same_columns = [table_name, &values](const InsertBatch& batch)
+    {
+        return batch.table_name == table_name &&
+            std::equal (batch.columns.begin(), batch.columns.end(),
+                        values.begin(), values.end(),
+                        [](const std::string& column, const auto& col_value)
+                        { return column == col_value.first; });
+    };
+    auto batch = std::find_if (m_insert_batches.begin(),
+                               m_insert_batches.end(), same_columns);
+    if (batch == m_insert_batches.end())
+    {
+        InsertBatch new_batch{table_name, {}, "INSERT INTO ", 0, 0};
+        new_batch.sql += table_name;
+        new_batch.sql += "(";
+        for (auto const& col_value : values)
+        {
+            if (!new_batch.columns.empty())
+                new_batch.sql += ",";
+            new_batch.sql += col_value.first;
+            new_batch.columns.push_back (col_value.first);
+        }
+        new_batch.sql += ") VALUES";
+        new_batch.header_size = new_batch.sql.size();
+        m_insert_batches.push_back (std::move (new_batch));
+        batch = m_insert_batches.end() - 1;
+    }
+
+    auto& sql = batch->sql;
+    sql += batch->rows ? ",(" : "(";
+    auto first = true;
+    for (auto const& col_value : values)
+    {
+        if (!first)
+            sql += ",";
+        first = false;
+        sql += col_value.second;
+    }
+    sql += ")";
+
+    if (++batch->rows < m_insert_batch_size && sql.size() < MAX_INSERT_SQL_SIZE)
+        return true;
+    return flush_inserts();
+}
+
+bool
+GncSqlBackend::flush_inserts() const noexcept
+{
+    bool is_ok = true;
+
+    for (auto& batch : m_insert_batches)
+    {
+        if (!batch.rows)
+            continue;
+        if (is_ok)
+        {
+            auto stmt = create_statement_from_sql (batch.sql);
+            is_ok = stmt != nullptr &&
+                m_conn->execute_nonselect_statement (stmt) != -1;
+            if (!is_ok)
+            {
+                PERR ("SQL error: %s\n", batch.sql.c_str());
+                qof_backend_set_error ((QofBackend*)this,
+                                       ERR_BACKEND_SERVER_ERR);
+            }
+        }
+        batch.sql.resize (batch.header_size);
+        batch.rows = 0;
+    }
+    return is_ok;
+}
+
 GncSqlStatementPtr
 GncSqlBackend::build_update_statement(const gchar* table_name,
                                       QofIdTypeConst obj_name, gpointer pObject,
@@ -30,6 +30,7 @@
 #include <memory>
 #include <exception>
 #include <sstream>
+#include <unordered_set>
 #include <vector>
 #include <qof-backend.hpp>
 
@@ -71,6 +72,22 @@ public:
      * @param book Book to be loaded
      */
     void load(QofBook*, QofBackendLoadType) override;
+    /**
+     * Load the transactions with splits in an account posted on or after a
+     * date.  Only does anything when the initial load was lazy.
+     *
+     * @param inst The account
+     * @param since The earliest posted date to load
+     */
+    void load_splits(QofInstance*, time64) override;
+    /**
+     * Load the transactions a query for splits might match before it's run,
+     * all of them unless the query is restricted to some accounts.  Only
+     * does anything when the initial load was lazy.
+     *
+     * @param query The query about to be run
+     */
+    void load_for_query(QofQuery*) override;
     /**
      * Save the contents of a book to an SQL database.
      *
@@ -234,6 +251,47 @@ public:
     bool save_commodity(gnc_commodity* comm) noexcept;
     QofBook* book() const noexcept { return m_book; }
     void set_loading(bool loading) noexcept { m_loading = loading; }
+    /**
+     * Whether the initial load leaves the transactions in the database to be
+     * loaded as they're needed.  Defaults to true if the environment variable
+     * GNC_SQL_LAZY_LOAD is set to a number greater than zero.
+     */
+    void set_lazy_load(bool lazy) noexcept { m_lazy_load = lazy; }
+    bool lazy_load() const noexcept { return m_lazy_load; }
+    /** Whether there are still transactions that haven't been loaded. */
+    bool lazy_pending() const noexcept { return m_lazy_pending; }
+    /**
+     * Set how many rows sync writes with each INSERT statement.  Defaults to
+     * the environment variable GNC_SQL_INSERT_BATCH if it's set to a number
+     * greater than zero, otherwise to 100.  1 writes a statement per row.
+     */
+    void set_insert_batch_size(unsigned size) noexcept
+    {
+        m_insert_batch_size = size ? size : 1;
+    }
+    unsigned insert_batch_size() const noexcept { return m_insert_batch_size; }
+    /**
+     * Set how long committed objects wait to be written, in milliseconds.
+     * While it's 0 or more, commit queues the objects instead of writing each
+     * in a database transaction of its own.  The queue is written in a single
+     * transaction once the main loop has been idle that long, and before an
+     * object is destroyed, a lazy load, a sync or closing the connection.
+     * Commits made outside of a running main loop, as in gnucash-cli or a
+     * script, aren't queued but written at the end of each outermost edit
+     * together with anything already waiting.
+     * The objects stay dirty until they're written.  Defaults to the
+     * environment variable GNC_SQL_COMMIT_DELAY if it's set, otherwise to -1,
+     * writing each commit at once.
+     */
+    void set_commit_delay(int delay) noexcept;
+    int commit_delay() const noexcept { return m_commit_delay; }
+    /**
+     * Write the objects waiting to be committed in one database transaction.
+     *
+     * @return false if that failed, leaving the objects dirty and queued and
+     * the book marked as not saved.
+     */
+    bool commit_pending() noexcept;
     bool pristine() const noexcept { return m_is_pristine_db; }
     void update_progress(double pct) const noexcept;
     void finish_progress() const noexcept;
@@ -244,6 +302,11 @@ protected:
     bool m_loading;        /**< We are performing an initial load */
     bool m_in_query;       /**< We are processing a query */
     bool m_is_pristine_db; /**< Are we saving to a new pristine db? */
+    bool m_lazy_load;      /**< Leave transactions out of the initial load */
+    bool m_lazy_pending = false; /**< Not all transactions are loaded yet */
+    unsigned m_insert_batch_size; /**< Rows per INSERT statement in sync */
+    int m_commit_delay; /**< Milliseconds commits wait, < 0 for not at all */
+    bool m_batch_inserts = false; /**< Queue INSERTs instead of running them */
     const char* m_time_format = nullptr; /**< Server-specific date-time string format */
     VersionVec m_versions;    /**< Version number for each table */
 private:
@@ -264,6 +327,65 @@ private:
                                                QofIdTypeConst obj_name,
                                                gpointer pObject,
                                                const EntryVec& table) const noexcept;
+    /**
+     * Add an object's row to the pending INSERT for its table, running the
+     * statement once it holds enough rows.
+     *
+     * @return false if a statement was run and failed
+     */
+    bool queue_insert (const char* table_name, QofIdTypeConst obj_name,
+                       gpointer pObject, const EntryVec& table) const noexcept;
+    /**
+     * Run the pending INSERT statements.  Called before any other statement
+     * so that the database never lags behind what's been written.
+     *
+     * @return false if one of them failed
+     */
+    bool flush_inserts() const noexcept;
+    /**
+     * Add an object to the objects waiting to be committed and make sure
+     * they'll be written.
+     */
+    void queue_commit (QofInstance* inst) noexcept;
+    /**
+     * Run the object backends' commits for the waiting objects, in the order
+     * their types are loaded in so that objects come after those they refer
+     * to, except those opened for editing again since they were queued.
+     * Must be called inside a database transaction.
+     *
+     * @return false if one of them failed
+     */
+    bool write_pending_commits() noexcept;
+    /**
+     * Empty the queue of waiting objects and mark them clean if they were
+     * written.  If they weren't they stay queued to be tried again, as do
+     * those that were being edited again and so weren't written.
+     */
+    void finish_pending_commits(bool is_ok) noexcept;
+    /**
+     * Tell the book and the engine's commit error callbacks that waiting
+     * objects couldn't be written, as nobody is committing them just then.
+     */
+    void report_pending_error() noexcept;
+    static gboolean commit_pending_cb (gpointer data);
+
+    /** Objects waiting to be committed, with their type's place in the
+     * object backend registry. */
+    std::vector<std::pair<QofInstance*, size_t>> m_pending_commits;
+    std::unordered_set<QofInstance*> m_pending_instances;
+    guint m_commit_source = 0; /**< Main loop source writing the queue */
+
+    /** Rows waiting to be inserted into a table with the same columns.  The
+     * statement text up to VALUES is kept between flushes. */
+    struct InsertBatch
+    {
+        std::string table_name;
+        std::vector<std::string> columns;
+        std::string sql;
+        size_t header_size;
+        unsigned rows;
+    };
+    mutable std::vector<InsertBatch> m_insert_batches;
 
     class ObjectBackendRegistry
     {
@@ -312,14 +312,12 @@ GncSqlColumnTableEntryImpl<CT_GUID>::load (const GncSqlBackend* sql_be,
     const noexcept
 {
 
-    GncGUID guid;
-
     g_return_if_fail (pObject != NULL);
     g_return_if_fail (m_gobj_param_name != nullptr || get_setter(obj_name) != nullptr);
 
-    auto strval{row.get_string_at_col(m_col_name)};
-    if (strval && string_to_guid (strval->c_str(), &guid))
-        set_parameter(pObject, &guid, get_setter(obj_name), m_gobj_param_name);
+    auto guid{row.get_guid_at_col(m_col_name)};
+    if (guid)
+        set_parameter(pObject, &*guid, get_setter(obj_name), m_gobj_param_name);
 }
 
 template<> void
@@ -56,6 +56,16 @@ protected:
         virtual std::optional<std::string> get_string_at_col (const char* col) const = 0;
         virtual std::optional<time64> get_time64_at_col (const char* col) const = 0;
         virtual bool is_col_null (const char* col) const noexcept = 0;
+        /* A GUID stored as text.  Implementations that can get at the
+         * text in place should override this to parse it from there. */
+        virtual std::optional<GncGUID> get_guid_at_col (const char* col) const
+        {
+            GncGUID guid;
+            auto strval{get_string_at_col (col)};
+            if (strval && string_to_guid (strval->c_str(), &guid))
+                return guid;
+            return std::nullopt;
+        }
     };
 };
 
@@ -97,6 +107,8 @@ public:
         return m_iter->get_time64_at_col (col); }
     bool is_col_null (const char* col) const noexcept {
         return m_iter->is_col_null (col); }
+    std::optional<GncGUID> get_guid_at_col (const char* col) const {
+        return m_iter->get_guid_at_col (col); }
 private:
     GncSqlResult::IteratorImpl* m_iter;
 };
@@ -35,6 +35,8 @@
 #include "qofquerycore-p.h"
 
 #include "Account.h"
+#include <Account.hpp>
+#include <AccountP.hpp>
 #include "Transaction.h"
 #include <TransactionP.hpp>
 #include <Scrub.h>
@@ -47,8 +49,10 @@
 #include "splint-defs.h"
 #endif
 
+#include <algorithm>
 #include <string>
 #include <sstream>
+#include <unordered_map>
 
 #include "escape.h"
 
@@ -97,6 +101,8 @@ static const EntryVec tx_col_table
 static  gpointer get_split_reconcile_state (gpointer pObject);
 static void set_split_reconcile_state (gpointer pObject,  gpointer pValue);
 static void set_split_lot (gpointer pObject,  gpointer pLot);
+static void query_transactions_keeping_balances (GncSqlBackend* sql_be,
+                                                 const std::string& selector);
 
 #define SPLIT_MAX_MEMO_LEN 2048
 #define SPLIT_MAX_ACTION_LEN 2048
@@ -268,12 +274,20 @@ load_splits_for_transactions (GncSqlBackend* sql_be, std::string selector)
     auto stmt = sql_be->create_statement_from_sql(sql);
     auto result = sql_be->execute_select_statement (stmt);
 
+    /* Splits already in the engine may have unsaved slot changes, so only
+     * the new ones get their slots loaded. */
+    InstanceVec new_splits;
     for (auto row : *result)
-        load_single_split (sql_be, row);
+    {
+        auto guid = gnc_sql_load_guid (sql_be, row);
+        auto loaded = guid && xaccSplitLookup (guid, sql_be->book());
+        auto split = load_single_split (sql_be, row);
+        if (split && !loaded)
+            new_splits.push_back (QOF_INSTANCE (split));
+    }
     sql = "SELECT DISTINCT ";
     sql += spkey + " FROM " SPLIT_TABLE " WHERE " + sskey + " IN " + selector;
-    gnc_sql_slots_load_for_sql_subquery(sql_be, sql,
-                                        (BookLookupFn)xaccSplitLookup);
+    gnc_sql_slots_load_for_sql_subquery (sql_be, sql, new_splits);
 }
 
 static  Transaction*
@@ -309,23 +323,6 @@ load_single_tx (GncSqlBackend* sql_be, GncSqlRow& row)
     return pTx;
 }
 
-/**
- * Structure to hold start/end balances for each account.  The values are
- * saved before splits are loaded, and then used to adjust the start balances
- * so that the end balances (which are calculated and correct on initial load)
- * are unchanged.
- */
-typedef struct
-{
-    Account* acc;
-    gnc_numeric start_bal;
-    gnc_numeric end_bal;
-    gnc_numeric start_cleared_bal;
-    gnc_numeric end_cleared_bal;
-    gnc_numeric start_reconciled_bal;
-    gnc_numeric end_reconciled_bal;
-} full_acct_balances_t;
-
 /**
  * Executes a transaction query statement and loads the transactions and all
  * of the splits.
@@ -386,8 +383,9 @@ query_transactions (GncSqlBackend* sql_be, std::string selector)
             selector = "SELECT DISTINCT ";
             selector += tpkey + " FROM " TRANSACTION_TABLE;
         }
-        gnc_sql_slots_load_for_sql_subquery (sql_be, selector,
-					     (BookLookupFn)xaccTransLookup);
+        /* load_single_tx skips the transactions already in the engine, so
+         * their slots, perhaps edited since, aren't reloaded either. */
+        gnc_sql_slots_load_for_sql_subquery (sql_be, selector, instances);
     }
 
     // Commit all of the transactions, but don't scrub because any
@@ -719,6 +717,17 @@ GncSqlTransBackend::load_all (GncSqlBackend* sql_be)
     g_return_if_fail (sql_be != NULL);
 
     auto root = gnc_book_get_root_account (sql_be->book());
+    /* What was loaded lazily is in the balances already. */
+    if (sql_be->lazy_pending())
+    {
+        query_transactions_keeping_balances (sql_be, "");
+        gnc_account_foreach_descendant (root, [](Account* acc)
+        {
+            gnc_account_set_splits_loaded_from (acc, INT64_MIN);
+        });
+        return;
+    }
+
     gnc_account_foreach_descendant(root, (AccountCb)xaccAccountBeginEdit,
                                    nullptr);
     query_transactions (sql_be, "");
@@ -785,6 +794,267 @@ static const EntryVec acct_balances_col_table
                                          (QofSetterFunc)set_acct_bal_balance),
 };
 
+/* ----------------------------------------------------------------- */
+/* Lazy loading
+
+   The lazy initial load leaves the transactions in the database and puts
+   the totals of each account's splits into its starting balances, so that
+   the ending balances are right before any split is loaded.  The engine
+   then asks for an account's splits from some date on when it first needs
+   them.  The transactions loaded bring their splits in other accounts
+   along, so after each load the starting balances are shifted to put every
+   account's ending balances back where they were.
+*/
+
+using AccountBalancesVec = std::vector<std::pair<Account*, RunningBalances>>;
+
+static bool
+running_balances_equal (const RunningBalances& a, const RunningBalances& b)
+{
+    return gnc_numeric_equal (a.balance, b.balance) &&
+        gnc_numeric_equal (a.noclosing_balance, b.noclosing_balance) &&
+        gnc_numeric_equal (a.cleared_balance, b.cleared_balance) &&
+        gnc_numeric_equal (a.reconciled_balance, b.reconciled_balance);
+}
+
+/**
+ * Loads the transactions selector picks, as query_transactions does, without
+ * changing any account's ending balances.
+ *
+ * @param sql_be SQL backend
+ * @param selector As for query_transactions
+ */
+static void
+query_transactions_keeping_balances (GncSqlBackend* sql_be,
+                                     const std::string& selector)
+{
+    auto root = gnc_book_get_root_account (sql_be->book());
+    AccountBalancesVec balances;
+
+    gnc_account_foreach_descendant (root, [&balances](Account* acc)
+    {
+        balances.emplace_back (acc, gnc_account_get_end_balances (acc));
+    });
+
+    gnc_account_foreach_descendant(root, (AccountCb)xaccAccountBeginEdit,
+                                   nullptr);
+    query_transactions (sql_be, selector);
+    gnc_account_foreach_descendant(root, (AccountCb)xaccAccountCommitEdit,
+                                   nullptr);
+
+    for (const auto& [acc, ends] : balances)
+        if (!running_balances_equal (gnc_account_get_end_balances (acc), ends))
+            gnc_account_set_end_balances (acc, ends);
+}
+
+void
+gnc_sql_transaction_load_balances (GncSqlBackend* sql_be)
+{
+    g_return_if_fail (sql_be != NULL);
+
+    /* The quantities can only be summed in the database for each
+     * denominator, so the totals are finished off here.  Closing
+     * transactions are told apart by their book_closing slot. */
+    const std::string sakey(split_col_table[2]->name()); //account_guid
+    const std::string srkey(split_col_table[5]->name()); //reconcile_state
+    const std::string stkey(split_col_table[1]->name()); //tx_guid
+    std::string sql("SELECT " + sakey + ", " + srkey + ", "
+                    "SUM(quantity_num) AS quantity_num, quantity_denom, closing"
+                    " FROM (SELECT " + sakey + ", " + srkey + ", quantity_num, "
+                    "quantity_denom, CASE WHEN " + stkey + " IN "
+                    "(SELECT obj_guid FROM slots WHERE name = 'book_closing'"
+                    " AND int64_val <> 0) THEN 1 ELSE 0 END AS closing FROM "
+                    SPLIT_TABLE ") AS split_totals GROUP BY " + sakey + ", " +
+                    srkey + ", quantity_denom, closing");
+    auto stmt = sql_be->create_statement_from_sql (sql);
+    auto result = sql_be->execute_select_statement (stmt);
+    if (result == nullptr)
+        return;
+
+    auto zero = gnc_numeric_zero ();
+    std::unordered_map<Account*, RunningBalances> totals;
+    for (auto row : *result)
+    {
+        single_acct_balance_t bal{sql_be, nullptr, NREC, zero};
+
+        gnc_sql_load_object (sql_be, row, NULL, &bal, acct_balances_col_table);
+        if (bal.acct == nullptr)
+            continue;
+
+        auto& sums = totals.try_emplace (bal.acct, RunningBalances{zero, zero,
+                                                                   zero, zero})
+            .first->second;
+        auto add = [&bal](gnc_numeric& sum)
+        {
+            sum = gnc_numeric_add (sum, bal.balance, GNC_DENOM_AUTO,
+                                   GNC_HOW_DENOM_LCD);
+        };
+
+        add (sums.balance);
+        if (bal.reconcile_state != NREC)
+            add (sums.cleared_balance);
+        if (bal.reconcile_state == YREC || bal.reconcile_state == FREC)
+            add (sums.reconciled_balance);
+        if (row.get_int_at_col ("closing").value_or (0) == 0)
+            add (sums.noclosing_balance);
+    }
+    delete result;
+
+    for (const auto& [acc, sums] : totals)
+        gnc_account_set_end_balances (acc, sums);
+
+    gnc_account_foreach_descendant (gnc_book_get_root_account (sql_be->book()),
+                                    [](Account* acc)
+    {
+        gnc_account_set_splits_loaded_from (acc, INT64_MAX);
+    });
+}
+
+/* The condition on the posted date for since <= date < until, where either
+ * end may be open.  A missing date is read as the epoch, as it's loaded. */
+static std::string
+post_date_condition (time64 since, time64 until)
+{
+    const std::string column(TRANSACTION_TABLE "." +
+                             std::string{tx_col_table[3]->name()});
+    auto quote = [](time64 t)
+    {
+        return "'" + GncDateTime(t).format_iso8601() + "'";
+    };
+    std::string cond;
+
+    if (since > MINTIME)
+    {
+        cond += " AND (" + column + " >= " + quote (since);
+        if (since <= 0)
+            cond += " OR " + column + " IS NULL";
+        cond += ")";
+    }
+    if (until < MAXTIME)
+    {
+        cond += " AND (" + column + " < " + quote (until);
+        if (until > 0)
+            cond += " OR " + column + " IS NULL";
+        cond += ")";
+    }
+    return cond;
+}
+
+void
+gnc_sql_transaction_load_tx_since (GncSqlBackend* sql_be,
+                                   const AccountDateVec& accounts)
+{
+    g_return_if_fail (sql_be != NULL);
+
+    const std::string tpkey(tx_col_table[0]->name());    //guid
+    const std::string stkey(split_col_table[1]->name()); //tx_guid
+    const std::string sakey(split_col_table[2]->name()); //account_guid
+    std::string conditions;
+
+    for (const auto& [acc, since] : accounts)
+    {
+        auto loaded_from = gnc_account_get_splits_loaded_from (acc);
+        if (since >= loaded_from)
+            continue;
+
+        /* Marked first so that nothing asks for them again while they're
+         * being loaded. */
+        gnc_account_set_splits_loaded_from (acc, since);
+
+        if (!conditions.empty())
+            conditions += " OR ";
+        conditions += "(" SPLIT_TABLE "." + sakey + " = '";
+        conditions += gnc::GUID(*qof_instance_get_guid (acc)).to_string() + "'";
+        conditions += post_date_condition (since, loaded_from) + ")";
+    }
+    if (conditions.empty())
+        return;
+
+    std::string sql("(SELECT DISTINCT " SPLIT_TABLE "." + stkey + " FROM "
+                    SPLIT_TABLE " INNER JOIN " TRANSACTION_TABLE " ON "
+                    SPLIT_TABLE "." + stkey + " = " TRANSACTION_TABLE "." +
+                    tpkey + " WHERE " + conditions + ")");
+
+    sql_be->set_loading (true);
+    query_transactions_keeping_balances (sql_be, sql);
+    sql_be->set_loading (false);
+}
+
+static bool
+param_path_is (QofQueryParamList* path, const char* first, const char* second)
+{
+    return path && path->next && !path->next->next &&
+        g_strcmp0 (static_cast<const char*> (path->data), first) == 0 &&
+        g_strcmp0 (static_cast<const char*> (path->next->data), second) == 0;
+}
+
+bool
+gnc_sql_transaction_query_accounts (QofBook* book, QofQuery* query,
+                                    AccountDateVec& accounts)
+{
+    g_return_val_if_fail (query != NULL, false);
+
+    auto or_terms = qof_query_get_terms (query);
+    /* No terms at all matches everything. */
+    if (or_terms == nullptr)
+        return false;
+
+    std::unordered_map<Account*, time64> dates;
+    for (auto or_node = or_terms; or_node; or_node = or_node->next)
+    {
+        query_guid_t guids = nullptr;
+        time64 since = INT64_MIN;
+
+        /* Terms that aren't understood, or are inverted, only narrow the
+         * match down further and are passed over. */
+        for (auto and_node = static_cast<GList*> (or_node->data); and_node;
+             and_node = and_node->next)
+        {
+            auto term = static_cast<QofQueryTerm*> (and_node->data);
+            if (qof_query_term_is_inverted (term))
+                continue;
+
+            auto path = qof_query_term_get_param_path (term);
+            auto pred = qof_query_term_get_pred_data (term);
+            if (param_path_is (path, SPLIT_ACCOUNT, QOF_PARAM_GUID) &&
+                g_strcmp0 (pred->type_name, QOF_TYPE_GUID) == 0 &&
+                reinterpret_cast<query_guid_t> (pred)->options ==
+                QOF_GUID_MATCH_ANY)
+            {
+                guids = reinterpret_cast<query_guid_t> (pred);
+            }
+            else if (param_path_is (path, SPLIT_TRANS, TRANS_DATE_POSTED) &&
+                     g_strcmp0 (pred->type_name, QOF_TYPE_DATE) == 0 &&
+                     (pred->how == QOF_COMPARE_GTE ||
+                      pred->how == QOF_COMPARE_GT ||
+                      pred->how == QOF_COMPARE_EQUAL))
+            {
+                /* A day match compares whole days. */
+                auto date = reinterpret_cast<query_date_t> (pred)->date;
+                since = std::max (since, gnc_time64_get_day_start (date));
+            }
+        }
+
+        if (guids == nullptr)
+            return false;
+
+        for (auto node = guids->guids; node; node = node->next)
+        {
+            auto acc = xaccAccountLookup (static_cast<GncGUID*> (node->data),
+                                          book);
+            if (acc == nullptr)
+                continue;
+
+            auto [it, inserted] = dates.try_emplace (acc, since);
+            if (!inserted)
+                it->second = std::min (it->second, since);
+        }
+    }
+
+    accounts.assign (dates.begin(), dates.end());
+    return true;
+}
+
 /* ----------------------------------------------------------------- */
 template<> void
 GncSqlColumnTableEntryImpl<CT_TXREF>::load (const GncSqlBackend* sql_be,
@@ -33,6 +33,9 @@
 #include "qof.h"
 #include "Account.h"
 
+#include <utility>
+#include <vector>
+
 class GncSqlTransBackend : public GncSqlObjectBackend
 {
 public:
@@ -59,6 +62,42 @@ public:
  */
 void gnc_sql_transaction_load_tx_for_account (GncSqlBackend* sql_be,
                                               Account* account);
+
+/** Accounts, each with the earliest posted date wanted from it. */
+using AccountDateVec = std::vector<std::pair<Account*, time64>>;
+
+/**
+ * For a lazy initial load: sets each account's ending balances to the totals
+ * of its splits in the database, from an aggregate query, and marks the
+ * accounts as having none of their splits loaded.
+ *
+ * @param sql_be SQL backend
+ */
+void gnc_sql_transaction_load_balances (GncSqlBackend* sql_be);
+
+/**
+ * Loads the transactions with splits in each account posted on or after its
+ * date and before what has been loaded from it already.  Every account's
+ * ending balances stay where they were: the splits loaded were already
+ * summed into its starting balances.
+ *
+ * @param sql_be SQL backend
+ * @param accounts Accounts and dates
+ */
+void gnc_sql_transaction_load_tx_since (GncSqlBackend* sql_be,
+                                        const AccountDateVec& accounts);
+
+/**
+ * Finds the accounts a query for splits can only match splits in, and the
+ * earliest posted date it can match in each.
+ *
+ * @param book The book being queried
+ * @param query Query for splits
+ * @param accounts Filled in with the accounts and dates
+ * @return false if the query could match splits in any account
+ */
+bool gnc_sql_transaction_query_accounts (QofBook* book, QofQuery* query,
+                                         AccountDateVec& accounts);
 typedef struct
 {
     Account* acct;
@@ -23,6 +23,10 @@
 #include <config.h>
 
 #include <string.h>
+
+#include <string>
+#include <vector>
+
 #include "gnc-pricedb.h"
 #include "gnc-pricedb-p.h"
 
@@ -32,6 +36,8 @@
 #include "sixtp-parsers.h"
 #include "sixtp-dom-parsers.h"
 #include "sixtp-dom-generators.h"
+#include "sixtp-stream-parsers.h"
+#include "sixtp-stream-generators.h"
 #include "io-gncxml-gen.h"
 #include "io-gncxml-v2.h"
 
@@ -75,147 +81,236 @@ static QofLogModule log_module = GNC_MOD_IO;
 /****************************************************************************/
 /* <price>
 
-  restores a price.  Does so via a walk of the XML tree in memory.
-  Returns a GNCPrice * in result.
+  restores a price.  Does so straight from the SAX events, setting each
+  field on the price as its element ends.  Returns a GNCPrice * in result.
 
   Right now, a price is legitimate even if all of it's fields are not
   set.  We may need to change that later, but at the moment.
 
 */
 
-static gboolean
-price_parse_xml_sub_node (GNCPrice* p, xmlNodePtr sub_node, QofBook* book)
+struct GncXmlPriceStream
+{
+    enum class Element
+    {
+        PRICE, ID, COMMODITY, CURRENCY, TIME, SOURCE, TYPE, VALUE,
+        CMDTY_SPACE, CMDTY_ID, TS_DATE, IGNORE
+    };
+    struct Frame
+    {
+        Element element;
+        std::string* text;
+    };
+
+    QofBook* book;
+    GNCPrice* price;
+    gboolean ok;
+    bool empty;
+    std::vector<Frame> stack;
+    std::string text;
+    GncXmlStreamGuid id;
+    GncXmlStreamCommodity commodity;
+    GncXmlStreamDate time;
+
+    static GncXmlPriceStream* begin (gxpf_data* gdata, const gchar* tag,
+                                     gchar** attrs);
+    bool start (const gchar* tag, gchar** attrs);
+    void characters (const char* text, int length);
+    bool end (const gchar* tag);
+    gboolean finish (gxpf_data* gdata, const gchar* tag, gpointer* result);
+    static void abort (GncXmlPriceStream* stream);
+
+    gboolean set_field (Element element);
+};
+
+using PriceElement = GncXmlPriceStream::Element;
+
+static const struct
+{
+    PriceElement parent;
+    const char* tag;
+    PriceElement element;
+} price_elements[] =
+{
+    { PriceElement::PRICE, "price:id", PriceElement::ID },
+    { PriceElement::PRICE, "price:commodity", PriceElement::COMMODITY },
+    { PriceElement::PRICE, "price:currency", PriceElement::CURRENCY },
+    { PriceElement::PRICE, "price:time", PriceElement::TIME },
+    { PriceElement::PRICE, "price:source", PriceElement::SOURCE },
+    { PriceElement::PRICE, "price:type", PriceElement::TYPE },
+    { PriceElement::PRICE, "price:value", PriceElement::VALUE },
+    { PriceElement::COMMODITY, "cmdty:space", PriceElement::CMDTY_SPACE },
+    { PriceElement::COMMODITY, "cmdty:id", PriceElement::CMDTY_ID },
+    { PriceElement::CURRENCY, "cmdty:space", PriceElement::CMDTY_SPACE },
+    { PriceElement::CURRENCY, "cmdty:id", PriceElement::CMDTY_ID },
+    { PriceElement::TIME, "ts:date", PriceElement::TS_DATE },
+};
+
+GncXmlPriceStream*
+GncXmlPriceStream::begin (gxpf_data* gdata, const gchar* tag, gchar** attrs)
+{
+    auto book = static_cast<QofBook*> (gdata->bookdata);
+    auto price = gnc_price_create (book);
+
+    if (!price)
+        return nullptr;
+
+    auto stream = new GncXmlPriceStream;
+    stream->book = book;
+    stream->price = price;
+    stream->ok = TRUE;
+    stream->empty = true;
+    stream->stack.push_back ({Element::PRICE, nullptr});
+    return stream;
+}
+
+bool
+GncXmlPriceStream::start (const gchar* tag, gchar** attrs)
 {
-    if (!p || !sub_node) return FALSE;
+    auto parent = stack.back ().element;
+    auto element = Element::IGNORE;
+    std::string* buffer = nullptr;
 
-    gnc_price_begin_edit (p);
-    if (g_strcmp0 ("price:id", (char*)sub_node->name) == 0)
+    empty = false;
+
+    for (const auto& rule : price_elements)
     {
-        GncGUID* c = dom_tree_to_guid (sub_node);
-        if (!c) return FALSE;
-        gnc_price_set_guid (p, c);
-        guid_free (c);
+        if (rule.parent == parent && strcmp (rule.tag, tag) == 0)
+        {
+            element = rule.element;
+            break;
+        }
     }
-    else if (g_strcmp0 ("price:commodity", (char*)sub_node->name) == 0)
+
+    switch (element)
     {
-        gnc_commodity* c = dom_tree_to_commodity_ref (sub_node, book);
-        if (!c) return FALSE;
-        gnc_price_set_commodity (p, c);
+    case Element::ID:
+        id.start (tag, attrs);
+        buffer = &id.text;
+        break;
+    case Element::COMMODITY:
+    case Element::CURRENCY:
+        commodity.start ();
+        break;
+    case Element::TIME:
+        time.start ();
+        break;
+    case Element::SOURCE:
+    case Element::TYPE:
+    case Element::VALUE:
+        text.clear ();
+        buffer = &text;
+        break;
+    case Element::CMDTY_SPACE:
+        buffer = commodity.cmdty_space ();
+        break;
+    case Element::CMDTY_ID:
+        buffer = commodity.cmdty_id ();
+        break;
+    case Element::TS_DATE:
+        buffer = time.ts_date ();
+        break;
+    case Element::PRICE:
+    case Element::IGNORE:
+        break;
     }
-    else if (g_strcmp0 ("price:currency", (char*)sub_node->name) == 0)
+
+    stack.push_back ({element, buffer});
+    return true;
+}
+
+void
+GncXmlPriceStream::characters (const char* text, int length)
+{
+    empty = false;
+    if (auto buffer = stack.back ().text)
+        buffer->append (text, length);
+}
+
+gboolean
+GncXmlPriceStream::set_field (Element element)
+{
+    gnc_price_begin_edit (price);
+    switch (element)
     {
-        gnc_commodity* c = dom_tree_to_commodity_ref (sub_node, book);
-        if (!c) return FALSE;
-        gnc_price_set_currency (p, c);
-    }
-    else if (g_strcmp0 ("price:time", (char*)sub_node->name) == 0)
+    case Element::ID:
     {
-        time64 time = dom_tree_to_time64 (sub_node);
-        if (!dom_tree_valid_time64 (time, sub_node->name)) time = 0;
-        gnc_price_set_time64 (p, time);
+        id.parse ();
+        auto guid = id.get ();
+        if (!guid) return FALSE;
+        gnc_price_set_guid (price, guid);
+        break;
     }
-    else if (g_strcmp0 ("price:source", (char*)sub_node->name) == 0)
+    case Element::COMMODITY:
     {
-        char* text = dom_tree_to_text (sub_node);
-        if (!text) return FALSE;
-        gnc_price_set_source_string (p, text);
-        g_free (text);
+        gnc_commodity* c = commodity.lookup (book);
+        if (!c) return FALSE;
+        gnc_price_set_commodity (price, c);
+        break;
     }
-    else if (g_strcmp0 ("price:type", (char*)sub_node->name) == 0)
+    case Element::CURRENCY:
     {
-        char* text = dom_tree_to_text (sub_node);
-        if (!text) return FALSE;
-        gnc_price_set_typestr (p, text);
-        g_free (text);
+        gnc_commodity* c = commodity.lookup (book);
+        if (!c) return FALSE;
+        gnc_price_set_currency (price, c);
+        break;
     }
-    else if (g_strcmp0 ("price:value", (char*)sub_node->name) == 0)
-    {
-        gnc_price_set_value (p, dom_tree_to_gnc_numeric (sub_node));
+    case Element::TIME:
+        time.parse ();
+        if (!dom_tree_valid_time64 (time.time, BAD_CAST "price:time"))
+            time.time = 0;
+        gnc_price_set_time64 (price, time.time);
+        break;
+    case Element::SOURCE:
+        gnc_price_set_source_string (price, text.c_str ());
+        break;
+    case Element::TYPE:
+        gnc_price_set_typestr (price, text.c_str ());
+        break;
+    case Element::VALUE:
+        gnc_price_set_value (price, sixtp_stream_to_gnc_numeric (text));
+        break;
+    default:
+        break;
     }
-    gnc_price_commit_edit (p);
+    gnc_price_commit_edit (price);
     return TRUE;
 }
 
-static gboolean
-price_parse_xml_end_handler (gpointer data_for_children,
-                             GSList* data_from_children,
-                             GSList* sibling_data,
-                             gpointer parent_data,
-                             gpointer global_data,
-                             gpointer* result,
-                             const gchar* tag)
+bool
+GncXmlPriceStream::end (const gchar* tag)
 {
-    gboolean ok = TRUE;
-    xmlNodePtr price_xml = (xmlNodePtr) data_for_children;
-    xmlNodePtr child;
-    GNCPrice* p = NULL;
-    gxpf_data* gdata = static_cast<decltype (gdata)> (global_data);
-    QofBook* book = static_cast<decltype (book)> (gdata->bookdata);
-
-    /* we haven't been handed the *top* level node yet... */
-    if (parent_data) return TRUE;
+    auto element = stack.back ().element;
 
-    *result = NULL;
-
-    if (!price_xml) return FALSE;
-    if (price_xml->next)
-    {
-        ok = FALSE;
-        goto cleanup_and_exit;
-    }
-    if (price_xml->prev)
-    {
-        ok = FALSE;
-        goto cleanup_and_exit;
-    }
-    if (!price_xml->xmlChildrenNode)
-    {
-        ok = FALSE;
-        goto cleanup_and_exit;
-    }
-
-    p = gnc_price_create (book);
-    if (!p)
-    {
-        ok = FALSE;
-        goto cleanup_and_exit;
-    }
+    stack.pop_back ();
+    /* Stop at the first field that can't be set. */
+    if (ok && stack.back ().element == Element::PRICE)
+        ok = set_field (element);
+    return true;
+}
 
-    for (child = price_xml->xmlChildrenNode; child; child = child->next)
-    {
-        switch (child->type)
-        {
-        case XML_COMMENT_NODE:
-        case XML_TEXT_NODE:
-            break;
-        case XML_ELEMENT_NODE:
-            if (!price_parse_xml_sub_node (p, child, book))
-            {
-                ok = FALSE;
-                goto cleanup_and_exit;
-            }
-            break;
-        default:
-            PERR ("Unknown node type (%d) while parsing gnc-price xml.", child->type);
-            child = NULL;
-            ok = FALSE;
-            goto cleanup_and_exit;
-            break;
-        }
-    }
+gboolean
+GncXmlPriceStream::finish (gxpf_data* gdata, const gchar* tag,
+                           gpointer* result)
+{
+    gboolean retval = ok && !empty;
 
-cleanup_and_exit:
-    if (ok)
-    {
-        *result = p;
-    }
+    if (retval)
+        *result = price;
     else
     {
         *result = NULL;
-        gnc_price_unref (p);
+        gnc_price_unref (price);
     }
-    xmlFreeNode (price_xml);
-    return ok;
+    delete this;
+    return retval;
+}
+
+void
+GncXmlPriceStream::abort (GncXmlPriceStream* stream)
+{
+    gnc_price_unref (stream->price);
+    delete stream;
 }
 
 static void
@@ -227,12 +322,10 @@ cleanup_gnc_price (sixtp_child_result* result)
 static sixtp*
 gnc_price_parser_new (void)
 {
-    return sixtp_dom_parser_new (price_parse_xml_end_handler,
-                                 cleanup_gnc_price,
-                                 cleanup_gnc_price);
+    return sixtp_stream_parser_new<GncXmlPriceStream> (cleanup_gnc_price,
+                                                       cleanup_gnc_price);
 }
 
-
 /****************************************************************************/
 /* <pricedb> (lineage <ledger-data>)
 
@@ -507,3 +600,46 @@ gnc_pricedb_dom_tree_create (GNCPriceDB* db)
 {
     return gnc_pricedb_to_dom_tree (BAD_CAST "gnc:pricedb", db);
 }
+
+xmlNodePtr
+gnc_price_dom_tree_create (GNCPrice* price)
+{
+    return gnc_price_to_dom_tree (BAD_CAST "price", price);
+}
+
+gboolean
+gnc_price_write_xml (GncXmlWriter& writer, GNCPrice* price)
+{
+    g_return_val_if_fail (price, FALSE);
+
+    auto commodity = gnc_price_get_commodity (price);
+    auto currency = gnc_price_get_currency (price);
+    auto time = gnc_price_get_time64 (price);
+
+    /* Check everything gnc_price_to_dom_tree would give up on before
+       writing anything. */
+    if (! (commodity && currency) || time == INT64_MAX)
+        return FALSE;
+    for (auto c : {commodity, currency})
+        if (!gnc_commodity_get_namespace (c) || !gnc_commodity_get_mnemonic (c))
+            return FALSE;
+
+    writer.start ("price");
+    writer.guid ("price:id", gnc_price_get_guid (price));
+    writer.commodity_ref ("price:commodity", commodity);
+    writer.commodity_ref ("price:currency", currency);
+    writer.time ("price:time", time);
+
+    auto sourcestr = gnc_price_get_source_string (price);
+    if (sourcestr && *sourcestr)
+        writer.checked_text ("price:source", sourcestr);
+
+    auto typestr = gnc_price_get_typestr (price);
+    if (typestr && *typestr)
+        writer.checked_text ("price:type", typestr);
+
+    writer.numeric ("price:value", gnc_price_get_value (price));
+    writer.end ("price");
+
+    return TRUE;
+}
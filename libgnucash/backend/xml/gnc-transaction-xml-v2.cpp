@@ -25,6 +25,11 @@
 
 #include <config.h>
 #include <string.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
 #include "AccountP.hpp"
 #include "Transaction.h"
 #include "TransactionP.hpp"
@@ -39,6 +44,8 @@
 #include "sixtp-utils.h"
 #include "sixtp-dom-parsers.h"
 #include "sixtp-dom-generators.h"
+#include "sixtp-stream-parsers.h"
+#include "sixtp-stream-generators.h"
 
 #include "gnc-xml.h"
 
@@ -191,12 +198,77 @@ gnc_transaction_dom_tree_create (Transaction* trn)
     return ret;
 }
 
+/* The same elements as split_to_dom_tree, written directly. */
+static void
+write_split (GncXmlWriter& writer, const gchar* tag, Split* spl)
+{
+    writer.start (tag);
+
+    writer.guid ("split:id", xaccSplitGetGUID (spl));
+
+    auto memo = xaccSplitGetMemo (spl);
+    if (memo && *memo)
+        writer.checked_text ("split:memo", memo);
+
+    auto action = xaccSplitGetAction (spl);
+    if (action && *action)
+        writer.checked_text ("split:action", action);
+
+    char tmp[2] = { xaccSplitGetReconcile (spl), '\0' };
+    writer.text ("split:reconciled-state", tmp);
+
+    if (auto date = xaccSplitGetDateReconciled (spl))
+        writer.time ("split:reconcile-date", date);
+
+    writer.numeric ("split:value", xaccSplitGetValue (spl));
+    writer.numeric ("split:quantity", xaccSplitGetAmount (spl));
+
+    writer.guid ("split:account",
+                 xaccAccountGetGUID (xaccSplitGetAccount (spl)));
+
+    if (auto lot = xaccSplitGetLot (spl))
+        writer.guid ("split:lot", gnc_lot_get_guid (lot));
+
+    writer.instance_slots ("split:slots", QOF_INSTANCE (spl));
+
+    writer.end (tag);
+}
+
+void
+gnc_transaction_write_xml (GncXmlWriter& writer, Transaction* trn)
+{
+    writer.start ("gnc:transaction", "version", transaction_version_string);
+
+    writer.guid ("trn:id", xaccTransGetGUID (trn));
+    writer.commodity_ref ("trn:currency", xaccTransGetCurrency (trn));
+
+    auto num = xaccTransGetNum (trn);
+    if (num && *num)
+        writer.checked_text ("trn:num", num);
+
+    writer.time ("trn:date-posted", xaccTransRetDatePosted (trn));
+    writer.time ("trn:date-entered", xaccTransRetDateEntered (trn));
+
+    if (auto description = xaccTransGetDescription (trn))
+        writer.checked_text ("trn:description", description);
+
+    writer.instance_slots ("trn:slots", QOF_INSTANCE (trn));
+
+    writer.start ("trn:splits");
+    for (auto n = xaccTransGetSplitList (trn); n; n = n->next)
+        write_split (writer, "trn:split", static_cast<Split*> (n->data));
+    writer.end ("trn:splits");
+
+    writer.end ("gnc:transaction");
+}
+
 /***********************************************************************/
 
 struct split_pdata
 {
     Split* split;
     QofBook* book;
+    gboolean no_account;
 };
 
 static inline gboolean
@@ -288,26 +360,49 @@ spl_quantity_handler (xmlNodePtr node, gpointer data)
 
 gboolean gnc_transaction_xml_v2_testing = FALSE;
 
+static void
+split_set_account (Split* split, const GncGUID* id, QofBook* book)
+{
+    Account* account = xaccAccountLookup (id, book);
+    if (!account && gnc_transaction_xml_v2_testing &&
+        !guid_equal (id, guid_null ()))
+    {
+        account = xaccMallocAccount (book);
+        xaccAccountSetGUID (account, id);
+        xaccAccountSetCommoditySCU (account,
+                                    xaccSplitGetAmount (split).denom);
+    }
+
+    xaccAccountInsertSplit (account, split);
+}
+
+static void
+split_set_lot (Split* split, const GncGUID* id, QofBook* book)
+{
+    GNCLot* lot = gnc_lot_lookup (id, book);
+    if (!lot && gnc_transaction_xml_v2_testing &&
+        !guid_equal (id, guid_null ()))
+    {
+        lot = gnc_lot_new (book);
+        gnc_lot_set_guid (lot, *id);
+    }
+
+    gnc_lot_add_split (lot, split);
+}
+
 static gboolean
 spl_account_handler (xmlNodePtr node, gpointer data)
 {
     struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
     GncGUID* id = dom_tree_to_guid (node);
-    Account* account;
 
-    g_return_val_if_fail (id, FALSE);
-
-    account = xaccAccountLookup (id, pdata->book);
-    if (!account && gnc_transaction_xml_v2_testing &&
-        !guid_equal (id, guid_null ()))
+    if (!id)
     {
-        account = xaccMallocAccount (pdata->book);
-        xaccAccountSetGUID (account, id);
-        xaccAccountSetCommoditySCU (account,
-                                    xaccSplitGetAmount (pdata->split).denom);
+        pdata->no_account = TRUE;
+        return FALSE;
     }
 
-    xaccAccountInsertSplit (account, pdata->split);
+    split_set_account (pdata->split, id, pdata->book);
 
     guid_free (id);
 
@@ -319,19 +414,10 @@ spl_lot_handler (xmlNodePtr node, gpointer data)
 {
     struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
     GncGUID* id = dom_tree_to_guid (node);
-    GNCLot* lot;
 
     g_return_val_if_fail (id, FALSE);
 
-    lot = gnc_lot_lookup (id, pdata->book);
-    if (!lot && gnc_transaction_xml_v2_testing &&
-        !guid_equal (id, guid_null ()))
-    {
-        lot = gnc_lot_new (pdata->book);
-        gnc_lot_set_guid (lot, *id);
-    }
-
-    gnc_lot_add_split (lot, pdata->split);
+    split_set_lot (pdata->split, id, pdata->book);
 
     guid_free (id);
 
@@ -366,8 +452,10 @@ struct dom_tree_handler spl_dom_handlers[] =
     { NULL, NULL, 0, 0 },
 };
 
+/* no_account is set if the split's account isn't a GUID, even if the split
+ * is otherwise good. */
 static Split*
-dom_tree_to_split (xmlNodePtr node, QofBook* book)
+dom_tree_to_split (xmlNodePtr node, QofBook* book, gboolean* no_account)
 {
     struct split_pdata pdata;
     Split* ret;
@@ -379,9 +467,13 @@ dom_tree_to_split (xmlNodePtr node, QofBook* book)
 
     pdata.split = ret;
     pdata.book = book;
+    pdata.no_account = FALSE;
 
     /* this isn't going to work in a testing setup */
-    if (dom_tree_generic_parse (node, spl_dom_handlers, &pdata))
+    auto successful = dom_tree_generic_parse (node, spl_dom_handlers, &pdata);
+    if (pdata.no_account)
+        *no_account = TRUE;
+    if (successful)
     {
         return ret;
     }
@@ -398,6 +490,8 @@ struct trans_pdata
 {
     Transaction* trans;
     QofBook* book;
+    /* The transaction's id or a split's account isn't a GUID. */
+    gboolean bad_guid;
 };
 
 static inline gboolean
@@ -434,7 +528,11 @@ trn_id_handler (xmlNodePtr node, gpointer trans_pdata)
     Transaction* trn = pdata->trans;
     GncGUID* tmp = dom_tree_to_guid (node);
 
-    g_return_val_if_fail (tmp, FALSE);
+    if (!tmp)
+    {
+        pdata->bad_guid = TRUE;
+        return FALSE;
+    }
 
     xaccTransSetGUID ((Transaction*)trn, tmp);
 
@@ -528,7 +626,7 @@ trn_splits_handler (xmlNodePtr node, gpointer trans_pdata)
             return FALSE;
         }
 
-        spl = dom_tree_to_split (mark, pdata->book);
+        spl = dom_tree_to_split (mark, pdata->book, &pdata->bad_guid);
 
         if (spl)
         {
@@ -607,8 +705,15 @@ dom_tree_to_transaction (xmlNodePtr node, QofBook* book)
 
     pdata.trans = trn;
     pdata.book = book;
+    pdata.bad_guid = FALSE;
 
     successful = dom_tree_generic_parse (node, trn_dom_handlers, &pdata);
+    /* Rather than keep a made-up id or a split without an account. */
+    if (pdata.bad_guid)
+    {
+        PERR ("transaction with an id or split account that isn't a GUID");
+        successful = FALSE;
+    }
 
     xaccTransCommitEdit (trn);
 
@@ -624,6 +729,675 @@ dom_tree_to_transaction (xmlNodePtr node, QofBook* book)
     return trn;
 }
 
+/***********************************************************************/
+/* Streaming transactions.
+
+   The stream parser reads a <gnc:transaction> straight from the SAX
+   events into a GncXmlTxnStream: element text lands in the stream's
+   buffers and the slots are built as they go by, so there's no DOM tree to
+   build, walk and free for every transaction.  The GUIDs, numbers and
+   dates are converted once the transaction is complete, on a worker thread
+   if there's a pipeline.  Creating the engine objects and linking them to
+   their accounts and lots isn't thread safe and is done on the parsing
+   thread in the order the transactions appear in the file.  The pipeline
+   recycles the streams, buffers and all.
+
+   Transactions are accepted or rejected as dom_tree_to_transaction would:
+   an unknown or missing required element fails the transaction, as does an
+   id or split account that isn't typed as a GUID, and a bad split ends its
+   list of splits.
+*/
+
+enum class TxnElement
+{
+    TRANSACTION,
+    ID,
+    CURRENCY,
+    NUM,
+    DATE_POSTED,
+    DATE_ENTERED,
+    DESCRIPTION,
+    SLOTS,
+    SPLITS,
+    SPLIT,
+    SPLIT_ID,
+    SPLIT_MEMO,
+    SPLIT_ACTION,
+    SPLIT_RECONCILED,
+    SPLIT_RECONCILE_DATE,
+    SPLIT_VALUE,
+    SPLIT_QUANTITY,
+    SPLIT_ACCOUNT,
+    SPLIT_LOT,
+    SPLIT_SLOTS,
+    CMDTY_SPACE,
+    CMDTY_ID,
+    TS_DATE,
+    IGNORE,
+};
+
+static const struct
+{
+    TxnElement parent;
+    const char* tag;
+    TxnElement element;
+} txn_elements[] =
+{
+    { TxnElement::TRANSACTION, "trn:id", TxnElement::ID },
+    { TxnElement::TRANSACTION, "trn:currency", TxnElement::CURRENCY },
+    { TxnElement::TRANSACTION, "trn:num", TxnElement::NUM },
+    { TxnElement::TRANSACTION, "trn:date-posted", TxnElement::DATE_POSTED },
+    { TxnElement::TRANSACTION, "trn:date-entered", TxnElement::DATE_ENTERED },
+    { TxnElement::TRANSACTION, "trn:description", TxnElement::DESCRIPTION },
+    { TxnElement::TRANSACTION, "trn:slots", TxnElement::SLOTS },
+    { TxnElement::TRANSACTION, "trn:splits", TxnElement::SPLITS },
+    { TxnElement::SPLITS, "trn:split", TxnElement::SPLIT },
+    { TxnElement::SPLIT, "split:id", TxnElement::SPLIT_ID },
+    { TxnElement::SPLIT, "split:memo", TxnElement::SPLIT_MEMO },
+    { TxnElement::SPLIT, "split:action", TxnElement::SPLIT_ACTION },
+    { TxnElement::SPLIT, "split:reconciled-state", TxnElement::SPLIT_RECONCILED },
+    { TxnElement::SPLIT, "split:reconcile-date", TxnElement::SPLIT_RECONCILE_DATE },
+    { TxnElement::SPLIT, "split:value", TxnElement::SPLIT_VALUE },
+    { TxnElement::SPLIT, "split:quantity", TxnElement::SPLIT_QUANTITY },
+    { TxnElement::SPLIT, "split:account", TxnElement::SPLIT_ACCOUNT },
+    { TxnElement::SPLIT, "split:lot", TxnElement::SPLIT_LOT },
+    { TxnElement::SPLIT, "split:slots", TxnElement::SPLIT_SLOTS },
+    { TxnElement::CURRENCY, "cmdty:space", TxnElement::CMDTY_SPACE },
+    { TxnElement::CURRENCY, "cmdty:id", TxnElement::CMDTY_ID },
+    { TxnElement::DATE_POSTED, "ts:date", TxnElement::TS_DATE },
+    { TxnElement::DATE_ENTERED, "ts:date", TxnElement::TS_DATE },
+    { TxnElement::SPLIT_RECONCILE_DATE, "ts:date", TxnElement::TS_DATE },
+};
+
+static constexpr unsigned
+txn_element_bit (TxnElement element)
+{
+    return 1u << static_cast<unsigned> (element);
+}
+
+static constexpr unsigned trn_required =
+    txn_element_bit (TxnElement::ID) |
+    txn_element_bit (TxnElement::DATE_POSTED) |
+    txn_element_bit (TxnElement::DATE_ENTERED) |
+    txn_element_bit (TxnElement::SPLITS);
+
+static constexpr unsigned spl_required =
+    txn_element_bit (TxnElement::SPLIT_ID) |
+    txn_element_bit (TxnElement::SPLIT_RECONCILED) |
+    txn_element_bit (TxnElement::SPLIT_VALUE) |
+    txn_element_bit (TxnElement::SPLIT_QUANTITY) |
+    txn_element_bit (TxnElement::SPLIT_ACCOUNT);
+
+struct split_stream_data
+{
+    unsigned seen;
+    bool bad;
+    GncXmlStreamGuid id;
+    std::string memo;
+    std::string action;
+    std::string reconciled;
+    GncXmlStreamDate reconcile_date;
+    std::string value;
+    std::string quantity;
+    GncXmlStreamGuid account;
+    GncXmlStreamGuid lot;
+    KvpFrame* slots;
+
+    gnc_numeric value_num;
+    gnc_numeric quantity_num;
+};
+
+struct GncXmlTxnStream
+{
+    struct Frame
+    {
+        TxnElement element;
+        std::string* text;
+    };
+
+    GncXmlTxnPipeline* pipeline;
+    std::string tag;
+    unsigned seen;
+    bool bad;
+    GncXmlStreamGuid id;
+    GncXmlStreamCommodity currency;
+    std::string num;
+    GncXmlStreamDate date_posted;
+    GncXmlStreamDate date_entered;
+    std::string description;
+    KvpFrame* slots = nullptr;
+    /* The ones past n_splits are kept for their buffers. */
+    std::vector<split_stream_data> splits;
+    size_t n_splits;
+    bool splits_closed;
+    /* A split:account that wasn't typed as a GUID, in any split read. */
+    bool untyped_account;
+
+    std::vector<Frame> stack;
+    GncXmlSlotBuilder slot_builder;
+    /* Set once a worker has prepared the stream. */
+    bool ready;
+
+    ~GncXmlTxnStream () { clear_slots (); }
+
+    static GncXmlTxnStream* begin (gxpf_data* gdata, const gchar* tag,
+                                   gchar** attrs);
+    bool start (const gchar* tag, gchar** attrs);
+    void characters (const char* text, int length);
+    bool end (const gchar* tag);
+    gboolean finish (gxpf_data* gdata, const gchar* tag, gpointer* result);
+    static void abort (GncXmlTxnStream* stream);
+
+    void clear_slots ();
+    void end_split ();
+    void prepare ();
+    Transaction* to_transaction (QofBook* book);
+};
+
+struct GncXmlTxnPipeline
+{
+    gxpf_data gdata;
+    GThreadPool* pool;
+    GMutex mutex;
+    GCond cond;
+    std::deque<GncXmlTxnStream*> jobs;
+    std::vector<GncXmlTxnStream*> spare;
+    size_t max_jobs;
+    gboolean ok;
+};
+
+static void
+txn_stream_release (GncXmlTxnStream* stream)
+{
+    stream->clear_slots ();
+    stream->slot_builder.reset ();
+
+    if (stream->pipeline)
+        stream->pipeline->spare.push_back (stream);
+    else
+        delete stream;
+}
+
+void
+GncXmlTxnStream::clear_slots ()
+{
+    delete slots;
+    slots = nullptr;
+
+    for (auto& spl : splits)
+    {
+        delete spl.slots;
+        spl.slots = nullptr;
+    }
+}
+
+GncXmlTxnStream*
+GncXmlTxnStream::begin (gxpf_data* gdata, const gchar* tag, gchar** attrs)
+{
+    auto pipeline = gdata->txn_pipeline;
+    GncXmlTxnStream* stream;
+
+    if (pipeline && !pipeline->spare.empty ())
+    {
+        stream = pipeline->spare.back ();
+        pipeline->spare.pop_back ();
+    }
+    else
+        stream = new GncXmlTxnStream;
+
+    stream->pipeline = pipeline;
+    stream->tag = tag;
+    stream->seen = 0;
+    stream->bad = false;
+    stream->n_splits = 0;
+    stream->splits_closed = false;
+    stream->untyped_account = false;
+    stream->stack.clear ();
+    stream->stack.push_back ({TxnElement::TRANSACTION, nullptr});
+    stream->ready = false;
+
+    return stream;
+}
+
+bool
+GncXmlTxnStream::start (const gchar* tag, gchar** attrs)
+{
+    if (slot_builder.active ())
+    {
+        slot_builder.start (tag, attrs);
+        return true;
+    }
+
+    auto parent = stack.back ().element;
+    auto element = TxnElement::IGNORE;
+    std::string* text = nullptr;
+
+    for (const auto& rule : txn_elements)
+    {
+        if (rule.parent == parent && strcmp (rule.tag, tag) == 0)
+        {
+            element = rule.element;
+            break;
+        }
+    }
+
+    if (element == TxnElement::SPLIT && splits_closed)
+        element = TxnElement::IGNORE;
+
+    if (element == TxnElement::SPLIT)
+    {
+        if (n_splits == splits.size ())
+            splits.emplace_back ();
+
+        auto& spl = splits[n_splits++];
+        spl.seen = 0;
+        spl.bad = false;
+        spl.slots = nullptr;
+    }
+
+    auto spl = n_splits ? &splits[n_splits - 1] : nullptr;
+
+    if (element <= TxnElement::SPLITS)
+        seen |= txn_element_bit (element);
+    else if (element >= TxnElement::SPLIT_ID &&
+             element <= TxnElement::SPLIT_SLOTS)
+        spl->seen |= txn_element_bit (element);
+
+    switch (element)
+    {
+    case TxnElement::ID:
+        id.start (tag, attrs);
+        text = &id.text;
+        break;
+    case TxnElement::CURRENCY:
+        currency.start ();
+        break;
+    case TxnElement::NUM:
+        num.clear ();
+        text = &num;
+        break;
+    case TxnElement::DATE_POSTED:
+        date_posted.start ();
+        break;
+    case TxnElement::DATE_ENTERED:
+        date_entered.start ();
+        break;
+    case TxnElement::DESCRIPTION:
+        description.clear ();
+        text = &description;
+        break;
+    case TxnElement::SLOTS:
+        if (!slots)
+            slots = new KvpFrame;
+        slot_builder.begin (slots);
+        return true;
+    case TxnElement::SPLITS:
+        splits_closed = false;
+        break;
+    case TxnElement::SPLIT_ID:
+        spl->id.start (tag, attrs);
+        text = &spl->id.text;
+        break;
+    case TxnElement::SPLIT_MEMO:
+        spl->memo.clear ();
+        text = &spl->memo;
+        break;
+    case TxnElement::SPLIT_ACTION:
+        spl->action.clear ();
+        text = &spl->action;
+        break;
+    case TxnElement::SPLIT_RECONCILED:
+        spl->reconciled.clear ();
+        text = &spl->reconciled;
+        break;
+    case TxnElement::SPLIT_RECONCILE_DATE:
+        spl->reconcile_date.start ();
+        break;
+    case TxnElement::SPLIT_VALUE:
+        spl->value.clear ();
+        text = &spl->value;
+        break;
+    case TxnElement::SPLIT_QUANTITY:
+        spl->quantity.clear ();
+        text = &spl->quantity;
+        break;
+    case TxnElement::SPLIT_ACCOUNT:
+        spl->account.start (tag, attrs);
+        if (!spl->account.typed)
+            untyped_account = true;
+        text = &spl->account.text;
+        break;
+    case TxnElement::SPLIT_LOT:
+        spl->lot.start (tag, attrs);
+        text = &spl->lot.text;
+        break;
+    case TxnElement::SPLIT_SLOTS:
+        if (!spl->slots)
+            spl->slots = new KvpFrame;
+        slot_builder.begin (spl->slots);
+        return true;
+    case TxnElement::CMDTY_SPACE:
+        text = currency.cmdty_space ();
+        break;
+    case TxnElement::CMDTY_ID:
+        text = currency.cmdty_id ();
+        break;
+    case TxnElement::TS_DATE:
+        if (parent == TxnElement::DATE_POSTED)
+            text = date_posted.ts_date ();
+        else if (parent == TxnElement::DATE_ENTERED)
+            text = date_entered.ts_date ();
+        else
+            text = spl->reconcile_date.ts_date ();
+        break;
+    case TxnElement::IGNORE:
+        if (parent == TxnElement::TRANSACTION || parent == TxnElement::SPLIT)
+        {
+            PERR ("Unhandled tag: %s", tag);
+            if (parent == TxnElement::TRANSACTION)
+                bad = true;
+            else
+                spl->bad = true;
+        }
+        /* Anything else in the list of splits ends it. */
+        else if (parent == TxnElement::SPLITS)
+            splits_closed = true;
+        break;
+    case TxnElement::TRANSACTION:
+    case TxnElement::SPLIT:
+        break;
+    }
+
+    stack.push_back ({element, text});
+    return true;
+}
+
+void
+GncXmlTxnStream::characters (const char* text, int length)
+{
+    if (slot_builder.active ())
+        slot_builder.characters (text, length);
+    else if (auto buffer = stack.back ().text)
+        buffer->append (text, length);
+}
+
+void
+GncXmlTxnStream::end_split ()
+{
+    auto& spl = splits[n_splits - 1];
+
+    if (!spl.bad && (spl.seen & spl_required) == spl_required)
+        return;
+
+    if (!spl.bad)
+        PERR ("didn't find all of the expected tags in the input");
+
+    /* dom_tree_to_split would have failed, leaving the transaction with
+     * just the splits before this one. */
+    delete spl.slots;
+    spl.slots = nullptr;
+    --n_splits;
+    splits_closed = true;
+}
+
+bool
+GncXmlTxnStream::end (const gchar* tag)
+{
+    if (slot_builder.active ())
+    {
+        slot_builder.end ();
+        return true;
+    }
+
+    if (stack.back ().element == TxnElement::SPLIT)
+        end_split ();
+    stack.pop_back ();
+    return true;
+}
+
+void
+GncXmlTxnStream::prepare ()
+{
+    id.parse ();
+    date_posted.parse ();
+    date_entered.parse ();
+
+    for (size_t i = 0; i < n_splits; i++)
+    {
+        auto& spl = splits[i];
+
+        spl.id.parse ();
+        spl.account.parse ();
+        if (spl.seen & txn_element_bit (TxnElement::SPLIT_LOT))
+            spl.lot.parse ();
+        if (spl.seen & txn_element_bit (TxnElement::SPLIT_RECONCILE_DATE))
+            spl.reconcile_date.parse ();
+        spl.value_num = sixtp_stream_to_gnc_numeric (spl.value);
+        spl.quantity_num = sixtp_stream_to_gnc_numeric (spl.quantity);
+    }
+}
+
+static time64
+txn_stream_valid_time64 (time64 time, const char* name)
+{
+    return dom_tree_valid_time64 (time, BAD_CAST name) ? time : 0;
+}
+
+static Split*
+split_stream_to_split (split_stream_data& spl, QofBook* book)
+{
+    auto split = xaccMallocSplit (book);
+
+    if (auto guid = spl.id.get ())
+        xaccSplitSetGUID (split, guid);
+    if (spl.seen & txn_element_bit (TxnElement::SPLIT_MEMO))
+        xaccSplitSetMemo (split, spl.memo.c_str ());
+    if (spl.seen & txn_element_bit (TxnElement::SPLIT_ACTION))
+        xaccSplitSetAction (split, spl.action.c_str ());
+    xaccSplitSetReconcile (split, spl.reconciled[0]);
+    if (spl.seen & txn_element_bit (TxnElement::SPLIT_RECONCILE_DATE))
+        xaccSplitSetDateReconciledSecs (split,
+            txn_stream_valid_time64 (spl.reconcile_date.time,
+                                     "split:reconcile-date"));
+    xaccSplitSetValue (split, spl.value_num);
+    xaccSplitSetAmount (split, spl.quantity_num);
+    if (auto guid = spl.account.get ())
+        split_set_account (split, guid, book);
+    if (spl.seen & txn_element_bit (TxnElement::SPLIT_LOT))
+        if (auto guid = spl.lot.get ())
+            split_set_lot (split, guid, book);
+    if (spl.slots)
+    {
+        sixtp_stream_install_slots (QOF_INSTANCE (split), spl.slots);
+        spl.slots = nullptr;
+    }
+
+    return split;
+}
+
+Transaction*
+GncXmlTxnStream::to_transaction (QofBook* book)
+{
+    auto trn = xaccMallocTransaction (book);
+    xaccTransBeginEdit (trn);
+
+    if (auto guid = id.get ())
+        xaccTransSetGUID (trn, guid);
+    if (seen & txn_element_bit (TxnElement::CURRENCY))
+        xaccTransSetCurrency (trn, currency.lookup (book));
+    if (seen & txn_element_bit (TxnElement::NUM))
+        xaccTransSetNum (trn, num.c_str ());
+    xaccTransSetDatePostedSecs (trn,
+        txn_stream_valid_time64 (date_posted.time, "trn:date-posted"));
+    xaccTransSetDateEnteredSecs (trn,
+        txn_stream_valid_time64 (date_entered.time, "trn:date-entered"));
+    if (seen & txn_element_bit (TxnElement::DESCRIPTION))
+        xaccTransSetDescription (trn, description.c_str ());
+    if (slots)
+    {
+        sixtp_stream_install_slots (QOF_INSTANCE (trn), slots);
+        slots = nullptr;
+    }
+    for (size_t i = 0; i < n_splits; i++)
+        xaccTransAppendSplit (trn, split_stream_to_split (splits[i], book));
+
+    xaccTransCommitEdit (trn);
+    return trn;
+}
+
+static void txn_pipeline_push (GncXmlTxnPipeline* pipeline,
+                               GncXmlTxnStream* stream);
+
+gboolean
+GncXmlTxnStream::finish (gxpf_data* gdata, const gchar* tag,
+                         gpointer* result)
+{
+    if (bad || (seen & trn_required) != trn_required)
+    {
+        if (!bad)
+            PERR ("didn't find all of the expected tags in the input");
+        txn_stream_release (this);
+        return FALSE;
+    }
+
+    /* get () would give the transaction a made-up GUID or leave a split
+     * without an account. */
+    if (!id.typed || untyped_account)
+    {
+        PERR ("transaction with an id or split account that isn't a GUID");
+        txn_stream_release (this);
+        return FALSE;
+    }
+
+    if (pipeline)
+    {
+        txn_pipeline_push (pipeline, this);
+        return TRUE;
+    }
+
+    prepare ();
+    auto trn = to_transaction (static_cast<QofBook*> (gdata->bookdata));
+    gdata->cb (tag, gdata->parsedata, trn);
+    txn_stream_release (this);
+    return TRUE;
+}
+
+void
+GncXmlTxnStream::abort (GncXmlTxnStream* stream)
+{
+    txn_stream_release (stream);
+}
+
+static void
+txn_pipeline_prepare (gpointer job_data, gpointer pipeline_data)
+{
+    auto stream = static_cast<GncXmlTxnStream*> (job_data);
+    auto pipeline = static_cast<GncXmlTxnPipeline*> (pipeline_data);
+
+    stream->prepare ();
+
+    g_mutex_lock (&pipeline->mutex);
+    stream->ready = true;
+    g_cond_signal (&pipeline->cond);
+    g_mutex_unlock (&pipeline->mutex);
+}
+
+static void
+txn_pipeline_insert (GncXmlTxnPipeline* pipeline, GncXmlTxnStream* stream)
+{
+    auto gdata = &pipeline->gdata;
+    auto book = static_cast<QofBook*> (gdata->bookdata);
+    auto trn = stream->to_transaction (book);
+
+    if (!gdata->cb (stream->tag.c_str (), gdata->parsedata, trn))
+        pipeline->ok = FALSE;
+
+    txn_stream_release (stream);
+}
+
+/* Insert the finished transactions at the head of the queue, waiting for
+ * the workers for as long as more than max_pending are outstanding. */
+static void
+txn_pipeline_collect (GncXmlTxnPipeline* pipeline, size_t max_pending)
+{
+    while (!pipeline->jobs.empty ())
+    {
+        auto stream = pipeline->jobs.front ();
+
+        g_mutex_lock (&pipeline->mutex);
+        if (pipeline->jobs.size () > max_pending)
+            while (!stream->ready)
+                g_cond_wait (&pipeline->cond, &pipeline->mutex);
+        auto ready = stream->ready;
+        g_mutex_unlock (&pipeline->mutex);
+
+        if (!ready)
+            break;
+
+        pipeline->jobs.pop_front ();
+        txn_pipeline_insert (pipeline, stream);
+    }
+}
+
+static void
+txn_pipeline_push (GncXmlTxnPipeline* pipeline, GncXmlTxnStream* stream)
+{
+    pipeline->jobs.push_back (stream);
+    g_thread_pool_push (pipeline->pool, stream, NULL);
+
+    txn_pipeline_collect (pipeline, pipeline->max_jobs);
+}
+
+GncXmlTxnPipeline*
+gnc_transaction_pipeline_new (const gxpf_data* gdata, int n_workers)
+{
+    g_return_val_if_fail (gdata, NULL);
+    g_return_val_if_fail (n_workers > 0, NULL);
+
+    auto pipeline = new GncXmlTxnPipeline;
+    pipeline->gdata = *gdata;
+    pipeline->gdata.txn_pipeline = NULL;
+    g_mutex_init (&pipeline->mutex);
+    g_cond_init (&pipeline->cond);
+    /* Enough to keep the workers busy through a run of large transactions
+     * without holding much of the file in memory. */
+    pipeline->max_jobs = 64 * n_workers;
+    pipeline->ok = TRUE;
+    pipeline->pool = g_thread_pool_new (txn_pipeline_prepare, pipeline,
+                                        n_workers, TRUE, NULL);
+    return pipeline;
+}
+
+gboolean
+gnc_transaction_pipeline_flush (GncXmlTxnPipeline* pipeline)
+{
+    g_return_val_if_fail (pipeline, FALSE);
+
+    txn_pipeline_collect (pipeline, 0);
+    return pipeline->ok;
+}
+
+void
+gnc_transaction_pipeline_destroy (GncXmlTxnPipeline* pipeline)
+{
+    if (!pipeline)
+        return;
+
+    txn_pipeline_collect (pipeline, 0);
+    g_thread_pool_free (pipeline->pool, FALSE, TRUE);
+    for (auto stream : pipeline->spare)
+        delete stream;
+    g_cond_clear (&pipeline->cond);
+    g_mutex_clear (&pipeline->mutex);
+    delete pipeline;
+}
+
+sixtp*
+gnc_transaction_stream_parser_create (void)
+{
+    return sixtp_stream_parser_new<GncXmlTxnStream> (NULL, NULL);
+}
+
 sixtp*
 gnc_transaction_sixtp_parser_create (void)
 {
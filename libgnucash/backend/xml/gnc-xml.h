@@ -32,6 +32,9 @@
 
 #include "gnc-xml-helper.h"
 #include "sixtp.h"
+#include "io-gncxml-gen.h"
+
+class GncXmlWriter;
 
 xmlNodePtr gnc_account_dom_tree_create (Account* act, gboolean exporting,
                                         gboolean allow_incompat);
@@ -51,6 +54,11 @@ xmlNodePtr gnc_lot_dom_tree_create (GNCLot*);
 sixtp* gnc_lot_sixtp_parser_create (void);
 
 xmlNodePtr gnc_pricedb_dom_tree_create (GNCPriceDB* db);
+/** The <price> element of a single price, as it appears in the pricedb. */
+xmlNodePtr gnc_price_dom_tree_create (GNCPrice* price);
+/** Write the same element as gnc_price_dom_tree_create without building
+ * it.  Returns FALSE, having written nothing, where that returns NULL. */
+gboolean gnc_price_write_xml (GncXmlWriter& writer, GNCPrice* price);
 sixtp* gnc_pricedb_sixtp_parser_create (void);
 
 xmlNodePtr gnc_schedXaction_dom_tree_create (SchedXaction* sx);
@@ -60,7 +68,27 @@ xmlNodePtr gnc_budget_dom_tree_create (GncBudget* bgt);
 sixtp* gnc_budget_sixtp_parser_create (void);
 
 xmlNodePtr gnc_transaction_dom_tree_create (Transaction* txn);
+/** Write the same element as gnc_transaction_dom_tree_create without
+ * building it. */
+void gnc_transaction_write_xml (GncXmlWriter& writer, Transaction* txn);
 sixtp* gnc_transaction_sixtp_parser_create (void);
+/** Reads transactions straight from the SAX events instead of going
+ * through a DOM tree.  If the parse data has a transaction pipeline the
+ * transactions are handed to it, otherwise they're passed to the callback
+ * as soon as they're read. */
+sixtp* gnc_transaction_stream_parser_create (void);
+
+/** Convert the transactions read by the transaction stream parser on
+ * n_workers threads.  The finished transactions are passed to gdata's
+ * callback on the calling thread, in the order they were read, as the
+ * parser goes along and from within gnc_transaction_pipeline_flush.
+ */
+GncXmlTxnPipeline* gnc_transaction_pipeline_new (const gxpf_data* gdata,
+                                                 int n_workers);
+/** Wait for and insert all pending transactions.  Returns FALSE if any
+ * of the transactions read so far failed to convert. */
+gboolean gnc_transaction_pipeline_flush (GncXmlTxnPipeline* pipeline);
+void gnc_transaction_pipeline_destroy (GncXmlTxnPipeline* pipeline);
 
 sixtp* gnc_template_transaction_sixtp_parser_create (void);
 
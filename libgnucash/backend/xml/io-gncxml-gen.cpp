@@ -36,6 +36,7 @@ gnc_xml_parse_file (sixtp* top_parser, const char* filename,
     gpdata.cb = callback;
     gpdata.parsedata = parsedata;
     gpdata.bookdata = bookdata;
+    gpdata.txn_pipeline = NULL;
 
     return sixtp_parse_file (top_parser, filename,
                              NULL, &gpdata, &parse_result);
@@ -52,6 +53,7 @@ gnc_xml_parse_fd (sixtp* top_parser, FILE* fd,
     gpdata.cb = callback;
     gpdata.parsedata = parsedata;
     gpdata.bookdata = bookdata;
+    gpdata.txn_pipeline = NULL;
 
     return sixtp_parse_fd (top_parser, fd,
                            NULL, &gpdata, &parse_result);
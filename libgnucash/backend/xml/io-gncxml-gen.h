@@ -29,6 +29,8 @@
 
 #include "sixtp.h"
 
+typedef struct GncXmlTxnPipeline GncXmlTxnPipeline;
+
 typedef gboolean (*gxpf_callback) (const char* tag, gpointer parsedata,
                                    gpointer data);
 
@@ -37,6 +39,9 @@ struct gxpf_data_struct
     gxpf_callback cb;
     gpointer parsedata;
     gpointer bookdata;
+    /* When set, transactions are handed to this instead of being
+     * converted by the transaction parser's end handler. */
+    GncXmlTxnPipeline* txn_pipeline;
 };
 
 typedef struct gxpf_data_struct gxpf_data;
@@ -45,6 +45,9 @@
 #include <zlib.h>
 #include <errno.h>
 #include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
 
 #include "gnc-engine.h"
 #include "gnc-pricedb-p.h"
@@ -71,6 +74,7 @@
 #include "gnc-xml.h"
 #include "io-utils.h"
 #include "sixtp-dom-parsers.h"
+#include "sixtp-stream-generators.h"
 #include "io-gncxml-v2.h"
 #include "io-gncxml-gen.h"
 
@@ -82,6 +86,7 @@ typedef struct
     gchar* filename;
     gchar* perms;
     gboolean write;
+    gint threads;
 } gz_thread_params_t;
 
 /* Callback structure */
@@ -621,6 +626,23 @@ generic_callback (const char* tag, gpointer globaldata, gpointer data)
     return TRUE;
 }
 
+/* Whatever follows the transactions may refer to them, so they all have
+ * to be in the book before the next section is parsed. */
+static gboolean
+txn_pipeline_before_child (gpointer data_for_children,
+                           GSList* data_from_children, GSList* sibling_data,
+                           gpointer parent_data, gpointer global_data,
+                           gpointer* result, const gchar* tag,
+                           const gchar* child_tag)
+{
+    gxpf_data* gdata = (gxpf_data*)global_data;
+
+    if (gdata->txn_pipeline && g_strcmp0 (child_tag, TRANSACTION_TAG) != 0)
+        return gnc_transaction_pipeline_flush (gdata->txn_pipeline);
+
+    return TRUE;
+}
+
 static void
 add_parser(const GncXmlDataType_t& data, struct file_backend* be_data)
 {
@@ -678,6 +700,62 @@ gnc_sixtp_gdv2_new (
     return gd;
 }
 
+static int xml_load_threads = -1;
+
+void
+gnc_xml_set_load_threads (int n_threads)
+{
+    xml_load_threads = n_threads;
+}
+
+static int
+gnc_xml_get_load_threads (void)
+{
+    if (xml_load_threads >= 0)
+        return xml_load_threads;
+
+    if (auto env = g_getenv ("GNC_XML_LOAD_THREADS"))
+        return MAX (atoi (env), 0);
+
+    /* The parsing thread and the decompression thread are busy already,
+     * and beyond a few workers the parsing thread can't keep up anyway. */
+    return CLAMP (g_get_num_processors () - 1, 0, 4);
+}
+
+static int xml_save_threads = -1;
+static gsize xml_save_block_size = 0;
+
+void
+gnc_xml_set_save_threads (int n_threads)
+{
+    xml_save_threads = n_threads;
+}
+
+static int
+gnc_xml_get_save_threads (void)
+{
+    if (xml_save_threads >= 0)
+        return xml_save_threads;
+
+    if (auto env = g_getenv ("GNC_XML_SAVE_THREADS"))
+        return MAX (atoi (env), 0);
+
+    /* Leave a core for the thread walking the book. */
+    return CLAMP (g_get_num_processors () - 1, 0, 8);
+}
+
+void
+gnc_xml_set_save_block_size (gsize size)
+{
+    xml_save_block_size = size;
+}
+
+static gsize
+gnc_xml_get_save_block_size (void)
+{
+    return xml_save_block_size ? xml_save_block_size : 1 << 20;
+}
+
 static gboolean
 qof_session_load_from_xml_file_v2_full (
     GncXmlBackend* xml_be, QofBook* book,
@@ -691,6 +769,7 @@ qof_session_load_from_xml_file_v2_full (
     sixtp* main_parser;
     sixtp* book_parser;
     struct file_backend be_data;
+    gxpf_data gpdata;
     gboolean retval;
     char* v2type = NULL;
 
@@ -726,7 +805,7 @@ qof_session_load_from_xml_file_v2_full (
             PRICEDB_TAG, gnc_pricedb_sixtp_parser_create (),
             COMMODITY_TAG, gnc_commodity_sixtp_parser_create (),
             ACCOUNT_TAG, gnc_account_sixtp_parser_create (),
-            TRANSACTION_TAG, gnc_transaction_sixtp_parser_create (),
+            TRANSACTION_TAG, gnc_transaction_stream_parser_create (),
             SCHEDXACTION_TAG, gnc_schedXaction_sixtp_parser_create (),
             TEMPLATE_TRANSACTION_TAG, gnc_template_transaction_sixtp_parser_create (),
             NULL, NULL))
@@ -743,7 +822,7 @@ qof_session_load_from_xml_file_v2_full (
             COMMODITY_TAG, gnc_commodity_sixtp_parser_create (),
             ACCOUNT_TAG, gnc_account_sixtp_parser_create (),
             BUDGET_TAG, gnc_budget_sixtp_parser_create (),
-            TRANSACTION_TAG, gnc_transaction_sixtp_parser_create (),
+            TRANSACTION_TAG, gnc_transaction_stream_parser_create (),
             SCHEDXACTION_TAG, gnc_schedXaction_sixtp_parser_create (),
             TEMPLATE_TRANSACTION_TAG, gnc_template_transaction_sixtp_parser_create (),
             NULL, NULL))
@@ -762,14 +841,22 @@ qof_session_load_from_xml_file_v2_full (
     xaccLogDisable ();
     xaccDisableDataScrubbing ();
 
+    gpdata.cb = generic_callback;
+    gpdata.parsedata = gd;
+    gpdata.bookdata = book;
+    gpdata.txn_pipeline = NULL;
+
+    if (auto n_workers = gnc_xml_get_load_threads ())
+    {
+        gpdata.txn_pipeline = gnc_transaction_pipeline_new (&gpdata,
+                                                            n_workers);
+        sixtp_set_before_child (main_parser, txn_pipeline_before_child);
+        sixtp_set_before_child (book_parser, txn_pipeline_before_child);
+    }
+
     if (push_handler)
     {
         gpointer parse_result = NULL;
-        gxpf_data gpdata;
-
-        gpdata.cb = generic_callback;
-        gpdata.parsedata = gd;
-        gpdata.bookdata = book;
 
         retval = sixtp_parse_push (top_parser, push_handler, push_user_data,
                                    NULL, &gpdata, &parse_result);
@@ -792,14 +879,22 @@ qof_session_load_from_xml_file_v2_full (
         }
         else
         {
-            retval = gnc_xml_parse_fd (top_parser, file,
-                                       generic_callback, gd, book);
+            gpointer parse_result = NULL;
+
+            retval = sixtp_parse_fd (top_parser, file,
+                                     NULL, &gpdata, &parse_result);
             fclose (file);
             if (thread)
                 g_thread_join (thread);
         }
     }
 
+    if (gpdata.txn_pipeline)
+    {
+        retval = gnc_transaction_pipeline_flush (gpdata.txn_pipeline) && retval;
+        gnc_transaction_pipeline_destroy (gpdata.txn_pipeline);
+    }
+
     if (!retval)
     {
         sixtp_destroy (top_parser);
@@ -946,6 +1041,219 @@ compare_commodity_ids (gconstpointer a, gconstpointer b)
                        gnc_commodity_get_mnemonic (cb)));
 }
 
+/* Transactions, prices and scheduled transactions are rendered to text in
+ * runs on worker threads.  The calling thread walks the book, hands out the
+ * runs and writes the finished text in the order the objects were walked.
+ * Rendering only reads the engine objects, which is safe as long as nothing
+ * changes the book while it's being written.
+ */
+typedef gboolean (*xml_render_fn) (std::string& text, gpointer item);
+
+struct xml_write_run
+{
+    std::vector<gpointer> items;
+    std::string text;
+    gboolean ok;
+    gboolean ready;
+};
+
+struct xml_write_queue
+{
+    FILE* out;
+    sixtp_gdv2* gd;
+    xml_render_fn render;
+    int* counter;
+    const char* type;
+    GThreadPool* pool;
+    GMutex mutex;
+    GCond cond;
+    std::deque<xml_write_run*> runs;
+    std::vector<xml_write_run*> spare;
+    xml_write_run* filling;
+    size_t max_runs;
+    gboolean ok;
+};
+
+/* Large enough that handing out a run costs little next to rendering it. */
+constexpr size_t XML_WRITE_RUN_SIZE{256};
+
+static int
+xml_string_write (void* context, const char* buffer, int len)
+{
+    static_cast<std::string*> (context)->append (buffer, len);
+    return len;
+}
+
+/* Append node to text exactly as xmlElemDump would write it to a file. */
+static gboolean
+xml_node_to_string (std::string& text, xmlNodePtr node, int level)
+{
+    if (!node)
+        return FALSE;
+
+    auto outbuf = xmlOutputBufferCreateIO (xml_string_write, NULL, &text,
+                                           NULL);
+    if (!outbuf)
+        return FALSE;
+
+    xmlNodeDumpOutput (outbuf, NULL, node, level, 1, NULL);
+    return xmlOutputBufferClose (outbuf) >= 0;
+}
+
+static gboolean
+xml_write_run_render (xml_write_queue* queue, xml_write_run* run)
+{
+    for (auto item : run->items)
+        if (!queue->render (run->text, item))
+            return FALSE;
+    return TRUE;
+}
+
+static void
+xml_write_run_thread (gpointer job_data, gpointer queue_data)
+{
+    auto run = static_cast<xml_write_run*> (job_data);
+    auto queue = static_cast<xml_write_queue*> (queue_data);
+    auto ok = xml_write_run_render (queue, run);
+
+    g_mutex_lock (&queue->mutex);
+    run->ok = ok;
+    run->ready = TRUE;
+    g_cond_signal (&queue->cond);
+    g_mutex_unlock (&queue->mutex);
+}
+
+/* Write out the finished runs at the head of the queue, waiting for the
+ * workers for as long as more than max_pending are outstanding. */
+static void
+xml_write_queue_collect (xml_write_queue* queue, size_t max_pending)
+{
+    while (!queue->runs.empty ())
+    {
+        auto run = queue->runs.front ();
+
+        g_mutex_lock (&queue->mutex);
+        if (queue->runs.size () > max_pending)
+            while (!run->ready)
+                g_cond_wait (&queue->cond, &queue->mutex);
+        auto ready = run->ready;
+        g_mutex_unlock (&queue->mutex);
+
+        if (!ready)
+            break;
+
+        queue->runs.pop_front ();
+        if (!run->ok)
+            queue->ok = FALSE;
+        if (queue->ok)
+        {
+            if (fwrite (run->text.data (), 1, run->text.size (), queue->out)
+                != run->text.size () || ferror (queue->out))
+                queue->ok = FALSE;
+            else
+            {
+                *queue->counter += run->items.size ();
+                sixtp_run_callback (queue->gd, queue->type);
+            }
+        }
+
+        run->items.clear ();
+        run->text.clear ();
+        queue->spare.push_back (run);
+    }
+}
+
+static void
+xml_write_queue_submit (xml_write_queue* queue)
+{
+    auto run = queue->filling;
+
+    queue->filling = nullptr;
+    run->ok = FALSE;
+    run->ready = FALSE;
+    queue->runs.push_back (run);
+
+    if (!queue->pool)
+    {
+        run->ok = xml_write_run_render (queue, run);
+        run->ready = TRUE;
+        xml_write_queue_collect (queue, 0);
+        return;
+    }
+
+    g_thread_pool_push (queue->pool, run, NULL);
+    xml_write_queue_collect (queue, queue->max_runs);
+}
+
+static void
+xml_write_queue_init (xml_write_queue* queue, FILE* out, sixtp_gdv2* gd,
+                      xml_render_fn render, int* counter, const char* type)
+{
+    auto n_threads = gnc_xml_get_save_threads ();
+
+    queue->out = out;
+    queue->gd = gd;
+    queue->render = render;
+    queue->counter = counter;
+    queue->type = type;
+    queue->pool = nullptr;
+    queue->filling = nullptr;
+    queue->max_runs = 4 * n_threads;
+    queue->ok = TRUE;
+    g_mutex_init (&queue->mutex);
+    g_cond_init (&queue->cond);
+
+    if (n_threads > 0)
+    {
+        /* libxml2 has to be initialized on the main thread before it's
+         * used on others. */
+        xmlInitParser ();
+        queue->pool = g_thread_pool_new (xml_write_run_thread, queue,
+                                         n_threads, TRUE, NULL);
+    }
+}
+
+/* Returns the queue's ok so the caller can stop walking on an error. */
+static gboolean
+xml_write_queue_add (xml_write_queue* queue, gpointer item)
+{
+    if (!queue->filling)
+    {
+        if (queue->spare.empty ())
+            queue->filling = new xml_write_run;
+        else
+        {
+            queue->filling = queue->spare.back ();
+            queue->spare.pop_back ();
+        }
+    }
+
+    queue->filling->items.push_back (item);
+    if (queue->filling->items.size () >= XML_WRITE_RUN_SIZE)
+        xml_write_queue_submit (queue);
+
+    return queue->ok;
+}
+
+/* Write out everything that's been added and dispose of the queue. */
+static gboolean
+xml_write_queue_finish (xml_write_queue* queue)
+{
+    if (queue->filling)
+        xml_write_queue_submit (queue);
+    xml_write_queue_collect (queue, 0);
+
+    if (queue->pool)
+        g_thread_pool_free (queue->pool, FALSE, TRUE);
+    for (auto run : queue->spare)
+        delete run;
+    queue->spare.clear ();
+    g_cond_clear (&queue->cond);
+    g_mutex_clear (&queue->mutex);
+
+    return queue->ok;
+}
+
 static gboolean write_pricedb (FILE* out, QofBook* book, sixtp_gdv2* gd);
 static gboolean write_transactions (FILE* out, QofBook* book, sixtp_gdv2* gd);
 static gboolean write_template_transaction_data (FILE* out, QofBook* book,
@@ -1088,142 +1396,137 @@ write_commodities (FILE* out, QofBook* book, sixtp_gdv2* gd)
 }
 
 static gboolean
-write_pricedb (FILE* out, QofBook* book, sixtp_gdv2* gd)
+xml_render_price (std::string& text, gpointer item)
 {
-    xmlNodePtr node;
-    xmlNodePtr parent;
-    xmlOutputBufferPtr outbuf;
+    GncXmlWriter writer{text, 1};
+
+    /* Write two spaces since the writer doesn't indent the first line */
+    text += "  ";
+    auto ok = gnc_price_write_xml (writer, static_cast<GNCPrice*> (item));
+    /* It also doesn't terminate the last line */
+    text += '\n';
+    return ok;
+}
 
-    parent = gnc_pricedb_dom_tree_create (gnc_pricedb_get_db (book));
+static gboolean
+xml_queue_price (GNCPrice* p, gpointer data)
+{
+    static_cast<std::vector<GNCPrice*>*> (data)->push_back (p);
+    return TRUE;
+}
 
-    if (!parent)
-    {
-        return TRUE;
-    }
+static gboolean
+write_pricedb (FILE* out, QofBook* book, sixtp_gdv2* gd)
+{
+    std::vector<GNCPrice*> prices;
+    xml_write_queue queue;
 
-    /* Write out the parent pricedb tag then loop to write out each price.
-       We do it this way instead of just calling xmlElemDump so that we can
-       increment the progress bar as we go. */
+    gnc_pricedb_foreach_price (gnc_pricedb_get_db (book), xml_queue_price,
+                               &prices, TRUE);
+    if (prices.empty ())
+        return TRUE;
 
-    if (fprintf (out, "<%s version=\"%s\">\n", parent->name,
-                 xmlGetProp (parent, BAD_CAST "version")) < 0)
+    /* Write out the parent pricedb tag then the prices, so that the progress
+       bar moves as we go. */
+    if (fprintf (out, "<gnc:pricedb version=\"1\">\n") < 0)
         return FALSE;
 
-    /* We create our own output buffer so we can call xmlNodeDumpOutput to get
-       the indentation correct. */
-    outbuf = xmlOutputBufferCreateFile (out, NULL);
-    if (outbuf == NULL)
-    {
-        xmlFreeNode (parent);
+    xml_write_queue_init (&queue, out, gd, xml_render_price,
+                          &gd->counter.prices_loaded, "prices");
+    for (auto price : prices)
+        if (!xml_write_queue_add (&queue, price))
+            break;
+    if (!xml_write_queue_finish (&queue))
         return FALSE;
-    }
 
-    for (node = parent->children; node; node = node->next)
-    {
-        /* Write two spaces since xmlNodeDumpOutput doesn't indent the first line */
-        xmlOutputBufferWrite (outbuf, 2, "  ");
-        xmlNodeDumpOutput (outbuf, NULL, node, 1, 1, NULL);
-        /* It also doesn't terminate the last line */
-        xmlOutputBufferWrite (outbuf, 1, "\n");
-        if (ferror (out))
-            break;
-        gd->counter.prices_loaded += 1;
-        sixtp_run_callback (gd, "prices");
-    }
+    if (fprintf (out, "</gnc:pricedb>\n") < 0)
+        return FALSE;
 
-    xmlOutputBufferClose (outbuf);
+    return TRUE;
+}
 
-    if (ferror (out) || fprintf (out, "</%s>\n", parent->name) < 0)
-    {
-        xmlFreeNode (parent);
-        return FALSE;
-    }
+static gboolean
+xml_render_transaction (std::string& text, gpointer item)
+{
+    GncXmlWriter writer{text};
 
-    xmlFreeNode (parent);
+    gnc_transaction_write_xml (writer, static_cast<Transaction*> (item));
+    text += '\n';
     return TRUE;
 }
 
 static int
 xml_add_trn_data (Transaction* t, gpointer data)
 {
-    struct file_backend* be_data = static_cast<decltype (be_data)> (data);
-    xmlNodePtr node;
-
-    node = gnc_transaction_dom_tree_create (t);
+    auto queue = static_cast<xml_write_queue*> (data);
 
-    xmlElemDump (be_data->out, NULL, node);
-    xmlFreeNode (node);
-
-    if (ferror (be_data->out) || fprintf (be_data->out, "\n") < 0)
-        return -1;
-
-    be_data->gd->counter.transactions_loaded++;
-    sixtp_run_callback (be_data->gd, "transaction");
-    return 0;
+    return xml_write_queue_add (queue, t) ? 0 : -1;
 }
 
 static gboolean
 write_transactions (FILE* out, QofBook* book, sixtp_gdv2* gd)
 {
-    struct file_backend be_data;
+    xml_write_queue queue;
 
-    be_data.out = out;
-    be_data.gd = gd;
-    return 0 ==
-           xaccAccountTreeForEachTransaction (gnc_book_get_root_account (book),
-                                              xml_add_trn_data,
-                                              (gpointer) &be_data);
+    xml_write_queue_init (&queue, out, gd, xml_render_transaction,
+                          &gd->counter.transactions_loaded, "transaction");
+    xaccAccountTreeForEachTransaction (gnc_book_get_root_account (book),
+                                       xml_add_trn_data, &queue);
+    return xml_write_queue_finish (&queue);
 }
 
 static gboolean
 write_template_transaction_data (FILE* out, QofBook* book, sixtp_gdv2* gd)
 {
     Account* ra;
-    struct file_backend be_data;
-
-    be_data.out = out;
-    be_data.gd = gd;
+    xml_write_queue queue;
 
     ra = gnc_book_get_template_root (book);
     if (gnc_account_n_descendants (ra) > 0)
     {
         if (fprintf (out, "<%s>\n", TEMPLATE_TRANSACTION_TAG) < 0
-            || !write_account_tree (out, ra, gd)
-            || xaccAccountTreeForEachTransaction (ra, xml_add_trn_data, (gpointer)&be_data)
-            || fprintf (out, "</%s>\n", TEMPLATE_TRANSACTION_TAG) < 0)
+            || !write_account_tree (out, ra, gd))
+            return FALSE;
 
+        xml_write_queue_init (&queue, out, gd, xml_render_transaction,
+                              &gd->counter.transactions_loaded, "transaction");
+        xaccAccountTreeForEachTransaction (ra, xml_add_trn_data, &queue);
+        if (!xml_write_queue_finish (&queue)
+            || fprintf (out, "</%s>\n", TEMPLATE_TRANSACTION_TAG) < 0)
             return FALSE;
     }
 
     return TRUE;
 }
 
+static gboolean
+xml_render_schedXaction (std::string& text, gpointer item)
+{
+    auto node = gnc_schedXaction_dom_tree_create (static_cast<SchedXaction*> (item));
+    auto ok = xml_node_to_string (text, node, 0);
+    text += '\n';
+    xmlFreeNode (node);
+    return ok;
+}
+
 static gboolean
 write_schedXactions (FILE* out, QofBook* book, sixtp_gdv2* gd)
 {
     GList* schedXactions;
-    SchedXaction* tmpSX;
-    xmlNodePtr node;
+    xml_write_queue queue;
 
     schedXactions = gnc_book_get_schedxactions (book)->sx_list;
 
     if (schedXactions == NULL)
         return TRUE;
 
-    do
-    {
-        tmpSX = static_cast<decltype (tmpSX)> (schedXactions->data);
-        node = gnc_schedXaction_dom_tree_create (tmpSX);
-        xmlElemDump (out, NULL, node);
-        xmlFreeNode (node);
-        if (ferror (out) || fprintf (out, "\n") < 0)
-            return FALSE;
-        gd->counter.schedXactions_loaded++;
-        sixtp_run_callback (gd, "schedXactions");
-    }
-    while ((schedXactions = schedXactions->next));
+    xml_write_queue_init (&queue, out, gd, xml_render_schedXaction,
+                          &gd->counter.schedXactions_loaded, "schedXactions");
+    for (; schedXactions; schedXactions = schedXactions->next)
+        if (!xml_write_queue_add (&queue, schedXactions->data))
+            break;
 
-    return TRUE;
+    return xml_write_queue_finish (&queue);
 }
 
 static void
@@ -1478,6 +1781,217 @@ gz_thread_read (gzFile file, gz_thread_params_t* params)
     return success;
 }
 
+/* Parallel compression, the way pigz does it: the data is cut into blocks
+ * that are deflated on worker threads, each into a complete gzip member,
+ * and the members are written out in order.  A gzip file may hold any
+ * number of members, which gunzip and gzread read as one stream.  The cost
+ * is a member header per block and the dictionary not carrying over from
+ * one block to the next, which is negligible with blocks this large.
+ */
+struct gz_member
+{
+    std::vector<Bytef> in;
+    std::vector<Bytef> out;
+    gboolean ok;
+    gboolean ready;
+};
+
+struct gz_member_writer
+{
+    FILE* file;
+    const gchar* filename;
+    GThreadPool* pool;
+    GMutex mutex;
+    GCond cond;
+    std::deque<gz_member*> members;
+    std::vector<gz_member*> spare;
+    size_t max_members;
+    bool ok;
+};
+
+static gboolean
+gz_member_deflate (gz_member* member)
+{
+    z_stream stream{};
+
+    /* The same settings gzopen uses; adding 16 to the window bits writes a
+     * gzip header and trailer instead of a zlib one. */
+    if (deflateInit2 (&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                      MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return FALSE;
+
+    member->out.resize (deflateBound (&stream, member->in.size ()));
+    stream.next_in = member->in.data ();
+    stream.avail_in = member->in.size ();
+    stream.next_out = member->out.data ();
+    stream.avail_out = member->out.size ();
+
+    auto ret = deflate (&stream, Z_FINISH);
+    member->out.resize (stream.total_out);
+    deflateEnd (&stream);
+
+    return ret == Z_STREAM_END;
+}
+
+static void
+gz_member_thread (gpointer job_data, gpointer writer_data)
+{
+    auto member = static_cast<gz_member*> (job_data);
+    auto writer = static_cast<gz_member_writer*> (writer_data);
+    auto ok = gz_member_deflate (member);
+
+    g_mutex_lock (&writer->mutex);
+    member->ok = ok;
+    member->ready = TRUE;
+    g_cond_signal (&writer->cond);
+    g_mutex_unlock (&writer->mutex);
+}
+
+/* Write out the compressed members at the head of the queue, waiting for
+ * the workers for as long as more than max_pending are outstanding. */
+static void
+gz_member_collect (gz_member_writer* writer, size_t max_pending)
+{
+    while (!writer->members.empty ())
+    {
+        auto member = writer->members.front ();
+
+        g_mutex_lock (&writer->mutex);
+        if (writer->members.size () > max_pending)
+            while (!member->ready)
+                g_cond_wait (&writer->cond, &writer->mutex);
+        auto ready = member->ready;
+        g_mutex_unlock (&writer->mutex);
+
+        if (!ready)
+            break;
+
+        writer->members.pop_front ();
+        if (writer->ok && !member->ok)
+        {
+            g_warning ("Could not compress the data for '%s'",
+                       writer->filename);
+            writer->ok = false;
+        }
+        if (writer->ok &&
+            fwrite (member->out.data (), 1, member->out.size (), writer->file)
+            != member->out.size ())
+        {
+            g_warning ("Could not write the compressed file '%s'. The error is: '%s' (%d)",
+                       writer->filename,
+                       g_strerror (errno) ? g_strerror (errno) : "", errno);
+            writer->ok = false;
+        }
+        writer->spare.push_back (member);
+    }
+}
+
+static gz_member*
+gz_member_get (gz_member_writer* writer)
+{
+    if (writer->spare.empty ())
+        return new gz_member;
+
+    auto member = writer->spare.back ();
+    writer->spare.pop_back ();
+    return member;
+}
+
+/* Fill a block from the pipe.  Returns false at the end of the data. */
+static bool
+gz_member_fill (gz_member* member, gz_thread_params_t* params, gsize size,
+                bool* error)
+{
+    gsize filled = 0;
+
+    member->in.resize (size);
+    while (filled < size)
+    {
+        auto bytes = read (params->fd, member->in.data () + filled,
+                           size - filled);
+        if (bytes > 0)
+        {
+            filled += bytes;
+        }
+        else if (bytes == 0)
+        {
+            break;
+        }
+        else
+        {
+            g_warning ("Could not read from pipe. The error is '%s' (errno %d)",
+                       g_strerror (errno) ? g_strerror (errno) : "", errno);
+            *error = true;
+            break;
+        }
+    }
+    member->in.resize (filled);
+
+    return filled == size;
+}
+
+static inline bool
+gz_thread_write_members (gz_thread_params_t* params)
+{
+    gz_member_writer writer;
+    auto block_size = gnc_xml_get_save_block_size ();
+    bool more = true, error = false, written = false;
+
+    writer.file = g_fopen (params->filename, "wb");
+    if (!writer.file)
+    {
+        g_warning ("Could not open the compressed file '%s'. The error is: '%s' (%d)",
+                   params->filename,
+                   g_strerror (errno) ? g_strerror (errno) : "", errno);
+        return false;
+    }
+
+    writer.filename = params->filename;
+    writer.max_members = 2 * params->threads;
+    writer.ok = true;
+    g_mutex_init (&writer.mutex);
+    g_cond_init (&writer.cond);
+    writer.pool = g_thread_pool_new (gz_member_thread, &writer,
+                                     params->threads, TRUE, NULL);
+
+    while (more && !error && writer.ok)
+    {
+        auto member = gz_member_get (&writer);
+
+        more = gz_member_fill (member, params, block_size, &error);
+        /* Even an empty file needs one member to be a gzip file. */
+        if (error || (member->in.empty () && written))
+        {
+            writer.spare.push_back (member);
+            break;
+        }
+
+        member->ok = FALSE;
+        member->ready = FALSE;
+        writer.members.push_back (member);
+        g_thread_pool_push (writer.pool, member, NULL);
+        written = true;
+        gz_member_collect (&writer, writer.max_members);
+    }
+
+    gz_member_collect (&writer, 0);
+    g_thread_pool_free (writer.pool, FALSE, TRUE);
+    for (auto member : writer.spare)
+        delete member;
+    g_cond_clear (&writer.cond);
+    g_mutex_clear (&writer.mutex);
+
+    if (fclose (writer.file))
+    {
+        g_warning ("Could not close the compressed file '%s'. The error is: '%s' (%d)",
+                   params->filename,
+                   g_strerror (errno) ? g_strerror (errno) : "", errno);
+        return false;
+    }
+
+    return writer.ok && !error;
+}
+
 /* Compress or decompress function that is to be run in a separate thread.
  * Returns 1 on success or 0 otherwise, stuffed into a pointer type. */
 static gpointer
@@ -1485,8 +1999,15 @@ gz_thread_func (gz_thread_params_t* params)
 {
     gint gzval;
     bool success = true;
+    gzFile file;
+
+    if (params->write && params->threads > 0)
+    {
+        success = gz_thread_write_members (params);
+        goto cleanup_gz_thread_func;
+    }
 
-    auto file = do_gzopen (params->filename, params->perms);
+    file = do_gzopen (params->filename, params->perms);
 
     if (!file)
     {
@@ -1565,6 +2086,7 @@ try_gz_open (const char* filename, const char* perms, gboolean compress,
         params->filename = g_strdup (filename);
         params->perms = g_strdup (perms);
         params->write = write;
+        params->threads = write ? gnc_xml_get_save_threads () : 0;
 
         auto thread = g_thread_new ("xml_thread", (GThreadFunc) gz_thread_func,
                                     params);
@@ -85,6 +85,28 @@ typedef struct
 gboolean qof_session_load_from_xml_file_v2 (GncXmlBackend*, QofBook*,
                                             QofBookFileType);
 
+/** Set the number of worker threads used to convert transactions while
+ * loading a file.  0 converts them on the parsing thread; a negative
+ * value, the default, uses GNC_XML_LOAD_THREADS from the environment if
+ * it's set and a number based on the processor count otherwise.
+ */
+void gnc_xml_set_load_threads (int n_threads);
+
+/** Set the number of worker threads used to write a file.  Transactions,
+ * prices and scheduled transactions are rendered on them, and compressed
+ * files are written as a series of gzip members deflated in parallel.  0
+ * does all of it on the calling thread and a single compression thread; a
+ * negative value, the default, uses GNC_XML_SAVE_THREADS from the
+ * environment if it's set and a number based on the processor count
+ * otherwise.
+ */
+void gnc_xml_set_save_threads (int n_threads);
+
+/** Set how much uncompressed data goes into each gzip member when
+ * compressing on worker threads.  0 restores the default of 1 MiB.
+ */
+void gnc_xml_set_save_block_size (gsize size);
+
 /* write all book info to a file */
 gboolean gnc_book_write_to_xml_filehandle_v2 (QofBook* book, FILE* fh);
 gboolean gnc_book_write_to_xml_file_v2 (QofBook* book, const char* filename,
@@ -414,8 +414,8 @@ dom_tree_to_kvp_frame_given (xmlNodePtr node, KvpFrame* frame)
             {
                 if (val)
                 {
-                    //We're deleting the old KvpValue returned by replace_nc().
-                    delete frame->set ({key}, val);
+                    /* Sorted below, once they're all in. */
+                    frame->add_unsorted (key, val);
                 }
                 else
                 {
@@ -425,6 +425,7 @@ dom_tree_to_kvp_frame_given (xmlNodePtr node, KvpFrame* frame)
             }
         }
     }
+    frame->sort_added ();
 
     return TRUE;
 }
@@ -0,0 +1,386 @@
+/********************************************************************
+ * sixtp-stream-generators.cpp                                      *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+#include <glib.h>
+
+#include <config.h>
+#include <stdio.h>
+#include <string.h>
+#include <cinttypes>
+
+#include <kvp-frame.hpp>
+#include <gnc-datetime.hpp>
+
+#include "gnc-xml-helper.h"
+#include "sixtp-dom-generators.h"
+#include "sixtp-stream-generators.h"
+
+/* xmlNodeDumpOutput stops indenting deeper than this. */
+static const int MAX_INDENT_LEVEL = 30;
+
+void
+GncXmlWriter::indent (int depth)
+{
+    m_out.append (2 * MIN (m_level + depth, MAX_INDENT_LEVEL), ' ');
+}
+
+void
+GncXmlWriter::begin_child ()
+{
+    if (m_open)
+    {
+        m_out += ">\n";
+        m_open = false;
+    }
+    if (m_depth > 0)
+        indent (m_depth);
+}
+
+void
+GncXmlWriter::start (const char* tag, const char* attr, const char* value)
+{
+    begin_child ();
+    m_out += '<';
+    m_out += tag;
+    if (attr)
+    {
+        m_out += ' ';
+        m_out += attr;
+        m_out += "=\"";
+        m_out += value;
+        m_out += '"';
+    }
+    m_open = true;
+    ++m_depth;
+}
+
+void
+GncXmlWriter::end (const char* tag)
+{
+    g_return_if_fail (m_depth > 0);
+
+    --m_depth;
+    if (m_open)
+    {
+        m_out += "/>";
+        m_open = false;
+    }
+    else
+    {
+        indent (m_depth);
+        m_out += "</";
+        m_out += tag;
+        m_out += '>';
+    }
+
+    if (m_depth > 0)
+        m_out += '\n';
+}
+
+/* libxml2 escapes text content this way when it's writing UTF-8. */
+void
+GncXmlWriter::escape (const char* str, size_t len, bool checked)
+{
+    const char* run = str;
+    const char* end = str + len;
+
+    for (auto p = str; p < end; ++p)
+    {
+        const char* entity;
+
+        switch (*p)
+        {
+        case '<':
+            entity = "&lt;";
+            break;
+        case '>':
+            entity = "&gt;";
+            break;
+        case '&':
+            entity = "&amp;";
+            break;
+        case '\r':
+            entity = "&#13;";
+            break;
+        default:
+            /* See checked_char_cast. */
+            if (checked && *p > 0 && *p < 0x20 && *p != 0x09 && *p != 0x0a)
+                entity = "?";
+            else
+                continue;
+            break;
+        }
+        m_out.append (run, p - run);
+        m_out += entity;
+        run = p + 1;
+    }
+    m_out.append (run, end - run);
+}
+
+void
+GncXmlWriter::text_element (const char* tag, const char* str,
+                            const char* attr, const char* value, bool checked)
+{
+    start (tag, attr, value);
+    if (!str)
+    {
+        end (tag);
+        return;
+    }
+
+    m_out += '>';
+    m_open = false;
+    escape (str, strlen (str), checked);
+
+    /* Not indented: the element holds text. */
+    --m_depth;
+    m_out += "</";
+    m_out += tag;
+    m_out += '>';
+    if (m_depth > 0)
+        m_out += '\n';
+}
+
+void
+GncXmlWriter::text (const char* tag, const char* str, const char* attr,
+                    const char* value)
+{
+    text_element (tag, str, attr, value, false);
+}
+
+void
+GncXmlWriter::checked_text (const char* tag, const char* str,
+                            const char* attr, const char* value)
+{
+    if (!str || g_utf8_validate (str, -1, NULL))
+    {
+        text_element (tag, str, attr, value, true);
+        return;
+    }
+
+    /* Rare enough that the copy doesn't matter. */
+    auto copy = g_strdup (str);
+    text_element (tag, reinterpret_cast<const char*> (checked_char_cast (copy)),
+                  attr, value, false);
+    g_free (copy);
+}
+
+void
+GncXmlWriter::guid (const char* tag, const GncGUID* gid)
+{
+    char guid_str[GUID_ENCODING_LENGTH + 1];
+
+    if (!guid_to_string_buff (gid, guid_str))
+        return;
+
+    text (tag, guid_str, "type", "guid");
+}
+
+void
+GncXmlWriter::commodity_ref (const char* tag, const gnc_commodity* c)
+{
+    g_return_if_fail (c);
+
+    auto name_space = gnc_commodity_get_namespace (c);
+    auto mnemonic = gnc_commodity_get_mnemonic (c);
+    if (!name_space || !mnemonic)
+        return;
+
+    start (tag);
+    checked_text ("cmdty:space", name_space);
+    checked_text ("cmdty:id", mnemonic);
+    end (tag);
+}
+
+/* GncDateTime (time).format_iso8601 () for the years boost handles,
+   without going through the time zone. */
+static bool
+format_time64 (time64 time, char* buf, size_t size)
+{
+    /* 1400-01-01 and 9999-12-31 23:59:59 */
+    if (time < INT64_C(-17987443200) || time > INT64_C(253402300799))
+        return false;
+
+    auto days = time / 86400;
+    auto secs = time % 86400;
+    if (secs < 0)
+    {
+        secs += 86400;
+        --days;
+    }
+
+    /* Howard Hinnant's civil_from_days. */
+    auto z = days + 719468;
+    auto era = (z >= 0 ? z : z - 146096) / 146097;
+    auto doe = z - era * 146097;
+    auto yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    auto doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    auto mp = (5 * doy + 2) / 153;
+    auto day = doy - (153 * mp + 2) / 5 + 1;
+    auto month = mp < 10 ? mp + 3 : mp - 9;
+    auto year = yoe + era * 400 + (month <= 2);
+
+    snprintf (buf, size, "%04d-%02d-%02d %02d:%02d:%02d",
+              static_cast<int> (year), static_cast<int> (month),
+              static_cast<int> (day), static_cast<int> (secs / 3600),
+              static_cast<int> (secs / 60 % 60), static_cast<int> (secs % 60));
+    return true;
+}
+
+void
+GncXmlWriter::time (const char* tag, time64 time, const char* attr,
+                    const char* value)
+{
+    /* Room for the UTC offset. */
+    char buf[32];
+
+    g_return_if_fail (time != INT64_MAX);
+
+    if (!format_time64 (time, buf, sizeof (buf)))
+    {
+        auto date_str = GncDateTime (time).format_iso8601 ();
+        if (date_str.empty ())
+            return;
+        g_strlcpy (buf, date_str.c_str (), sizeof (buf) - 6);
+    }
+    //Tack on a UTC offset to mollify GnuCash for Android
+    strcat (buf, " +0000");
+
+    start (tag, attr, value);
+    checked_text ("ts:date", buf);
+    end (tag);
+}
+
+void
+GncXmlWriter::gdate (const char* tag, const GDate* date, const char* attr,
+                     const char* value)
+{
+    gchar date_str[512] = "";
+
+    g_return_if_fail (date);
+
+    g_date_strftime (date_str, sizeof (date_str), "%Y-%m-%d", date);
+    start (tag, attr, value);
+    checked_text ("gdate", date_str);
+    end (tag);
+}
+
+void
+GncXmlWriter::numeric (const char* tag, gnc_numeric num)
+{
+    char buf[48];
+
+    snprintf (buf, sizeof (buf), "%" PRId64 "/%" PRId64, num.num, num.denom);
+    text (tag, buf);
+}
+
+void
+GncXmlWriter::kvp_value (const char* tag, const KvpValue* val)
+{
+    char buf[48];
+
+    /* Note: The type attribute must remain 'timespec' to maintain
+     * compatibility.
+     */
+    switch (val->get_type ())
+    {
+    case KvpValue::Type::INT64:
+        snprintf (buf, sizeof (buf), "%" PRId64, val->get<int64_t> ());
+        text (tag, buf, "type", "integer");
+        break;
+    case KvpValue::Type::DOUBLE:
+    {
+        auto dbl_str = double_to_string (val->get<double> ());
+        checked_text (tag, *dbl_str ? dbl_str : nullptr, "type", "double");
+        g_free (dbl_str);
+        break;
+    }
+    case KvpValue::Type::NUMERIC:
+    {
+        auto num = val->get<gnc_numeric> ();
+        snprintf (buf, sizeof (buf), "%" PRId64 "/%" PRId64, num.num,
+                  num.denom);
+        text (tag, buf, "type", "numeric");
+        break;
+    }
+    case KvpValue::Type::STRING:
+        checked_text (tag, val->get<const char*> (), "type", "string");
+        break;
+    case KvpValue::Type::GUID:
+    {
+        auto guid = val->get<GncGUID*> ();
+        if (guid && guid_to_string_buff (guid, buf))
+            text (tag, buf, "type", "guid");
+        else
+            text (tag, nullptr, "type", "guid");
+        break;
+    }
+    case KvpValue::Type::TIME64:
+        time (tag, val->get<Time64> ().t, "type", "timespec");
+        break;
+    case KvpValue::Type::GDATE:
+    {
+        auto d = val->get<GDate> ();
+        gdate (tag, &d, "type", "gdate");
+        break;
+    }
+    case KvpValue::Type::GLIST:
+        start (tag, "type", "list");
+        for (auto cursor = val->get<GList*> (); cursor; cursor = cursor->next)
+            kvp_value ("slot:value", static_cast<KvpValue*> (cursor->data));
+        end (tag);
+        break;
+    case KvpValue::Type::FRAME:
+        start (tag, "type", "frame");
+        if (auto frame = val->get<KvpFrame*> ())
+            kvp_frame (frame);
+        end (tag);
+        break;
+    default:
+        start (tag);
+        end (tag);
+        break;
+    }
+}
+
+void
+GncXmlWriter::kvp_frame (const KvpFrame* frame)
+{
+    frame->for_each_slot_temp ([this] (const char* key, KvpValue* value)
+    {
+        start ("slot");
+        checked_text ("slot:key", key);
+        kvp_value ("slot:value", value);
+        end ("slot");
+    });
+}
+
+void
+GncXmlWriter::instance_slots (const char* tag, const QofInstance* inst)
+{
+    KvpFrame* frame = qof_instance_get_slots (inst);
+    if (!frame || frame->empty ())
+        return;
+
+    start (tag);
+    kvp_frame (frame);
+    end (tag);
+}
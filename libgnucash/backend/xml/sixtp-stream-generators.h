@@ -0,0 +1,101 @@
+/********************************************************************
+ * sixtp-stream-generators.h                                        *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+
+#ifndef SIXTP_STREAM_GENERATORS_H
+#define SIXTP_STREAM_GENERATORS_H
+
+#include <glib.h>
+
+#include <string>
+
+#include "gnc-commodity.h"
+#include "qof.h"
+
+/* Writes elements straight to text instead of building a DOM tree and
+   dumping it.  The output is byte for byte what xmlNodeDumpOutput makes of
+   the trees the matching *_to_dom_tree functions build: elements holding
+   elements have each child on its own line, indented two spaces a level,
+   elements holding text don't, and elements holding nothing are closed
+   with "/>".
+
+   A start tag is only finished when the first child is written, so an
+   element that ends up empty comes out the same as its DOM counterpart
+   whether or not anything was tried inside it.
+*/
+class GncXmlWriter
+{
+public:
+    /* level is the indentation level of the first element, as passed to
+       xmlNodeDumpOutput.  Like there, the first element's start tag isn't
+       indented and its end tag isn't followed by a newline. */
+    GncXmlWriter (std::string& out, int level = 0) :
+        m_out{out}, m_level{level} {}
+    GncXmlWriter (const GncXmlWriter&) = delete;
+    GncXmlWriter& operator= (const GncXmlWriter&) = delete;
+
+    /* Open an element with an optional attribute.  The attribute value
+       isn't escaped. */
+    void start (const char* tag, const char* attr = nullptr,
+                const char* value = nullptr);
+    void end (const char* tag);
+
+    /* An element holding text, as xmlNewTextChild makes it: NULL text
+       gives an empty element, "" an element holding an empty string.  The
+       text is written as it is, apart from escaping. */
+    void text (const char* tag, const char* str, const char* attr = nullptr,
+               const char* value = nullptr);
+    /* The same, with str run through checked_char_cast first. */
+    void checked_text (const char* tag, const char* str,
+                       const char* attr = nullptr,
+                       const char* value = nullptr);
+
+    /* Counterparts of guid_to_dom_tree, commodity_ref_to_dom_tree,
+       time64_to_dom_tree, gdate_to_dom_tree, gnc_numeric_to_dom_tree and
+       qof_instance_slots_to_dom_tree.  Where those return NULL these
+       write nothing. */
+    void guid (const char* tag, const GncGUID* gid);
+    void commodity_ref (const char* tag, const gnc_commodity* c);
+    void time (const char* tag, time64 time, const char* attr = nullptr,
+               const char* value = nullptr);
+    void gdate (const char* tag, const GDate* date,
+                const char* attr = nullptr, const char* value = nullptr);
+    void numeric (const char* tag, gnc_numeric num);
+    void instance_slots (const char* tag, const QofInstance* inst);
+
+private:
+    void begin_child ();
+    void indent (int depth);
+    void escape (const char* str, size_t len, bool checked);
+    void text_element (const char* tag, const char* str, const char* attr,
+                       const char* value, bool checked);
+    void kvp_value (const char* tag, const KvpValue* val);
+    void kvp_frame (const KvpFrame* frame);
+
+    std::string& m_out;
+    int m_level;
+    /* The number of open elements. */
+    int m_depth = 0;
+    /* Whether the innermost open element's start tag still needs its '>'. */
+    bool m_open = false;
+};
+
+#endif /* SIXTP_STREAM_GENERATORS_H */
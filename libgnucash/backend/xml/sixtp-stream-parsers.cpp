@@ -0,0 +1,459 @@
+/********************************************************************
+ * sixtp-stream-parsers.cpp                                         *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+#include <glib.h>
+
+#include <config.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "qofinstance-p.h"
+#include <kvp-frame.hpp>
+
+#include "sixtp-utils.h"
+#include "sixtp-stream-parsers.h"
+
+static QofLogModule log_module = GNC_MOD_IO;
+
+/***********************************************************************/
+
+void
+GncXmlStreamGuid::start (const gchar* tag, gchar** attrs)
+{
+    text.clear ();
+    typed = parsed = false;
+
+    /* dom_tree_to_guid only looks at the first attribute. */
+    if (!attrs || !attrs[0])
+        return;
+
+    if (strcmp (attrs[0], "type") != 0)
+    {
+        PERR ("Unknown attribute for id tag: %s", attrs[0]);
+        return;
+    }
+
+    /* handle new and guid the same for the moment */
+    if (g_strcmp0 ("guid", attrs[1]) == 0 || g_strcmp0 ("new", attrs[1]) == 0)
+        typed = true;
+    else
+        PERR ("Unknown type %s for attribute type for tag %s",
+              attrs[1] ? attrs[1] : "(null)", attrs[0]);
+}
+
+void
+GncXmlStreamGuid::parse ()
+{
+    parsed = typed && string_to_guid (text.c_str (), &guid);
+}
+
+const GncGUID*
+GncXmlStreamGuid::get ()
+{
+    if (!typed)
+        return nullptr;
+
+    if (!parsed)
+    {
+        guid_replace (&guid);
+        parsed = true;
+    }
+    return &guid;
+}
+
+void
+GncXmlStreamDate::parse ()
+{
+    if (count == 1)
+        time = gnc_iso8601_to_time64_gmt (text.c_str ());
+    else
+    {
+        if (!count)
+            PERR ("no ts:date node found.");
+        time = INT64_MAX;
+    }
+}
+
+gnc_commodity*
+GncXmlStreamCommodity::lookup (QofBook* book)
+{
+    gnc_commodity* daref = NULL;
+
+    if (spaces == 1 && ids == 1)
+    {
+        auto space_str = g_strstrip (g_strdup (space.c_str ()));
+        auto id_str = g_strstrip (g_strdup (id.c_str ()));
+        daref = gnc_commodity_new (book, NULL, space_str, id_str, NULL, 0);
+        g_free (space_str);
+        g_free (id_str);
+    }
+
+    auto table = gnc_commodity_table_get_table (book);
+    g_return_val_if_fail (table != NULL, NULL);
+
+    auto ret = gnc_commodity_table_lookup (table,
+                                           gnc_commodity_get_namespace (daref),
+                                           gnc_commodity_get_mnemonic (daref));
+    gnc_commodity_destroy (daref);
+
+    g_return_val_if_fail (ret != NULL, NULL);
+
+    return ret;
+}
+
+gnc_numeric
+sixtp_stream_to_gnc_numeric (const std::string& text)
+{
+    gnc_numeric num = gnc_numeric_from_string (text.c_str ());
+    if (gnc_numeric_check (num))
+        num = gnc_numeric_zero ();
+    return num;
+}
+
+void
+sixtp_stream_install_slots (QofInstance* inst, KvpFrame* frame)
+{
+    auto slots = qof_instance_get_slots (inst);
+
+    for (auto& slot : *frame)
+    {
+        slots->add_unsorted (slot.first, slot.second);
+        slot.second = nullptr;
+    }
+    slots->sort_added ();
+    delete frame;
+}
+
+/***********************************************************************/
+/* Slots
+
+   <foo:slots>
+     <slot>
+       <slot:key>bar</slot:key>
+       <slot:value type="frame">
+         <slot> ... </slot>
+       </slot:value>
+     </slot>
+   </foo:slots>
+*/
+
+GncXmlSlotBuilder::~GncXmlSlotBuilder ()
+{
+    reset ();
+}
+
+void
+GncXmlSlotBuilder::reset ()
+{
+    while (m_depth > 0)
+    {
+        auto& entry = m_stack[--m_depth];
+
+        delete entry.value;
+        entry.value = nullptr;
+
+        if (entry.list)
+        {
+            for (auto node = entry.list; node; node = node->next)
+                delete static_cast<KvpValue*> (node->data);
+            g_list_free (entry.list);
+            entry.list = nullptr;
+        }
+
+        /* The outermost frame is the caller's, and has to be left usable. */
+        if (entry.kind == Kind::VALUE)
+            delete entry.frame;
+        else if (entry.kind == Kind::FRAME && entry.frame)
+            entry.frame->sort_added ();
+        entry.frame = nullptr;
+    }
+}
+
+GncXmlSlotBuilder::Entry&
+GncXmlSlotBuilder::push (Kind kind)
+{
+    if (m_depth == m_stack.size ())
+        m_stack.emplace_back ();
+
+    auto& entry = m_stack[m_depth++];
+    entry.kind = kind;
+    entry.type = Type::NONE;
+    entry.text.clear ();
+    entry.have_key = false;
+    entry.value = nullptr;
+    entry.frame = nullptr;
+    entry.list = nullptr;
+    entry.dates = 0;
+    entry.bad_date = false;
+    return entry;
+}
+
+void
+GncXmlSlotBuilder::begin (KvpFrame* frame)
+{
+    reset ();
+    push (Kind::FRAME).frame = frame;
+}
+
+void
+GncXmlSlotBuilder::start (const gchar* tag, gchar** attrs)
+{
+    g_return_if_fail (m_depth > 0);
+
+    /* Note: The type attribute must remain 'timespec' to maintain
+     * compatibility. */
+    static const struct
+    {
+        const gchar* tag;
+        Type type;
+    } value_types[] =
+    {
+        { "integer", Type::INTEGER },
+        { "double", Type::DOUBLE },
+        { "numeric", Type::NUMERIC },
+        { "string", Type::STRING },
+        { "guid", Type::GUID },
+        { "timespec", Type::TIMESPEC },
+        { "gdate", Type::GDATE },
+        { "list", Type::LIST },
+        { "frame", Type::FRAME },
+    };
+
+    auto parent_kind = m_stack[m_depth - 1].kind;
+    auto parent_type = m_stack[m_depth - 1].type;
+    auto kind = Kind::IGNORE;
+
+    if (parent_kind == Kind::FRAME ||
+        (parent_kind == Kind::VALUE && parent_type == Type::FRAME))
+    {
+        if (g_strcmp0 (tag, "slot") == 0)
+            kind = Kind::SLOT;
+    }
+    else if (parent_kind == Kind::SLOT)
+    {
+        if (g_strcmp0 (tag, "slot:key") == 0)
+            kind = Kind::KEY;
+        else if (g_strcmp0 (tag, "slot:value") == 0)
+            kind = Kind::VALUE;
+    }
+    else if (parent_kind == Kind::VALUE)
+    {
+        /* List members are values whatever they're called. */
+        if (parent_type == Type::LIST)
+            kind = Kind::VALUE;
+        else if (parent_type == Type::TIMESPEC &&
+                 g_strcmp0 (tag, "ts:date") == 0)
+            kind = Kind::TS_DATE;
+        else if (parent_type == Type::GDATE && g_strcmp0 (tag, "gdate") == 0)
+            kind = Kind::GDATE;
+    }
+
+    auto& entry = push (kind);
+    if (kind != Kind::VALUE)
+        return;
+
+    for (auto attr = attrs; attr && attr[0]; attr += 2)
+    {
+        if (strcmp (attr[0], "type") != 0)
+            continue;
+
+        for (const auto& value_type : value_types)
+            if (g_strcmp0 (attr[1], value_type.tag) == 0)
+                entry.type = value_type.type;
+        break;
+    }
+
+    if (entry.type == Type::FRAME)
+        entry.frame = new KvpFrame;
+}
+
+void
+GncXmlSlotBuilder::characters (const char* text, int length)
+{
+    g_return_if_fail (m_depth > 0);
+
+    auto& entry = m_stack[m_depth - 1];
+    switch (entry.kind)
+    {
+    case Kind::KEY:
+    case Kind::TS_DATE:
+    case Kind::GDATE:
+        entry.text.append (text, length);
+        break;
+    case Kind::VALUE:
+        switch (entry.type)
+        {
+        case Type::INTEGER:
+        case Type::DOUBLE:
+        case Type::NUMERIC:
+        case Type::STRING:
+        case Type::GUID:
+            entry.text.append (text, length);
+            break;
+        default:
+            break;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+KvpValue*
+GncXmlSlotBuilder::finish_value (Entry& entry)
+{
+    KvpValue* ret = nullptr;
+
+    switch (entry.type)
+    {
+    case Type::INTEGER:
+    {
+        gint64 daint;
+        if (string_to_gint64 (entry.text.c_str (), &daint))
+            ret = new KvpValue {daint};
+        break;
+    }
+    case Type::DOUBLE:
+    {
+        double dadoub;
+        if (string_to_double (entry.text.c_str (), &dadoub))
+            ret = new KvpValue {dadoub};
+        break;
+    }
+    case Type::NUMERIC:
+        ret = new KvpValue {sixtp_stream_to_gnc_numeric (entry.text)};
+        break;
+    case Type::STRING:
+        ret = new KvpValue {static_cast<const gchar*> (g_strdup (entry.text.c_str ()))};
+        break;
+    case Type::GUID:
+    {
+        auto daguid = guid_new ();
+        string_to_guid (entry.text.c_str (), daguid);
+        ret = new KvpValue {daguid};
+        break;
+    }
+    case Type::TIMESPEC:
+    {
+        if (!entry.dates)
+            PERR ("no ts:date node found.");
+        Time64 t{entry.dates == 1 ? entry.time : INT64_MAX};
+        ret = new KvpValue {t};
+        break;
+    }
+    case Type::GDATE:
+        if (!entry.dates)
+            PWARN ("no gdate node found.");
+        else if (!entry.bad_date)
+            ret = new KvpValue {entry.date};
+        break;
+    case Type::LIST:
+        ret = new KvpValue {g_list_reverse (entry.list)};
+        entry.list = nullptr;
+        break;
+    case Type::FRAME:
+        entry.frame->sort_added ();
+        ret = new KvpValue {entry.frame};
+        entry.frame = nullptr;
+        break;
+    case Type::NONE:
+        break;
+    }
+
+    return ret;
+}
+
+void
+GncXmlSlotBuilder::deliver (Entry& parent, KvpValue* value)
+{
+    if (parent.kind == Kind::SLOT)
+    {
+        delete parent.value;
+        parent.value = value;
+    }
+    else if (value)
+    {
+        parent.list = g_list_prepend (parent.list, value);
+    }
+}
+
+void
+GncXmlSlotBuilder::end ()
+{
+    g_return_if_fail (m_depth > 0);
+
+    auto& entry = m_stack[m_depth - 1];
+    Entry* parent = m_depth > 1 ? &m_stack[m_depth - 2] : nullptr;
+
+    switch (entry.kind)
+    {
+    case Kind::SLOT:
+        if (entry.have_key && entry.value)
+        {
+            /* Sorted once the frame is complete; a repeated key's last
+             * value wins as it would with set. */
+            parent->frame->add_unsorted (entry.key, entry.value);
+        }
+        else
+            delete entry.value;
+        entry.value = nullptr;
+        break;
+    case Kind::KEY:
+        parent->key.swap (entry.text);
+        parent->have_key = true;
+        break;
+    case Kind::VALUE:
+        deliver (*parent, finish_value (entry));
+        break;
+    case Kind::TS_DATE:
+        if (!parent->dates++)
+            parent->time = gnc_iso8601_to_time64_gmt (entry.text.c_str ());
+        break;
+    case Kind::GDATE:
+    {
+        gint year, month, day;
+
+        if (parent->dates++ ||
+            sscanf (entry.text.c_str (), "%d-%d-%d", &year, &month, &day) != 3)
+        {
+            parent->bad_date = true;
+            break;
+        }
+
+        g_date_clear (&parent->date, 1);
+        g_date_set_dmy (&parent->date, day, static_cast<GDateMonth> (month),
+                        year);
+        if (!g_date_valid (&parent->date))
+        {
+            PWARN ("invalid date");
+            parent->bad_date = true;
+        }
+        break;
+    }
+    case Kind::FRAME:
+        entry.frame->sort_added ();
+        break;
+    case Kind::IGNORE:
+        break;
+    }
+
+    --m_depth;
+}
@@ -0,0 +1,272 @@
+/********************************************************************
+ * sixtp-stream-parsers.h                                           *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+
+#ifndef SIXTP_STREAM_PARSERS_H
+#define SIXTP_STREAM_PARSERS_H
+
+#include <glib.h>
+
+#include <string>
+#include <vector>
+
+#include "qof.h"
+#include "gnc-commodity.h"
+#include <kvp-frame.hpp>
+
+#include "sixtp.h"
+#include "io-gncxml-gen.h"
+
+/* Stream parsers read an element straight from the SAX events instead of
+   building a DOM tree of it first and walking that.  The Handler class
+   holds the parse state of one top-level element and provides
+
+     static Handler* begin (gxpf_data* gdata, const gchar* tag, gchar** attrs);
+     bool start (const gchar* tag, gchar** attrs);
+     void characters (const char* text, int length);
+     bool end (const gchar* tag);
+     gboolean finish (gxpf_data* gdata, const gchar* tag, gpointer* result);
+     static void abort (Handler* handler);
+
+   begin is called for the top-level element's start tag and finish for its
+   end tag; start, characters and end for everything in between.  finish
+   and abort dispose of the handler.
+
+   Like the DOM parser, don't put anything into the parent's
+   data_for_children: that's how the top-level element is recognized.
+*/
+
+template <class Handler> gboolean
+sixtp_stream_start_handler (GSList* sibling_data, gpointer parent_data,
+                            gpointer global_data, gpointer* data_for_children,
+                            gpointer* result, const gchar* tag, gchar** attrs)
+{
+    /* The parser context calls this without a tag when it's created. */
+    if (!tag)
+        return TRUE;
+
+    *result = NULL;
+
+    if (!parent_data)
+    {
+        auto handler = Handler::begin (static_cast<gxpf_data*> (global_data),
+                                       tag, attrs);
+        *data_for_children = handler;
+        return handler != nullptr;
+    }
+
+    *data_for_children = parent_data;
+    return static_cast<Handler*> (parent_data)->start (tag, attrs);
+}
+
+template <class Handler> gboolean
+sixtp_stream_chars_handler (GSList* sibling_data, gpointer parent_data,
+                            gpointer global_data, gpointer* result,
+                            const char* text, int length)
+{
+    if (parent_data && length > 0)
+        static_cast<Handler*> (parent_data)->characters (text, length);
+    return TRUE;
+}
+
+template <class Handler> gboolean
+sixtp_stream_end_handler (gpointer data_for_children,
+                          GSList* data_from_children, GSList* sibling_data,
+                          gpointer parent_data, gpointer global_data,
+                          gpointer* result, const gchar* tag)
+{
+    auto handler = static_cast<Handler*> (data_for_children);
+
+    if (!tag || !handler)
+        return TRUE;
+
+    if (parent_data)
+        return handler->end (tag);
+
+    return handler->finish (static_cast<gxpf_data*> (global_data), tag,
+                            result);
+}
+
+template <class Handler> void
+sixtp_stream_fail_handler (gpointer data_for_children,
+                           GSList* data_from_children, GSList* sibling_data,
+                           gpointer parent_data, gpointer global_data,
+                           gpointer* result, const gchar* tag)
+{
+    if (!parent_data && data_for_children)
+        Handler::abort (static_cast<Handler*> (data_for_children));
+}
+
+template <class Handler> sixtp*
+sixtp_stream_parser_new (sixtp_result_handler cleanup_result_by_default_func,
+                         sixtp_result_handler cleanup_result_on_fail_func)
+{
+    sixtp* top_level = sixtp_new ();
+
+    if (!top_level)
+        return NULL;
+
+    sixtp_set_start (top_level, sixtp_stream_start_handler<Handler>);
+    sixtp_set_chars (top_level, sixtp_stream_chars_handler<Handler>);
+    sixtp_set_end (top_level, sixtp_stream_end_handler<Handler>);
+    sixtp_set_fail (top_level, sixtp_stream_fail_handler<Handler>);
+
+    if (cleanup_result_by_default_func)
+        sixtp_set_cleanup_result (top_level, cleanup_result_by_default_func);
+
+    if (cleanup_result_on_fail_func)
+        sixtp_set_result_fail (top_level, cleanup_result_on_fail_func);
+
+    if (!sixtp_add_sub_parser (top_level, SIXTP_MAGIC_CATCHER, top_level))
+    {
+        sixtp_destroy (top_level);
+        return NULL;
+    }
+
+    return top_level;
+}
+
+/* An id element's text, read the way dom_tree_to_guid reads it. */
+struct GncXmlStreamGuid
+{
+    std::string text;
+    bool typed = false;
+    bool parsed = false;
+    GncGUID guid;
+
+    /* Call with the element's attributes at its start tag. */
+    void start (const gchar* tag, gchar** attrs);
+    /* Safe to call off the main thread. */
+    void parse ();
+    /* NULL if the element wasn't typed as a GUID, a new GUID if its text
+       wasn't one. */
+    const GncGUID* get ();
+};
+
+/* The <ts:date> child of a date element, read the way dom_tree_to_time64
+   reads it.  Only the first child's text is kept; more than one makes the
+   date invalid. */
+struct GncXmlStreamDate
+{
+    std::string text;
+    int count = 0;
+    time64 time = INT64_MAX;
+
+    void start ()
+    {
+        text.clear ();
+        count = 0;
+    }
+    /* Returns the buffer for the next <ts:date>'s text, or NULL to drop it. */
+    std::string* ts_date ()
+    {
+        return ++count == 1 ? &text : nullptr;
+    }
+    /* Safe to call off the main thread. */
+    void parse ();
+};
+
+/* The <cmdty:space> and <cmdty:id> children of a commodity reference. */
+struct GncXmlStreamCommodity
+{
+    std::string space;
+    std::string id;
+    int spaces = 0;
+    int ids = 0;
+
+    void start ()
+    {
+        space.clear ();
+        id.clear ();
+        spaces = ids = 0;
+    }
+    /* The buffers for the children's text, NULL for repeats. */
+    std::string* cmdty_space ()
+    {
+        return ++spaces == 1 ? &space : nullptr;
+    }
+    std::string* cmdty_id ()
+    {
+        return ++ids == 1 ? &id : nullptr;
+    }
+    /* The commodity in book's table, NULL if there isn't one or the
+       reference is malformed. */
+    gnc_commodity* lookup (QofBook* book);
+};
+
+gnc_numeric sixtp_stream_to_gnc_numeric (const std::string& text);
+
+/* Merge frame's slots into inst's, consuming frame. */
+void sixtp_stream_install_slots (QofInstance* inst, KvpFrame* frame);
+
+/* Builds the slots of a <foo:slots> element into a KvpFrame the same way
+   dom_tree_to_kvp_frame does, one SAX event at a time.  The entries stay
+   around between elements so their buffers are reused. */
+class GncXmlSlotBuilder
+{
+public:
+    GncXmlSlotBuilder () = default;
+    GncXmlSlotBuilder (const GncXmlSlotBuilder&) = delete;
+    GncXmlSlotBuilder& operator= (const GncXmlSlotBuilder&) = delete;
+    ~GncXmlSlotBuilder ();
+
+    /* Start on the <foo:slots> element, adding its slots to frame. */
+    void begin (KvpFrame* frame);
+    /* TRUE until the <foo:slots> element has ended. */
+    bool active () const { return m_depth > 0; }
+    void start (const gchar* tag, gchar** attrs);
+    void characters (const char* text, int length);
+    void end ();
+    /* Throw away a partly built frame's pending values. */
+    void reset ();
+
+private:
+    enum class Kind { FRAME, SLOT, KEY, VALUE, TS_DATE, GDATE, IGNORE };
+    enum class Type
+    {
+        NONE, INTEGER, DOUBLE, NUMERIC, STRING, GUID, TIMESPEC, GDATE, LIST,
+        FRAME
+    };
+    struct Entry
+    {
+        Kind kind;
+        Type type;
+        std::string text;
+        std::string key;
+        bool have_key;
+        KvpValue* value;
+        KvpFrame* frame;
+        GList* list;
+        int dates;
+        bool bad_date;
+        time64 time;
+        GDate date;
+    };
+
+    Entry& push (Kind kind);
+    KvpValue* finish_value (Entry& entry);
+    void deliver (Entry& parent, KvpValue* value);
+
+    std::vector<Entry> m_stack;
+    size_t m_depth = 0;
+};
+
+#endif /* SIXTP_STREAM_PARSERS_H */
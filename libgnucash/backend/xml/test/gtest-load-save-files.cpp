@@ -32,12 +32,15 @@
 
 #include <cstdlib>
 #include <functional>
+#include <iostream>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include <Account.h>
 #include <cashobjects.h>
 #include <TransLog.h>
+#include <Transaction.h>
 #include <gnc-engine.h>
 #include <gnc-prefs.h>
 
@@ -111,7 +114,14 @@ decompress_file (std::string filename, const std::vector<unsigned char> &in, std
         return false;
     }
 
-    ret = inflate (&stream, Z_NO_FLUSH);
+    /* Files compressed in parallel consist of several gzip members. */
+    while ((ret = inflate (&stream, Z_NO_FLUSH)) == Z_STREAM_END
+           && stream.avail_in)
+    {
+        ret = inflateReset (&stream);
+        if (ret != Z_OK)
+            break;
+    }
     if (ret != Z_STREAM_END)
     {
         ADD_FAILURE() << "decompress_file: " << filename << " could not be uncompressed (inflate "
@@ -202,9 +212,9 @@ public:
             << " \"" << qof_session_get_error_message (_session.get ()) << "\""; \
     } while (0)
 
-TEST_P(LoadSaveFiles, test_file)
+static void
+load_save_file (const std::string& filename)
 {
-    auto filename = GetParam();
     /* Verify that we can write a compressed version of the original file that
      * has the original content when uncompressed.
      */
@@ -277,6 +287,209 @@ TEST_P(LoadSaveFiles, test_file)
         return;
 }
 
+TEST_P(LoadSaveFiles, test_file)
+{
+    gnc_xml_set_load_threads (0);
+    load_save_file (GetParam ());
+    gnc_xml_set_load_threads (-1);
+}
+
+/* The same again with the transactions converted by worker threads, and
+ * written by them with small enough blocks that the compressed file has
+ * many gzip members. */
+TEST_P(LoadSaveFiles, test_file_pipelined)
+{
+    gnc_xml_set_load_threads (4);
+    gnc_xml_set_save_threads (4);
+    gnc_xml_set_save_block_size (4096);
+    load_save_file (GetParam ());
+    gnc_xml_set_save_block_size (0);
+    gnc_xml_set_save_threads (-1);
+    gnc_xml_set_load_threads (-1);
+}
+
+TEST_P(LoadSaveFiles, test_file_serial_save)
+{
+    gnc_xml_set_save_threads (0);
+    load_save_file (GetParam ());
+    gnc_xml_set_save_threads (-1);
+}
+
+/* Not run by default.  Run with --gtest_also_run_disabled_tests
+ * --gtest_filter='LoadBenchmark.*' to compare loading a generated book
+ * with transactions converted on the parsing thread and with worker
+ * threads.
+ */
+class LoadBenchmark : public testing::Test
+{
+public:
+    static void SetUpTestSuite ()
+    {
+        LoadSaveFiles::SetUpTestSuite ();
+    }
+
+    static void TearDownTestSuite ()
+    {
+        LoadSaveFiles::TearDownTestSuite ();
+    }
+};
+
+static void
+make_benchmark_book (QofBook* book, int n_transactions)
+{
+    auto table = gnc_commodity_table_get_table (book);
+    auto currency = gnc_commodity_table_lookup (table,
+                                                GNC_COMMODITY_NS_CURRENCY,
+                                                "USD");
+    auto root = gnc_book_get_root_account (book);
+    std::vector<Account*> accounts;
+
+    for (auto i = 0; i < 50; ++i)
+    {
+        auto account = xaccMallocAccount (book);
+        auto name = std::string{"Account "} + std::to_string (i);
+
+        xaccAccountBeginEdit (account);
+        xaccAccountSetName (account, name.c_str ());
+        xaccAccountSetType (account, i % 2 ? ACCT_TYPE_EXPENSE :
+                            ACCT_TYPE_BANK);
+        xaccAccountSetCommodity (account, currency);
+        gnc_account_append_child (root, account);
+        xaccAccountCommitEdit (account);
+        accounts.push_back (account);
+    }
+
+    auto rand = g_rand_new_with_seed (20261017);
+    for (auto i = 0; i < n_transactions; ++i)
+    {
+        auto trans = xaccMallocTransaction (book);
+        auto amount = gnc_numeric_create (g_rand_int_range (rand, 1, 1000000),
+                                          100);
+        auto date = 1262304000 + g_rand_int_range (rand, 0, 3650) * 86400;
+        auto num = std::to_string (i);
+
+        xaccTransBeginEdit (trans);
+        xaccTransSetCurrency (trans, currency);
+        xaccTransSetDatePostedSecsNormalized (trans, date);
+        xaccTransSetDateEnteredSecs (trans, date);
+        xaccTransSetNum (trans, num.c_str ());
+        xaccTransSetDescription (trans, "Benchmark transaction");
+        for (auto value : {amount, gnc_numeric_neg (amount)})
+        {
+            auto split = xaccMallocSplit (book);
+            auto account = accounts[g_rand_int_range (rand, 0,
+                                                      accounts.size ())];
+
+            xaccSplitSetParent (split, trans);
+            xaccSplitSetAccount (split, account);
+            xaccSplitSetMemo (split, "Benchmark split");
+            xaccSplitSetValue (split, value);
+            xaccSplitSetAmount (split, value);
+        }
+        xaccTransCommitEdit (trans);
+    }
+    g_rand_free (rand);
+}
+
+static double
+time_load (const std::string& filename, int n_threads, guint n_transactions)
+{
+    auto session = std::shared_ptr<QofSession>{qof_session_new (qof_book_new ()), qof_session_destroy};
+    auto timer = g_timer_new ();
+
+    gnc_xml_set_load_threads (n_threads);
+    qof_session_begin (session.get (), filename.c_str (), SESSION_READ_ONLY);
+    g_timer_start (timer);
+    qof_session_load (session.get (), nullptr);
+    auto elapsed = g_timer_elapsed (timer, nullptr);
+    gnc_xml_set_load_threads (-1);
+
+    EXPECT_EQ (qof_session_get_error (session.get ()), 0);
+    auto book = qof_session_get_book (session.get ());
+    EXPECT_EQ (qof_collection_count (qof_book_get_collection (book, GNC_ID_TRANS)),
+               n_transactions);
+
+    qof_session_end (session.get ());
+    g_timer_destroy (timer);
+    return elapsed;
+}
+
+TEST_F(LoadBenchmark, DISABLED_pipelined_load)
+{
+    const guint n_transactions = 200000;
+    std::shared_ptr<gchar> filename{g_build_filename (g_get_tmp_dir (), "load-benchmark.gnucash", (gchar*)nullptr), g_free};
+
+    {
+        auto session = std::shared_ptr<QofSession>{qof_session_new (nullptr), qof_session_destroy};
+
+        g_unlink (filename.get ());
+        QOF_SESSION_CHECKED_CALL(qof_session_begin, session, filename.get (), SESSION_NEW_OVERWRITE);
+        make_benchmark_book (qof_session_get_book (session.get ()), n_transactions);
+        gnc_prefs_set_file_save_compressed (TRUE);
+        QOF_SESSION_CHECKED_CALL(qof_session_save, session, nullptr);
+        qof_session_end (session.get ());
+    }
+
+    auto serial = time_load (filename.get (), 0, n_transactions);
+    auto pipelined = time_load (filename.get (), -1, n_transactions);
+    std::cout << n_transactions << " transactions: " << serial
+              << "s single threaded, " << pipelined << "s pipelined"
+              << std::endl;
+
+    g_unlink (filename.get ());
+}
+
+/* Not run by default.  Run with --gtest_also_run_disabled_tests
+ * --gtest_filter='SaveBenchmark.*' to compare writing a generated book of
+ * a million splits on the calling thread and with worker threads.
+ */
+class SaveBenchmark : public LoadBenchmark
+{
+};
+
+static double
+time_save (QofSession* session, int n_threads, gboolean compress)
+{
+    auto timer = g_timer_new ();
+
+    gnc_xml_set_save_threads (n_threads);
+    gnc_prefs_set_file_save_compressed (compress);
+    qof_book_mark_session_dirty (qof_session_get_book (session));
+    g_timer_start (timer);
+    qof_session_save (session, nullptr);
+    auto elapsed = g_timer_elapsed (timer, nullptr);
+    gnc_xml_set_save_threads (-1);
+
+    EXPECT_EQ (qof_session_get_error (session), 0);
+    g_timer_destroy (timer);
+    return elapsed;
+}
+
+TEST_F(SaveBenchmark, DISABLED_parallel_save)
+{
+    /* Two splits each. */
+    const guint n_transactions = 500000;
+    std::shared_ptr<gchar> filename{g_build_filename (g_get_tmp_dir (), "save-benchmark.gnucash", (gchar*)nullptr), g_free};
+    auto session = std::shared_ptr<QofSession>{qof_session_new (nullptr), qof_session_destroy};
+
+    g_unlink (filename.get ());
+    QOF_SESSION_CHECKED_CALL(qof_session_begin, session, filename.get (), SESSION_NEW_OVERWRITE);
+    make_benchmark_book (qof_session_get_book (session.get ()), n_transactions);
+
+    for (auto compress : {TRUE, FALSE})
+    {
+        auto serial = time_save (session.get (), 0, compress);
+        auto parallel = time_save (session.get (), -1, compress);
+        std::cout << 2 * n_transactions << " splits, "
+                  << (compress ? "compressed: " : "uncompressed: ") << serial
+                  << "s single threaded, " << parallel << "s parallel"
+                  << std::endl;
+    }
+
+    qof_session_end (session.get ());
+    g_unlink (filename.get ());
+}
+
 std::vector<std::string> ListTestCases ();
 
 INSTANTIATE_TEST_SUITE_P(
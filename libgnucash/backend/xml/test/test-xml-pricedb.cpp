@@ -40,11 +40,14 @@
 #include "sixtp.h"
 #include "sixtp-parsers.h"
 #include "sixtp-dom-parsers.h"
+#include "sixtp-stream-generators.h"
 #include "io-gncxml-v2.h"
 #include "test-file-stuff.h"
 #include "test-stuff.h"
 #include <qoflog.h>
 
+#include <vector>
+
 static const QofLogModule log_module = G_LOG_DOMAIN;
 
 static QofSession* session = NULL;
@@ -64,6 +67,45 @@ test_add_pricedb (const char* tag, gpointer globaldata, gpointer data)
     return TRUE;
 }
 
+static int
+string_write (void* context, const char* buffer, int len)
+{
+    static_cast<std::string*> (context)->append (buffer, len);
+    return len;
+}
+
+static gboolean
+collect_price (GNCPrice* p, gpointer data)
+{
+    static_cast<std::vector<GNCPrice*>*> (data)->push_back (p);
+    return TRUE;
+}
+
+/* Each price written directly has to come out exactly as it's written
+ * from the pricedb's DOM tree. */
+static void
+test_price_writer (xmlNodePtr db_node, GNCPriceDB* db)
+{
+    std::vector<GNCPrice*> prices;
+    auto node = db_node->xmlChildrenNode;
+
+    gnc_pricedb_foreach_price (db, collect_price, &prices, TRUE);
+    for (auto price : prices)
+    {
+        std::string dom_text, text;
+        GncXmlWriter writer{text, 1};
+
+        auto outbuf = xmlOutputBufferCreateIO (string_write, NULL, &dom_text,
+                                               NULL);
+        xmlNodeDumpOutput (outbuf, NULL, node, 1, 1, NULL);
+        xmlOutputBufferClose (outbuf);
+
+        do_test_args (gnc_price_write_xml (writer, price) && text == dom_text,
+                      "gnc_price_write_xml", __FILE__, __LINE__, "%d", iter);
+        node = node->next;
+    }
+}
+
 static void
 test_db (GNCPriceDB* db)
 {
@@ -84,6 +126,8 @@ test_db (GNCPriceDB* db)
     if (!db)
         return;
 
+    test_price_writer (test_node, db);
+
     filename1 = g_strdup_printf ("test_file_XXXXXX");
 
     fd = g_mkstemp (filename1);
@@ -33,6 +33,8 @@
 #include <dirent.h>
 #include <sys/stat.h>
 
+#include <string>
+
 #include <gnc-engine.h>
 #include <cashobjects.h>
 #include <TransLog.h>
@@ -48,6 +50,7 @@
 #include "../gnc-xml.h"
 #include "../sixtp-parsers.h"
 #include "../sixtp-dom-parsers.h"
+#include "../sixtp-stream-generators.h"
 #include "../io-gncxml-gen.h"
 #include "test-file-stuff.h"
 #include <test-stuff.h>
@@ -372,7 +375,7 @@ test_transaction (void)
         Transaction* ran_trn;
         xmlNodePtr test_node;
         gnc_commodity* com, *new_com;
-        gchar* filename1;
+        gchar* filename1, *filename2;
         int fd;
 
         /* The next line exists for its side effect of creating the
@@ -441,6 +444,26 @@ test_transaction (void)
 
         close (fd);
 
+        /* Writing the transaction directly has to give exactly the same
+         * file, and that's the one read back below. */
+        {
+            std::string text;
+            GncXmlWriter writer{text};
+
+            gnc_transaction_write_xml (writer, ran_trn);
+
+            filename2 = g_strdup_printf ("test_file_XXXXXX");
+            fd = g_mkstemp (filename2);
+            do_test_args (write (fd, text.data (), text.size ())
+                          == static_cast<ssize_t> (text.size ()),
+                          "gnc_transaction_write_xml", __FILE__, __LINE__,
+                          "write %d", i);
+            close (fd);
+            do_test_args (files_compare (filename1, filename2) == 0,
+                          "gnc_transaction_write_xml", __FILE__, __LINE__,
+                          "%d", i);
+        }
+
         {
             GList* node = xaccTransGetSplitList (ran_trn);
             for (; node; node = node->next)
@@ -456,6 +479,10 @@ test_transaction (void)
             }
         }
 
+        /* Read it back both through the DOM and straight from the SAX
+         * events. */
+        for (auto create_parser : {gnc_transaction_sixtp_parser_create,
+                                   gnc_transaction_stream_parser_create})
         {
             sixtp* parser;
             tran_data data;
@@ -473,9 +500,9 @@ test_transaction (void)
             data.trn = ran_trn;
             data.com = com;
             data.value = i;
-            parser = gnc_transaction_sixtp_parser_create ();
+            parser = create_parser ();
 
-            if (!gnc_xml_parse_file (parser, filename1, test_add_transaction,
+            if (!gnc_xml_parse_file (parser, filename2, test_add_transaction,
                                      (gpointer)&data, book))
             {
                 failure_args ("gnc_xml_parse_file returned FALSE",
@@ -490,11 +517,89 @@ test_transaction (void)
 
         g_unlink (filename1);
         g_free (filename1);
+        g_unlink (filename2);
+        g_free (filename2);
         really_get_rid_of_transaction (ran_trn);
         xmlFreeNode (test_node);
     }
 }
 
+static gboolean
+count_transaction (const char* tag, gpointer globaldata, gpointer data)
+{
+    ++*static_cast<int*> (globaldata);
+    really_get_rid_of_transaction (static_cast<Transaction*> (data));
+    return TRUE;
+}
+
+/* A transaction whose id or a split's account isn't typed as a GUID has to
+ * be rejected, and the same way by the DOM and the stream parsers, rather
+ * than given a made-up id or a split without an account. */
+static void
+test_malformed_transaction (void)
+{
+    static const char* typed = " type=\"guid\"";
+    static const struct
+    {
+        const char* id_attrs;
+        const char* account_attrs;
+        int accepted;
+    } cases[] =
+    {
+        { typed, typed, 1 },
+        { "", typed, 0 },
+        { " type=\"bogus\"", typed, 0 },
+        { typed, "", 0 },
+        { typed, " type=\"bogus\"", 0 },
+    };
+
+    for (const auto& c : cases)
+    {
+        auto text = std::string {"<gnc:transaction version=\"2.0.0\">\n"
+                                 "  <trn:id"} + c.id_attrs +
+            ">f18fa0198b104215b1a7365d1eaaf1ed</trn:id>\n"
+            "  <trn:date-posted>\n"
+            "    <ts:date>2018-02-23 10:59:00 +0000</ts:date>\n"
+            "  </trn:date-posted>\n"
+            "  <trn:date-entered>\n"
+            "    <ts:date>2018-02-23 20:33:58 +0000</ts:date>\n"
+            "  </trn:date-entered>\n"
+            "  <trn:splits>\n"
+            "    <trn:split>\n"
+            "      <split:id type=\"guid\">bf69b191406448e3b52a6956d0df5b98</split:id>\n"
+            "      <split:reconciled-state>n</split:reconciled-state>\n"
+            "      <split:value>1000000/100</split:value>\n"
+            "      <split:quantity>1000000/100</split:quantity>\n"
+            "      <split:account" + c.account_attrs +
+            ">547d8ff75f4347e3b3607c40b40a3fef</split:account>\n"
+            "    </trn:split>\n"
+            "  </trn:splits>\n"
+            "</gnc:transaction>\n";
+
+        auto filename = g_strdup ("test_file_XXXXXX");
+        auto fd = g_mkstemp (filename);
+        do_test (write (fd, text.data (), text.size ())
+                 == static_cast<ssize_t> (text.size ()),
+                 "malformed transaction write");
+        close (fd);
+
+        int dom_count = 0, stream_count = 0;
+        gnc_xml_parse_file (gnc_transaction_sixtp_parser_create (), filename,
+                            count_transaction, &dom_count, book);
+        gnc_xml_parse_file (gnc_transaction_stream_parser_create (), filename,
+                            count_transaction, &stream_count, book);
+        do_test_args (dom_count == c.accepted, "malformed transaction DOM",
+                      __FILE__, __LINE__, "id%s account%s", c.id_attrs,
+                      c.account_attrs);
+        do_test_args (stream_count == dom_count,
+                      "malformed transaction stream", __FILE__, __LINE__,
+                      "id%s account%s", c.id_attrs, c.account_attrs);
+
+        g_unlink (filename);
+        g_free (filename);
+    }
+}
+
 static gboolean
 test_real_transaction (const char* tag, gpointer global_data, gpointer data)
 {
@@ -528,6 +633,7 @@ main (int argc, char** argv)
     else
     {
         test_transaction ();
+        test_malformed_transaction ();
     }
 
     print_test_results ();
@@ -45,7 +45,9 @@
 #include "qofinstance-p.h"
 #include "gnc-features.h"
 #include "guid.hpp"
+#include "qof-backend.hpp"
 
+#include <algorithm>
 #include <numeric>
 #include <map>
 #include <unordered_set>
@@ -326,11 +328,15 @@ gnc_account_init(Account* acc)
     priv->starting_cleared_balance = gnc_numeric_zero();
     priv->starting_reconciled_balance = gnc_numeric_zero();
     priv->balance_dirty = FALSE;
+    priv->balance_dirty_from = 0;
 
     new (&priv->children) AccountVec ();
     new (&priv->splits) SplitsVec ();
+    new (&priv->split_dates) std::vector<time64> ();
     priv->splits_hash = g_hash_table_new (g_direct_hash, g_direct_equal);
     priv->sort_dirty = FALSE;
+    priv->sort_dirty_from = 0;
+    priv->splits_loaded_from = INT64_MIN;
 }
 
 static void
@@ -1134,6 +1140,36 @@ xaccInitAccount (Account * acc, QofBook *book)
 /********************************************************************\
 \********************************************************************/
 
+void
+gnc_account_set_splits_loaded_from (Account *acc, time64 date)
+{
+    g_return_if_fail (GNC_IS_ACCOUNT (acc));
+    GET_PRIVATE(acc)->splits_loaded_from = date;
+}
+
+time64
+gnc_account_get_splits_loaded_from (const Account *acc)
+{
+    g_return_val_if_fail (GNC_IS_ACCOUNT (acc), INT64_MIN);
+    return GET_PRIVATE(acc)->splits_loaded_from;
+}
+
+/* Ask the backend for the account's splits posted on or after date if it
+ * hasn't loaded them yet. */
+static void
+account_load_splits (const Account *acc, time64 date = INT64_MIN)
+{
+    if (G_LIKELY (date >= GET_PRIVATE(acc)->splits_loaded_from))
+        return;
+
+    auto book{qof_instance_get_book (acc)};
+    if (qof_book_shutting_down (book) || qof_instance_get_destroying (acc))
+        return;
+
+    if (auto be = qof_book_get_backend (book))
+        be->load_splits (QOF_INSTANCE (acc), date);
+}
+
 void
 gnc_account_foreach_split (const Account *acc, std::function<void(Split*)> func,
                            bool reverse)
@@ -1141,6 +1177,7 @@ gnc_account_foreach_split (const Account *acc, std::function<void(Split*)> func,
     if (!GNC_IS_ACCOUNT (acc))
         return;
 
+    account_load_splits (acc);
     auto& splits{GET_PRIVATE(acc)->splits};
     if (reverse)
         std::for_each(splits.rbegin(), splits.rend(), func);
@@ -1158,6 +1195,7 @@ gnc_account_foreach_split_until_date (const Account *acc, time64 end_date,
     auto after_date = [](time64 end_date, auto s) -> bool
     { return (xaccTransGetDate (xaccSplitGetParent (s)) > end_date); };
 
+    account_load_splits (acc);
     auto& splits{GET_PRIVATE(acc)->splits};
     auto after_date_iter = std::upper_bound (splits.begin(), splits.end(), end_date, after_date);
     std::for_each (splits.begin(), after_date_iter, f);
@@ -1171,6 +1209,7 @@ gnc_account_find_split (const Account *acc, std::function<bool(const Split*)> pr
     if (!GNC_IS_ACCOUNT (acc))
         return nullptr;
 
+    account_load_splits (acc);
     const auto& splits{GET_PRIVATE(acc)->splits};
     if (reverse)
     {
@@ -1458,8 +1497,10 @@ xaccFreeAccount (Account *acc)
     priv->commodity = nullptr;
 
     priv->balance_dirty = FALSE;
+    priv->balance_dirty_from = 0;
     priv->sort_dirty = FALSE;
     priv->splits.~SplitsVec();
+    priv->split_dates.~vector();
     priv->children.~AccountVec();
     g_hash_table_destroy (priv->splits_hash);
 
@@ -1542,6 +1583,13 @@ xaccAccountCommitEdit (Account *acc)
            themselves will be destroyed by the transaction code */
         if (!qof_book_shutting_down(book))
         {
+            /* Splits the backend hasn't loaded yet would be left behind
+               pointing at a deleted account. account_load_splits won't
+               load for an account being destroyed, so ask directly. */
+            if (priv->splits_loaded_from > INT64_MIN)
+                if (auto be = qof_book_get_backend (book))
+                    be->load_splits (QOF_INSTANCE (acc), INT64_MIN);
+
             // We need to delete in reverse order so that the vector's iterators aren't invalidated.
             for_each(priv->splits.rbegin(), priv->splits.rend(), [](Split *s) {
                 xaccSplitDestroy (s); });
@@ -1549,6 +1597,7 @@ xaccAccountCommitEdit (Account *acc)
         else
         {
             priv->splits.clear();
+            priv->split_dates.clear();
             g_hash_table_remove_all (priv->splits_hash);
         }
 
@@ -1862,6 +1911,17 @@ xaccAccountEqual(const Account *aa, const Account *ab, gboolean check_guids)
 
 /********************************************************************\
 \********************************************************************/
+
+/* Mark the running balances stale from position pos on.  The earliest
+ * position wins if the balances are already dirty. */
+static void
+account_set_balance_dirty_from (AccountPrivate *priv, size_t pos)
+{
+    if (!priv->balance_dirty || pos < priv->balance_dirty_from)
+        priv->balance_dirty_from = pos;
+    priv->balance_dirty = TRUE;
+}
+
 void
 gnc_account_set_sort_dirty (Account *acc)
 {
@@ -1874,6 +1934,7 @@ gnc_account_set_sort_dirty (Account *acc)
 
     priv = GET_PRIVATE(acc);
     priv->sort_dirty = TRUE;
+    priv->sort_dirty_from = 0;
 }
 
 void
@@ -1887,7 +1948,7 @@ gnc_account_set_balance_dirty (Account *acc)
         return;
 
     priv = GET_PRIVATE(acc);
-    priv->balance_dirty = TRUE;
+    account_set_balance_dirty_from (priv, 0);
 }
 
 void gnc_account_set_defer_bal_computation (Account *acc, gboolean defer)
@@ -1916,10 +1977,21 @@ gboolean gnc_account_get_defer_bal_computation (Account *acc)
 /********************************************************************\
 \********************************************************************/
 
-static bool split_cmp_less (const Split* a, const Split* b)
+/* xaccSplitOrder for the splits of one account, with the book option it
+ * depends on looked up once instead of on every comparison. */
+struct SplitOrderLess
 {
-    return xaccSplitOrder (a, b) < 0;
-}
+    gboolean action_for_num;
+
+    explicit SplitOrderLess (const Account *acc) :
+        action_for_num{qof_book_use_split_action_for_num_field
+                       (gnc_account_get_book (acc))} {}
+
+    bool operator() (const Split* a, const Split* b) const
+    {
+        return xaccSplitOrderActionForNum (a, b, action_for_num) < 0;
+    }
+};
 
 gboolean
 gnc_account_insert_split (Account *acc, Split *s)
@@ -1933,19 +2005,37 @@ gnc_account_insert_split (Account *acc, Split *s)
     if (!g_hash_table_add (priv->splits_hash, s))
         return false;
 
-    priv->splits.push_back (s);
-
-    if (qof_instance_get_editlevel(acc) == 0)
-        std::sort (priv->splits.begin(), priv->splits.end(), split_cmp_less);
+    if (!priv->sort_dirty && qof_instance_get_editlevel(acc) == 0)
+    {
+        auto pos{std::upper_bound (priv->splits.begin(), priv->splits.end(),
+                                   s, SplitOrderLess{acc})};
+        size_t idx = pos - priv->splits.begin();
+        account_set_balance_dirty_from (priv, idx);
+        if (idx <= priv->split_dates.size())
+            priv->split_dates.insert (priv->split_dates.begin() + idx,
+                                      xaccTransGetDate (s->parent));
+        priv->splits.insert (pos, s);
+    }
     else
-        priv->sort_dirty = true;
+    {
+        /* Append to the unsorted tail; xaccAccountSortSplits merges it
+         * into the sorted run in one go once the edit is done. */
+        if (!priv->sort_dirty)
+        {
+            priv->sort_dirty = TRUE;
+            priv->sort_dirty_from = priv->splits.size();
+        }
+        account_set_balance_dirty_from (priv, priv->splits.size());
+        priv->splits.push_back (s);
+        if (qof_instance_get_editlevel(acc) == 0)
+            xaccAccountSortSplits (acc, FALSE);
+    }
 
     //FIXME: find better event
     qof_event_gen (&acc->inst, QOF_EVENT_MODIFY, nullptr);
     /* Also send an event based on the account */
     qof_event_gen(&acc->inst, GNC_EVENT_ITEM_ADDED, s);
 
-    priv->balance_dirty = TRUE;
 //  DRH: Should the below be added? It is present in the delete path.
 //  xaccAccountRecomputeBalance(acc);
     return TRUE;
@@ -1967,17 +2057,32 @@ gnc_account_remove_split (Account *acc, Split *s)
     // shortcut pruning the last element. this is the most common
     // remove_split operation during UI or book shutdown.
     if (s == priv->splits.back())
+    {
         priv->splits.pop_back();
+        account_set_balance_dirty_from (priv, priv->splits.size());
+        if (priv->split_dates.size() > priv->splits.size())
+            priv->split_dates.pop_back();
+    }
     else
-        priv->splits.erase (std::remove (priv->splits.begin(), priv->splits.end(), s),
-                            priv->splits.end());
+    {
+        auto pos{std::find (priv->splits.begin(), priv->splits.end(), s)};
+        if (pos != priv->splits.end())
+        {
+            size_t idx = pos - priv->splits.begin();
+            account_set_balance_dirty_from (priv, idx);
+            if (priv->sort_dirty && idx < priv->sort_dirty_from)
+                --priv->sort_dirty_from;
+            if (idx < priv->split_dates.size())
+                priv->split_dates.erase (priv->split_dates.begin() + idx);
+            priv->splits.erase (pos);
+        }
+    }
 
     //FIXME: find better event type
     qof_event_gen(&acc->inst, QOF_EVENT_MODIFY, nullptr);
     // And send the account-based event, too
     qof_event_gen(&acc->inst, GNC_EVENT_ITEM_REMOVED, s);
 
-    priv->balance_dirty = TRUE;
     xaccAccountRecomputeBalance(acc);
     return TRUE;
 }
@@ -1992,9 +2097,24 @@ xaccAccountSortSplits (Account *acc, gboolean force)
     priv = GET_PRIVATE(acc);
     if (!priv->sort_dirty || (!force && qof_instance_get_editlevel(acc) > 0))
         return;
-    std::sort (priv->splits.begin(), priv->splits.end(), split_cmp_less);
+
+    /* Sort the splits appended since the last sort and merge them into
+     * the sorted run; the splits before the first one that they sort
+     * before keep both their places and their running balances. */
+    auto& splits{priv->splits};
+    auto tail{splits.begin() + std::min (priv->sort_dirty_from, splits.size())};
+    SplitOrderLess split_cmp_less{acc};
+    std::sort (tail, splits.end(), split_cmp_less);
+    auto unmoved{tail == splits.end() ? tail :
+                 std::upper_bound (splits.begin(), tail, *tail, split_cmp_less)};
+    account_set_balance_dirty_from (priv, unmoved - splits.begin());
+    std::inplace_merge (splits.begin(), tail, splits.end(), split_cmp_less);
+
+    /* Only the splits before the first one merged in kept their places. */
+    if (priv->split_dates.size() > static_cast<size_t>(unmoved - splits.begin()))
+        priv->split_dates.resize (unmoved - splits.begin());
     priv->sort_dirty = FALSE;
-    priv->balance_dirty = TRUE;
+    priv->sort_dirty_from = 0;
 }
 
 static void
@@ -2188,8 +2308,11 @@ xaccAccountMoveAllSplits (Account *accfrom, Account *accto)
     g_return_if_fail(GNC_IS_ACCOUNT(accto));
 
     /* optimizations */
+    if (accfrom == accto)
+        return;
+    account_load_splits (accfrom);
     from_priv = GET_PRIVATE(accfrom);
-    if (from_priv->splits.empty() || accfrom == accto)
+    if (from_priv->splits.empty())
         return;
 
     /* check for book mix-up */
@@ -2257,14 +2380,50 @@ xaccAccountMoveAllSplits (Account *accfrom, Account *accto)
  * Return: void                                                     *
 \********************************************************************/
 
+/* The running totals just before position pos: the starting balances
+ * for the first split, otherwise those cached in the preceding split. */
+static RunningBalances
+running_balances_before (const AccountPrivate *priv, size_t pos)
+{
+    if (pos == 0)
+        return {priv->starting_balance, priv->starting_noclosing_balance,
+                priv->starting_cleared_balance,
+                priv->starting_reconciled_balance};
+
+    auto prev{priv->splits[pos - 1]};
+    return {prev->balance, prev->noclosing_balance, prev->cleared_balance,
+            prev->reconciled_balance};
+}
+
+static void
+running_balances_add_split (RunningBalances& totals, const Split *split)
+{
+    gnc_numeric amt = xaccSplitGetAmount (split);
+
+    totals.balance = gnc_numeric_add_fixed(totals.balance, amt);
+
+    if (NREC != split->reconciled)
+    {
+        totals.cleared_balance =
+            gnc_numeric_add_fixed(totals.cleared_balance, amt);
+    }
+
+    if (YREC == split->reconciled ||
+            FREC == split->reconciled)
+    {
+        totals.reconciled_balance =
+            gnc_numeric_add_fixed(totals.reconciled_balance, amt);
+    }
+
+    if (!(xaccTransGetIsClosingTxn (split->parent)))
+        totals.noclosing_balance =
+            gnc_numeric_add_fixed(totals.noclosing_balance, amt);
+}
+
 void
 xaccAccountRecomputeBalance (Account * acc)
 {
     AccountPrivate *priv;
-    gnc_numeric  balance;
-    gnc_numeric  noclosing_balance;
-    gnc_numeric  cleared_balance;
-    gnc_numeric  reconciled_balance;
 
     if (nullptr == acc) return;
 
@@ -2274,46 +2433,178 @@ xaccAccountRecomputeBalance (Account * acc)
     if (qof_instance_get_destroying(acc)) return;
     if (qof_book_shutting_down(qof_instance_get_book(acc))) return;
 
-    balance            = priv->starting_balance;
-    noclosing_balance  = priv->starting_noclosing_balance;
-    cleared_balance    = priv->starting_cleared_balance;
-    reconciled_balance = priv->starting_reconciled_balance;
+    /* Everything before balance_dirty_from is still correct, so pick
+     * up the running totals from there. */
+    auto from{std::min (priv->balance_dirty_from, priv->splits.size())};
+    auto totals{running_balances_before (priv, from)};
 
-    PINFO ("acct=%s starting baln=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT,
-           priv->accountName, balance.num, balance.denom);
-    for (auto split : priv->splits)
+    PINFO ("acct=%s from split %zu baln=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT,
+           priv->accountName, from, totals.balance.num, totals.balance.denom);
+    for (auto it = priv->splits.begin() + from; it != priv->splits.end(); ++it)
     {
-        gnc_numeric amt = xaccSplitGetAmount (split);
+        auto split{*it};
 
-        balance = gnc_numeric_add_fixed(balance, amt);
+        running_balances_add_split (totals, split);
 
-        if (NREC != split->reconciled)
-        {
-            cleared_balance = gnc_numeric_add_fixed(cleared_balance, amt);
-        }
+        split->balance = totals.balance;
+        split->noclosing_balance = totals.noclosing_balance;
+        split->cleared_balance = totals.cleared_balance;
+        split->reconciled_balance = totals.reconciled_balance;
+    }
+
+    priv->balance = totals.balance;
+    priv->noclosing_balance = totals.noclosing_balance;
+    priv->cleared_balance = totals.cleared_balance;
+    priv->reconciled_balance = totals.reconciled_balance;
+    priv->balance_dirty = FALSE;
+    priv->balance_dirty_from = 0;
+}
+
+RunningBalances
+gnc_account_get_end_balances (Account *acc)
+{
+    g_return_val_if_fail (GNC_IS_ACCOUNT (acc), RunningBalances{});
+
+    xaccAccountRecomputeBalance (acc);
+    auto priv{GET_PRIVATE(acc)};
+    return {priv->balance, priv->noclosing_balance, priv->cleared_balance,
+            priv->reconciled_balance};
+}
+
+void
+gnc_account_set_end_balances (Account *acc, const RunningBalances& ends)
+{
+    g_return_if_fail (GNC_IS_ACCOUNT (acc));
+
+    /* Summed from scratch rather than taken from the cached balances,
+     * which are stale while the account is being edited. */
+    auto priv{GET_PRIVATE(acc)};
+    auto zero{gnc_numeric_zero()};
+    RunningBalances totals{zero, zero, zero, zero};
+    for (auto split : priv->splits)
+        running_balances_add_split (totals, split);
+
+    priv->starting_balance = gnc_numeric_sub_fixed (ends.balance,
+                                                    totals.balance);
+    priv->starting_noclosing_balance =
+        gnc_numeric_sub_fixed (ends.noclosing_balance,
+                               totals.noclosing_balance);
+    priv->starting_cleared_balance =
+        gnc_numeric_sub_fixed (ends.cleared_balance, totals.cleared_balance);
+    priv->starting_reconciled_balance =
+        gnc_numeric_sub_fixed (ends.reconciled_balance,
+                               totals.reconciled_balance);
+    account_set_balance_dirty_from (priv, 0);
+    xaccAccountRecomputeBalance (acc);
+}
+
+static inline void
+shift_running_total (gnc_numeric& total, gnc_numeric delta)
+{
+    if (!gnc_numeric_zero_p (delta))
+        total = gnc_numeric_add_fixed (total, delta);
+}
+
+void
+gnc_account_split_changed (Account *acc, Split *s)
+{
+    g_return_if_fail (GNC_IS_ACCOUNT (acc));
+
+    if (qof_instance_get_destroying (acc))
+        return;
+
+    auto priv{GET_PRIVATE (acc)};
+    /* Splits not (or not yet) in the account are taken care of by
+     * gnc_account_insert_split and gnc_account_remove_split. */
+    if (!g_hash_table_contains (priv->splits_hash, s))
+        return;
+
+    auto& splits{priv->splits};
+    auto mark_unsorted = [priv]()
+    {
+        priv->sort_dirty = TRUE;
+        priv->sort_dirty_from = 0;
+        account_set_balance_dirty_from (priv, 0);
+    };
 
-        if (YREC == split->reconciled ||
-                FREC == split->reconciled)
+    if (priv->sort_dirty)
+    {
+        /* A split in the not yet sorted tail can change freely, anything
+         * else may have broken the sorted run before it. */
+        auto tail_start{std::make_reverse_iterator (splits.begin() + priv->sort_dirty_from)};
+        auto in_tail{priv->sort_dirty_from > 0 ?
+                     std::find (splits.rbegin(), tail_start, s) : tail_start};
+        if (in_tail != tail_start)
         {
-            reconciled_balance =
-                gnc_numeric_add_fixed(reconciled_balance, amt);
+            size_t pos = splits.rend() - in_tail - 1;
+            if (pos < priv->split_dates.size())
+                priv->split_dates[pos] = xaccTransGetDate (s->parent);
+            account_set_balance_dirty_from (priv, pos);
         }
+        else
+            mark_unsorted ();
+        return;
+    }
+
+    /* If the split can't be found by bisection, or isn't between its
+     * neighbours, the change has broken the sort order. */
+    SplitOrderLess split_cmp_less{acc};
+    auto it{std::lower_bound (splits.begin(), splits.end(), s, split_cmp_less)};
+    if (it == splits.end() || *it != s ||
+        (it != splits.begin() && !split_cmp_less (*(it - 1), s)) ||
+        (it + 1 != splits.end() && !split_cmp_less (s, *(it + 1))))
+    {
+        mark_unsorted ();
+        return;
+    }
 
-        if (!(xaccTransGetIsClosingTxn (split->parent)))
-            noclosing_balance = gnc_numeric_add_fixed(noclosing_balance, amt);
+    size_t pos = it - splits.begin();
+    if (pos < priv->split_dates.size())
+        priv->split_dates[pos] = xaccTransGetDate (s->parent);
 
-        split->balance = balance;
-        split->noclosing_balance = noclosing_balance;
-        split->cleared_balance = cleared_balance;
-        split->reconciled_balance = reconciled_balance;
+    /* The running totals from pos on will be recomputed anyway. */
+    if (priv->balance_dirty && priv->balance_dirty_from <= pos)
+        return;
+
+    auto expected{running_balances_before (priv, pos)};
+    running_balances_add_split (expected, s);
+    auto delta_bal = gnc_numeric_sub_fixed (expected.balance, s->balance);
+    auto delta_noclosing = gnc_numeric_sub_fixed (expected.noclosing_balance,
+                                                  s->noclosing_balance);
+    auto delta_cleared = gnc_numeric_sub_fixed (expected.cleared_balance,
+                                                s->cleared_balance);
+    auto delta_reconciled = gnc_numeric_sub_fixed (expected.reconciled_balance,
+                                                   s->reconciled_balance);
+    if (gnc_numeric_zero_p (delta_bal) && gnc_numeric_zero_p (delta_noclosing) &&
+        gnc_numeric_zero_p (delta_cleared) && gnc_numeric_zero_p (delta_reconciled))
+        return;
+
+    if (qof_instance_get_editlevel (acc) > 0 || priv->defer_bal_computation)
+    {
+        account_set_balance_dirty_from (priv, pos);
+        return;
+    }
 
+    /* Only this split changed, so every later running total moves by
+     * the same amount.  Shift just the totals that differ, e.g. only
+     * the cleared and reconciled ones for a reconcile state change. */
+    auto end{priv->balance_dirty ? priv->balance_dirty_from : splits.size()};
+    for (auto i = pos; i < end; ++i)
+    {
+        auto split{splits[i]};
+        shift_running_total (split->balance, delta_bal);
+        shift_running_total (split->noclosing_balance, delta_noclosing);
+        shift_running_total (split->cleared_balance, delta_cleared);
+        shift_running_total (split->reconciled_balance, delta_reconciled);
     }
 
-    priv->balance = balance;
-    priv->noclosing_balance = noclosing_balance;
-    priv->cleared_balance = cleared_balance;
-    priv->reconciled_balance = reconciled_balance;
-    priv->balance_dirty = FALSE;
+    if (priv->balance_dirty)
+        return;
+
+    shift_running_total (priv->balance, delta_bal);
+    shift_running_total (priv->noclosing_balance, delta_noclosing);
+    shift_running_total (priv->cleared_balance, delta_cleared);
+    shift_running_total (priv->reconciled_balance, delta_reconciled);
 }
 
 /********************************************************************\
@@ -2414,7 +2705,8 @@ xaccAccountSetType (Account *acc, GNCAccountType tip)
 
     xaccAccountBeginEdit(acc);
     priv->type = tip;
-    priv->balance_dirty = TRUE; /* new type may affect balance computation */
+    /* new type may affect balance computation */
+    account_set_balance_dirty_from (priv, 0);
     mark_account(acc);
     xaccAccountCommitEdit(acc);
 }
@@ -2487,7 +2779,7 @@ set_kvp_gnc_numeric_path (Account *acc, const std::vector<std::string>& path,
 }
 
 static std::optional<gnc_numeric>
-get_kvp_gnc_numeric_path (const Account *acc, const Path& path)
+get_kvp_gnc_numeric_path (const Account *acc, KvpKeys path)
 {
     return qof_instance_get_path_kvp<gnc_numeric> (QOF_INSTANCE(acc), path);
 }
@@ -2506,7 +2798,7 @@ set_kvp_string_path (Account *acc, std::vector<std::string> const & path,
 }
 
 static const char*
-get_kvp_string_path (const Account *acc, const Path& path)
+get_kvp_string_path (const Account *acc, KvpKeys path)
 {
     auto rv{qof_instance_get_path_kvp<const char*> (QOF_INSTANCE(acc), path)};
     return rv ? *rv : nullptr;
@@ -2525,7 +2817,7 @@ set_kvp_account_path (Account* acc, const Path& path, const Account* kvp_account
 }
 
 static Account*
-get_kvp_account_path (const Account *acc, const Path& path)
+get_kvp_account_path (const Account *acc, KvpKeys path)
 {
     auto val{qof_instance_get_path_kvp<GncGUID*> (QOF_INSTANCE(acc), path)};
     return val ? xaccAccountLookup (*val, gnc_account_get_book (acc)) : nullptr;
@@ -2538,7 +2830,7 @@ set_kvp_boolean_path (Account *acc, const Path& path, gboolean option)
 }
 
 static gboolean
-get_kvp_boolean_path (const Account *acc, const Path& path)
+get_kvp_boolean_path (const Account *acc, KvpKeys path)
 {
     auto slot{QOF_INSTANCE(acc)->kvp_data->get_slot(path)};
     if (!slot) return false;
@@ -2562,7 +2854,7 @@ set_kvp_int64_path (Account *acc, const Path& path, std::optional<gint64> value)
 }
 
 static const std::optional<gint64>
-get_kvp_int64_path (const Account *acc, const Path& path)
+get_kvp_int64_path (const Account *acc, KvpKeys path)
 {
     return qof_instance_get_path_kvp<int64_t> (QOF_INSTANCE(acc), path);
 }
@@ -2647,6 +2939,7 @@ xaccAccountSetCommodity (Account * acc, gnc_commodity * com)
     priv->non_standard_scu = FALSE;
 
     /* iterate over splits */
+    account_load_splits (acc);
     for (auto s : priv->splits)
     {
         Transaction *trans = xaccSplitGetParent (s);
@@ -2657,7 +2950,8 @@ xaccAccountSetCommodity (Account * acc, gnc_commodity * com)
     }
 
     priv->sort_dirty = TRUE;  /* Not needed. */
-    priv->balance_dirty = TRUE;
+    priv->sort_dirty_from = 0;
+    account_set_balance_dirty_from (priv, 0);
     mark_account (acc);
 
     xaccAccountCommitEdit(acc);
@@ -3385,7 +3679,7 @@ gnc_account_set_start_balance (Account *acc, const gnc_numeric start_baln)
 
     priv = GET_PRIVATE(acc);
     priv->starting_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    account_set_balance_dirty_from (priv, 0);
 }
 
 void
@@ -3398,7 +3692,7 @@ gnc_account_set_start_cleared_balance (Account *acc,
 
     priv = GET_PRIVATE(acc);
     priv->starting_cleared_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    account_set_balance_dirty_from (priv, 0);
 }
 
 void
@@ -3411,7 +3705,7 @@ gnc_account_set_start_reconciled_balance (Account *acc,
 
     priv = GET_PRIVATE(acc);
     priv->starting_reconciled_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    account_set_balance_dirty_from (priv, 0);
 }
 
 gnc_numeric
@@ -3458,37 +3752,143 @@ xaccAccountGetProjectedMinimumBalance (const Account *acc)
 /********************************************************************\
 \********************************************************************/
 
+/* Returns the posted dates parallel to priv->splits, filling in those of
+ * the splits past the ones that are still known. */
+static const std::vector<time64>&
+account_split_dates (AccountPrivate *priv)
+{
+    auto& dates{priv->split_dates};
+    if (dates.size() < priv->splits.size())
+    {
+        dates.reserve (priv->splits.size());
+        std::for_each (priv->splits.begin() + dates.size(), priv->splits.end(),
+                       [&dates](const Split *split)
+                       { dates.push_back (xaccTransGetDate (split->parent)); });
+    }
+    return dates;
+}
+
+/* The splits of acc posted from start to end inclusive: a range of the
+ * splits vector when it's sorted, otherwise all of it and in_range has to
+ * be checked on each split.  Unless load is false, the backend is asked for
+ * any of them it hasn't loaded yet. */
+static std::pair<SplitsVec::const_iterator, SplitsVec::const_iterator>
+account_splits_posted_between (const Account *acc, time64 start, time64 end,
+                               bool& sorted, bool load = true)
+{
+    if (load)
+        account_load_splits (acc, start);
+    auto priv{GET_PRIVATE(acc)};
+    const auto& splits{priv->splits};
+
+    sorted = !priv->sort_dirty;
+    if (!sorted)
+        return {splits.begin(), splits.end()};
+
+    const auto& dates{account_split_dates (priv)};
+    auto first{std::lower_bound (dates.begin(), dates.end(), start)};
+    auto last{std::upper_bound (first, dates.end(), end)};
+    return {splits.begin() + (first - dates.begin()),
+            splits.begin() + (last - dates.begin())};
+}
+
+static inline bool
+split_posted_between (const Split *split, time64 start, time64 end)
+{
+    auto date{xaccTransGetDate (split->parent)};
+    return date >= start && date <= end;
+}
+
+void
+gnc_account_foreach_split_posted_between (const Account *acc, time64 start,
+                                          time64 end,
+                                          std::function<void(Split*)> f)
+{
+    if (!GNC_IS_ACCOUNT (acc) || start > end)
+        return;
+
+    bool sorted;
+    auto [first, last] = account_splits_posted_between (acc, start, end, sorted);
+    for (auto it = first; it != last; ++it)
+        if (sorted || split_posted_between (*it, start, end))
+            f (*it);
+}
+
+size_t
+gnc_account_count_splits_posted_between (const Account *acc, time64 start,
+                                         time64 end)
+{
+    if (!GNC_IS_ACCOUNT (acc) || start > end)
+        return 0;
+
+    bool sorted;
+    auto [first, last] = account_splits_posted_between (acc, start, end, sorted);
+    if (sorted)
+        return last - first;
+    return std::count_if (first, last, [start, end](const Split *s)
+                          { return split_posted_between (s, start, end); });
+}
+
+size_t
+gnc_account_estimate_splits_posted_between (const Account *acc, time64 start,
+                                            time64 end)
+{
+    if (!GNC_IS_ACCOUNT (acc) || start > end)
+        return 0;
+
+    bool sorted;
+    auto [first, last] = account_splits_posted_between (acc, start, end,
+                                                        sorted, false);
+    return last - first;
+}
+
+/* starting is the balance to return when nothing was posted before date,
+ * the one split_to_numeric picks out of the splits' running balances. */
 static gnc_numeric
-GetBalanceAsOfDate (Account *acc, time64 date, std::function<gnc_numeric(Split*)> split_to_numeric)
+GetBalanceAsOfDate (Account *acc, time64 date,
+                    std::function<gnc_numeric(Split*)> split_to_numeric,
+                    gnc_numeric AccountPrivate::*starting)
 {
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), gnc_numeric_zero());
 
+    /* Anything posted before date is summed into the starting balances
+     * until it's loaded. */
+    account_load_splits (acc, date);
     xaccAccountSortSplits (acc, TRUE); /* just in case, normally a noop */
     xaccAccountRecomputeBalance (acc); /* just in case, normally a noop */
 
-    auto is_before_date = [date](auto s) -> bool
-    { return xaccTransGetDate(xaccSplitGetParent(s)) < date; };
+    /* The splits are sorted by posted date first, so the ones posted
+     * before date are a prefix of the vector and the latest of them
+     * carries the running balance we want. */
+    auto priv{GET_PRIVATE(acc)};
+    const auto& dates{account_split_dates (priv)};
+    auto first_not_before{std::lower_bound (dates.begin(), dates.end(), date)};
+    if (first_not_before == dates.begin())
+        return priv->*starting;
 
-    auto latest_split{gnc_account_find_split (acc, is_before_date, true)};
-    return latest_split ? split_to_numeric (latest_split) : gnc_numeric_zero();
+    auto latest_split{priv->splits[first_not_before - dates.begin() - 1]};
+    return split_to_numeric (latest_split);
 }
 
 gnc_numeric
 xaccAccountGetBalanceAsOfDate (Account *acc, time64 date)
 {
-    return GetBalanceAsOfDate (acc, date, xaccSplitGetBalance);
+    return GetBalanceAsOfDate (acc, date, xaccSplitGetBalance,
+                               &AccountPrivate::starting_balance);
 }
 
 static gnc_numeric
 xaccAccountGetNoclosingBalanceAsOfDate (Account *acc, time64 date)
 {
-    return GetBalanceAsOfDate (acc, date, xaccSplitGetNoclosingBalance);
+    return GetBalanceAsOfDate (acc, date, xaccSplitGetNoclosingBalance,
+                               &AccountPrivate::starting_noclosing_balance);
 }
 
 gnc_numeric
 xaccAccountGetReconciledBalanceAsOfDate (Account *acc, time64 date)
 {
-    return GetBalanceAsOfDate (acc, date, xaccSplitGetReconciledBalance);
+    return GetBalanceAsOfDate (acc, date, xaccSplitGetReconciledBalance,
+                               &AccountPrivate::starting_reconciled_balance);
 }
 
 /*
@@ -3847,8 +4247,10 @@ xaccAccountBalanceChangeHelper (Account *acc, gpointer data)
     CurrencyBalanceChange *cbdiff = static_cast<CurrencyBalanceChange*>(data);
 
     gnc_numeric b1, b2;
-    b1 = GetBalanceAsOfDate(acc, cbdiff->t1, xaccSplitGetNoclosingBalance);
-    b2 = GetBalanceAsOfDate(acc, cbdiff->t2, xaccSplitGetNoclosingBalance);
+    b1 = GetBalanceAsOfDate(acc, cbdiff->t1, xaccSplitGetNoclosingBalance,
+                            &AccountPrivate::starting_noclosing_balance);
+    b2 = GetBalanceAsOfDate(acc, cbdiff->t2, xaccSplitGetNoclosingBalance,
+                            &AccountPrivate::starting_noclosing_balance);
     gnc_numeric balanceChange = gnc_numeric_sub(b2, b1, GNC_DENOM_AUTO, GNC_HOW_DENOM_FIXED);
     gnc_numeric balanceChange_conv = xaccAccountConvertBalanceToCurrencyAsOfDate(acc, balanceChange, xaccAccountGetCommodity(acc), cbdiff->currency, cbdiff->t2);
     cbdiff->balanceChange = gnc_numeric_add (cbdiff->balanceChange, balanceChange_conv,
@@ -3863,8 +4265,10 @@ xaccAccountGetNoclosingBalanceChangeInCurrencyForPeriod (Account *acc, time64 t1
     
 
     gnc_numeric b1, b2;
-    b1 = GetBalanceAsOfDate(acc, t1, xaccSplitGetNoclosingBalance);
-    b2 = GetBalanceAsOfDate(acc, t2, xaccSplitGetNoclosingBalance);
+    b1 = GetBalanceAsOfDate(acc, t1, xaccSplitGetNoclosingBalance,
+                            &AccountPrivate::starting_noclosing_balance);
+    b2 = GetBalanceAsOfDate(acc, t2, xaccSplitGetNoclosingBalance,
+                            &AccountPrivate::starting_noclosing_balance);
     gnc_numeric balanceChange = gnc_numeric_sub(b2, b1, GNC_DENOM_AUTO, GNC_HOW_DENOM_FIXED);
 
     gnc_commodity *report_commodity = xaccAccountGetCommodity(acc);
@@ -3886,6 +4290,7 @@ xaccAccountGetSplits (const Account *account)
 {
     static const SplitsVec empty;
     g_return_val_if_fail (GNC_IS_ACCOUNT(account), empty);
+    account_load_splits (account);
     return GET_PRIVATE(account)->splits;
 }
 
@@ -3893,6 +4298,7 @@ SplitList *
 xaccAccountGetSplitList (const Account *acc)
 {
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), nullptr);
+    account_load_splits (acc);
     auto priv{GET_PRIVATE(acc)};
     return std::accumulate (priv->splits.rbegin(), priv->splits.rend(),
                             static_cast<GList*>(nullptr), g_list_prepend);
@@ -3902,13 +4308,17 @@ size_t
 xaccAccountGetSplitsSize (const Account *account)
 {
     g_return_val_if_fail (GNC_IS_ACCOUNT(account), 0);
-    return GNC_IS_ACCOUNT(account) ? GET_PRIVATE(account)->splits.size() : 0;
+    account_load_splits (account);
+    return GET_PRIVATE(account)->splits.size();
 }
 
 gboolean gnc_account_and_descendants_empty (Account *acc)
 {
     g_return_val_if_fail (GNC_IS_ACCOUNT (acc), FALSE);
     auto priv = GET_PRIVATE (acc);
+    /* Only an account without any loaded splits needs the rest of them. */
+    if (priv->splits.empty())
+        account_load_splits (acc);
     if (!priv->splits.empty()) return FALSE;
     return std::all_of (priv->children.begin(), priv->children.end(),
                         gnc_account_and_descendants_empty);
@@ -4755,13 +5165,15 @@ GetOrMakeOrphanAccount (Account *root, gnc_commodity * currency)
 Account *
 xaccAccountGainsAccount (Account *acc, gnc_commodity *curr)
 {
-    Path path {KEY_LOT_MGMT, "gains-acct", gnc_commodity_get_unique_name (curr)};
-    auto gains_account = get_kvp_account_path (acc, path);
+    auto curr_name = gnc_commodity_get_unique_name (curr);
+    auto gains_account = get_kvp_account_path (acc, {KEY_LOT_MGMT, "gains-acct",
+                                                     curr_name});
 
     if (gains_account == nullptr) /* No gains account for this currency */
     {
         gains_account = GetOrMakeOrphanAccount (gnc_account_get_root (acc), curr);
-        set_kvp_account_path (acc, path, gains_account);
+        set_kvp_account_path (acc, {KEY_LOT_MGMT, "gains-acct", curr_name},
+                              gains_account);
     }
 
     return gains_account;
@@ -4974,6 +5386,7 @@ xaccAccountBeginStagedTransactionTraversals (const Account *account)
 {
     if (!account)
         return;
+    account_load_splits (account);
     xaccSplitsBeginStagedTransactionTraversals(GET_PRIVATE (account)->splits);
 }
 
@@ -5008,6 +5421,7 @@ xaccAccountStagedTransactionTraversal (const Account *acc,
 {
     if (!acc) return 0;
 
+    account_load_splits (acc);
     // iterate on copy of splits. some callers modify the splitsvec.
     auto splits = GET_PRIVATE(acc)->splits;
     for (auto s : splits)
@@ -5048,6 +5462,7 @@ gnc_account_tree_staged_transaction_traversal (const Account *acc,
     }
 
     /* Now this account */
+    account_load_splits (acc);
     for (auto s : priv->splits)
     {
         trans = s->parent;
@@ -5105,11 +5520,9 @@ gnc_account_imap_find_account (Account *acc,
                                const char *key)
 {
     if (!acc || !key) return nullptr;
-    std::vector<std::string> path {IMAP_FRAME};
     if (category)
-        path.push_back (category);
-    path.push_back (key);
-    return get_kvp_account_path (acc, path);
+        return get_kvp_account_path (acc, {IMAP_FRAME, category, key});
+    return get_kvp_account_path (acc, {IMAP_FRAME, key});
 }
 
 Account*
@@ -5874,6 +6287,8 @@ gboolean xaccAccountRegister (void)
     };
 
     qof_class_register (GNC_ID_ACCOUNT, (QofSortFunc) qof_xaccAccountOrder, params);
+    qof_class_register_pure_params (GNC_ID_ACCOUNT, ACCOUNT_NAME_, ACCOUNT_CODE_,
+                                    ACCOUNT_DESCRIPTION_, QOF_PARAM_GUID, nullptr);
 
     return qof_object_register (&account_object_def);
 }
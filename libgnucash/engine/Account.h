@@ -384,6 +384,12 @@ typedef enum
     void gnc_account_set_defer_bal_computation (Account *acc, gboolean defer);
 
     /** Insert the given split from an account.
+     *
+     *  Outside of an edit block the split is put in its sorted place
+     *  directly.  Inside an xaccAccountBeginEdit() /
+     *  xaccAccountCommitEdit() block the splits are appended and merged
+     *  into the sorted list in one go when the edit is committed, which
+     *  is much faster when adding many splits to a large account.
      *
      *  @param acc The account to which the split should be added.
      *
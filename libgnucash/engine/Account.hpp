@@ -49,6 +49,25 @@ void gnc_account_foreach_split (const Account*, std::function<void(Split*)>, boo
 void gnc_account_foreach_split_until_date (const Account *acc, time64 end_date,
                                            std::function<void(Split*)> f);
 
+/** Calls f on each split of the account posted from start to end,
+ *  inclusive, in the account's split order.  When the splits are sorted
+ *  the ones in range are found by binary search. */
+void gnc_account_foreach_split_posted_between (const Account *acc, time64 start,
+                                               time64 end,
+                                               std::function<void(Split*)> f);
+
+/** The number of splits of the account posted from start to end,
+ *  inclusive. */
+size_t gnc_account_count_splits_posted_between (const Account *acc,
+                                                time64 start, time64 end);
+
+/** About the number of splits of the account posted from start to end,
+ *  inclusive, counting only the splits already loaded and without asking
+ *  the backend for more: the splits of an account that hasn't been sorted
+ *  since it changed are all counted. */
+size_t gnc_account_estimate_splits_posted_between (const Account *acc,
+                                                   time64 start, time64 end);
+
 /** scans account split list (in forward or reverse order) until
  *    predicate split->bool returns true. Maybe return the split.
  *
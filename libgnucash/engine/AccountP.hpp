@@ -114,10 +114,29 @@ typedef struct AccountPrivate
     gnc_numeric reconciled_balance;
  
     gboolean balance_dirty;     /* balances in splits incorrect */
+    /* When balance_dirty is set, the running balances of the splits
+     * before this position are still correct and only the splits from
+     * here on need to be recomputed.  Zero means all of them. */
+    size_t balance_dirty_from;
 
     std::vector<Split*> splits;              /* list of split pointers */
     GHashTable* splits_hash;
+    /* Posted dates of the splits, parallel to splits.  Together with
+     * the running balances cached in each split this lets the
+     * as-of-date balance lookups binary search instead of scanning.
+     * It may be shorter than splits: it holds the dates of the leading
+     * splits, and insertions, removals and sorts keep those in step. */
+    std::vector<time64> split_dates;
     gboolean sort_dirty;        /* sort order of splits is bad */
+    /* When sort_dirty is set, the splits before this position are still
+     * in order and the ones after it were appended while sorting was
+     * deferred, so xaccAccountSortSplits only has to sort those and
+     * merge them in.  Zero means all of the splits need sorting. */
+    size_t sort_dirty_from;
+    /* The posted date of the earliest split the backend has loaded into
+     * the account, INT64_MIN once it has loaded all of them.  The ones
+     * still in the database are summed into the starting balances. */
+    time64 splits_loaded_from;
 
     LotList   *lots;		/* list of lot pointers */
     GNCPolicy *policy;		/* Cached pointer to policy method */
@@ -147,6 +166,38 @@ struct account_s
  * call this on an existing account! */
 void xaccAccountSetGUID (Account *account, const GncGUID *guid);
 
+/* Tell the account that the given split, already in it, has been
+ * modified.  If the split is still in order the running balances are
+ * brought up to date from its position only, otherwise the account is
+ * marked for a resort and a full recomputation. */
+void gnc_account_split_changed (Account *acc, Split *s);
+
+/* The four running totals kept in each split and in the account. */
+struct RunningBalances
+{
+    gnc_numeric balance;
+    gnc_numeric noclosing_balance;
+    gnc_numeric cleared_balance;
+    gnc_numeric reconciled_balance;
+};
+
+/* Backends that don't load all of an account's splits up front mark the
+ * account with the posted date from which they have, and the engine calls
+ * QofBackend::load_splits before it needs anything older.  The default,
+ * INT64_MIN, means all of the splits are loaded. */
+void gnc_account_set_splits_loaded_from (Account *acc, time64 date);
+time64 gnc_account_get_splits_loaded_from (const Account *acc);
+
+/* The account's ending balances, recomputed first if need be. */
+RunningBalances gnc_account_get_end_balances (Account *acc);
+
+/* Set the starting balances so that, with the splits in the account now,
+ * the ending balances come out as the given ones.  This lets a backend
+ * that loads splits lazily install the totals of the splits it hasn't
+ * loaded, and keep the ending balances where they were after it has
+ * loaded more. */
+void gnc_account_set_end_balances (Account *acc, const RunningBalances& ends);
+
 /* Register Accounts with the engine */
 gboolean xaccAccountRegister (void);
 
@@ -44,9 +44,17 @@
 # include <unistd.h>
 #endif
 
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+
 #include "qof.h"
 #include "qofbook.h"
+#include "qofquery-p.h"
+#include "qofquerycore-p.h"
 #include "Split.h"
+#include "Account.hpp"
 #include "AccountP.hpp"
 #include "Scrub.h"
 #include "TransactionP.hpp"
@@ -57,6 +65,7 @@
 #include "gnc-lot.h"
 #include "gnc-event.h"
 #include "qofinstance-p.h"
+#include "SX-book.h"
 
 const char *void_former_amt_str = "void-former-amount";
 const char *void_former_val_str = "void-former-value";
@@ -128,6 +137,7 @@ gnc_split_init(Split* split)
 
     split->gains = GAINS_STATUS_UNKNOWN;
     split->gains_split = nullptr;
+    split->sort_key = nullptr;
 }
 
 static void
@@ -507,6 +517,7 @@ xaccSplitReinit(Split * split)
 
     CACHE_REPLACE(split->action, "");
     CACHE_REPLACE(split->memo, "");
+    xaccSplitClearSortKey (split);
     split->reconciled  = NREC;
     split->amount      = gnc_numeric_zero();
     split->value       = gnc_numeric_zero();
@@ -712,6 +723,7 @@ xaccFreeSplit (Split *split)
     }
     CACHE_REMOVE(split->memo);
     CACHE_REMOVE(split->action);
+    xaccSplitClearSortKey (split);
 
     if (split->inst.e_type) /* Don't do this for dupe splits. */
     {
@@ -764,9 +776,7 @@ xaccFreeSplit (Split *split)
 void mark_split (Split *s)
 {
     if (s->acc)
-    {
-        g_object_set(s->acc, "sort-dirty", TRUE, "balance-dirty", TRUE, nullptr);
-    }
+        gnc_account_split_changed (s->acc, s);
 
     /* set dirty flag on lot too. */
     if (s->lot) gnc_lot_set_closed_unknown(s->lot);
@@ -1027,12 +1037,15 @@ xaccSplitCommitEdit(Split *s)
        original and new transactions, for the _next_ begin/commit cycle. */
     s->orig_acc = s->acc;
     s->orig_parent = s->parent;
+    /* do_destroy may free the split */
+    auto destroying = qof_instance_get_destroying(s);
     if (!qof_commit_edit_part2(QOF_INSTANCE(s), commit_err, nullptr, do_destroy))
         return;
 
     if (acc)
     {
-        g_object_set(acc, "sort-dirty", TRUE, "balance-dirty", TRUE, nullptr);
+        if (!destroying)
+            gnc_account_split_changed (acc, s);
         xaccAccountRecomputeBalance(acc);
     }
 }
@@ -1497,41 +1510,195 @@ xaccSplitDestroy (Split *split)
 /********************************************************************\
 \********************************************************************/
 
+/* A string as used for sorting: its collation key and, for num-like
+ * fields, the leading integer and the collation key of the remainder as
+ * order_by_int64_or_string in Transaction.cpp splits them. */
+struct SplitSortString
+{
+    uint64_t number = 0;
+    std::string rest_key;
+    std::string key;
+
+    explicit SplitSortString (const char *str)
+    {
+        if (!str)
+            str = "";
+
+        auto collate_key = [](const char *text)
+        {
+            auto ckey = g_utf8_collate_key (text, -1);
+            std::string rv{ckey};
+            g_free (ckey);
+            return rv;
+        };
+
+        char *end = nullptr;
+        number = strtoull (str, &end, 10);
+        rest_key = number ? collate_key (end) : std::string{};
+        key = collate_key (str);
+    }
+};
+
+/* The keys are built the first time a split or transaction is compared
+ * and dropped by the setters of the strings they were made from. */
+struct SplitSortKey
+{
+    SplitSortString memo;
+    SplitSortString action;
+
+    explicit SplitSortKey (const Split *split) :
+        memo{split->memo}, action{split->action} {}
+};
+
+struct TransSortKey
+{
+    SplitSortString num;
+    SplitSortString description;
+
+    explicit TransSortKey (const Transaction *trans) :
+        num{trans->num}, description{trans->description} {}
+};
+
+void
+xaccSplitClearSortKey (Split *split)
+{
+    delete split->sort_key;
+    split->sort_key = nullptr;
+}
+
+void
+xaccTransClearSortKey (Transaction *trans)
+{
+    delete trans->sort_key;
+    trans->sort_key = nullptr;
+}
+
+static inline int
+sort_key_cmp (const std::string& a, const std::string& b)
+{
+    auto cmp = a.compare (b);
+    return cmp < 0 ? -1 : cmp > 0 ? 1 : 0;
+}
+
+/* Same result as order_by_int64_or_string on the source strings. */
+static int
+sort_string_num_cmp (const SplitSortString& a, const SplitSortString& b)
+{
+    if (a.number && b.number)
+    {
+        if (a.number != b.number)
+            return a.number < b.number ? -1 : 1;
+        return sort_key_cmp (a.rest_key, b.rest_key);
+    }
+    return sort_key_cmp (a.key, b.key);
+}
+
+static const SplitSortKey&
+split_get_sort_key (const Split *s)
+{
+    auto split = const_cast<Split*>(s);
+    if (!split->sort_key)
+        split->sort_key = new SplitSortKey (split);
+    return *split->sort_key;
+}
+
+static const TransSortKey&
+trans_get_sort_key (const Transaction *t)
+{
+    auto trans = const_cast<Transaction*>(t);
+    if (!trans->sort_key)
+        trans->sort_key = new TransSortKey (trans);
+    return *trans->sort_key;
+}
+
+/* xaccTransOrder_num_action for the parents of sa and sb, comparing the
+ * cached keys instead of parsing and collating the num and description. */
+static int
+split_trans_order (const Split *sa, const SplitSortKey& ka,
+                   const Split *sb, const SplitSortKey& kb,
+                   gboolean action_for_num)
+{
+    const Transaction *ta = sa->parent, *tb = sb->parent;
+    int retval;
+
+    if ( ta && !tb ) return -1;
+    if ( !ta && tb ) return +1;
+    if ( !ta && !tb ) return 0;
+
+    if (ta->date_posted != tb->date_posted)
+        return (ta->date_posted > tb->date_posted) - (ta->date_posted < tb->date_posted);
+
+    /* Always sort closing transactions after normal transactions */
+    {
+        gboolean ta_is_closing = xaccTransGetIsClosingTxn (ta);
+        gboolean tb_is_closing = xaccTransGetIsClosingTxn (tb);
+        if (ta_is_closing != tb_is_closing)
+            return (ta_is_closing - tb_is_closing);
+    }
+
+    const auto& kta{trans_get_sort_key (ta)};
+    const auto& ktb{trans_get_sort_key (tb)};
+
+    /* otherwise, sort on number string */
+    if (action_for_num && sa->action && sb->action)
+        retval = sort_string_num_cmp (ka.action, kb.action);
+    else
+        retval = sort_string_num_cmp (kta.num, ktb.num);
+    if (retval)
+        return retval;
+
+    if (ta->date_entered != tb->date_entered)
+        return (ta->date_entered > tb->date_entered) - (ta->date_entered < tb->date_entered);
+
+    /* otherwise, sort on description string */
+    retval = sort_key_cmp (kta.description.key, ktb.description.key);
+    if (retval)
+        return retval;
+
+    /* else, sort on guid - keeps sort stable. */
+    return qof_instance_guid_compare(ta, tb);
+}
+
 gint
 xaccSplitOrder (const Split *sa, const Split *sb)
+{
+    if (sa == sb) return 0;
+    /* nothing is always less than something */
+    if (!sa) return -1;
+    if (!sb) return +1;
+
+    return xaccSplitOrderActionForNum (sa, sb,
+                                       qof_book_use_split_action_for_num_field
+                                       (xaccSplitGetBook (sa)));
+}
+
+gint
+xaccSplitOrderActionForNum (const Split *sa, const Split *sb,
+                            gboolean action_for_num)
 {
     int retval;
     int comp;
-    const char *da, *db;
-    gboolean action_for_num;
 
     if (sa == sb) return 0;
     /* nothing is always less than something */
     if (!sa) return -1;
     if (!sb) return +1;
 
+    const auto& ka{split_get_sort_key (sa)};
+    const auto& kb{split_get_sort_key (sb)};
+
     /* sort in transaction order, but use split action rather than trans num
      * according to book option */
-    action_for_num = qof_book_use_split_action_for_num_field
-        (xaccSplitGetBook (sa));
-    if (action_for_num)
-        retval = xaccTransOrder_num_action (sa->parent, sa->action,
-                                            sb->parent, sb->action);
-    else
-        retval = xaccTransOrder (sa->parent, sb->parent);
+    retval = split_trans_order (sa, ka, sb, kb, action_for_num);
     if (retval) return retval;
 
     /* otherwise, sort on memo strings */
-    da = sa->memo ? sa->memo : "";
-    db = sb->memo ? sb->memo : "";
-    retval = g_utf8_collate (da, db);
+    retval = sort_key_cmp (ka.memo.key, kb.memo.key);
     if (retval)
         return retval;
 
     /* otherwise, sort on action strings */
-    da = sa->action ? sa->action : "";
-    db = sb->action ? sb->action : "";
-    retval = g_utf8_collate (da, db);
+    retval = sort_key_cmp (ka.action.key, kb.action.key);
     if (retval != 0)
         return retval;
 
@@ -1723,6 +1890,7 @@ qofSplitSetMemo (Split *split, const char* memo)
 {
     g_return_if_fail(split);
     CACHE_REPLACE(split->memo, memo);
+    xaccSplitClearSortKey (split);
 }
 
 void
@@ -1732,6 +1900,7 @@ xaccSplitSetMemo (Split *split, const char *memo)
     xaccTransBeginEdit (split->parent);
 
     CACHE_REPLACE(split->memo, memo);
+    xaccSplitClearSortKey (split);
     qof_instance_set_dirty(QOF_INSTANCE(split));
     xaccTransCommitEdit(split->parent);
 
@@ -1742,6 +1911,7 @@ qofSplitSetAction (Split *split, const char *actn)
 {
     g_return_if_fail(split);
     CACHE_REPLACE(split->action, actn);
+    xaccSplitClearSortKey (split);
 }
 
 void
@@ -1751,6 +1921,7 @@ xaccSplitSetAction (Split *split, const char *actn)
     xaccTransBeginEdit (split->parent);
 
     CACHE_REPLACE(split->action, actn);
+    xaccSplitClearSortKey (split);
     qof_instance_set_dirty(QOF_INSTANCE(split));
     xaccTransCommitEdit(split->parent);
 
@@ -2250,6 +2421,259 @@ qofSplitSetAccount(Split *s, QofInstance *ent)
     xaccSplitSetAccount(s, acc);
 }
 
+/* ================================================================ */
+/* Query indexes
+ *
+ * Split queries nearly always ask for the splits of some accounts, for a
+ * range of posted dates, or both.  The accounts' split vectors are sorted
+ * by posted date, so they answer either without a look at the rest of the
+ * book's splits.
+ */
+
+struct SplitQueryRange
+{
+    AccountVec accounts;
+    time64 start = INT64_MIN;
+    time64 end = INT64_MAX;
+
+    /* Costing a plan mustn't make the backend load splits. */
+    gint64 count () const
+    {
+        gint64 count = 0;
+        for (auto acc : accounts)
+            count += gnc_account_estimate_splits_posted_between (acc, start,
+                                                                 end);
+        return count;
+    }
+};
+
+static bool
+query_term_has_path (const QofQueryTerm *qt,
+                     std::initializer_list<const char*> path)
+{
+    auto node = qof_query_term_get_param_path (qt);
+    for (auto param : path)
+    {
+        if (!node || g_strcmp0 (static_cast<const char*>(node->data), param))
+            return false;
+        node = node->next;
+    }
+    return !node;
+}
+
+/* Narrow range to the posted dates the AND-terms allow, adding the terms
+ * it then matches exactly to covered.  Returns whether there were any. */
+static bool
+split_query_date_range (GList *and_terms, SplitQueryRange& range,
+                        GList **covered)
+{
+    bool found = false;
+
+    for (auto node = and_terms; node; node = node->next)
+    {
+        auto qt = static_cast<QofQueryTerm*>(node->data);
+        auto pd = qof_query_term_get_pred_data (qt);
+        time64 date;
+
+        if (qof_query_term_is_inverted (qt) ||
+            !query_term_has_path (qt, {SPLIT_TRANS, TRANS_DATE_POSTED}) ||
+            !qof_query_date_predicate_get_date (pd, &date))
+            continue;
+
+        /* Day matches compare the canonical times of the days, so the
+         * bounds are widened enough to be sure and the term is checked on
+         * each split. */
+        bool exact = reinterpret_cast<query_date_t>(pd)->options ==
+            QOF_DATE_MATCH_NORMAL;
+        time64 slack = exact ? 0 : 2 * 86400;
+        time64 start = INT64_MIN, end = INT64_MAX;
+
+        if (date < INT64_MIN + slack || date > INT64_MAX - slack)
+            continue;
+
+        switch (pd->how)
+        {
+        case QOF_COMPARE_GT:
+            start = exact && date < INT64_MAX ? date + 1 : date - slack;
+            break;
+        case QOF_COMPARE_GTE:
+            start = date - slack;
+            break;
+        case QOF_COMPARE_LT:
+            end = exact && date > INT64_MIN ? date - 1 : date + slack;
+            break;
+        case QOF_COMPARE_LTE:
+            end = date + slack;
+            break;
+        case QOF_COMPARE_EQUAL:
+            start = date - slack;
+            end = date + slack;
+            break;
+        default:
+            continue;
+        }
+
+        range.start = std::max (range.start, start);
+        range.end = std::min (range.end, end);
+        if (exact)
+            *covered = g_list_prepend (*covered, qt);
+        found = true;
+    }
+    return found;
+}
+
+static void
+split_query_range_free (gpointer data)
+{
+    delete static_cast<SplitQueryRange*>(data);
+}
+
+static void
+split_query_range_foreach (QofBook *book, gpointer data,
+                           QofInstanceForeachCB cb, gpointer user_data)
+{
+    auto range = static_cast<SplitQueryRange*>(data);
+    for (auto acc : range->accounts)
+        gnc_account_foreach_split_posted_between (acc, range->start, range->end,
+                                                  [cb, user_data](Split *s)
+                                                  { cb (QOF_INSTANCE (s), user_data); });
+}
+
+static gchar *
+split_query_range_describe (const SplitQueryRange& range)
+{
+    auto accounts = g_strdup_printf ("%zu accounts", range.accounts.size());
+    if (range.start == INT64_MIN && range.end == INT64_MAX)
+        return accounts;
+
+    auto start = range.start == INT64_MIN ? g_strdup ("the start") :
+        gnc_print_time64 (range.start, "%Y-%m-%d %H:%M:%S");
+    auto end = range.end == INT64_MAX ? g_strdup ("the end") :
+        gnc_print_time64 (range.end, "%Y-%m-%d %H:%M:%S");
+    auto description = g_strdup_printf ("%s, posted from %s to %s", accounts,
+                                        start, end);
+    g_free (accounts);
+    g_free (start);
+    g_free (end);
+    return description;
+}
+
+/* The splits of the accounts an account GUID term asks for. */
+static gboolean
+split_account_index_plan (QofBook *book, GList *and_terms,
+                          QofQueryIndexPlan *plan)
+{
+    SplitQueryRange range;
+    GList *date_terms = nullptr;
+    QofQueryTerm *best_term = nullptr;
+    AccountVec best_accounts;
+    gint64 best_count = 0;
+
+    split_query_date_range (and_terms, range, &date_terms);
+
+    for (auto node = and_terms; node; node = node->next)
+    {
+        auto qt = static_cast<QofQueryTerm*>(node->data);
+        auto pd = qof_query_term_get_pred_data (qt);
+
+        if (qof_query_term_is_inverted (qt) ||
+            g_strcmp0 (pd->type_name, QOF_TYPE_GUID) ||
+            reinterpret_cast<query_guid_t>(pd)->options != QOF_GUID_MATCH_ANY ||
+            !(query_term_has_path (qt, {SPLIT_ACCOUNT, QOF_PARAM_GUID}) ||
+              query_term_has_path (qt, {SPLIT_ACCOUNT_GUID})))
+            continue;
+
+        range.accounts.clear();
+        for (auto guid = reinterpret_cast<query_guid_t>(pd)->guids; guid;
+             guid = guid->next)
+        {
+            auto acc = xaccAccountLookup (static_cast<GncGUID*>(guid->data), book);
+            if (acc && std::find (range.accounts.begin(), range.accounts.end(),
+                                  acc) == range.accounts.end())
+                range.accounts.push_back (acc);
+        }
+
+        auto count = range.count();
+        if (!best_term || count < best_count)
+        {
+            best_term = qt;
+            best_count = count;
+            best_accounts = std::move (range.accounts);
+        }
+    }
+
+    if (!best_term)
+    {
+        g_list_free (date_terms);
+        return FALSE;
+    }
+
+    range.accounts = std::move (best_accounts);
+    plan->estimate = best_count;
+    plan->covered = g_list_prepend (date_terms, best_term);
+    plan->description = split_query_range_describe (range);
+    plan->data = new SplitQueryRange (std::move (range));
+    return TRUE;
+}
+
+/* The splits posted in a range of dates, from all of the book's accounts.
+ * Only usable if every split of the book is in one of them. */
+static gboolean
+split_date_index_plan (QofBook *book, GList *and_terms,
+                       QofQueryIndexPlan *plan)
+{
+    SplitQueryRange range;
+    GList *date_terms = nullptr;
+    gint64 num_splits = 0;
+
+    if (!split_query_date_range (and_terms, range, &date_terms))
+        return FALSE;
+
+    auto add_account = [&range, &num_splits](Account *acc)
+    {
+        range.accounts.push_back (acc);
+        num_splits += gnc_account_estimate_splits_posted_between (acc, INT64_MIN,
+                                                                  INT64_MAX);
+    };
+    for (auto root : {gnc_book_get_root_account (book),
+                      gnc_book_get_template_root (book)})
+    {
+        if (!root)
+            continue;
+        add_account (root);
+        gnc_account_foreach_descendant (root, add_account);
+    }
+
+    auto coll = qof_book_get_collection (book, GNC_ID_SPLIT);
+    if (num_splits != static_cast<gint64>(qof_collection_count (coll)))
+    {
+        g_list_free (date_terms);
+        return FALSE;
+    }
+
+    plan->estimate = range.count();
+    plan->covered = date_terms;
+    plan->description = split_query_range_describe (range);
+    plan->data = new SplitQueryRange (std::move (range));
+    return TRUE;
+}
+
+static const QofQueryIndex split_account_index =
+{
+    "account splits",
+    split_account_index_plan,
+    split_query_range_foreach,
+    split_query_range_free
+};
+
+static const QofQueryIndex split_date_index =
+{
+    "posted date",
+    split_date_index_plan,
+    split_query_range_foreach,
+    split_query_range_free
+};
+
 gboolean xaccSplitRegister (void)
 {
     static const QofParam params[] =
@@ -2342,6 +2766,11 @@ gboolean xaccSplitRegister (void)
         };
 
     qof_class_register (GNC_ID_SPLIT, (QofSortFunc)xaccSplitOrder, params);
+    qof_class_register_pure_params (GNC_ID_SPLIT, SPLIT_DATE_RECONCILED,
+                                    SPLIT_MEMO, SPLIT_ACTION, SPLIT_RECONCILE,
+                                    SPLIT_AMOUNT, SPLIT_VALUE, SPLIT_TRANS,
+                                    SPLIT_ACCOUNT, SPLIT_ACCOUNT_GUID,
+                                    QOF_PARAM_GUID, nullptr);
     qof_class_register (SPLIT_ACCT_FULLNAME,
                         (QofSortFunc)xaccSplitCompareAccountFullNames, nullptr);
     qof_class_register (SPLIT_CORR_ACCT_NAME,
@@ -2350,6 +2779,9 @@ gboolean xaccSplitRegister (void)
     qof_class_register (SPLIT_CORR_ACCT_CODE,
                         (QofSortFunc)xaccSplitCompareOtherAccountCodes, nullptr);
 
+    qof_query_register_index (GNC_ID_SPLIT, &split_account_index);
+    qof_query_register_index (GNC_ID_SPLIT, &split_date_index);
+
     return qof_object_register (&split_object_def);
 }
 
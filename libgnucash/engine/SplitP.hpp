@@ -56,6 +56,9 @@
 /* A "split" is more commonly referred to as an "entry" in a "transaction".
  */
 
+/* Precomputed sort keys used by xaccSplitOrder, see Split.cpp. */
+struct SplitSortKey;
+
 /* Flags for handling cap-gains status */
 #define GAINS_STATUS_UNKNOWN        0xff
 #define GAINS_STATUS_CLEAN           0x0
@@ -128,6 +131,11 @@ struct split_s
     gnc_numeric  noclosing_balance;
     gnc_numeric  cleared_balance;
     gnc_numeric  reconciled_balance;
+
+    /* Collation keys and parsed numbers of the memo and action for
+     * sorting, built on demand by xaccSplitOrder and cleared by the
+     * setters of those strings. */
+    SplitSortKey *sort_key;
 };
 
 struct _SplitClass
@@ -160,6 +168,15 @@ void xaccSplitUnvoid(Split *split);
 void xaccSplitCommitEdit(Split *s);
 void xaccSplitRollbackEdit(Split *s);
 
+/* xaccSplitOrder with the book's "use split action for num field" option
+ * already looked up, for sorting many splits of the same book. */
+gint xaccSplitOrderActionForNum (const Split *sa, const Split *sb,
+                                 gboolean action_for_num);
+
+/* Drops the split's sort keys.  Anything that sets the memo or action
+ * without the setters must call it. */
+void xaccSplitClearSortKey (Split *split);
+
 /* Compute the value of a list of splits in the given currency,
  * excluding the skip_me split. */
 gnc_numeric xaccSplitsComputeValue (GList *splits, const Split * skip_me,
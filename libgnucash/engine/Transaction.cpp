@@ -272,7 +272,10 @@ gnc_transaction_init(Transaction* trans)
     trans->date_posted  = 0;
     trans->marker = 0;
     trans->orig = nullptr;
+    trans->sort_key = nullptr;
     trans->txn_type = TXN_TYPE_UNCACHED;
+    trans->is_closing = FALSE;
+    trans->is_closing_generation = 0;
     LEAVE (" ");
 }
 
@@ -805,6 +808,7 @@ xaccFreeTransaction (Transaction *trans)
     /* free up transaction strings */
     CACHE_REMOVE(trans->num);
     CACHE_REMOVE(trans->description);
+    xaccTransClearSortKey (trans);
 
     /* Just in case someone looks up freed memory ... */
     trans->num         = (char *) 1;
@@ -1657,6 +1661,7 @@ xaccTransRollbackEdit (Transaction *trans)
     orig = trans->orig;
     std::swap (trans->num, orig->num);
     std::swap (trans->description, orig->description);
+    xaccTransClearSortKey (trans);
     trans->date_entered = orig->date_entered;
     trans->date_posted = orig->date_posted;
     std::swap (trans->common_currency, orig->common_currency);
@@ -1685,6 +1690,7 @@ xaccTransRollbackEdit (Transaction *trans)
             xaccSplitRollbackEdit(s);
             std::swap (s->action, so->action);
             std::swap (s->memo, so->memo);
+            xaccSplitClearSortKey (s);
             qof_instance_copy_kvp (QOF_INSTANCE (s), QOF_INSTANCE (so));
             s->reconciled = so->reconciled;
             s->amount = so->amount;
@@ -2056,6 +2062,7 @@ xaccTransSetNum (Transaction *trans, const char *xnum)
     xaccTransBeginEdit(trans);
 
     CACHE_REPLACE(trans->num, xnum);
+    xaccTransClearSortKey (trans);
     qof_instance_set_dirty(QOF_INSTANCE(trans));
     mark_trans(trans);  /* Dirty balance of every account in trans */
     xaccTransCommitEdit(trans);
@@ -2076,6 +2083,7 @@ xaccTransSetDescription (Transaction *trans, const char *desc)
     xaccTransBeginEdit(trans);
 
     CACHE_REPLACE(trans->description, desc);
+    xaccTransClearSortKey (trans);
     qof_instance_set_dirty(QOF_INSTANCE(trans));
     xaccTransCommitEdit(trans);
 }
@@ -2142,6 +2150,8 @@ xaccTransSetIsClosingTxn (Transaction *trans, gboolean is_closing)
     {
         qof_instance_set_kvp (QOF_INSTANCE (trans), nullptr, 1, trans_is_closing_str);
     }
+    /* Affects the noclosing balances and the sort order of the splits */
+    mark_trans(trans);
     qof_instance_set_dirty(QOF_INSTANCE(trans));
     xaccTransCommitEdit(trans);
 }
@@ -2337,16 +2347,18 @@ xaccTransGetIsClosingTxn (const Transaction *trans)
 {
     if (!trans) return FALSE;
 
-    GValue v = G_VALUE_INIT;
-    gboolean rv;
-    qof_instance_get_kvp (QOF_INSTANCE (trans), &v, 1, trans_is_closing_str);
-    if (G_VALUE_HOLDS_INT64 (&v))
-        rv = (g_value_get_int64 (&v) ? 1 : 0);
-    else
-        rv = 0;
-    g_value_unset (&v);
+    auto frame = qof_instance_get_slots (QOF_INSTANCE (trans));
+    if (!frame) return FALSE;
+    if (trans->is_closing_generation != frame->generation ())
+    {
+        auto t = const_cast<Transaction*>(trans);
+        auto slot = frame->get_slot ({trans_is_closing_str});
+        t->is_closing = (slot && slot->get_type () == KvpValue::Type::INT64 &&
+                         slot->get<int64_t> () != 0);
+        t->is_closing_generation = frame->generation ();
+    }
 
-    return rv;
+    return trans->is_closing;
 }
 
 /********************************************************************\
@@ -3135,6 +3147,9 @@ gboolean xaccTransRegister (void)
         };
 
     qof_class_register (GNC_ID_TRANS, (QofSortFunc)xaccTransOrder, params);
+    qof_class_register_pure_params (GNC_ID_TRANS, TRANS_NUM, TRANS_DESCRIPTION,
+                                    TRANS_DATE_ENTERED, TRANS_DATE_POSTED,
+                                    QOF_PARAM_GUID, nullptr);
 
     return qof_object_register (&trans_object_def);
 }
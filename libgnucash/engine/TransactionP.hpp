@@ -54,6 +54,9 @@
 
 
 /** STRUCTS *********************************************************/
+/* Precomputed sort keys used by xaccSplitOrder, see Split.cpp. */
+struct TransSortKey;
+
 /*
  * Double-entry is forced by having at least two splits in every
  * transaction.  By convention, (and only by convention, not by
@@ -116,6 +119,17 @@ struct transaction_s
      */
     char txn_type;
 
+    /* Whether the transaction closes the books, as read from its slots,
+     * and the generation of the slots frame it was read from.  It's asked
+     * of every split when balances are computed or splits sorted, so it's
+     * only read again when the slots change.
+     */
+    gboolean is_closing;
+    guint64 is_closing_generation;
+
+    /* Collation keys and parsed numbers of the num and description for
+     * xaccSplitOrder, built on demand and cleared by their setters. */
+    TransSortKey *sort_key;
 };
 
 struct _TransactionClass
@@ -173,6 +187,10 @@ void xaccDisableDataScrubbing(void);
 void xaccTransRemoveSplit (Transaction *trans, const Split *split);
 void check_open (const Transaction *trans);
 
+/* Drops the transaction's sort keys.  Anything that sets the num or
+ * description without the setters must call it. */
+void xaccTransClearSortKey (Transaction *trans);
+
 /* Structure for accessing static functions for testing */
 typedef struct
 {
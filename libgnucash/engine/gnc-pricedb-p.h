@@ -61,7 +61,10 @@ struct gnc_price_db_s
     QofInstance inst;              /* globally unique object identifier */
     GHashTable *commodity_hash;
     gboolean bulk_update;		 /* TRUE while reading XML file, etc. */
-    gboolean reset_nth_price_cache;
+    gboolean sort_dirty;         /* a bulk update left a series out of order */
+    int max_conversion_hops;
+    /* The conversion rates found so far, see gnc-pricedb.cpp. */
+    struct gnc_price_conversion_cache_s *conversion_cache;
 };
 
 struct _GncPriceDBClass
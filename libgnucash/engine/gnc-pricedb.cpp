@@ -32,6 +32,12 @@
 #include "gnc-pricedb-p.h"
 #include <qofinstance-p.h>
 
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = GNC_MOD_PRICE;
 
@@ -40,10 +46,7 @@ static gboolean remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup);
 static GNCPrice *lookup_nearest_in_time(GNCPriceDB *db, const gnc_commodity *c,
                                         const gnc_commodity *currency,
                                         time64 t, gboolean sameday);
-static gboolean
-pricedb_pricelist_traversal(GNCPriceDB *db,
-                            gboolean (*f)(GList *p, gpointer user_data),
-                            gpointer user_data);
+static void price_conversion_cache_clear (GNCPriceDB *db);
 
 enum
 {
@@ -561,6 +564,8 @@ gnc_price_set_value(GNCPrice *p, gnc_numeric value)
         p->value = value;
         gnc_price_set_dirty(p);
         gnc_price_commit_edit (p);
+        if (p->db)
+            price_conversion_cache_clear (p->db);
     }
 }
 
@@ -766,15 +771,245 @@ gnc_price_list_equal(PriceList *prices1, PriceList *prices2)
     return TRUE;
 }
 
+/* ==================================================================== */
+/* price series functions
+
+   The prices of one commodity in one currency are kept in a vector sorted
+   the same way as a GNCPrice list, newest first, so that lookups by time
+   are binary searches.  The vector holds a reference to each price.
+ */
+
+using PriceVec = std::vector<GNCPrice*>;
+
+static bool
+price_is_newer (const GNCPrice *a, const GNCPrice *b)
+{
+    return compare_prices_by_date (a, b) < 0;
+}
+
+/* The first price in the series that isn't newer than t. */
+static PriceVec::const_iterator
+price_series_at_or_before (const PriceVec& series, time64 t)
+{
+    return std::partition_point (series.begin(), series.end(),
+                                 [t](const GNCPrice *p){ return p->tmspec > t; });
+}
+
+/* The first price in the series that is older than t. */
+static PriceVec::const_iterator
+price_series_before (const PriceVec& series, time64 t)
+{
+    return std::partition_point (series.begin(), series.end(),
+                                 [t](const GNCPrice *p){ return p->tmspec >= t; });
+}
+
+static void
+price_series_sort (gpointer key, gpointer value, gpointer data)
+{
+    auto series = static_cast<PriceVec*>(value);
+    if (!std::is_sorted (series->begin(), series->end(), price_is_newer))
+        std::sort (series->begin(), series->end(), price_is_newer);
+}
+
+static void
+price_series_sort_currency_hash (gpointer key, gpointer value, gpointer data)
+{
+    g_hash_table_foreach (static_cast<GHashTable*>(value), price_series_sort,
+                          nullptr);
+}
+
+/* Put back in order the series that a bulk update appended prices to out
+ * of order.  Everything that reads the series calls this first, so that a
+ * lookup in the middle of a bulk update still finds them sorted. */
+static void
+pricedb_sort_series (GNCPriceDB *db)
+{
+    if (!db->sort_dirty || !db->commodity_hash)
+        return;
+    g_hash_table_foreach (db->commodity_hash, price_series_sort_currency_hash,
+                          nullptr);
+    db->sort_dirty = FALSE;
+}
+
+static PriceVec*
+price_series_lookup (GNCPriceDB *db, const gnc_commodity *commodity,
+                     const gnc_commodity *currency)
+{
+    pricedb_sort_series (db);
+    auto currency_hash = static_cast<GHashTable*>(g_hash_table_lookup(db->commodity_hash, commodity));
+    if (!currency_hash)
+        return nullptr;
+    return static_cast<PriceVec*>(g_hash_table_lookup(currency_hash, currency));
+}
+
+/* The series of commodity in currency, made if there isn't one yet. */
+static PriceVec*
+price_series_get (GNCPriceDB *db, gnc_commodity *commodity,
+                  gnc_commodity *currency)
+{
+    auto currency_hash = static_cast<GHashTable*>(g_hash_table_lookup(db->commodity_hash, commodity));
+    if (!currency_hash)
+    {
+        currency_hash = g_hash_table_new(nullptr, nullptr);
+        g_hash_table_insert(db->commodity_hash, commodity, currency_hash);
+    }
+
+    auto series = static_cast<PriceVec*>(g_hash_table_lookup(currency_hash, currency));
+    if (!series)
+    {
+        series = new PriceVec;
+        g_hash_table_insert(currency_hash, currency, series);
+    }
+    return series;
+}
+
+/* Like gnc_price_list_insert, p is referenced even when a duplicate is found
+ * and it isn't inserted.  A bulk update doesn't check for duplicates and
+ * just appends p: loading may well add a series oldest first, which would
+ * make each insertion move the whole series.  pricedb_sort_series puts it
+ * in order before it's next looked at. */
+static void
+price_series_insert (GNCPriceDB *db, PriceVec& series, GNCPrice *p)
+{
+    gnc_price_ref(p);
+
+    if (db->bulk_update)
+    {
+        if (!series.empty() && price_is_newer (p, series.back()))
+            db->sort_dirty = TRUE;
+        series.push_back (p);
+        return;
+    }
+
+    /* A duplicate is on the same day, so only that day needs looking at. */
+    auto day_start = gnc_time64_get_day_start (p->tmspec);
+    auto day_end = gnc_time64_get_day_end (p->tmspec);
+    for (auto it = price_series_at_or_before (series, day_end);
+         it != series.end() && (*it)->tmspec >= day_start; ++it)
+        if (!price_is_duplicate (p, *it))
+            return;
+
+    series.insert (std::upper_bound (series.begin(), series.end(), p,
+                                     price_is_newer), p);
+}
+
+static void
+price_series_remove (PriceVec& series, GNCPrice *p)
+{
+    auto range = std::equal_range (series.begin(), series.end(), p,
+                                   price_is_newer);
+    auto it = std::find (range.first, range.second, p);
+
+    /* The series is out of order during a bulk update or if p's time was
+       changed behind our back. */
+    if (it == range.second)
+        it = std::find (series.begin(), series.end(), p);
+    if (it == series.end())
+        return;
+
+    series.erase (it);
+    gnc_price_unref(p);
+}
+
+static GList*
+price_series_to_list (const PriceVec& series)
+{
+    GList *list = nullptr;
+    for (auto it = series.rbegin(); it != series.rend(); ++it)
+        list = g_list_prepend (list, *it);
+    return list;
+}
+
+/* ==================================================================== */
+/* conversion cache
+
+   The results of get_nearest_price by the two commodities, the time and
+   whether the price has to be before it.  Reports convert the same pairs
+   at the same dates over and over, and a conversion without a direct
+   price searches the prices of both commodities.  Adding, removing or
+   changing the value of a price clears it.  The commodities are known by
+   their GUIDs: one destroyed without a price ever being touched could
+   have its address reused by another.
+ */
+
+struct PriceConversionKey
+{
+    GncGUID from;
+    GncGUID to;
+    time64 t;
+    gboolean before;
+
+    bool operator== (const PriceConversionKey& other) const
+    {
+        return t == other.t && before == other.before &&
+            guid_equal (&from, &other.from) && guid_equal (&to, &other.to);
+    }
+};
+
+struct PriceConversionKeyHash
+{
+    size_t operator() (const PriceConversionKey& key) const
+    {
+        size_t hash = guid_hash_to_guint (&key.from);
+        hash = hash * 31 + guid_hash_to_guint (&key.to);
+        hash = hash * 31 + std::hash<time64>{}(key.t);
+        return hash * 2 + (key.before ? 1 : 0);
+    }
+};
+
+struct gnc_price_conversion_cache_s
+{
+    std::unordered_map<PriceConversionKey, gnc_numeric,
+                       PriceConversionKeyHash> rates;
+    /* Conversions at the latest price go through prices before now, so
+       they're only good for a while. */
+    time64 latest_valid_until = 0;
+};
+
+/* Plenty for a large report, without letting it grow without bound. */
+static const size_t MAX_CACHED_CONVERSIONS = 100000;
+static const int DEFAULT_MAX_CONVERSION_HOPS = 2;
+
+static void
+price_conversion_cache_clear (GNCPriceDB *db)
+{
+    /* Clearing an empty map still goes through all its buckets. */
+    if (db && db->conversion_cache && !db->conversion_cache->rates.empty())
+        db->conversion_cache->rates.clear();
+}
+
+static gnc_price_conversion_cache_s *
+price_conversion_cache (GNCPriceDB *db, time64 t)
+{
+    if (!db->conversion_cache)
+        db->conversion_cache = new gnc_price_conversion_cache_s;
+
+    auto cache = db->conversion_cache;
+    if (t == INT64_MAX)
+    {
+        auto now = gnc_time (nullptr);
+        if (now >= cache->latest_valid_until)
+        {
+            price_conversion_cache_clear (db);
+            cache->latest_valid_until = now + 60;
+        }
+    }
+    if (cache->rates.size() >= MAX_CACHED_CONVERSIONS)
+        price_conversion_cache_clear (db);
+
+    return cache;
+}
+
 /* ==================================================================== */
 /* GNCPriceDB functions
 
    Structurally a GNCPriceDB contains a hash mapping price commodities
    (of type gnc_commodity*) to hashes mapping price currencies (of
-   type gnc_commodity*) to GNCPrice lists (see gnc-pricedb.h for a
-   description of GNCPrice lists).  The top-level key is the commodity
-   you want the prices for, and the second level key is the commodity
-   that the value is expressed in terms of.
+   type gnc_commodity*) to price series (see above).  The top-level key
+   is the commodity you want the prices for, and the second level key is
+   the commodity that the value is expressed in terms of.  Functions
+   returning prices to callers hand them out as GNCPrice lists (see
+   gnc-pricedb.h for a description of GNCPrice lists).
  */
 
 /* GObject Initialization */
@@ -783,7 +1018,7 @@ QOF_GOBJECT_IMPL(gnc_pricedb, GNCPriceDB, QOF_TYPE_INSTANCE)
 static void
 gnc_pricedb_init(GNCPriceDB* pdb)
 {
-    pdb->reset_nth_price_cache = FALSE;
+    pdb->max_conversion_hops = DEFAULT_MAX_CONVERSION_HOPS;
 }
 
 static void
@@ -834,18 +1069,15 @@ destroy_pricedb_currency_hash_data(gpointer key,
                                    gpointer data,
                                    gpointer user_data)
 {
-    GList *price_list = (GList *) data;
-    GList *node;
-    GNCPrice *p;
+    auto series = static_cast<PriceVec*>(data);
 
-    for (node = price_list; node; node = node->next)
+    for (auto p : *series)
     {
-        p = static_cast<GNCPrice*>(node->data);
-
         p->db = nullptr;
+        gnc_price_unref(p);
     }
 
-    gnc_price_list_destroy(price_list);
+    delete series;
 }
 
 static void
@@ -873,6 +1105,8 @@ gnc_pricedb_destroy(GNCPriceDB *db)
     }
     g_hash_table_destroy (db->commodity_hash);
     db->commodity_hash = nullptr;
+    delete db->conversion_cache;
+    db->conversion_cache = nullptr;
     /* qof_instance_release (&db->inst); */
     g_object_unref(db);
 }
@@ -880,9 +1114,29 @@ gnc_pricedb_destroy(GNCPriceDB *db)
 void
 gnc_pricedb_set_bulk_update(GNCPriceDB *db, gboolean bulk_update)
 {
+    /* The prices added during the bulk update may be out of order. */
+    if (db->bulk_update && !bulk_update)
+        pricedb_sort_series (db);
     db->bulk_update = bulk_update;
 }
 
+void
+gnc_pricedb_set_max_conversion_hops (GNCPriceDB *db, int max_hops)
+{
+    g_return_if_fail (db && max_hops > 0);
+    if (db->max_conversion_hops == max_hops)
+        return;
+    db->max_conversion_hops = max_hops;
+    price_conversion_cache_clear (db);
+}
+
+int
+gnc_pricedb_get_max_conversion_hops (GNCPriceDB *db)
+{
+    g_return_val_if_fail (db, DEFAULT_MAX_CONVERSION_HOPS);
+    return db->max_conversion_hops;
+}
+
 /* ==================================================================== */
 /* This is kind of weird, the way its done.  Each collection of prices
  * for a given commodity should get its own guid, be its own entity, etc.
@@ -955,15 +1209,21 @@ pricedb_equal_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
     auto equal_data = static_cast<GNCPriceDBEqualData*>(user_data);
     auto currency = static_cast<gnc_commodity*>(key);
-    auto price_list1 = static_cast<GList*>(val);
-    auto price_list2 = gnc_pricedb_get_prices (equal_data->db2,
-                                               equal_data->commodity,
-                                               currency);
+    auto series1 = static_cast<PriceVec*>(val);
+    auto series2 = price_series_lookup (equal_data->db2,
+                                        equal_data->commodity, currency);
 
-    if (!gnc_price_list_equal (price_list1, price_list2))
+    if (!series2 || series1->size() != series2->size())
+    {
+        PINFO ("price series differ in length");
         equal_data->equal = FALSE;
+        return;
+    }
 
-    gnc_price_list_destroy (price_list2);
+    if (!std::equal (series1->begin(), series1->end(), series2->begin(),
+                     [](const GNCPrice *p1, const GNCPrice *p2)
+                     { return gnc_price_equal (p1, p2); }))
+        equal_data->equal = FALSE;
 }
 
 static void
@@ -995,6 +1255,7 @@ gnc_pricedb_equal (GNCPriceDB *db1, GNCPriceDB *db2)
 
     equal_data.equal = TRUE;
     equal_data.db2 = db2;
+    pricedb_sort_series (db1);
 
     g_hash_table_foreach (db1->commodity_hash,
                           pricedb_equal_foreach_currencies_hash,
@@ -1012,10 +1273,9 @@ add_price(GNCPriceDB *db, GNCPrice *p)
 {
     /* This function will use p, adding a ref, so treat p as read-only
        if this function succeeds. */
-    GList *price_list;
+    PriceVec *series;
     gnc_commodity *commodity;
     gnc_commodity *currency;
-    GHashTable *currency_hash;
 
     if (!db || !p) return FALSE;
     ENTER ("db=%p, pr=%p dirty=%d destroying=%d",
@@ -1068,37 +1328,19 @@ add_price(GNCPriceDB *db, GNCPrice *p)
         }
     }
 
-    currency_hash = static_cast<GHashTable*>(g_hash_table_lookup(db->commodity_hash, commodity));
-    if (!currency_hash)
-    {
-        currency_hash = g_hash_table_new(nullptr, nullptr);
-        g_hash_table_insert(db->commodity_hash, commodity, currency_hash);
-    }
-
-    price_list = static_cast<GList*>(g_hash_table_lookup(currency_hash, currency));
-    if (!gnc_price_list_insert(&price_list, p, !db->bulk_update))
-    {
-        LEAVE ("gnc_price_list_insert failed");
-        return FALSE;
-    }
-
-    if (!price_list)
-    {
-        LEAVE (" no price list");
-        return FALSE;
-    }
-
-    g_hash_table_insert(currency_hash, currency, price_list);
+    series = price_series_get (db, commodity, currency);
+    price_series_insert (db, *series, p);
     p->db = db;
+    price_conversion_cache_clear (db);
 
     qof_event_gen (&p->inst, QOF_EVENT_ADD, nullptr);
 
-    LEAVE ("db=%p, pr=%p dirty=%d dextroying=%d commodity=%s/%s currency_hash=%p",
+    LEAVE ("db=%p, pr=%p dirty=%d dextroying=%d commodity=%s/%s series=%p",
            db, p, qof_instance_get_dirty_flag(p),
            qof_instance_get_destroying(p),
            gnc_commodity_get_namespace(p->commodity),
            gnc_commodity_get_mnemonic(p->commodity),
-           currency_hash);
+           series);
     return TRUE;
 }
 
@@ -1139,7 +1381,7 @@ gnc_pricedb_add_price(GNCPriceDB *db, GNCPrice *p)
 static gboolean
 remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup)
 {
-    GList *price_list;
+    PriceVec *series;
     gnc_commodity *commodity;
     gnc_commodity *currency;
     GHashTable *currency_hash;
@@ -1175,24 +1417,18 @@ remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup)
     }
 
     qof_event_gen (&p->inst, QOF_EVENT_REMOVE, nullptr);
-    price_list = static_cast<GList*>(g_hash_table_lookup(currency_hash, currency));
+    series = static_cast<PriceVec*>(g_hash_table_lookup(currency_hash, currency));
     gnc_price_ref(p);
-    if (!gnc_price_list_remove(&price_list, p))
-    {
-        gnc_price_unref(p);
-        LEAVE (" cannot remove price list");
-        return FALSE;
-    }
+    if (series)
+        price_series_remove (*series, p);
+    price_conversion_cache_clear (db);
 
-    /* if the price list is empty, then remove this currency from the
+    /* if the price series is empty, then remove this currency from the
        commodity hash */
-    if (price_list)
-    {
-        g_hash_table_insert(currency_hash, currency, price_list);
-    }
-    else
+    if (!series || series->empty())
     {
         g_hash_table_remove(currency_hash, currency);
+        delete series;
 
         if (cleanup)
         {
@@ -1213,6 +1449,17 @@ remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup)
     return TRUE;
 }
 
+/* Invoke the backend to delete a price that has been taken out of the
+ * pricedb. */
+static void
+price_destroy_removed (GNCPrice *p)
+{
+    gnc_price_begin_edit (p);
+    qof_instance_set_destroying(p, TRUE);
+    gnc_price_commit_edit (p);
+    p->db = nullptr;
+}
+
 gboolean
 gnc_pricedb_remove_price(GNCPriceDB *db, GNCPrice *p)
 {
@@ -1235,16 +1482,290 @@ gnc_pricedb_remove_price(GNCPriceDB *db, GNCPrice *p)
     qof_instance_set_dirty(&db->inst);
     gnc_pricedb_commit_edit(db);
 
-    /* invoke the backend to delete this price */
-    gnc_price_begin_edit (p);
-    qof_instance_set_destroying(p, TRUE);
-    gnc_price_commit_edit (p);
-    p->db = nullptr;
+    price_destroy_removed (p);
     gnc_price_unref(p);
     LEAVE ("db=%p, pr=%p", db, p);
     return rc;
 }
 
+/* ==================================================================== */
+/* Adding a batch of prices
+
+   The new prices are sorted once by series, then newest day first and,
+   within a day, by precedence, so that the price that survives on each day
+   comes first.  Each series is then gone through once to find the prices
+   the new ones replace and once more to merge them in, instead of looking
+   up and inserting every price on its own.
+ */
+
+struct PriceBatchEntry
+{
+    GNCPrice *price;
+    time64 day;
+    size_t order;
+};
+
+static bool
+price_batch_entry_less (const PriceBatchEntry& a, const PriceBatchEntry& b)
+{
+    std::less<const gnc_commodity*> commodity_less;
+
+    if (a.price->commodity != b.price->commodity)
+        return commodity_less (a.price->commodity, b.price->commodity);
+    if (a.price->currency != b.price->currency)
+        return commodity_less (a.price->currency, b.price->currency);
+    if (a.day != b.day)
+        return a.day > b.day;
+    if (a.price->source != b.price->source)
+        return a.price->source < b.price->source;
+    /* Adding them one by one, the last of equal precedence would win. */
+    return a.order > b.order;
+}
+
+static bool
+price_batch_same_series (const PriceBatchEntry& a, const PriceBatchEntry& b)
+{
+    return a.price->commodity == b.price->commodity &&
+        a.price->currency == b.price->currency;
+}
+
+/* The price in [first, last) nearest in time to t, if it's nearer than
+ * nearest. */
+static GNCPrice*
+price_range_nearest (PriceVec::const_iterator first,
+                     PriceVec::const_iterator last, time64 t,
+                     GNCPrice *nearest)
+{
+    for (; first != last; ++first)
+        if (!nearest || llabs ((*first)->tmspec - t) < llabs (nearest->tmspec - t))
+            nearest = *first;
+    return nearest;
+}
+
+/* Like gnc_pricedb_remove_price for each of the prices, which have to be
+ * sorted by address, but marking the pricedb dirty is left to the caller.
+ * Each series loses its replaced prices in one compaction pass instead of an
+ * erase apiece.  The QOF_EVENT_REMOVEs go out just before it, with the series
+ * still whole, oldest price first so that a handler finding a price by its
+ * place in the series isn't thrown by the ones already announced. */
+static void
+pricedb_remove_replaced (GNCPriceDB *db, const PriceVec& replaced)
+{
+    using SeriesKey = std::pair<gnc_commodity*, gnc_commodity*>;
+    std::vector<SeriesKey> keys;
+
+    if (replaced.empty())
+        return;
+
+    keys.reserve (replaced.size());
+    for (auto p : replaced)
+    {
+        gnc_price_ref (p);
+        keys.emplace_back (p->commodity, p->currency);
+    }
+    std::sort (keys.begin(), keys.end());
+    keys.erase (std::unique (keys.begin(), keys.end()), keys.end());
+
+    auto is_replaced = [&replaced](GNCPrice *p)
+    {
+        return std::binary_search (replaced.begin(), replaced.end(), p,
+                                   std::less<GNCPrice*>());
+    };
+    for (const auto& [commodity, currency] : keys)
+    {
+        auto series = price_series_lookup (db, commodity, currency);
+        if (!series)
+            continue;
+
+        for (auto it = series->rbegin(); it != series->rend(); ++it)
+            if (is_replaced (*it))
+                qof_event_gen (&(*it)->inst, QOF_EVENT_REMOVE, nullptr);
+
+        auto kept = series->begin();
+        for (auto it = series->begin(); it != series->end(); ++it)
+        {
+            if (is_replaced (*it))
+                gnc_price_unref (*it);
+            else
+                *kept++ = *it;
+        }
+        series->erase (kept, series->end());
+
+        if (series->empty())
+        {
+            auto currency_hash = static_cast<GHashTable*>(g_hash_table_lookup(db->commodity_hash, commodity));
+            g_hash_table_remove (currency_hash, currency);
+            delete series;
+            if (g_hash_table_size (currency_hash) == 0)
+            {
+                g_hash_table_remove (db->commodity_hash, commodity);
+                g_hash_table_destroy (currency_hash);
+            }
+        }
+    }
+    price_conversion_cache_clear (db);
+
+    for (auto p : replaced)
+    {
+        price_destroy_removed (p);
+        gnc_price_unref (p);
+    }
+}
+
+/* Merge new prices, newest first, into a series in one pass. */
+static void
+price_series_merge_new (PriceVec& series, PriceVec::const_iterator first,
+                        PriceVec::const_iterator last)
+{
+    PriceVec merged;
+    merged.reserve (series.size() + (last - first));
+    std::merge (series.begin(), series.end(), first, last,
+                std::back_inserter (merged), price_is_newer);
+    series.swap (merged);
+}
+
+guint
+gnc_pricedb_add_prices (GNCPriceDB *db, GNCPrice **prices, size_t num_prices)
+{
+    std::vector<PriceBatchEntry> entries;
+    PriceVec added;
+    PriceVec replaced;
+
+    if (!db || !prices || !db->commodity_hash) return 0;
+    ENTER ("db=%p, num_prices=%zu", db, num_prices);
+
+    entries.reserve (num_prices);
+    for (size_t i = 0; i < num_prices; ++i)
+    {
+        auto p = prices[i];
+        if (!p)
+            continue;
+        if (!qof_instance_books_equal (db, p))
+        {
+            PERR ("attempted to mix up prices across different books");
+            continue;
+        }
+        if (!p->commodity || !p->currency)
+        {
+            PWARN ("no commodity or no currency");
+            continue;
+        }
+        if (p->db == db)
+        {
+            PWARN ("price %p is already in the pricedb", p);
+            continue;
+        }
+        entries.push_back ({p, time64CanonicalDayTime (p->tmspec), i});
+    }
+
+    if (db->bulk_update)
+    {
+        /* Like add_price, take the prices as they are; they're sorted
+         * before they're next looked at. */
+        for (auto& entry : entries)
+        {
+            auto p = entry.price;
+            price_series_insert (db, *price_series_get (db, p->commodity,
+                                                        p->currency), p);
+            p->db = db;
+            added.push_back (p);
+        }
+    }
+    else
+    {
+        std::sort (entries.begin(), entries.end(), price_batch_entry_less);
+
+        /* Pick the new prices and the ones they replace, leaving the
+         * pricedb as it is for now. */
+        for (auto group = entries.begin(); group != entries.end();)
+        {
+            auto group_end = std::find_if_not (group, entries.end(),
+                                               [group](const PriceBatchEntry& e)
+                                               { return price_batch_same_series (*group, e); });
+            auto series = price_series_lookup (db, group->price->commodity,
+                                               group->price->currency);
+            auto reverse = price_series_lookup (db, group->price->currency,
+                                                group->price->commodity);
+            PriceVec::const_iterator cursor;
+            if (series)
+                cursor = series->cbegin();
+
+            for (auto entry = group; entry != group_end; ++entry)
+            {
+                /* Lost to a better price on the same day. */
+                if (entry != group && entry->day == (entry - 1)->day)
+                    continue;
+
+                auto p = entry->price;
+                auto day_start = gnc_time64_get_day_start (p->tmspec);
+                auto day_end = gnc_time64_get_day_end (p->tmspec);
+                GNCPrice *old_price = nullptr;
+
+                if (series)
+                {
+                    while (cursor != series->cend() && (*cursor)->tmspec > day_end)
+                        ++cursor;
+                    auto day_first = cursor;
+                    while (cursor != series->cend() && (*cursor)->tmspec >= day_start)
+                        ++cursor;
+                    old_price = price_range_nearest (day_first, cursor,
+                                                     p->tmspec, nullptr);
+                }
+                if (reverse)
+                    old_price = price_range_nearest (price_series_at_or_before (*reverse, day_end),
+                                                     price_series_before (*reverse, day_start),
+                                                     p->tmspec, old_price);
+
+                if (old_price && p->source > old_price->source)
+                    continue;
+                if (old_price)
+                    replaced.push_back (old_price);
+                added.push_back (p);
+            }
+            group = group_end;
+        }
+
+        std::sort (replaced.begin(), replaced.end(), std::less<GNCPrice*>());
+        replaced.erase (std::unique (replaced.begin(), replaced.end()),
+                        replaced.end());
+        pricedb_remove_replaced (db, replaced);
+
+        for (auto first = added.cbegin(); first != added.cend();)
+        {
+            auto commodity = (*first)->commodity;
+            auto currency = (*first)->currency;
+            auto last = std::find_if (first, added.cend(),
+                                      [commodity, currency](const GNCPrice *p)
+                                      { return p->commodity != commodity ||
+                                              p->currency != currency; });
+            for (auto it = first; it != last; ++it)
+            {
+                gnc_price_ref (*it);
+                (*it)->db = db;
+            }
+            price_series_merge_new (*price_series_get (db, commodity, currency),
+                                    first, last);
+            first = last;
+        }
+    }
+
+    if (!added.empty())
+    {
+        price_conversion_cache_clear (db);
+        gnc_pricedb_begin_edit(db);
+        qof_instance_set_dirty(&db->inst);
+        gnc_pricedb_commit_edit(db);
+
+        auto added_list = price_series_to_list (added);
+        qof_event_gen (&db->inst, QOF_EVENT_ADD, added_list);
+        g_list_free (added_list);
+    }
+
+    LEAVE ("db=%p, added %zu of %zu, replaced %zu", db, added.size(),
+           num_prices, replaced.size());
+    return added.size();
+}
+
 typedef struct
 {
     GNCPriceDB *db;
@@ -1300,14 +1821,14 @@ pricedb_remove_foreach_pricelist (gpointer key,
                                   gpointer val,
                                   gpointer user_data)
 {
-    GList *price_list = (GList *) val;
-    GList *node = price_list;
+    auto series = static_cast<PriceVec*>(val);
     remove_info *data = (remove_info *) user_data;
 
     ENTER("key %p, value %p, data %p", key, val, user_data);
 
-    /* now check each item in the list */
-    g_list_foreach(node, (GFunc)check_one_price_date, data);
+    /* now check each item in the series */
+    for (auto price : *series)
+        check_one_price_date (price, data);
 
     LEAVE(" ");
 }
@@ -1574,6 +2095,7 @@ gnc_pricedb_remove_old_prices (GNCPriceDB *db, GList *comm_list,
         data.delete_user = TRUE;
 
     // Walk the list of commodities
+    pricedb_sort_series (db);
     for (node = g_list_first (comm_list); node; node = g_list_next (node))
     {
         auto currencies_hash = static_cast<GHashTable*>(g_hash_table_lookup (db->commodity_hash, node->data));
@@ -1612,142 +2134,116 @@ gnc_pricedb_remove_old_prices (GNCPriceDB *db, GList *comm_list,
 /* ==================================================================== */
 /* lookup/query functions */
 
-static PriceList *pricedb_price_list_merge (PriceList *a, PriceList *b);
+/* The series priced in the other commodity both ways round, either of
+ * which may be null. */
+struct PriceSeriesPair
+{
+    const PriceVec *forward;
+    const PriceVec *reverse;
+};
 
-static void
-hash_values_helper(gpointer key, gpointer value, gpointer data)
+static PriceSeriesPair
+price_series_bidi (GNCPriceDB *db, const gnc_commodity *commodity,
+                   const gnc_commodity *currency)
 {
-    auto l = static_cast<GList**>(data);
-    if (*l)
-    {
-        GList *new_l;
-        new_l = pricedb_price_list_merge(*l, static_cast<PriceList*>(value));
-        g_list_free (*l);
-        *l = new_l;
-    }
-    else
-        *l = g_list_copy (static_cast<GList*>(value));
+    return {price_series_lookup (db, commodity, currency),
+            price_series_lookup (db, currency, commodity)};
 }
 
-static PriceList *
-price_list_from_hashtable (GHashTable *hash, const gnc_commodity *currency)
+/* The newer of two prices either of which may be null. */
+static GNCPrice*
+newer_price (GNCPrice *a, GNCPrice *b)
 {
-    GList *price_list = nullptr, *result = nullptr ;
-    if (currency)
-    {
-        price_list = static_cast<GList*>(g_hash_table_lookup(hash, currency));
-        if (!price_list)
-        {
-            LEAVE (" no price list");
-            return nullptr;
-        }
-        result = g_list_copy (price_list);
-    }
-    else
-    {
-        g_hash_table_foreach(hash, hash_values_helper, (gpointer)&result);
-    }
-    return result;
+    if (!a) return b;
+    if (!b) return a;
+    return price_is_newer (a, b) ? a : b;
 }
 
-static PriceList *
-pricedb_price_list_merge (PriceList *a, PriceList *b)
+/* The older of two prices either of which may be null. */
+static GNCPrice*
+older_price (GNCPrice *a, GNCPrice *b)
 {
-    PriceList *merged_list = nullptr;
-    GList *next_a = a;
-    GList *next_b = b;
+    if (!a) return b;
+    if (!b) return a;
+    return price_is_newer (a, b) ? b : a;
+}
 
-    while (next_a || next_b)
-    {
-        if (next_a == nullptr)
-        {
-            merged_list = g_list_prepend (merged_list, next_b->data);
-            next_b = next_b->next;
-        }
-        else if (next_b == nullptr)
-        {
-            merged_list = g_list_prepend (merged_list, next_a->data);
-            next_a = next_a->next;
-        }
-        /* We're building the list in reverse order so reverse the comparison. */
-        else if (compare_prices_by_date (next_a->data, next_b->data) < 0)
-        {
-            merged_list = g_list_prepend (merged_list, next_a->data);
-            next_a = next_a->next;
-        }
-        else
-        {
-            merged_list = g_list_prepend (merged_list, next_b->data);
-            next_b = next_b->next;
-        }
-    }
-    return g_list_reverse (merged_list);
+/* Append the series' prices to merged, keeping it sorted. */
+static void
+price_series_merge (PriceVec& merged, const PriceVec& series)
+{
+    auto middle = merged.size();
+    merged.insert (merged.end(), series.begin(), series.end());
+    std::inplace_merge (merged.begin(), merged.begin() + middle, merged.end(),
+                        price_is_newer);
+}
+
+static void
+price_series_merge_helper (gpointer key, gpointer value, gpointer data)
+{
+    price_series_merge (*static_cast<PriceVec*>(data),
+                        *static_cast<PriceVec*>(value));
 }
 
 static PriceList*
 pricedb_get_prices_internal(GNCPriceDB *db, const gnc_commodity *commodity,
                             const gnc_commodity *currency, gboolean bidi)
 {
-    GHashTable *forward_hash = nullptr, *reverse_hash = nullptr;
-    PriceList *forward_list = nullptr, *reverse_list = nullptr;
+    PriceVec merged;
     g_return_val_if_fail (db != nullptr, nullptr);
     g_return_val_if_fail (commodity != nullptr, nullptr);
-    forward_hash = static_cast<GHashTable*>(g_hash_table_lookup(db->commodity_hash, commodity));
-    if (currency && bidi)
-        reverse_hash = static_cast<GHashTable*>(g_hash_table_lookup(db->commodity_hash, currency));
-    if (!forward_hash && !reverse_hash)
-    {
-        LEAVE (" no currency hash");
-        return nullptr;
-    }
-    if (forward_hash)
-        forward_list = price_list_from_hashtable (forward_hash, currency);
-    if (currency && reverse_hash)
+
+    if (currency)
     {
-        reverse_list = price_list_from_hashtable (reverse_hash, commodity);
-        if (reverse_list)
+        auto series = price_series_bidi (db, commodity, currency);
+        if (!bidi)
+            series.reverse = nullptr;
+        if (!series.forward && !series.reverse)
         {
-            if (forward_list)
-            {
-                /* Since we have a currency both lists are a direct copy of a price
-                   list in the price DB.  This means the lists are already sorted
-                   from newest to oldest and we can just merge them together.  This
-                   is substantially faster than concatenating them and sorting the
-                   resulting list. */
-                PriceList *merged_list;
-                merged_list = pricedb_price_list_merge (forward_list, reverse_list);
-                g_list_free (forward_list);
-                g_list_free (reverse_list);
-                forward_list = merged_list;
-            }
-            else
-            {
-                forward_list = reverse_list;
-            }
+            LEAVE (" no price list");
+            return nullptr;
         }
+        /* With a currency there's no merging to do unless both directions
+           have prices. */
+        if (!series.reverse)
+            return price_series_to_list (*series.forward);
+        if (!series.forward)
+            return price_series_to_list (*series.reverse);
+        merged.reserve (series.forward->size() + series.reverse->size());
+        price_series_merge (merged, *series.forward);
+        price_series_merge (merged, *series.reverse);
+        return price_series_to_list (merged);
+    }
+
+    pricedb_sort_series (db);
+    auto currency_hash = static_cast<GHashTable*>(g_hash_table_lookup(db->commodity_hash, commodity));
+    if (!currency_hash)
+    {
+        LEAVE (" no currency hash");
+        return nullptr;
     }
-
-    return forward_list;
+    g_hash_table_foreach (currency_hash, price_series_merge_helper, &merged);
+    return price_series_to_list (merged);
 }
 
 GNCPrice *gnc_pricedb_lookup_latest(GNCPriceDB *db,
                           const gnc_commodity *commodity,
                           const gnc_commodity *currency)
 {
-    GList *price_list;
-    GNCPrice *result;
+    GNCPrice *result = nullptr;
 
     if (!db || !commodity || !currency) return nullptr;
     ENTER ("db=%p commodity=%p currency=%p", db, commodity, currency);
 
-    price_list = pricedb_get_prices_internal(db, commodity, currency, TRUE);
-    if (!price_list) return nullptr;
-    /* This works magically because prices are inserted in date-sorted
-     * order, and the latest date always comes first. So return the
-     * first in the list.  */
-    result = static_cast<GNCPrice*>(price_list->data);
+    /* The latest date always comes first in a price series. */
+    auto series = price_series_bidi (db, commodity, currency);
+    if (series.forward && !series.forward->empty())
+        result = series.forward->front();
+    if (series.reverse && !series.reverse->empty())
+        result = newer_price (result, series.reverse->front());
+    if (!result) return nullptr;
+
     gnc_price_ref(result);
-    g_list_free (price_list);
     LEAVE("price is %p", result);
     return result;
 }
@@ -1759,66 +2255,78 @@ typedef struct
     time64 t;
 } UsesCommodity;
 
-/* price_list_scan_any_currency is the helper function used with
- * pricedb_pricelist_traversal by the "any_currency" price lookup functions. It
- * builds a list of prices that are either to or from the commodity "com".
- * The resulting list will include the last price newer than "t" and the first
- * price older than "t".  All other prices will be ignored.  Since in the most
- * common cases we will be looking for recent prices which are at the front of
- * the various price lists, this is considerably faster than concatenating all
- * the relevant price lists and sorting the result.
+/* price_series_scan_any_currency is the helper used by the "any_currency"
+ * price lookup functions. It adds to the list the last price in the series
+ * newer than "t" and the first price older than "t".  All other prices will
+ * be ignored.  Since the series are sorted by time this is a binary search,
+ * which is considerably faster than concatenating all the relevant series
+ * and sorting the result.
 */
 
-static gboolean
-price_list_scan_any_currency(GList *price_list, gpointer data)
+static void
+price_series_scan_any_currency (const PriceVec& series, UsesCommodity *helper)
 {
-    UsesCommodity *helper = (UsesCommodity*)data;
-    gnc_commodity *com;
-    gnc_commodity *cur;
-
-    if (!price_list)
-        return TRUE;
-
-    auto price = static_cast<GNCPrice*>(price_list->data);
-    com = gnc_price_get_commodity(price);
-    cur = gnc_price_get_currency(price);
+    if (series.empty())
+        return;
 
-    /* if this price list isn't for the commodity we are interested in,
-       ignore it. */
-    if (com != helper->com && cur != helper->com)
-        return TRUE;
+    auto older = price_series_before (series, helper->t);
+    if (older == series.end())
+    {
+        /* The last price is later than given time, add it */
+        gnc_price_ref(series.back());
+        *helper->list = g_list_prepend(*helper->list, series.back());
+        return;
+    }
 
-    /* The price list is sorted in decreasing order of time.  Find the first
-       price on it that is older than the requested time and add it and the
-       previous price to the result list. */
-    for (auto node = price_list; node; node = g_list_next (node))
+    /* If there is a previous price add it to the results. */
+    if (older != series.begin())
     {
-        price = static_cast<GNCPrice*>(node->data);
-        time64 price_t = gnc_price_get_time64(price);
-        if (price_t < helper->t)
-        {
-            /* If there is a previous price add it to the results. */
-            if (node->prev)
-            {
-                auto prev_price = static_cast<GNCPrice*>(node->prev->data);
-                gnc_price_ref(prev_price);
-                *helper->list = g_list_prepend(*helper->list, prev_price);
-            }
-            /* Add the first price before the desired time */
-            gnc_price_ref(price);
-            *helper->list = g_list_prepend(*helper->list, price);
-            /* No point in looking further, they will all be older */
-            break;
-        }
-        else if (node->next == nullptr)
-        {
-            /* The last price is later than given time, add it */
-            gnc_price_ref(price);
-            *helper->list = g_list_prepend(*helper->list, price);
-        }
+        auto prev_price = *(older - 1);
+        gnc_price_ref(prev_price);
+        *helper->list = g_list_prepend(*helper->list, prev_price);
     }
+    /* Add the first price before the desired time */
+    gnc_price_ref(*older);
+    *helper->list = g_list_prepend(*helper->list, *older);
+}
 
-    return TRUE;
+/* The series of prices of helper->com. */
+static void
+forward_scan_helper (gpointer key, gpointer value, gpointer data)
+{
+    price_series_scan_any_currency (*static_cast<PriceVec*>(value),
+                                    static_cast<UsesCommodity*>(data));
+}
+
+/* The series of prices in helper->com of the commodity key. */
+static void
+reverse_scan_helper (gpointer key, gpointer value, gpointer data)
+{
+    auto helper = static_cast<UsesCommodity*>(data);
+    auto currency_hash = static_cast<GHashTable*>(value);
+
+    if (key == helper->com)
+        return;
+
+    auto series = static_cast<PriceVec*>(g_hash_table_lookup(currency_hash, helper->com));
+    if (series)
+        price_series_scan_any_currency (*series, helper);
+}
+
+/* The prices either to or from com around t, newest first. */
+static PriceList*
+pricedb_scan_any_currency (GNCPriceDB *db, const gnc_commodity *com, time64 t)
+{
+    GList *prices = nullptr;
+    UsesCommodity helper = {&prices, com, t};
+
+    pricedb_sort_series (db);
+    auto currency_hash = static_cast<GHashTable*>(g_hash_table_lookup(db->commodity_hash, com));
+    if (currency_hash)
+        g_hash_table_foreach (currency_hash, forward_scan_helper, &helper);
+    g_hash_table_foreach (db->commodity_hash, reverse_scan_helper, &helper);
+
+    return g_list_sort(prices, compare_prices_by_date);
 }
 
 /* This operates on the principal that the prices are sorted by date and that we
@@ -1967,14 +2475,12 @@ gnc_pricedb_lookup_nearest_in_time_any_currency_t64(GNCPriceDB *db,
                                                     time64 t)
 {
     GList *prices = nullptr, *result;
-    UsesCommodity helper = {&prices, commodity, t};
     result = nullptr;
 
     if (!db || !commodity) return nullptr;
     ENTER ("db=%p commodity=%p", db, commodity);
 
-    pricedb_pricelist_traversal(db, price_list_scan_any_currency, &helper);
-    prices = g_list_sort(prices, compare_prices_by_date);
+    prices = pricedb_scan_any_currency (db, commodity, t);
     result = nearest_to(prices, commodity, t);
     gnc_price_list_destroy(prices);
     LEAVE(" ");
@@ -1987,15 +2493,12 @@ gnc_pricedb_lookup_nearest_before_any_currency_t64(GNCPriceDB *db,
                                                    time64 t)
 {
     GList *prices = nullptr, *result;
-    UsesCommodity helper = {&prices, commodity, t};
     result = nullptr;
 
     if (!db || !commodity) return nullptr;
     ENTER ("db=%p commodity=%p", db, commodity);
 
-    pricedb_pricelist_traversal(db, price_list_scan_any_currency,
-                                       &helper);
-    prices = g_list_sort(prices, compare_prices_by_date);
+    prices = pricedb_scan_any_currency (db, commodity, t);
     result = latest_before(prices, commodity, t);
     gnc_price_list_destroy(prices);
     LEAVE(" ");
@@ -2011,7 +2514,6 @@ gnc_pricedb_has_prices(GNCPriceDB *db,
                        const gnc_commodity *commodity,
                        const gnc_commodity *currency)
 {
-    GList *price_list;
     GHashTable *currency_hash;
     gint size;
 
@@ -2026,8 +2528,7 @@ gnc_pricedb_has_prices(GNCPriceDB *db,
 
     if (currency)
     {
-        price_list = static_cast<GList*>(g_hash_table_lookup(currency_hash, currency));
-        if (price_list)
+        if (g_hash_table_lookup(currency_hash, currency))
         {
             LEAVE("yes");
             return TRUE;
@@ -2065,9 +2566,9 @@ static void
 price_count_helper(gpointer key, gpointer value, gpointer data)
 {
     auto result = static_cast<int*>(data);
-    auto price_list = static_cast<GList*>(value);
+    auto series = static_cast<PriceVec*>(value);
 
-    *result += g_list_length(price_list);
+    *result += series->size();
 }
 
 int
@@ -2090,83 +2591,80 @@ gnc_pricedb_num_prices(GNCPriceDB *db,
     return result;
 }
 
-/* Helper function for combining the price lists in gnc_pricedb_nth_price. */
-static void
-list_combine (gpointer element, gpointer data)
-{
-    GList *list = *(GList**)data;
-    auto lst = static_cast<GList*>(element);
-    if (list == nullptr)
-        *(GList**)data = g_list_copy (lst);
-    else
-    {
-        GList *new_list = g_list_concat (list, g_list_copy (lst));
-        *(GList**)data = new_list;
-    }
-}
+/* ==================================================================== */
+/* price snapshots
 
-/* This function is used by gnc-tree-model-price.c for iterating through the
- * prices when building or filtering the pricedb dialog's
- * GtkTreeView. gtk-tree-view-price.c sorts the results after it has obtained
- * the values so there's nothing gained by sorting. However, for very large
- * collections of prices in multiple currencies (here commodity is the one being
- * priced and currency the one in which the price is denominated; note that they
- * may both be currencies or not) just concatenating the price lists together
- * can be expensive because the receiving list must be traversed to obtain its
- * end. To avoid that cost n times we cache the commodity and merged price list.
- * Since this is a GUI-driven function there is no concern about concurrency.
+   The prices of one commodity in all currencies, newest first, for going
+   through them by index.  The price tree model in gnome-utils keeps one for
+   each commodity it shows and drops it when the commodity's prices change.
  */
 
-GNCPrice *
-gnc_pricedb_nth_price (GNCPriceDB *db,
-                       const gnc_commodity *c,
-                       const int n)
+struct gnc_price_snapshot_s
 {
-    static const gnc_commodity *last_c = nullptr;
-    static GList *prices = nullptr;
+    PriceVec prices;
+};
 
-    GNCPrice *result = nullptr;
-    GHashTable *currency_hash;
+GNCPriceSnapshot *
+gnc_pricedb_snapshot_new (GNCPriceDB *db, const gnc_commodity *c)
+{
     g_return_val_if_fail (GNC_IS_COMMODITY (c), nullptr);
+    ENTER ("db=%p commodity=%s", db, gnc_commodity_get_mnemonic(c));
 
-    if (!db || !c || n < 0) return nullptr;
-    ENTER ("db=%p commodity=%s index=%d", db, gnc_commodity_get_mnemonic(c), n);
-
-    if (last_c && prices && last_c == c && db->reset_nth_price_cache == FALSE)
+    auto snapshot = new gnc_price_snapshot_s;
+    if (db && db->commodity_hash)
     {
-        result = static_cast<GNCPrice*>(g_list_nth_data (prices, n));
-        LEAVE ("price=%p", result);
-        return result;
+        pricedb_sort_series (db);
+        auto currency_hash = static_cast<GHashTable*>(g_hash_table_lookup (db->commodity_hash, c));
+        if (currency_hash)
+            g_hash_table_foreach (currency_hash, price_series_merge_helper,
+                                  &snapshot->prices);
     }
+    for (auto p : snapshot->prices)
+        gnc_price_ref (p);
 
-    last_c = c;
-
-    if (prices)
-    {
-        g_list_free (prices);
-        prices = nullptr;
-    }
+    LEAVE ("snapshot=%p length=%zu", snapshot, snapshot->prices.size());
+    return snapshot;
+}
 
-    db->reset_nth_price_cache = FALSE;
+void
+gnc_price_snapshot_free (GNCPriceSnapshot *snapshot)
+{
+    if (!snapshot) return;
+    for (auto p : snapshot->prices)
+        gnc_price_unref (p);
+    delete snapshot;
+}
 
-    currency_hash = static_cast<GHashTable*>(g_hash_table_lookup (db->commodity_hash, c));
-    if (currency_hash)
-    {
-        GList *currencies = g_hash_table_get_values (currency_hash);
-        g_list_foreach (currencies, list_combine, &prices);
-        result = static_cast<GNCPrice*>(g_list_nth_data (prices, n));
-        g_list_free (currencies);
-    }
+int
+gnc_price_snapshot_length (const GNCPriceSnapshot *snapshot)
+{
+    g_return_val_if_fail (snapshot, 0);
+    return snapshot->prices.size();
+}
 
-    LEAVE ("price=%p", result);
-    return result;
+GNCPrice *
+gnc_price_snapshot_nth (const GNCPriceSnapshot *snapshot, int n)
+{
+    g_return_val_if_fail (snapshot, nullptr);
+    if (n < 0 || static_cast<size_t>(n) >= snapshot->prices.size())
+        return nullptr;
+    return snapshot->prices[n];
 }
 
-void
-gnc_pricedb_nth_price_reset_cache (GNCPriceDB *db)
+int
+gnc_price_snapshot_index (const GNCPriceSnapshot *snapshot, const GNCPrice *p)
 {
-    if (db)
-        db->reset_nth_price_cache = TRUE;
+    g_return_val_if_fail (snapshot, -1);
+    if (!p) return -1;
+
+    auto& prices = snapshot->prices;
+    auto it = std::lower_bound (prices.begin(), prices.end(), p, price_is_newer);
+    /* p's time may have been changed since the snapshot was taken. */
+    if (it == prices.end() || *it != p)
+        it = std::find (prices.begin(), prices.end(), p);
+    if (it == prices.end())
+        return -1;
+    return it - prices.begin();
 }
 
 GNCPrice *
@@ -2185,33 +2683,39 @@ lookup_nearest_in_time(GNCPriceDB *db,
                        time64 t,
                        gboolean sameday)
 {
-    GList *price_list;
     GNCPrice *current_price = nullptr;
     GNCPrice *next_price = nullptr;
+    GNCPrice *oldest_price = nullptr;
     GNCPrice *result = nullptr;
 
     if (!db || !c || !currency) return nullptr;
     if (t == INT64_MAX) return nullptr;
     ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
-    price_list = pricedb_get_prices_internal (db, c, currency, TRUE);
-    if (!price_list) return nullptr;
-
-    /* default answer */
-    current_price = static_cast<GNCPrice*>(price_list->data);
 
-    /* find the first candidate past the one we want.  Remember that
-       prices are in most-recent-first order. */
-    for (auto item = price_list; item; item = g_list_next (item))
+    /* find the first candidate past the one we want, and the one just
+       before it, in either direction.  Remember that prices are in
+       most-recent-first order. */
+    auto series = price_series_bidi (db, c, currency);
+    for (auto prices : {series.forward, series.reverse})
     {
-        auto p = static_cast<GNCPrice*>(item->data);
-        time64 price_time = gnc_price_get_time64(p);
-        if (price_time <= t)
-        {
-            next_price = static_cast<GNCPrice*>(item->data);
-            break;
-        }
-        current_price = static_cast<GNCPrice*>(item->data);
-    }
+        if (!prices || prices->empty())
+            continue;
+        auto item = price_series_at_or_before (*prices, t);
+        if (item != prices->end())
+            next_price = newer_price (next_price, *item);
+        if (item != prices->begin())
+            current_price = older_price (current_price, *(item - 1));
+        oldest_price = older_price (oldest_price, prices->back());
+    }
+    if (!oldest_price) return nullptr;
+
+    /* If the requested time is not earlier than the first price then
+       current_price and next_price will be the same; if it's earlier than
+       the last price then current_price is the last price. */
+    if (!current_price)
+        current_price = next_price;
+    else if (!next_price)
+        current_price = oldest_price;
 
     if (current_price)      /* How can this be null??? */
     {
@@ -2283,7 +2787,6 @@ lookup_nearest_in_time(GNCPriceDB *db,
     }
 
     gnc_price_ref(result);
-    g_list_free (price_list);
     LEAVE (" ");
     return result;
 }
@@ -2297,12 +2800,6 @@ gnc_pricedb_lookup_nearest_in_time64(GNCPriceDB *db,
     return lookup_nearest_in_time(db, c, currency, t, FALSE);
 }
 
-// return 0 if price's time is less or equal to time
-static int price_time64_less_or_equal (GNCPrice *p, time64 *time)
-{
-    return !(gnc_price_get_time64 (p) <= *time);
-}
-
 GNCPrice *
 gnc_pricedb_lookup_nearest_before_t64 (GNCPriceDB *db,
                                        const gnc_commodity *c,
@@ -2312,15 +2809,17 @@ gnc_pricedb_lookup_nearest_before_t64 (GNCPriceDB *db,
     GNCPrice *current_price = nullptr;
     if (!db || !c || !currency) return nullptr;
     ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
-    auto price_list = pricedb_get_prices_internal (db, c, currency, TRUE);
-    if (!price_list) return nullptr;
-    auto p = g_list_find_custom (price_list, &t, (GCompareFunc)price_time64_less_or_equal);
-    if (p)
+    auto series = price_series_bidi (db, c, currency);
+    for (auto prices : {series.forward, series.reverse})
     {
-        current_price = GNC_PRICE (p->data);
-        gnc_price_ref (current_price);
+        if (!prices)
+            continue;
+        auto item = price_series_at_or_before (*prices, t);
+        if (item != prices->end())
+            current_price = newer_price (current_price, *item);
     }
-    g_list_free (price_list);
+    if (current_price)
+        gnc_price_ref (current_price);
     LEAVE (" ");
     return current_price;
 }
@@ -2450,6 +2949,30 @@ indirect_price_conversion (GNCPriceDB *db, const gnc_commodity *from,
 }
 
 
+static GNCPrice *
+lookup_direct_price (GNCPriceDB *db, const gnc_commodity *from,
+                     const gnc_commodity *to, time64 t, gboolean before_date)
+{
+    if (t == INT64_MAX)
+        return gnc_pricedb_lookup_latest(db, from, to);
+    if (before_date)
+        return gnc_pricedb_lookup_nearest_before_t64(db, from, to, t);
+    return gnc_pricedb_lookup_nearest_in_time64(db, from, to, t);
+}
+
+/* The value of one "from" given by a price between it and another
+ * commodity, whichever way round the price is. */
+static gnc_numeric
+price_rate_from (GNCPrice *price, const gnc_commodity *from)
+{
+    gnc_numeric retval = gnc_price_get_value (price);
+
+    if (gnc_price_get_commodity (price) != from)
+        retval = gnc_numeric_invert (retval);
+
+    return retval;
+}
+
 static gnc_numeric
 direct_price_conversion (GNCPriceDB *db, const gnc_commodity *from,
                          const gnc_commodity *to, time64 t, gboolean before_date)
@@ -2459,24 +2982,138 @@ direct_price_conversion (GNCPriceDB *db, const gnc_commodity *from,
 
     if (!from || !to) return retval;
 
-    if (t == INT64_MAX)
-        price = gnc_pricedb_lookup_latest(db, from, to);
-    else if (before_date)
-        price = gnc_pricedb_lookup_nearest_before_t64(db, from, to, t);
-    else
-        price = gnc_pricedb_lookup_nearest_in_time64(db, from, to, t);
-
+    price = lookup_direct_price (db, from, to, t, before_date);
     if (!price) return retval;
 
-    retval = gnc_price_get_value (price);
-
-    if (gnc_price_get_commodity (price) != from)
-        retval = gnc_numeric_invert (retval);
-
+    retval = price_rate_from (price, from);
     gnc_price_unref (price);
     return retval;
 }
 
+using CommodityVec = std::vector<const gnc_commodity*>;
+
+typedef struct
+{
+    const gnc_commodity *com;
+    CommodityVec *neighbours;
+} PriceNeighbours;
+
+static void
+forward_neighbour_helper (gpointer key, gpointer value, gpointer data)
+{
+    auto helper = static_cast<PriceNeighbours*>(data);
+    helper->neighbours->push_back (static_cast<const gnc_commodity*>(key));
+}
+
+static void
+reverse_neighbour_helper (gpointer key, gpointer value, gpointer data)
+{
+    auto helper = static_cast<PriceNeighbours*>(data);
+    if (key != helper->com &&
+        g_hash_table_lookup (static_cast<GHashTable*>(value), helper->com))
+        helper->neighbours->push_back (static_cast<const gnc_commodity*>(key));
+}
+
+static bool
+commodity_name_less (const gnc_commodity *a, const gnc_commodity *b)
+{
+    return g_strcmp0 (gnc_commodity_get_unique_name (a),
+                      gnc_commodity_get_unique_name (b)) < 0;
+}
+
+/* The commodities com has prices with in either direction, in a stable
+ * order so that conversions don't depend on how the hash tables are laid
+ * out. */
+static CommodityVec
+price_neighbours (GNCPriceDB *db, const gnc_commodity *com)
+{
+    CommodityVec neighbours;
+    PriceNeighbours helper = {com, &neighbours};
+
+    auto currency_hash = static_cast<GHashTable*>(g_hash_table_lookup(db->commodity_hash, com));
+    if (currency_hash)
+        g_hash_table_foreach (currency_hash, forward_neighbour_helper, &helper);
+    g_hash_table_foreach (db->commodity_hash, reverse_neighbour_helper, &helper);
+
+    std::sort (neighbours.begin(), neighbours.end(), commodity_name_less);
+    neighbours.erase (std::unique (neighbours.begin(), neighbours.end()),
+                      neighbours.end());
+    return neighbours;
+}
+
+/* A conversion through a chain of prices: the value of one of the
+ * commodity the chain starts at, and how far the price in it furthest
+ * from the requested time is from it. */
+typedef struct
+{
+    gnc_numeric rate;
+    time64 distance;
+} PriceChain;
+
+/* Look for a chain of up to max_hops prices from "from" to "to", for when
+ * there's no direct price and no commodity that both have prices with.  The
+ * search goes out from "from" one price at a time so the chain found is one
+ * of the shortest; of those it takes the one whose prices are nearest to t.
+ */
+static gnc_numeric
+chained_price_conversion (GNCPriceDB *db, const gnc_commodity *from,
+                          const gnc_commodity *to, time64 t,
+                          gboolean before_date, int max_hops)
+{
+    int no_round = GNC_HOW_DENOM_EXACT | GNC_HOW_RND_NEVER;
+    time64 target = t == INT64_MAX ? gnc_time (nullptr) : t;
+    std::unordered_map<const gnc_commodity*, PriceChain> reached;
+    CommodityVec frontier {from};
+
+    reached.emplace (from, PriceChain {gnc_numeric_create (1, 1), 0});
+    for (int hop = 1; hop <= max_hops && !frontier.empty(); ++hop)
+    {
+        std::unordered_map<const gnc_commodity*, PriceChain> next;
+
+        for (auto com : frontier)
+        {
+            const auto& chain = reached.at (com);
+            for (auto other : price_neighbours (db, com))
+            {
+                /* The last price has to reach "to". */
+                if (reached.count (other) || (hop == max_hops && other != to))
+                    continue;
+
+                auto price = lookup_direct_price (db, com, other, t, before_date);
+                if (!price)
+                    continue;
+                auto rate = gnc_numeric_mul (chain.rate, price_rate_from (price, com),
+                                             GNC_DENOM_AUTO, no_round);
+                time64 distance = llabs (gnc_price_get_time64 (price) - target);
+                distance = std::max (chain.distance, distance);
+                gnc_price_unref (price);
+                if (gnc_numeric_check (rate))
+                    continue;
+
+                auto found = next.find (other);
+                if (found == next.end())
+                    next.emplace (other, PriceChain {rate, distance});
+                else if (distance < found->second.distance)
+                    found->second = PriceChain {rate, distance};
+            }
+        }
+
+        auto found = next.find (to);
+        if (found != next.end())
+            return found->second.rate;
+
+        frontier.clear();
+        for (const auto& entry : next)
+        {
+            frontier.push_back (entry.first);
+            reached.insert (entry);
+        }
+        std::sort (frontier.begin(), frontier.end(), commodity_name_less);
+    }
+
+    return gnc_numeric_zero ();
+}
+
 static gnc_numeric
 get_nearest_price (GNCPriceDB *pdb,
                    const gnc_commodity *orig_curr,
@@ -2489,16 +3126,33 @@ get_nearest_price (GNCPriceDB *pdb,
     if (gnc_commodity_equiv (orig_curr, new_curr))
         return gnc_numeric_create (1, 1);
 
+    if (!pdb || !orig_curr || !new_curr)
+        return gnc_numeric_zero ();
+
+    auto cache = price_conversion_cache (pdb, t);
+    PriceConversionKey key {*qof_instance_get_guid (orig_curr),
+                            *qof_instance_get_guid (new_curr), t, before};
+    auto cached = cache->rates.find (key);
+    if (cached != cache->rates.end())
+        return cached->second;
+
     /* Look for a direct price. */
     price = direct_price_conversion (pdb, orig_curr, new_curr, t, before);
 
     /*
      * no direct price found, try find a price in another currency
      */
-    if (gnc_numeric_zero_p (price))
+    if (gnc_numeric_zero_p (price) && pdb->max_conversion_hops > 1)
         price = indirect_price_conversion (pdb, orig_curr, new_curr, t, before);
 
-    return gnc_numeric_reduce (price);
+    /* nor through a single other currency, try longer chains of prices */
+    if (gnc_numeric_zero_p (price) && pdb->max_conversion_hops > 2)
+        price = chained_price_conversion (pdb, orig_curr, new_curr, t, before,
+                                          pdb->max_conversion_hops);
+
+    price = gnc_numeric_reduce (price);
+    cache->rates.emplace (key, price);
+    return price;
 }
 
 gnc_numeric
@@ -2600,12 +3254,14 @@ typedef struct
 static void
 pricedb_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
-    GList *price_list = (GList *) val;
+    auto series = static_cast<PriceVec*>(val);
     GNCPriceDBForeachData *foreach_data = (GNCPriceDBForeachData *) user_data;
 
     /* stop traversal when func returns FALSE */
-    foreach_data->ok = g_list_find_custom (price_list, foreach_data->user_data, (GCompareFunc)foreach_data->func)
-        != nullptr;
+    foreach_data->ok = std::find_if (series->begin(), series->end(),
+                                     [foreach_data](GNCPrice *p)
+                                     { return !foreach_data->func (p, foreach_data->user_data); })
+        != series->end();
 }
 
 static void
@@ -2630,6 +3286,7 @@ unstable_price_traversal(GNCPriceDB *db,
     {
         return FALSE;
     }
+    pricedb_sort_series (db);
     g_hash_table_foreach(db->commodity_hash,
                          pricedb_foreach_currencies_hash,
                          &foreach_data);
@@ -2637,54 +3294,6 @@ unstable_price_traversal(GNCPriceDB *db,
     return foreach_data.ok;
 }
 
-/* foreach_pricelist */
-typedef struct
-{
-    gboolean ok;
-    gboolean (*func)(GList *p, gpointer user_data);
-    gpointer user_data;
-} GNCPriceListForeachData;
-
-static void
-pricedb_pricelist_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
-{
-    GList *price_list = (GList *) val;
-    GNCPriceListForeachData *foreach_data = (GNCPriceListForeachData *) user_data;
-    if (foreach_data->ok)
-    {
-        foreach_data->ok = foreach_data->func(price_list, foreach_data->user_data);
-    }
-}
-
-static void
-pricedb_pricelist_foreach_currencies_hash(gpointer key, gpointer val, gpointer user_data)
-{
-    GHashTable *currencies_hash = (GHashTable *) val;
-    g_hash_table_foreach(currencies_hash, pricedb_pricelist_foreach_pricelist, user_data);
-}
-
-static gboolean
-pricedb_pricelist_traversal(GNCPriceDB *db,
-                         gboolean (*f)(GList *p, gpointer user_data),
-                         gpointer user_data)
-{
-    GNCPriceListForeachData foreach_data;
-
-    if (!db || !f) return FALSE;
-    foreach_data.ok = TRUE;
-    foreach_data.func = f;
-    foreach_data.user_data = user_data;
-    if (db->commodity_hash == nullptr)
-    {
-        return FALSE;
-    }
-    g_hash_table_foreach(db->commodity_hash,
-                         pricedb_pricelist_foreach_currencies_hash,
-                         &foreach_data);
-
-    return foreach_data.ok;
-}
-
 static bool
 compare_hash_entries_by_commodity_key (const CommodityPtrPair& he_a, const CommodityPtrPair& he_b)
 {
@@ -2712,6 +3321,7 @@ stable_price_traversal(GNCPriceDB *db,
 {
     g_return_val_if_fail (db && f, false);
 
+    pricedb_sort_series (db);
     auto currency_hashes = hash_table_to_vector (db->commodity_hash);
     std::sort (currency_hashes.begin(), currency_hashes.end(), compare_hash_entries_by_commodity_key);
 
@@ -2721,8 +3331,13 @@ stable_price_traversal(GNCPriceDB *db,
         std::sort (price_lists.begin(), price_lists.end(), compare_hash_entries_by_commodity_key);
 
         for (const auto& pricelist_entry : price_lists)
-            if (g_list_find_custom (static_cast<GList*>(pricelist_entry.second), user_data, (GCompareFunc)f))
+        {
+            auto series = static_cast<PriceVec*>(pricelist_entry.second);
+            if (std::find_if (series->begin(), series->end(),
+                              [f, user_data](GNCPrice *p){ return !f (p, user_data); })
+                != series->end())
                 return false;
+        }
     }
 
     return true;
@@ -2864,10 +3479,11 @@ VoidGNCPriceDBForeachData;
 static void
 void_pricedb_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
-    GList *price_list = (GList *) val;
+    auto series = static_cast<PriceVec*>(val);
     VoidGNCPriceDBForeachData *foreach_data = (VoidGNCPriceDBForeachData *) user_data;
 
-    g_list_foreach (price_list, (GFunc)foreach_data->func, foreach_data->user_data);
+    for (auto price : *series)
+        foreach_data->func (price, foreach_data->user_data);
 }
 
 static void
@@ -2888,6 +3504,7 @@ void_unstable_price_traversal(GNCPriceDB *db,
     foreach_data.func = f;
     foreach_data.user_data = user_data;
 
+    pricedb_sort_series (db);
     g_hash_table_foreach(db->commodity_hash,
                          void_pricedb_foreach_currencies_hash,
                          &foreach_data);
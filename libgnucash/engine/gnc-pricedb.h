@@ -356,12 +356,30 @@ void gnc_pricedb_commit_edit (GNCPriceDB *);
 
 /** @brief Set flag to indicate whether duplication checks should be performed.
  *
- * Normally used at load time to speed up loading the pricedb.
+ * Normally used at load time to speed up loading the pricedb. Prices added
+ * during a bulk update are only sorted by date when it's turned off, so
+ * don't look prices up in the meantime.
  * @param db The pricedb
  * @param bulk_update TRUE to disable duplication checks, FALSE to enable them.
  */
 void gnc_pricedb_set_bulk_update(GNCPriceDB *db, gboolean bulk_update);
 
+/** @brief Set the longest chain of prices used to convert between two
+ * commodities that have no price between them.
+ *
+ * A direct price is a chain of one. The default of 2 allows a conversion
+ * through one other commodity that both have prices with.
+ * @param db The pricedb
+ * @param max_hops The number of prices a conversion may chain, at least 1.
+ */
+void gnc_pricedb_set_max_conversion_hops (GNCPriceDB *db, int max_hops);
+
+/** @brief Get the longest chain of prices used for a conversion.
+ * @param db The pricedb
+ * @return The number of prices a conversion may chain.
+ */
+int gnc_pricedb_get_max_conversion_hops (GNCPriceDB *db);
+
 /** @brief Add a price to the pricedb.
  *
  * You may drop your reference to the price (i.e. call unref) after this
@@ -372,6 +390,30 @@ void gnc_pricedb_set_bulk_update(GNCPriceDB *db, gboolean bulk_update);
  */
 gboolean     gnc_pricedb_add_price(GNCPriceDB *db, GNCPrice *p);
 
+/** @brief Add many prices to the pricedb at once.
+ *
+ * The result is the same as adding the prices one at a time with
+ * gnc_pricedb_add_price(), with one exception: when several of the new
+ * prices of a commodity and currency fall on the same day, the one with the
+ * best source is kept, the last one given if there's a tie, and the others
+ * are not added.  The prices are sorted once and merged into the pricedb in
+ * a single pass instead of being looked up and inserted one by one.
+ *
+ * Instead of a QOF_EVENT_ADD for each price, a single QOF_EVENT_ADD is sent
+ * for the pricedb with a PriceList of the prices that were added as event
+ * data.  Prices that the new ones replace still get their own
+ * QOF_EVENT_REMOVE.
+ *
+ * The pricedb takes its own reference to each price it adds; you must drop
+ * yours whether or not it was added.
+ * @param db The pricedb
+ * @param prices The prices to add.
+ * @param num_prices The number of prices.
+ * @return The number of prices added.
+ */
+guint        gnc_pricedb_add_prices(GNCPriceDB *db, GNCPrice **prices,
+                                    size_t num_prices);
+
 /** @brief Remove a price from the pricedb and unref the price.
  * @param db The Pricedb
  * @param p The price to remove.
@@ -661,19 +703,51 @@ int
 gnc_pricedb_num_prices(GNCPriceDB *db,
                        const gnc_commodity *c);
 
-/** @brief Get the nth price for the given commodity in  reverse date order
+/** @brief A snapshot of the prices of a commodity that can be indexed.
+ *
+ * It holds the commodity's prices at the time it was made, in all
+ * currencies and in reverse chronological order, and a reference to each of
+ * them.  It doesn't follow later changes to the pricedb: whoever owns it
+ * should watch for price events and make a new one when they need to.
+ */
+typedef struct gnc_price_snapshot_s GNCPriceSnapshot;
+
+/** @brief Take a snapshot of the prices of a commodity.
  * @param db The pricedb
- * @param c The commodity whose nth price is needed
+ * @param c The commodity
+ * @return A new snapshot, to be freed with gnc_price_snapshot_free().
+ */
+GNCPriceSnapshot *gnc_pricedb_snapshot_new (GNCPriceDB *db,
+                                            const gnc_commodity *c);
+
+/** @brief Free a snapshot and drop its references to the prices.
+ * @param snapshot The snapshot
+ */
+void gnc_price_snapshot_free (GNCPriceSnapshot *snapshot);
+
+/** @brief Get the number of prices in a snapshot.
+ * @param snapshot The snapshot
+ * @return The number of prices
+ */
+int gnc_price_snapshot_length (const GNCPriceSnapshot *snapshot);
+
+/** @brief Get the nth price of a snapshot.
+ * @param snapshot The snapshot
  * @param n Zero based index of the price wanted
- * @return The nth price for this commodity in reverse chronological order, without
- * regard for what currency the price is in
+ * @return The nth price in reverse chronological order, without regard for
+ * what currency the price is in, or NULL if there are fewer prices.  The
+ * price isn't reffed.
  */
-GNCPrice *
-gnc_pricedb_nth_price (GNCPriceDB *db,
-                       const gnc_commodity *c,
-                       const int n);
+GNCPrice *gnc_price_snapshot_nth (const GNCPriceSnapshot *snapshot, int n);
 
-void gnc_pricedb_nth_price_reset_cache (GNCPriceDB *db);
+/** @brief Find a price in a snapshot.
+ * @param snapshot The snapshot
+ * @param p The price
+ * @return The zero based index of the price, or -1 if it isn't in the
+ * snapshot.
+ */
+int gnc_price_snapshot_index (const GNCPriceSnapshot *snapshot,
+                              const GNCPrice *p);
 
 /* The following two convenience functions are used to test the xml backend */
 /** @brief Return the number of prices in the database.
@@ -28,6 +28,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <cstdint>
+#include <atomic>
 
 #include "kvp-value.hpp"
 #include "kvp-frame.hpp"
@@ -40,14 +41,70 @@
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = "qof.kvp";
 
+/* Frames with up to this many slots are searched from the front, larger
+ * ones by bisection. */
+static const size_t KVP_LINEAR_SEARCH_MAX = 16;
+
+/* Keys are cached strings, so a key handed back from another frame is
+ * found without comparing any characters. */
+static bool
+key_equal (const char * one, std::string_view key)
+{
+    /* key may be a view of just the start of the very string one is. */
+    if (one == key.data ())
+        return one[key.size ()] == '\0';
+    return !std::strncmp (one, key.data (), key.size ()) && one[key.size ()] == '\0';
+}
+
+static bool
+key_less (const KvpFrameImpl::map_type::value_type & a, std::string_view key)
+{
+    if (a.first == key.data () && a.first[key.size ()] == '\0')
+        return false;
+    return std::string_view {a.first} < key;
+}
+
+template <typename Iter> static Iter
+find_key (Iter begin, Iter end, std::string_view key) noexcept
+{
+    if (static_cast<size_t>(end - begin) <= KVP_LINEAR_SEARCH_MAX)
+        return std::find_if (begin, end,
+                             [key](const KvpFrameImpl::map_type::value_type & a)
+                             { return key_equal (a.first, key); });
+    auto spot = std::lower_bound (begin, end, key, key_less);
+    if (spot != end && key_equal (spot->first, key))
+        return spot;
+    return end;
+}
+
+KvpFrameImpl::map_type::iterator
+KvpFrameImpl::find (std::string_view key) noexcept
+{
+    return find_key (m_valuemap.begin (), m_valuemap.end (), key);
+}
+
+KvpFrameImpl::map_type::const_iterator
+KvpFrameImpl::find (std::string_view key) const noexcept
+{
+    return find_key (m_valuemap.cbegin (), m_valuemap.cend (), key);
+}
+
+uint64_t
+KvpFrameImpl::new_generation () noexcept
+{
+    static std::atomic<uint64_t> last_generation {0};
+    return ++last_generation;
+}
+
 KvpFrameImpl::KvpFrameImpl(const KvpFrameImpl & rhs) noexcept
 {
+    m_valuemap.reserve (rhs.m_valuemap.size ());
     std::for_each(rhs.m_valuemap.begin(), rhs.m_valuemap.end(),
         [this](const map_type::value_type & a)
         {
             auto key = qof_string_cache_insert(a.first);
             auto val = new KvpValueImpl(*a.second);
-            this->m_valuemap.insert({key,val});
+            this->m_valuemap.emplace_back(key,val);
         }
     );
 }
@@ -69,7 +126,7 @@ KvpFrame::get_child_frame_or_nullptr (Path const & path) noexcept
     if (!path.size ())
         return this;
     auto key = path.front ();
-    auto map_iter = m_valuemap.find (key.c_str ());
+    auto map_iter = find (key.c_str ());
     if (map_iter == m_valuemap.end ())
         return nullptr;
     auto child = map_iter->second->get <KvpFrame *> ();
@@ -86,12 +143,12 @@ KvpFrame::get_child_frame_or_create (Path const & path) noexcept
     if (!path.size ())
         return this;
     auto key = path.front ();
-    auto spot = m_valuemap.find (key.c_str ());
+    auto spot = find (key.c_str ());
     if (spot == m_valuemap.end () || spot->second->get_type () != KvpValue::Type::FRAME)
         delete set_impl (key.c_str (), new KvpValue {new KvpFrame});
     Path send;
     std::copy (path.begin () + 1, path.end (), std::back_inserter (send));
-    auto child_val = m_valuemap.at (key.c_str ());
+    auto child_val = find (key.c_str ())->second;
     auto child = child_val->get <KvpFrame *> ();
     return child->get_child_frame_or_create (send);
 }
@@ -101,21 +158,74 @@ KvpValue *
 KvpFrame::set_impl (std::string const & key, KvpValue * value) noexcept
 {
     KvpValue * ret {};
-    auto spot = m_valuemap.find (key.c_str ());
+    auto spot = find (key);
+    m_generation = new_generation ();
     if (spot != m_valuemap.end ())
     {
-        qof_string_cache_remove (spot->first);
         ret = spot->second;
+        if (value)
+        {
+            /* The slot keeps its key and its place. */
+            spot->second = value;
+            return ret;
+        }
+        qof_string_cache_remove (spot->first);
         m_valuemap.erase (spot);
     }
     if (value)
     {
         auto cachedkey = static_cast <char const *> (qof_string_cache_insert (key.c_str ()));
-        m_valuemap.emplace (cachedkey, value);
+        auto place = std::lower_bound (m_valuemap.begin (), m_valuemap.end (),
+                                       cachedkey, key_less);
+        m_valuemap.emplace (place, cachedkey, value);
     }
     return ret;
 }
 
+void
+KvpFrameImpl::add_unsorted (std::string_view key, KvpValue * value) noexcept
+{
+    if (!value)
+        return;
+    std::string keystr {key};
+    auto cachedkey = static_cast <char const *> (qof_string_cache_insert (keystr.c_str ()));
+    m_valuemap.emplace_back (cachedkey, value);
+    m_generation = new_generation ();
+}
+
+void
+KvpFrameImpl::sort_added () noexcept
+{
+    auto less = [](const map_type::value_type & a, const map_type::value_type & b)
+    {
+        return a.first != b.first && std::strcmp (a.first, b.first) < 0;
+    };
+    /* Loaders mostly add the slots in order already. */
+    if (std::adjacent_find (m_valuemap.begin (), m_valuemap.end (),
+                            [](const map_type::value_type & a,
+                               const map_type::value_type & b)
+                            { return std::strcmp (a.first, b.first) >= 0; }) ==
+        m_valuemap.end ())
+        return;
+
+    /* Stable, so that of the slots with the same key the last one added
+     * comes last. */
+    std::stable_sort (m_valuemap.begin (), m_valuemap.end (), less);
+    auto kept = m_valuemap.begin ();
+    for (auto it = m_valuemap.begin (); it != m_valuemap.end (); ++it)
+    {
+        auto next = it + 1;
+        if (next != m_valuemap.end () && key_equal (it->first, next->first))
+        {
+            qof_string_cache_remove (it->first);
+            delete it->second;
+            continue;
+        }
+        *kept++ = *it;
+    }
+    m_valuemap.erase (kept, m_valuemap.end ());
+}
+
 KvpValue *
 KvpFrameImpl::set (Path path, KvpValue* value) noexcept
 {
@@ -148,12 +258,30 @@ KvpFrameImpl::get_slot (Path path) noexcept
     auto target = get_child_frame_or_nullptr (path);
     if (!target)
         return nullptr;
-    auto spot = target->m_valuemap.find (key.c_str ());
+    auto spot = target->find (key.c_str ());
     if (spot != target->m_valuemap.end ())
         return spot->second;
     return nullptr;
 }
 
+KvpValue *
+KvpFrameImpl::get_slot (KvpKeys keys) noexcept
+{
+    KvpFrame * frame = this;
+    KvpValue * value = nullptr;
+    for (auto key : keys)
+    {
+        if (!frame)
+            return nullptr;
+        auto spot = frame->find (key);
+        if (spot == frame->m_valuemap.end ())
+            return nullptr;
+        value = spot->second;
+        frame = value->get <KvpFrame *> ();
+    }
+    return value;
+}
+
 std::string
 KvpFrameImpl::to_string() const noexcept
 {
@@ -217,7 +345,7 @@ int compare(const KvpFrameImpl & one, const KvpFrameImpl & two) noexcept
 {
     for (const auto & a : one.m_valuemap)
     {
-        auto otherspot = two.m_valuemap.find(a.first);
+        auto otherspot = two.find(a.first);
         if (otherspot == two.m_valuemap.end())
         {
             return 1;
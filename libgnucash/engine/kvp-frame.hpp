@@ -85,13 +85,20 @@
 #define GNC_KVP_FRAME_TYPE
 
 #include "kvp-value.hpp"
-#include <map>
 #include <string>
+#include <string_view>
+#include <initializer_list>
 #include <vector>
 #include <cstring>
+#include <cstdint>
 #include <algorithm>
 #include <iostream>
 using Path = std::vector<std::string>;
+/** A path of keys that aren't copied to look it up, usually a braced list of
+ * string literals and string constants.  A braced list of keys passed to a
+ * function taking either this or a Path makes one of these.
+ */
+using KvpKeys = std::initializer_list<std::string_view>;
 using KvpEntry = std::pair <std::vector <std::string>, KvpValue*>;
 
 /** Implements KvpFrame.
@@ -108,17 +115,10 @@ using KvpEntry = std::pair <std::vector <std::string>, KvpValue*>;
  */
 struct KvpFrameImpl
 {
-    class cstring_comparer
-    {
-    public:
-	/* Returns true if one is less than two. */
-	bool operator()(const char * one, const char * two) const
-	    {
-		auto ret = std::strcmp(one, two) < 0;
-		return ret;
-	    }
-    };
-    using map_type = std::map<const char *, KvpValue*, cstring_comparer>;
+    /* The slots are kept in a vector sorted by key.  Most frames hold only
+     * a handful of slots, for which a vector is about half the size of a
+     * tree and no slower to search. */
+    using map_type = std::vector<std::pair<const char *, KvpValue*>>;
 
     public:
     KvpFrameImpl() noexcept {};
@@ -169,6 +169,21 @@ struct KvpFrameImpl
      * @return The old value if there was one or nullptr.
      */
     KvpValue* set_path(Path path, KvpValue* newvalue) noexcept;
+    /**
+     * Add a slot to the immediate frame for a bulk load, appending it
+     * instead of inserting it in its place. Call sort_added() once all of
+     * them are added and before the frame is used for anything else. Takes
+     * ownership of the value as set does.
+     * @param key: The key of the new slot.
+     * @param newvalue: The value to set at key.
+     */
+    void add_unsorted(std::string_view key, KvpValue* newvalue) noexcept;
+    /**
+     * Sort the slots added with add_unsorted() into place. Where a key was
+     * added more than once, or was already in the frame, the last value
+     * added wins and the others are deleted.
+     */
+    void sort_added() noexcept;
     /**
      * Make a string representation of the frame. Mostly useful for debugging.
      * @return A std::string representing the frame and all its children.
@@ -192,6 +207,13 @@ struct KvpFrameImpl
      * @return The value at the key or nullptr.
      */
     KvpValue* get_slot(Path keys) noexcept;
+    KvpValue* get_slot(KvpKeys keys) noexcept;
+
+    /** A number that changes whenever a slot is set or removed in this frame
+     * (but not in its subframes) and that no other frame ever has, so that
+     * values read from the frame can be cached until it changes.
+     */
+    uint64_t generation() const noexcept { return m_generation; }
 
     /** The function should be of the form:
      * <anything> func (char const *, KvpValue *, data_type &);
@@ -231,7 +253,11 @@ struct KvpFrameImpl
 
     private:
     map_type m_valuemap;
+    uint64_t m_generation = new_generation ();
 
+    static uint64_t new_generation () noexcept;
+    map_type::iterator find (std::string_view) noexcept;
+    map_type::const_iterator find (std::string_view) const noexcept;
     KvpFrame * get_child_frame_or_nullptr (Path const &) noexcept;
     KvpFrame * get_child_frame_or_create (Path const &) noexcept;
     void flatten_kvp_impl(std::vector <std::string>, std::vector <KvpEntry> &) const noexcept;
@@ -210,6 +210,19 @@ public:
  *    better to wait for the query).
  */
     virtual void load (QofBook*, QofBackendLoadType) = 0;
+/**
+ *    Load the splits of an account posted on or after a date.  A backend that
+ *    leaves transactions out of the initial load marks each account with
+ *    gnc_account_set_splits_loaded_from and the engine calls this the first
+ *    time it needs splits older than that.  The backend must mark the account
+ *    again before it loads anything.
+ */
+    virtual void load_splits (QofInstance*, time64) {}
+/**
+ *    Called before a query is run over the book so that a backend that loads
+ *    lazily can fetch whatever the query might match.
+ */
+    virtual void load_for_query (QofQuery*) {}
 /**
  *    Called when the engine is about to make a change to a data structure. It
  *    could provide an advisory lock on data, but no backend does this.
@@ -248,6 +261,11 @@ public:
  *   database with it. Implemented only in the XML backend at present.
  */
     virtual void export_coa(QofBook *) {}
+/**   Copy the data store as it is to a new one of the same kind at uri,
+ *   without loading it into a book. Returns false if the backend can't, in
+ *   which case the book has to be loaded and saved instead.
+ */
+    virtual bool copy_to(const char*) { return false; }
 /** Set the error value only if there isn't already an error already.
  */
     void set_error(QofBackendError err);
@@ -31,6 +31,8 @@ static QofLogModule log_module = QOF_MOD_CLASS;
 
 static GHashTable *classTable = NULL;
 static GHashTable *sortTable = NULL;
+/* The parameters whose getters were declared to only read the object. */
+static GHashTable *pureTable = NULL;
 static gboolean initialized = FALSE;
 
 static gboolean clear_table (gpointer key, gpointer value, gpointer user_data)
@@ -58,6 +60,7 @@ qof_class_init(void)
 
     classTable = g_hash_table_new (g_str_hash, g_str_equal);
     sortTable = g_hash_table_new (g_str_hash, g_str_equal);
+    pureTable = g_hash_table_new (g_direct_hash, g_direct_equal);
 }
 
 void
@@ -69,6 +72,7 @@ qof_class_shutdown (void)
     g_hash_table_foreach_remove (classTable, clear_table, NULL);
     g_hash_table_destroy (classTable);
     g_hash_table_destroy (sortTable);
+    g_hash_table_destroy (pureTable);
 }
 
 QofSortFunc
@@ -121,6 +125,36 @@ qof_class_register (QofIdTypeConst obj_name,
     }
 }
 
+void
+qof_class_register_pure_params (QofIdTypeConst obj_name,
+                                const char *param_name, ...)
+{
+    va_list ap;
+
+    if (!obj_name) return;
+    if (!check_init()) return;
+
+    va_start (ap, param_name);
+    for (; param_name; param_name = va_arg (ap, const char *))
+    {
+        auto param = qof_class_get_parameter (obj_name, param_name);
+        if (param)
+            g_hash_table_add (pureTable, (gpointer)param);
+        else
+            PWARN ("no parameter %s of %s", param_name, obj_name);
+    }
+    va_end (ap);
+}
+
+gboolean
+qof_class_param_is_pure (const QofParam *param)
+{
+    if (!param) return FALSE;
+    if (!check_init()) return FALSE;
+
+    return g_hash_table_contains (pureTable, param);
+}
+
 gboolean
 qof_class_is_registered (QofIdTypeConst obj_name)
 {
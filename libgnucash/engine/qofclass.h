@@ -231,6 +231,19 @@ void qof_class_register (QofIdTypeConst obj_name,
  * qof_class_register ("myObjectName", myObjectCompare, &myParams);
  */
 
+/** Declare that the getters of some of an object's registered parameters
+ *  only read the object: they don't load, cache, recompute or log, so a
+ *  query running in parallel may call them from several threads at once.
+ *  The list of parameter names ends with NULL.
+ */
+void qof_class_register_pure_params (QofIdTypeConst obj_name,
+                                     const char *param_name, ...);
+
+/** Return TRUE if the parameter's getter was declared to only read the
+ *  object.
+ */
+gboolean qof_class_param_is_pure (const QofParam *param);
+
 /** Return true if the the indicated type is registered,
  *  else return FALSE.
  */
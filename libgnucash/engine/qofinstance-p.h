@@ -91,6 +91,9 @@ void qof_instance_set_dirty(QofInstance* inst);
 
 /* reset the dirty flag */
 void qof_instance_mark_clean (QofInstance *);
+/** Set the flag that tells whether the instance has ever been saved, for
+ *  backends that save an instance after its edit has been committed. */
+void qof_instance_set_infant (QofInstance *, gboolean infant);
 /** Get the version number on this instance.  The version number is
  *  used to manage multi-user updates. */
 gint32 qof_instance_get_version (gconstpointer inst);
@@ -169,6 +172,10 @@ void qof_instance_set_path_kvp (QofInstance *, GValue const *, std::vector<std::
 template <typename T> std::optional<T>
 qof_instance_get_path_kvp (QofInstance*, const Path&);
 
+/** As above, without copying the keys. */
+template <typename T> std::optional<T>
+qof_instance_get_path_kvp (QofInstance*, KvpKeys);
+
 template <typename T> void
 qof_instance_set_path_kvp (QofInstance*, std::optional<T>, const Path&);
 
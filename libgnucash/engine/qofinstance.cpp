@@ -673,6 +673,13 @@ qof_instance_mark_clean (QofInstance *inst)
     GET_PRIVATE(inst)->dirty = FALSE;
 }
 
+void
+qof_instance_set_infant (QofInstance *inst, gboolean infant)
+{
+    g_return_if_fail(QOF_IS_INSTANCE(inst));
+    GET_PRIVATE(inst)->infant = infant;
+}
+
 void
 qof_instance_print_dirty (const QofInstance *inst, gpointer dummy)
 {
@@ -1080,11 +1087,24 @@ qof_instance_set_path_kvp (QofInstance* inst, std::optional<T> value, const Path
     qof_instance_set_dirty (inst);
 }
 
+template <typename T> std::optional<T>
+qof_instance_get_path_kvp (QofInstance* inst, KvpKeys path)
+{
+    g_return_val_if_fail (QOF_IS_INSTANCE(inst), std::nullopt);
+    auto kvp_value{inst->kvp_data->get_slot(path)};
+    return kvp_value ? std::make_optional<T>(kvp_value->get<T>()) : std::nullopt;
+}
+
 template std::optional<const char*> qof_instance_get_path_kvp <const char*> (QofInstance*, const Path&);
 template std::optional<gnc_numeric> qof_instance_get_path_kvp <gnc_numeric> (QofInstance*, const Path&);
 template std::optional<GncGUID*> qof_instance_get_path_kvp <GncGUID*> (QofInstance*, const Path&);
 template std::optional<int64_t> qof_instance_get_path_kvp <int64_t> (QofInstance*, const Path&);
 
+template std::optional<const char*> qof_instance_get_path_kvp <const char*> (QofInstance*, KvpKeys);
+template std::optional<gnc_numeric> qof_instance_get_path_kvp <gnc_numeric> (QofInstance*, KvpKeys);
+template std::optional<GncGUID*> qof_instance_get_path_kvp <GncGUID*> (QofInstance*, KvpKeys);
+template std::optional<int64_t> qof_instance_get_path_kvp <int64_t> (QofInstance*, KvpKeys);
+
 template void qof_instance_set_path_kvp <const char*> (QofInstance*, std::optional<const char*>, const Path& path);
 template void qof_instance_set_path_kvp <gnc_numeric> (QofInstance*, std::optional<gnc_numeric>, const Path& path);
 template void qof_instance_set_path_kvp <GncGUID*> (QofInstance*, std::optional<GncGUID*>, const Path& path);
@@ -1098,13 +1118,20 @@ void qof_instance_get_path_kvp (QofInstance * inst, GValue * value, std::vector<
 void
 qof_instance_get_kvp (QofInstance * inst, GValue * value, unsigned count, ...)
 {
-    std::vector<std::string> path;
+    /* Follow the keys one frame at a time rather than copying them into a
+     * Path: this is called for every row of a register. */
+    KvpFrame *frame = inst->kvp_data;
+    KvpValue *slot = nullptr;
     va_list args;
     va_start (args, count);
     for (unsigned i{0}; i < count; ++i)
-        path.push_back (va_arg (args, char const *));
+    {
+        auto key = va_arg (args, char const *);
+        slot = frame ? frame->get_slot ({key}) : nullptr;
+        frame = slot ? slot->get<KvpFrame*> () : nullptr;
+    }
     va_end (args);
-    gvalue_from_kvp_value (inst->kvp_data->get_slot (path), value);
+    gvalue_from_kvp_value (slot, value);
 }
 
 void
@@ -38,6 +38,12 @@ extern "C"
 int qof_query_get_max_results (const QofQuery *q);
 
 
+/* Let parallel queries (see qof_query_set_parallel) use the thread pool
+ * from min_objects objects on, with threads threads, so that tests needn't
+ * build books big enough for the defaults.  0 restores a default. */
+void qof_query_set_parallel_limits (guint min_objects, int threads);
+
+
 /* Functions to get and look at QueryTerms */
 
 /* This returns a List of List of Query Terms.  Each list of Query
@@ -71,6 +77,53 @@ QofQueryParamList * qof_query_sort_get_param_path (const QofQuerySort *querysort
 gint qof_query_sort_get_sort_options (const QofQuerySort *querysort);
 gboolean qof_query_sort_get_increasing (const QofQuerySort *querysort);
 
+/* Query indexes
+ *
+ * An index finds the objects of a book that can pass one OR-branch of a
+ * query without qof_query_run going through the whole collection.  When
+ * it's run in a book, each branch is offered to the indexes registered
+ * for the type searched for and the one with the fewest candidates is
+ * used.  If any branch has no index, or the indexes would hand out about
+ * as many objects as the collection holds, the collection is searched as
+ * before.
+ */
+
+/* What an index's plan function fills in when it can drive a branch. */
+typedef struct
+{
+    /* About how many objects foreach will hand out. */
+    gint64      estimate;
+    /* The terms of the branch every object foreach hands out passes.
+     * They aren't checked again.  The list is freed by the query, not
+     * the terms. */
+    GList *     covered;
+    /* Passed to foreach and then to the index's free_data. */
+    gpointer    data;
+    /* What the index will do, for qof_query_explain.  Freed with g_free. */
+    gchar *     description;
+} QofQueryIndexPlan;
+
+typedef struct
+{
+    /* A short name for qof_query_explain. */
+    const char *name;
+    /* Look at the AND-terms of one branch.  Return TRUE and fill in plan
+     * if the index can hand out a superset of the objects of book passing
+     * them, FALSE otherwise. */
+    gboolean    (*plan) (QofBook *book, GList *and_terms,
+                         QofQueryIndexPlan *plan);
+    /* Call cb on each candidate planned for. */
+    void        (*foreach) (QofBook *book, gpointer data,
+                            QofInstanceForeachCB cb, gpointer user_data);
+    /* Free a plan's data.  May be NULL. */
+    GDestroyNotify free_data;
+} QofQueryIndex;
+
+/* Register an index for the objects of type obj_type.  The index is
+ * copied. */
+void qof_query_register_index (QofIdTypeConst obj_type,
+                               const QofQueryIndex *index);
+
 #ifdef __cplusplus
 }
 #endif
@@ -29,11 +29,17 @@
 #include <regex.h>
 #include <string.h>
 
+#include <algorithm>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
 #include "qof.h"
 #include "qof-backend.hpp"
 #include "qofbook-p.h"
 #include "qofclass-p.h"
 #include "qofquery-p.h"
+#include "qofquery.hpp"
 #include "qofquerycore-p.h"
 
 static QofLogModule log_module = QOF_MOD_QUERY;
@@ -90,6 +96,9 @@ struct _QofQuery
     /* The maximum number of results to return */
     gint              max_results;
 
+    /* Whether the objects may be checked on several threads */
+    gboolean          parallel;
+
     /* list of books that will be participating in the query */
     GList *           books;
 
@@ -100,14 +109,49 @@ struct _QofQuery
      * again until it's really necessary */
     gint              changed;
 
-    GList *           results;
+    QofQueryResults * results;
+    /* The results as a GList, made when first asked for. */
+    GList *           results_list;
+};
+
+/* One OR-branch of a query as it's run. */
+struct QueryBranch
+{
+    /* The AND-terms, as the query holds them. */
+    GList *                 and_terms;
+    /* The terms to check, cheapest first.  Terms that couldn't be
+     * compiled pass everything and aren't here. */
+    std::vector<QofQueryTerm*> checks;
+    /* The index driving the branch in the book being searched, if one
+     * can, and what's left to check on the objects it hands out. */
+    const QofQueryIndex *   index;
+    QofQueryIndexPlan       index_plan;
+    std::vector<QofQueryTerm*> residual;
+};
+
+/* How a query is run in one book. */
+struct QueryPlan
+{
+    std::vector<QueryBranch> branches;
+    /* The size of the book's collection and whether the branches' indexes
+     * are used instead of searching all of it. */
+    gint64                  collection_size;
+    bool                    use_indexes;
+};
+
+struct QueryIndexEntry
+{
+    std::string             obj_type;
+    QofQueryIndex           index;
 };
 
+static std::vector<QueryIndexEntry> query_indexes;
+
 typedef struct _QofQueryCB
 {
     QofQuery *        query;
-    GList *           list;
-    gint              count;
+    QueryPlan *       plan;
+    QofQueryResults * matches;
 } QofQueryCB;
 
 /* Query Print functions for use with qof_log_set_level, static prototypes */
@@ -129,6 +173,14 @@ static void qof_query_printOutput (GList * output);
 static void qof_query_print (QofQuery * query);
 
 
+static void query_free_results (QofQuery *q)
+{
+    delete q->results;
+    q->results = nullptr;
+    g_list_free (q->results_list);
+    q->results_list = nullptr;
+}
+
 /* initial_term will be owned by the new Query */
 static void query_init (QofQuery *q, QofQueryTerm *initial_term)
 {
@@ -147,7 +199,7 @@ static void query_init (QofQuery *q, QofQueryTerm *initial_term)
     if (q->terms)
         qof_query_clear (q);
 
-    g_list_free (q->results);
+    query_free_results (q);
     g_list_free (q->books);
 
     g_slist_free (q->primary_sort.param_list);
@@ -288,8 +340,7 @@ static void free_members (QofQuery *q)
     g_list_free(q->books);
     q->books = nullptr;
 
-    g_list_free(q->results);
-    q->results = nullptr;
+    query_free_results (q);
 }
 
 static int cmp_func (const QofQuerySort *sort, QofSortFunc default_sort,
@@ -378,61 +429,48 @@ sort_func (const gconstpointer a, const gconstpointer b, const gpointer q)
  * object passes the seive.
  */
 
-static int
-check_object (const QofQuery *q, gpointer object)
+static gboolean
+check_term (const QofQueryTerm *qt, gpointer object)
 {
-    const GList     * and_ptr;
-    const GList     * or_ptr;
-    const QofQueryTerm * qt;
-    int       and_terms_ok = 1;
+    const GSList *node;
+    QofParam *param = nullptr;
+    gpointer conv_obj = object;
 
-    for (or_ptr = q->terms; or_ptr; or_ptr = or_ptr->next)
+    /* iterate through the conversions */
+    for (node = qt->param_fcns; node; node = node->next)
     {
-        and_terms_ok = 1;
-        for (and_ptr = static_cast<GList*>(or_ptr->data); and_ptr;
-	     and_ptr = static_cast<GList*>(and_ptr->next))
-        {
-            qt = (QofQueryTerm *)(and_ptr->data);
-            if (qt->param_fcns && qt->pred_fcn)
-            {
-                const GSList *node;
-                QofParam *param = nullptr;
-                gpointer conv_obj = object;
+        param = static_cast<QofParam*>(node->data);
 
-                /* iterate through the conversions */
-                for (node = qt->param_fcns; node; node = node->next)
-                {
-                    param = static_cast<QofParam*>(node->data);
+        /* The last term is the actual parameter getter */
+        if (!node->next) break;
 
-                    /* The last term is the actual parameter getter */
-                    if (!node->next) break;
+        conv_obj = (void*)param->param_getfcn (conv_obj, param);
+    }
 
-                    conv_obj = (void*)param->param_getfcn (conv_obj, param);
-                }
+    return ((qt->pred_fcn)(conv_obj, param, qt->pdata)) != qt->invert;
+}
 
-                if (((qt->pred_fcn)(conv_obj, param, qt->pdata)) == qt->invert)
-                {
-                    and_terms_ok = 0;
-                    break;
-                }
-            }
-            else
-            {
-                /* XXX: Don't know how to do this conversion -- do we care? */
-            }
-        }
-        if (and_terms_ok)
-        {
-            return 1;
-        }
-    }
+static gboolean
+check_terms (const std::vector<QofQueryTerm*>& terms, gpointer object)
+{
+    return std::all_of (terms.begin(), terms.end(),
+                        [object](const QofQueryTerm *qt)
+                        { return check_term (qt, object); });
+}
 
+static int
+check_object (const QueryPlan *plan, gpointer object)
+{
     /* If there are no terms, assume a "match any" applies.
      * A query with no terms is still meaningful, since the user
      * may want to get all objects, but in a particular sorted
      * order.
      */
-    if (nullptr == q->terms) return 1;
+    if (plan->branches.empty()) return 1;
+
+    for (const auto& branch : plan->branches)
+        if (check_terms (branch.checks, object))
+            return 1;
     return 0;
 }
 
@@ -589,12 +627,426 @@ static void check_item_cb (gpointer object, gpointer user_data)
 
     if (!object || !ql) return;
 
-    if (check_object (ql->query, object))
+    if (check_object (ql->plan, object))
+        ql->matches->push_back (object);
+    return;
+}
+
+/* ==================================================================== */
+/* Query plans
+ *
+ * An object matches a query if it passes every term of any one of its
+ * OR-branches.  The plan checks each branch's terms cheapest first and,
+ * in each book, drives each branch from the cheapest index that can find
+ * its candidates.  Only if every branch has an index, and together they
+ * hand out fewer objects than the collection holds, are the indexes used.
+ */
+
+/* A rough cost of checking a term: one for each object the parameter
+ * path goes through, and more for the predicates that do more than
+ * compare a number. */
+static int
+query_term_cost (const QofQueryTerm *qt)
+{
+    auto type = qt->pdata->type_name;
+    int cost = g_slist_length (qt->param_fcns) - 1;
+
+    if (!g_strcmp0 (type, QOF_TYPE_NUMERIC) ||
+        !g_strcmp0 (type, QOF_TYPE_DEBCRED))
+        cost += 1;
+    else if (!g_strcmp0 (type, QOF_TYPE_STRING))
+        cost += 2;
+    else if (!g_strcmp0 (type, QOF_TYPE_KVP) ||
+             !g_strcmp0 (type, QOF_TYPE_COLLECT) ||
+             !g_strcmp0 (type, QOF_TYPE_CHOICE))
+        cost += 3;
+    return cost;
+}
+
+static void
+query_index_plan_free (const QofQueryIndex *index, QofQueryIndexPlan& plan)
+{
+    if (index && index->free_data && plan.data)
+        index->free_data (plan.data);
+    g_list_free (plan.covered);
+    g_free (plan.description);
+    plan = {};
+}
+
+static void
+query_plan_clear_indexes (QueryPlan& plan)
+{
+    for (auto& branch : plan.branches)
     {
-        ql->list = g_list_prepend (ql->list, object);
-        ql->count++;
+        query_index_plan_free (branch.index, branch.index_plan);
+        branch.index = nullptr;
+        branch.residual.clear();
+    }
+    plan.collection_size = 0;
+    plan.use_indexes = false;
+}
+
+/* The query must have been compiled. */
+static void
+query_plan_init (QueryPlan& plan, const QofQuery *q)
+{
+    for (auto or_ptr = q->terms; or_ptr; or_ptr = or_ptr->next)
+    {
+        QueryBranch branch{};
+        branch.and_terms = static_cast<GList*>(or_ptr->data);
+        for (auto and_ptr = branch.and_terms; and_ptr; and_ptr = and_ptr->next)
+        {
+            auto qt = static_cast<QofQueryTerm*>(and_ptr->data);
+            if (qt->param_fcns && qt->pred_fcn)
+                branch.checks.push_back (qt);
+        }
+        std::stable_sort (branch.checks.begin(), branch.checks.end(),
+                          [](const QofQueryTerm *a, const QofQueryTerm *b)
+                          { return query_term_cost (a) < query_term_cost (b); });
+        plan.branches.push_back (std::move (branch));
+    }
+}
+
+static void
+query_plan_destroy (QueryPlan& plan)
+{
+    query_plan_clear_indexes (plan);
+    plan.branches.clear();
+}
+
+/* Pick the indexes to search book with. */
+static void
+query_plan_choose_indexes (QueryPlan& plan, QofIdTypeConst search_for,
+                           QofBook *book)
+{
+    gint64 candidates = 0;
+    bool all_indexed = true;
+
+    query_plan_clear_indexes (plan);
+    auto coll = qof_book_get_collection (book, search_for);
+    plan.collection_size = coll ? qof_collection_count (coll) : 0;
+
+    /* No terms: everything matches. */
+    if (plan.branches.empty())
+        return;
+
+    for (auto& branch : plan.branches)
+    {
+        for (const auto& entry : query_indexes)
+        {
+            QofQueryIndexPlan index_plan{};
+
+            if (entry.obj_type != search_for ||
+                !entry.index.plan (book, branch.and_terms, &index_plan))
+                continue;
+
+            if (!branch.index || index_plan.estimate < branch.index_plan.estimate)
+            {
+                query_index_plan_free (branch.index, branch.index_plan);
+                branch.index = &entry.index;
+                branch.index_plan = index_plan;
+            }
+            else
+            {
+                query_index_plan_free (&entry.index, index_plan);
+            }
+        }
+
+        if (!branch.index)
+        {
+            all_indexed = false;
+            continue;
+        }
+
+        candidates += branch.index_plan.estimate;
+        for (auto qt : branch.checks)
+            if (!g_list_find (branch.index_plan.covered, qt))
+                branch.residual.push_back (qt);
+    }
+
+    plan.use_indexes = all_indexed && candidates < plan.collection_size;
+}
+
+struct QueryIndexRun
+{
+    QofQueryCB *              qcb;
+    const QueryBranch *       branch;
+    /* The objects already matched, when there's more than one branch to
+     * hand them out. */
+    std::unordered_set<gpointer> *seen;
+};
+
+static void
+index_item_cb (QofInstance *object, gpointer user_data)
+{
+    auto run = static_cast<QueryIndexRun*>(user_data);
+
+    if (!object || !check_terms (run->branch->residual, object))
+        return;
+    if (run->seen && !run->seen->insert (object).second)
+        return;
+
+    run->qcb->matches->push_back (object);
+}
+
+static void
+query_plan_run_indexes (QofQueryCB *qcb, QofBook *book)
+{
+    std::unordered_set<gpointer> seen;
+    QueryIndexRun run{qcb, nullptr,
+                      qcb->plan->branches.size() > 1 ? &seen : nullptr};
+
+    for (const auto& branch : qcb->plan->branches)
+    {
+        run.branch = &branch;
+        branch.index->foreach (book, branch.index_plan.data, index_item_cb,
+                               &run);
+    }
+}
+
+/* ==================================================================== */
+/* Checking objects in parallel
+ *
+ * A parallel query gathers the objects it would check, cuts them into
+ * slices and checks the slices on a thread pool.  Each slice keeps its
+ * own matches, and they're put back together in slice order so that the
+ * results come out as they would have from one thread.  That's only safe
+ * when nothing a term calls changes anything: the getters must have been
+ * registered as pure and the predicate must be one of the plain core
+ * types.
+ */
+
+/* Fewer objects than this aren't worth starting threads for. */
+#define QUERY_PARALLEL_MIN_OBJECTS 4096
+/* Each thread gets about this many slices, to even out the load. */
+#define QUERY_PARALLEL_SLICES 4
+
+/* Set by qof_query_set_parallel_limits, 0 for the defaults. */
+static guint query_parallel_min_objects = 0;
+static int query_parallel_max_threads = 0;
+
+static bool
+query_term_is_pure (const QofQueryTerm *qt)
+{
+    static const char *pure_types[] =
+    {
+        QOF_TYPE_STRING, QOF_TYPE_NUMERIC, QOF_TYPE_DEBCRED, QOF_TYPE_DATE,
+        QOF_TYPE_GUID, QOF_TYPE_INT32, QOF_TYPE_INT64, QOF_TYPE_DOUBLE,
+        QOF_TYPE_BOOLEAN, QOF_TYPE_CHAR
+    };
+    auto type = qt->pdata->type_name;
+
+    if (std::none_of (std::begin (pure_types), std::end (pure_types),
+                      [type](const char *t) { return !g_strcmp0 (type, t); }))
+        return false;
+    for (auto node = qt->param_fcns; node; node = node->next)
+        if (!qof_class_param_is_pure (static_cast<QofParam*>(node->data)))
+            return false;
+    return true;
+}
+
+static bool
+query_plan_is_pure (const QueryPlan& plan)
+{
+    for (const auto& branch : plan.branches)
+        if (!std::all_of (branch.checks.begin(), branch.checks.end(),
+                          query_term_is_pure))
+            return false;
+    return true;
+}
+
+static int
+query_parallel_threads (void)
+{
+    if (query_parallel_max_threads > 0)
+        return query_parallel_max_threads;
+    return CLAMP (g_get_num_processors (), 1, 8);
+}
+
+void
+qof_query_set_parallel_limits (guint min_objects, int threads)
+{
+    query_parallel_min_objects = min_objects;
+    query_parallel_max_threads = threads;
+}
+
+struct QueryFilterSlice
+{
+    const QueryPlan *         plan;
+    /* The terms to check, or nullptr to check the whole plan. */
+    const std::vector<QofQueryTerm*> *terms;
+    const gpointer *          begin;
+    const gpointer *          end;
+    QofQueryResults           matches;
+};
+
+static bool
+query_filter_check (const QueryFilterSlice *slice, gpointer object)
+{
+    return slice->terms ? check_terms (*slice->terms, object) :
+           check_object (slice->plan, object);
+}
+
+static void
+query_filter_slice (gpointer data, gpointer user_data)
+{
+    auto slice = static_cast<QueryFilterSlice*>(data);
+
+    for (auto it = slice->begin; it != slice->end; ++it)
+        if (query_filter_check (slice, *it))
+            slice->matches.push_back (*it);
+}
+
+/* Check objects against terms, or against the plan if terms is nullptr,
+ * and add those that pass to matches in the order they're in. */
+static void
+query_filter (const QueryPlan *plan, const std::vector<QofQueryTerm*> *terms,
+              const std::vector<gpointer>& objects, QofQueryResults& matches)
+{
+    auto threads = query_parallel_threads ();
+    GThreadPool *pool = nullptr;
+
+    auto min_objects = query_parallel_min_objects ? query_parallel_min_objects :
+                       QUERY_PARALLEL_MIN_OBJECTS;
+
+    if (threads > 1 && objects.size() >= min_objects)
+    {
+        pool = g_thread_pool_new (query_filter_slice, nullptr, threads,
+                                  FALSE, nullptr);
+        if (!pool)
+            PWARN ("Couldn't start the query threads, checking serially");
+    }
+    if (!pool)
+    {
+        QueryFilterSlice slice{plan, terms, objects.data(),
+                               objects.data() + objects.size(), {}};
+        for (auto object : objects)
+            if (query_filter_check (&slice, object))
+                matches.push_back (object);
+        return;
+    }
+
+    size_t n_slices = threads * QUERY_PARALLEL_SLICES;
+    size_t slice_size = (objects.size() + n_slices - 1) / n_slices;
+    std::vector<QueryFilterSlice> slices;
+    slices.reserve (n_slices);
+    for (size_t start = 0; start < objects.size(); start += slice_size)
+    {
+        auto end = MIN (start + slice_size, objects.size());
+        slices.push_back ({plan, terms, objects.data() + start,
+                           objects.data() + end, {}});
+    }
+    for (auto& slice : slices)
+        g_thread_pool_push (pool, &slice, nullptr);
+    g_thread_pool_free (pool, FALSE, TRUE);
+
+    PINFO ("checked %zu objects in %zu slices on %d threads", objects.size(),
+           slices.size(), threads);
+    for (const auto& slice : slices)
+        matches.insert (matches.end(), slice.matches.begin(),
+                        slice.matches.end());
+}
+
+static void
+gather_item_cb (QofInstance *object, gpointer user_data)
+{
+    if (object)
+        static_cast<std::vector<gpointer>*>(user_data)->push_back (object);
+}
+
+static void
+query_plan_run_parallel (QofQueryCB *qcb, QofBook *book)
+{
+    auto plan = qcb->plan;
+    std::vector<gpointer> objects;
+
+    if (!plan->use_indexes)
+    {
+        objects.reserve (plan->collection_size);
+        qof_object_foreach (qcb->query->search_for, book, gather_item_cb,
+                            &objects);
+        query_filter (plan, nullptr, objects, *qcb->matches);
+        return;
+    }
+
+    /* An object found by more than one branch is only matched once, the
+     * first time, as query_plan_run_indexes does. */
+    std::unordered_set<gpointer> seen;
+    for (const auto& branch : plan->branches)
+    {
+        QofQueryResults branch_matches;
+
+        objects.clear();
+        branch.index->foreach (book, branch.index_plan.data, gather_item_cb,
+                               &objects);
+        query_filter (plan, &branch.residual, objects, branch_matches);
+        for (auto object : branch_matches)
+            if (plan->branches.size() == 1 || seen.insert (object).second)
+                qcb->matches->push_back (object);
+    }
+}
+
+static void
+query_term_describe (GString *gs, const QofQueryTerm *qt)
+{
+    if (qt->invert)
+        g_string_append (gs, "not ");
+    for (auto node = qt->param_list; node; node = node->next)
+    {
+        g_string_append (gs, static_cast<const char*>(node->data));
+        if (node->next)
+            g_string_append (gs, "->");
+    }
+    g_string_append_printf (gs, " (%s)", qt->pdata->type_name);
+}
+
+static void
+query_plan_explain (const QueryPlan& plan, QofBook *book, GString *gs)
+{
+    gchar guid_str[GUID_ENCODING_LENGTH + 1];
+    int n = 0;
+
+    guid_to_string_buff (qof_instance_get_guid (book), guid_str);
+    g_string_append_printf (gs, "Book %s: %" G_GINT64_FORMAT " objects, ",
+                            guid_str, plan.collection_size);
+    if (plan.branches.empty())
+    {
+        g_string_append (gs, "no terms, every object matches\n");
+        return;
+    }
+    g_string_append (gs, plan.use_indexes ? "searched by index\n" :
+                     "whole collection searched\n");
+
+    for (const auto& branch : plan.branches)
+    {
+        g_string_append_printf (gs, "  Branch %d: ", ++n);
+        if (branch.index)
+            g_string_append_printf (gs, "index \"%s\", %s, about %"
+                                    G_GINT64_FORMAT " candidates\n",
+                                    branch.index->name,
+                                    branch.index_plan.description ?
+                                    branch.index_plan.description : "",
+                                    branch.index_plan.estimate);
+        else
+            g_string_append (gs, "no index\n");
+
+        const auto& checks = plan.use_indexes ? branch.residual : branch.checks;
+        if (plan.use_indexes)
+        {
+            for (auto node = branch.index_plan.covered; node; node = node->next)
+            {
+                g_string_append (gs, "    by index: ");
+                query_term_describe (gs, static_cast<QofQueryTerm*>(node->data));
+                g_string_append_c (gs, '\n');
+            }
+        }
+        for (auto qt : checks)
+        {
+            g_string_append (gs, "    check: ");
+            query_term_describe (gs, qt);
+            g_string_append_c (gs, '\n');
+        }
     }
-    return;
 }
 
 static int param_list_cmp (const QofQueryParamList *l1, const QofQueryParamList *l2)
@@ -740,21 +1192,58 @@ void qof_query_purge_terms (QofQuery *q, QofQueryParamList *param_list)
     }
 }
 
-static GList * qof_query_run_internal (QofQuery *q,
-                                       void(*run_cb)(QofQueryCB*, gpointer),
-                                       gpointer cb_arg)
+/* A match and where it was found, so that sorting part of the matches
+ * keeps ties in the order they were found like a stable sort of all of
+ * them would. */
+struct QueryMatch
 {
-    GList *matching_objects = nullptr;
-    int        object_count = 0;
+    gpointer    object;
+    size_t      pos;
+};
+
+/* Sort the matches and keep the last keep of them.  When that's only a
+ * few of many, they're picked out first and only they are sorted. */
+static void
+query_sort_matches (QofQuery *q, QofQueryResults& matches, size_t keep)
+{
+    if (keep >= matches.size())
+    {
+        std::stable_sort (matches.begin(), matches.end(),
+                          [q](gpointer a, gpointer b)
+                          { return sort_func (a, b, q) < 0; });
+        return;
+    }
+
+    std::vector<QueryMatch> top;
+    top.reserve (matches.size());
+    for (size_t i = 0; i < matches.size(); ++i)
+        top.push_back ({matches[i], i});
+
+    auto less = [q](const QueryMatch& a, const QueryMatch& b)
+    {
+        auto retval = sort_func (a.object, b.object, q);
+        return retval < 0 || (retval == 0 && a.pos < b.pos);
+    };
+    auto first_kept = top.end() - keep;
+    std::nth_element (top.begin(), first_kept, top.end(), less);
+    std::sort (first_kept, top.end(), less);
+
+    matches.clear();
+    for (auto it = first_kept; it != top.end(); ++it)
+        matches.push_back (it->object);
+}
 
+static const QofQueryResults *
+qof_query_run_internal (QofQuery *q,
+                        void(*run_cb)(QofQueryCB*, gpointer),
+                        gpointer cb_arg)
+{
     if (!q) return nullptr;
     g_return_val_if_fail (q->search_for, nullptr);
     g_return_val_if_fail (q->books, nullptr);
     g_return_val_if_fail (run_cb, nullptr);
     ENTER (" q=%p", q);
 
-    /* XXX: Prioritize the query terms? */
-
     /* prepare the Query for processing */
     if (q->changed)
     {
@@ -766,69 +1255,70 @@ static GList * qof_query_run_internal (QofQuery *q,
     if (qof_log_check (log_module, QOF_LOG_DEBUG))
         qof_query_print (q);
 
-    /* Now run the query over all the objects and save the results */
+    /* Now run the query over all the objects and save the results.
+     * They're collected in the order they were found, which in the
+     * common case of searching a confined location is already the order
+     * we want and makes the sorting go much faster. */
+    auto matches = new QofQueryResults;
     {
+        QueryPlan plan{};
         QofQueryCB qcb;
 
         memset (&qcb, 0, sizeof (qcb));
         qcb.query = q;
+        query_plan_init (plan, q);
+        qcb.plan = &plan;
+        qcb.matches = matches;
 
         /* Run the query callback */
         run_cb(&qcb, cb_arg);
 
-        matching_objects = qcb.list;
-        object_count = qcb.count;
+        query_plan_destroy (plan);
     }
-    PINFO ("matching objects=%p count=%d", matching_objects, object_count);
+    PINFO ("matching objects count=%zu", matches->size());
 
-    /* There is no absolute need to reverse this list, since it's being
-     * sorted below. However, in the common case, we will be searching
-     * in a confined location where the objects are already in order,
-     * thus reversing will put us in the correct order we want and make
-     * the sorting go much faster.
-     */
-    matching_objects = g_list_reverse(matching_objects);
+    /* Only the last max_results matches are returned. */
+    auto keep = matches->size();
+    if (q->max_results > -1)
+        keep = MIN (keep, static_cast<size_t>(q->max_results));
 
     /* Now sort the matching objects based on the search criteria */
     if (q->primary_sort.comp_fcn || q->primary_sort.obj_cmp ||
             (q->primary_sort.use_default && q->defaultSort))
+        query_sort_matches (q, *matches, keep);
+    else if (keep < matches->size())
     {
-        matching_objects = g_list_sort_with_data(matching_objects, sort_func, q);
-    }
-
-    /* Crop the list to limit the number of splits. */
-    if ((object_count > q->max_results) && (q->max_results > -1))
-    {
-        if (q->max_results > 0)
+        /* The order the matches were found in depends on the indexes
+         * chosen, so keep the last of them by GUID instead. */
+        auto guid_less = [](gpointer a, gpointer b)
         {
-            GList *mptr;
-
-            /* mptr is set to the first node of what will be the new list */
-            mptr = g_list_nth(matching_objects, object_count - q->max_results);
-            /* mptr should not be nullptr, but let's be safe */
-            if (mptr != nullptr)
-            {
-                if (mptr->prev != nullptr) mptr->prev->next = nullptr;
-                mptr->prev = nullptr;
-            }
-            g_list_free(matching_objects);
-            matching_objects = mptr;
-        }
-        else
-        {
-            /* q->max_results == 0 */
-            g_list_free(matching_objects);
-            matching_objects = nullptr;
-        }
+            return guid_compare (qof_instance_get_guid (a),
+                                 qof_instance_get_guid (b)) < 0;
+        };
+        auto first_kept = matches->end() - keep;
+        std::nth_element (matches->begin(), first_kept, matches->end(),
+                          guid_less);
+        std::sort (first_kept, matches->end(), guid_less);
+        matches->erase (matches->begin(), first_kept);
     }
 
     q->changed = 0;
 
-    g_list_free(q->results);
-    q->results = matching_objects;
+    query_free_results (q);
+    q->results = matches;
 
     LEAVE (" q=%p", q);
-    return matching_objects;
+    return matches;
+}
+
+/* The results as a GList belonging to the query. */
+static GList *
+query_results_list (QofQuery *q)
+{
+    if (!q->results_list && q->results)
+        for (auto it = q->results->rbegin(); it != q->results->rend(); ++it)
+            q->results_list = g_list_prepend (q->results_list, *it);
+    return q->results_list;
 }
 
 static void qof_query_run_cb(QofQueryCB* qcb, gpointer cb_arg)
@@ -856,16 +1346,46 @@ static void qof_query_run_cb(QofQueryCB* qcb, gpointer cb_arg)
             }
         }
 #endif
-        /* And then iterate over all the objects */
-        qof_object_foreach (qcb->query->search_for, book,
-                            (QofInstanceForeachCB) check_item_cb, qcb);
+        /* Let a backend that hasn't loaded everything fetch what the
+         * query could match before it's searched for. */
+        if (auto be = qof_book_get_backend (book))
+            be->load_for_query (qcb->query);
+
+        query_plan_choose_indexes (*qcb->plan, qcb->query->search_for, book);
+        if (qof_log_check (log_module, QOF_LOG_DEBUG))
+        {
+            GString *gs = g_string_new (nullptr);
+            query_plan_explain (*qcb->plan, book, gs);
+            DEBUG ("%s", gs->str);
+            g_string_free (gs, TRUE);
+        }
+
+        /* And then iterate over the objects that can match */
+        if (qcb->query->parallel && query_plan_is_pure (*qcb->plan))
+            query_plan_run_parallel (qcb, book);
+        else if (qcb->plan->use_indexes)
+            query_plan_run_indexes (qcb, book);
+        else
+            qof_object_foreach (qcb->query->search_for, book,
+                                (QofInstanceForeachCB) check_item_cb, qcb);
     }
 }
 
 GList * qof_query_run (QofQuery *q)
 {
     /* Just a wrapper */
-    return qof_query_run_internal(q, qof_query_run_cb, nullptr);
+    if (!qof_query_run_internal(q, qof_query_run_cb, nullptr))
+        return nullptr;
+    return query_results_list (q);
+}
+
+static const QofQueryResults empty_results;
+
+const QofQueryResults&
+qof_query_run_results (QofQuery *q)
+{
+    auto results = qof_query_run_internal(q, qof_query_run_cb, nullptr);
+    return results ? *results : empty_results;
 }
 
 static void qof_query_run_subq_cb(QofQueryCB* qcb, gpointer cb_arg)
@@ -873,11 +1393,13 @@ static void qof_query_run_subq_cb(QofQueryCB* qcb, gpointer cb_arg)
     QofQuery* pq = static_cast<QofQuery*>(cb_arg);
 
     g_return_if_fail(pq);
-    g_list_foreach(qof_query_last_run(pq), check_item_cb, qcb);
+    if (pq->results)
+        for (auto object : *pq->results)
+            check_item_cb (object, qcb);
 }
 
-GList *
-qof_query_run_subquery (QofQuery *subq, const QofQuery* primaryq)
+static const QofQueryResults *
+query_run_subquery (QofQuery *subq, const QofQuery* primaryq)
 {
     if (!subq) return nullptr;
     if (!primaryq) return nullptr;
@@ -893,13 +1415,67 @@ qof_query_run_subquery (QofQuery *subq, const QofQuery* primaryq)
                                   (gpointer)primaryq);
 }
 
+GList *
+qof_query_run_subquery (QofQuery *subq, const QofQuery* primaryq)
+{
+    if (!query_run_subquery (subq, primaryq))
+        return nullptr;
+    return query_results_list (subq);
+}
+
+const QofQueryResults&
+qof_query_run_subquery_results (QofQuery *subq, const QofQuery* primaryq)
+{
+    auto results = query_run_subquery (subq, primaryq);
+    return results ? *results : empty_results;
+}
+
+gchar *
+qof_query_explain (QofQuery *q)
+{
+    QueryPlan plan{};
+    GString *gs;
+
+    g_return_val_if_fail (q, nullptr);
+    g_return_val_if_fail (q->search_for, nullptr);
+
+    if (q->changed)
+    {
+        query_clear_compiles (q);
+        compile_terms (q);
+    }
+
+    gs = g_string_new (nullptr);
+    g_string_append_printf (gs, "Query for %s, %u OR-branches\n",
+                            q->search_for, g_list_length (q->terms));
+    query_plan_init (plan, q);
+    for (auto node = q->books; node; node = node->next)
+    {
+        auto book = static_cast<QofBook*>(node->data);
+        query_plan_choose_indexes (plan, q->search_for, book);
+        query_plan_explain (plan, book, gs);
+    }
+    query_plan_destroy (plan);
+
+    return g_string_free (gs, FALSE);
+}
+
 GList *
 qof_query_last_run (QofQuery *query)
 {
     if (!query)
         return nullptr;
 
-    return query->results;
+    return query_results_list (query);
+}
+
+const QofQueryResults&
+qof_query_last_results (QofQuery *query)
+{
+    if (!query || !query->results)
+        return empty_results;
+
+    return *query->results;
 }
 
 void qof_query_clear (QofQuery *query)
@@ -910,8 +1486,7 @@ void qof_query_clear (QofQuery *query)
 
     g_list_free (query->books);
     query->books = nullptr;
-    g_list_free (query->results);
-    query->results = nullptr;
+    query_free_results (query);
     query->changed = 1;
 }
 
@@ -1030,7 +1605,8 @@ QofQuery * qof_query_copy (QofQuery *q)
     copy->be_compiled = ht;
     copy->terms = copy_or_terms (q->terms);
     copy->books = g_list_copy (q->books);
-    copy->results = g_list_copy (q->results);
+    copy->results = q->results ? new QofQueryResults (*q->results) : nullptr;
+    copy->results_list = nullptr;
 
     copy_sort (&(copy->primary_sort), &(q->primary_sort));
     copy_sort (&(copy->secondary_sort), &(q->secondary_sort));
@@ -1167,6 +1743,7 @@ qof_query_merge(QofQuery *q1, QofQuery *q2, QofQueryOp op)
             g_list_concat(copy_or_terms(q1->terms), copy_or_terms(q2->terms));
         retval->books           = merge_books (q1->books, q2->books);
         retval->max_results    = q1->max_results;
+        retval->parallel       = q1->parallel;
         retval->changed        = 1;
         break;
 
@@ -1174,6 +1751,7 @@ qof_query_merge(QofQuery *q1, QofQuery *q2, QofQueryOp op)
         retval = qof_query_create();
         retval->books          = merge_books (q1->books, q2->books);
         retval->max_results    = q1->max_results;
+        retval->parallel       = q1->parallel;
         retval->changed        = 1;
 
         /* g_list_append() can take forever, so let's build the list in
@@ -1292,6 +1870,12 @@ void qof_query_set_max_results (QofQuery *q, int n)
     q->max_results = n;
 }
 
+void qof_query_set_parallel (QofQuery *q, gboolean parallel)
+{
+    if (!q) return;
+    q->parallel = parallel;
+}
+
 void qof_query_add_guid_list_match (QofQuery *q, QofQueryParamList *param_list,
                                     GList *guid_list, QofGuidMatch options,
                                     QofQueryOp op)
@@ -1367,10 +1951,29 @@ void qof_query_init (void)
 
 void qof_query_shutdown (void)
 {
+    query_indexes.clear();
     qof_class_shutdown ();
     qof_query_core_shutdown ();
 }
 
+void qof_query_register_index (QofIdTypeConst obj_type,
+                               const QofQueryIndex *index)
+{
+    g_return_if_fail (obj_type && index && index->name);
+    g_return_if_fail (index->plan && index->foreach);
+
+    auto it = std::find_if (query_indexes.begin(), query_indexes.end(),
+                            [obj_type, index](const QueryIndexEntry& entry)
+                            {
+                                return entry.obj_type == obj_type &&
+                                    !g_strcmp0 (entry.index.name, index->name);
+                            });
+    if (it != query_indexes.end())
+        it->index = *index;
+    else
+        query_indexes.push_back ({obj_type, *index});
+}
+
 int qof_query_get_max_results (const QofQuery *q)
 {
     if (!q) return 0;
@@ -226,6 +226,15 @@ GList * qof_query_run (QofQuery *query);
  */
 GList * qof_query_last_run (QofQuery *query);
 
+/** Describe how the query would be run in each of its books: which index,
+ *  if any, finds the candidates for each OR-branch and which terms are
+ *  then checked on them, in the order they're checked.  The same text is
+ *  logged at debug level each time the query is run.
+ *
+ *  @return A newly allocated string, to be freed with g_free().
+ */
+gchar * qof_query_explain (QofQuery *query);
+
 /** Perform a subquery, return the results.
  *  Instead of running over a book, the subquery runs over the results
  *  of the primary query.
@@ -356,9 +365,21 @@ void qof_query_set_sort_increasing (QofQuery *q, gboolean prim_inc,
  * only the last bit of results are returned.  For example,
  * if the sort order is set to be increasing date order, then
  * only the objects with the most recent dates will be returned.
+ * Without a sort order, the results kept are the last ones by GUID.
  */
 void qof_query_set_max_results (QofQuery *q, int n);
 
+/**
+ * Allow the query to check objects on several threads at once.  This
+ * only happens when every term's parameters were registered with
+ * qof_class_register_pure_params and compares one of the core types
+ * other than KVP, COLLECT and CHOICE, and when there are enough objects
+ * to be worth it; otherwise the query runs as usual.  The results are
+ * the same either way and come in the same order.  Parallel queries
+ * must not be run while another thread changes the book.
+ */
+void qof_query_set_parallel (QofQuery *q, gboolean parallel);
+
 /** Compare two queries for equality.
  * Query terms are compared each to each.
  * This is a simplistic
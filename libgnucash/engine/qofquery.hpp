@@ -0,0 +1,56 @@
+/********************************************************************\
+ * qofquery.hpp -- C++ API for running queries                      *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+/** @addtogroup Query
+    @{ */
+/** @file qofquery.hpp
+ *  @brief Query results as vectors (C++ api)
+ */
+
+#ifndef QOF_QUERY_HPP
+#define QOF_QUERY_HPP
+
+#include <vector>
+
+#include "qofquery.h"
+
+using QofQueryResults = std::vector<gpointer>;
+
+/** Perform the query and return the results, sorted and trimmed to the
+ *  max_results length as for qof_query_run().
+ *
+ *  The vector belongs to the query and stays valid until the query is
+ *  run again, cleared or destroyed.
+ */
+const QofQueryResults& qof_query_run_results (QofQuery *query);
+
+/** The results of the last run, without running the query again. */
+const QofQueryResults& qof_query_last_results (QofQuery *query);
+
+/** Perform a subquery over the results of the primary query and return
+ *  its results, as for qof_query_run_subquery().
+ */
+const QofQueryResults& qof_query_run_subquery_results (QofQuery *subquery,
+                                                       const QofQuery *primary_query);
+
+#endif /* QOF_QUERY_HPP */
+/** @} */
@@ -69,6 +69,14 @@ typedef struct
     gboolean		is_regex;
     gchar *		matchstring;
     regex_t		compiled;
+    /* For case-insensitive matches, the match string case-folded and
+     * normalized as the strings it's matched against will be, whether
+     * that's all ASCII and, if it is, the Horspool shift table for
+     * finding it. */
+    gchar *		folded;
+    gsize		folded_len;
+    gboolean		folded_ascii;
+    gsize		shift[256];
 } query_string_def, *query_string_t;
 
 typedef struct
@@ -125,6 +125,104 @@ static GHashTable *predEqualTable = nullptr;
 
 /* QOF_TYPE_STRING */
 
+/* Case-insensitive matches compare case-folded, NFC-normalized strings.
+ * The match string is folded once, when the predicate is made.  The
+ * strings matched against are nearly always ASCII, for which folding is
+ * just lower-casing, so those are compared a character at a time without
+ * making a folded copy; others are folded as before. */
+
+static gchar *
+string_fold (const char *str)
+{
+    auto casefold = g_utf8_casefold (str, -1);
+    auto normalized = g_utf8_normalize (casefold, -1, G_NORMALIZE_NFC);
+    g_free (casefold);
+    return normalized;
+}
+
+/* If str is all ASCII, set len to its length. */
+static gboolean
+string_is_ascii (const char *str, gsize *len)
+{
+    const char *p;
+
+    for (p = str; *p; ++p)
+        if (static_cast<guchar>(*p) & 0x80)
+            return FALSE;
+    *len = p - str;
+    return TRUE;
+}
+
+static void
+string_fold_matchstring (query_string_t pdata)
+{
+    gsize len;
+
+    pdata->folded = string_fold (pdata->matchstring);
+    pdata->folded_ascii = string_is_ascii (pdata->folded, &len);
+    pdata->folded_len = len;
+    if (!pdata->folded_ascii)
+        return;
+
+    for (auto& shift : pdata->shift)
+        shift = len;
+    for (gsize i = 0; i + 1 < len; ++i)
+        pdata->shift[static_cast<guchar>(pdata->folded[i])] = len - 1 - i;
+}
+
+/* Boyer-Moore-Horspool search for the folded match string in an ASCII
+ * string of length len, ignoring case. */
+static gboolean
+string_ascii_contains_nocase (const query_string_t pdata, const char *s,
+                              gsize len)
+{
+    auto needle = pdata->folded;
+    auto n = pdata->folded_len;
+
+    if (n > len) return FALSE;
+    if (n == 0) return TRUE;
+
+    for (gsize pos = 0; pos <= len - n;
+         pos += pdata->shift[static_cast<guchar>(g_ascii_tolower (s[pos + n - 1]))])
+    {
+        gsize i = n;
+        while (i > 0 && g_ascii_tolower (s[pos + i - 1]) == needle[i - 1])
+            --i;
+        if (i == 0)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+static gboolean
+string_match_nocase (const query_string_t pdata, QofQueryCompare how,
+                     const char *s)
+{
+    gsize len;
+    gboolean contains = (how == QOF_COMPARE_CONTAINS ||
+                         how == QOF_COMPARE_NCONTAINS);
+
+    if (string_is_ascii (s, &len))
+    {
+        /* An ASCII string folds to ASCII, so it can't hold a match
+         * string that doesn't. */
+        if (contains)
+            return pdata->folded_ascii &&
+                   string_ascii_contains_nocase (pdata, s, len);
+        if (pdata->folded_ascii)
+            return len == pdata->folded_len &&
+                   g_ascii_strcasecmp (s, pdata->folded) == 0;
+    }
+
+    if (!contains)
+        return safe_strcasecmp (s, pdata->matchstring) == 0; //uses collate
+
+    auto folded = string_fold (s);
+    auto ret = strstr (folded, pdata->folded) != nullptr;
+    g_free (folded);
+    return ret;
+}
+
 static int
 string_match_predicate (gpointer object,
                         QofParam *getter,
@@ -150,16 +248,8 @@ string_match_predicate (gpointer object,
     {
         if (pdata->options == QOF_STRING_MATCH_CASEINSENSITIVE)
         {
-            if (pd->how == QOF_COMPARE_CONTAINS || pd->how == QOF_COMPARE_NCONTAINS)
-            {
-                if (qof_utf8_substr_nocase (s, pdata->matchstring)) //uses strstr
-                    ret = 1;
-            }
-            else
-            {
-                 if (safe_strcasecmp (s, pdata->matchstring) == 0) //uses collate
-                    ret = 1;
-            }
+            if (string_match_nocase (pdata, pd->how, s))
+                ret = 1;
         }
         else
         {
@@ -248,6 +338,7 @@ string_free_pdata (QofQueryPredData *pd)
     if (pdata->is_regex)
         regfree (&pdata->compiled);
 
+    g_free (pdata->folded);
     g_free (pdata->matchstring);
     g_free (pdata);
 }
@@ -309,6 +400,10 @@ qof_query_string_predicate (QofQueryCompare how,
         }
         pdata->is_regex = TRUE;
     }
+    else if (options == QOF_STRING_MATCH_CASEINSENSITIVE)
+    {
+        string_fold_matchstring (pdata);
+    }
 
     return ((QofQueryPredData*)pdata);
 }
@@ -553,6 +553,16 @@ QofSessionImpl::export_session (QofSessionImpl & real_session,
     return true;
 }
 
+bool
+QofSessionImpl::copy_to (const char* uri) noexcept
+{
+    if (!m_backend || !uri) return false;
+    ENTER ("session=%p uri=%s", this, uri);
+    auto copied = m_backend->copy_to (uri);
+    LEAVE ("copied=%d", copied);
+    return copied;
+}
+
 /* C Wrapper Functions */
 /* ====================================================================== */
 
@@ -681,6 +691,13 @@ qof_session_export (QofSession *tmp_session,
     return tmp_session->export_session (*real_session, percentage_func);
 }
 
+gboolean
+qof_session_copy_to (QofSession *session, const char *uri)
+{
+    if (!session) return FALSE;
+    return session->copy_to (uri);
+}
+
 /* ================= Static function access for testing ================= */
 
 void init_static_qofsession_pointers (void);
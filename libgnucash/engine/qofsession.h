@@ -306,6 +306,13 @@ gboolean qof_session_export (QofSession *tmp_session,
                              QofSession *real_session,
                              QofPercentageFunc percentage_func);
 
+/** Copy the session's data store to a new one of the same kind at uri
+ *  without loading it, if the backend can (at present only sqlite3 to
+ *  sqlite3). Nothing need have been loaded; returns FALSE if the copy
+ *  wasn't made, in which case the book has to be loaded and saved instead.
+ */
+gboolean qof_session_copy_to (QofSession *session, const char *uri);
+
 /** Return a list of strings for the registered access methods. The owner is
  *  responsible for freeing the list but not the strings.
  */
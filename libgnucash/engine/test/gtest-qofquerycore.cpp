@@ -58,6 +58,42 @@ TEST_F(QofQueryCoreTest, construct_predicate_string)
     qof_query_core_predicate_free ((QofQueryPredData*) pdata);
 }
 
+static const char *
+string_getter (gpointer object, QofParam *)
+{
+    return static_cast<const char*>(object);
+}
+
+TEST_F(QofQueryCoreTest, string_predicate_nocase)
+{
+    QofParam param { "string", QOF_TYPE_STRING, (QofAccessFunc)string_getter,
+                     nullptr, nullptr };
+    auto match = qof_query_core_get_predicate (QOF_TYPE_STRING);
+    auto contains = qof_query_string_predicate (QOF_COMPARE_CONTAINS, "GrOcer",
+                                                QOF_STRING_MATCH_CASEINSENSITIVE,
+                                                FALSE);
+    auto equal = qof_query_string_predicate (QOF_COMPARE_EQUAL, "Straße",
+                                             QOF_STRING_MATCH_CASEINSENSITIVE,
+                                             FALSE);
+    auto ncontains = qof_query_string_predicate (QOF_COMPARE_NCONTAINS, "ss",
+                                                 QOF_STRING_MATCH_CASEINSENSITIVE,
+                                                 FALSE);
+
+    EXPECT_TRUE (match ((gpointer)"Weekly groceries", &param, contains));
+    EXPECT_TRUE (match ((gpointer)"GROCER", &param, contains));
+    EXPECT_TRUE (match ((gpointer)"Café grocer", &param, contains));
+    EXPECT_FALSE (match ((gpointer)"Weekly groce", &param, contains));
+    EXPECT_FALSE (match ((gpointer)"", &param, contains));
+    EXPECT_TRUE (match ((gpointer)"STRASSE", &param, equal));
+    EXPECT_FALSE (match ((gpointer)"Strasse 1", &param, equal));
+    EXPECT_FALSE (match ((gpointer)"Straße", &param, ncontains));
+    EXPECT_TRUE (match ((gpointer)"Strase", &param, ncontains));
+
+    qof_query_core_predicate_free (contains);
+    qof_query_core_predicate_free (equal);
+    qof_query_core_predicate_free (ncontains);
+}
+
 TEST_F(QofQueryCoreTest, construct_predicate_date)
 {
     query_date_def *pdata;
@@ -25,9 +25,43 @@
 #include <guid.hpp>
 #include "../kvp-value.hpp"
 #include "../kvp-frame.hpp"
+#include "../qof-string-cache.h"
 #include <gtest/gtest.h>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <new>
+#include <random>
+
+/* The heap bytes allocated while counting is on, for the benchmark. */
+static std::atomic<bool> count_allocations {false};
+static std::atomic<size_t> allocated_bytes {0};
+
+void*
+operator new (size_t size)
+{
+    if (count_allocations)
+        allocated_bytes += size;
+    if (auto ptr = std::malloc (size ? size : 1))
+        return ptr;
+    throw std::bad_alloc {};
+}
+
+void
+operator delete (void* ptr) noexcept
+{
+    std::free (ptr);
+}
+
+void
+operator delete (void* ptr, size_t) noexcept
+{
+    std::free (ptr);
+}
 
 class KvpFrameTest : public ::testing::Test
 {
@@ -182,6 +216,119 @@ TEST_F (KvpFrameTest, GetSlotPath)
     EXPECT_EQ (v1, t_root.get_slot(path3a));
 }
 
+TEST_F (KvpFrameTest, ManySlots)
+{
+    KvpFrameImpl f1;
+    std::vector<std::string> keys;
+    for (int i = 99; i >= 0; --i)
+    {
+        auto key = "key-" + std::to_string (i);
+        EXPECT_EQ (nullptr, f1.set ({key}, new KvpValue {(int64_t)i}));
+        keys.push_back (key);
+    }
+    std::sort (keys.begin (), keys.end ());
+    EXPECT_EQ (keys, f1.get_keys ());
+
+    for (int i = 0; i < 100; ++i)
+    {
+        auto val = f1.get_slot ({"key-" + std::to_string (i)});
+        ASSERT_NE (nullptr, val);
+        EXPECT_EQ (i, val->get<int64_t> ());
+    }
+    EXPECT_EQ (nullptr, f1.get_slot ({"key-100"}));
+    EXPECT_EQ (nullptr, f1.get_slot ({"not a key anywhere"}));
+
+    auto old_val = f1.set ({"key-42"}, new KvpValue {4.2});
+    ASSERT_NE (nullptr, old_val);
+    EXPECT_EQ (42, old_val->get<int64_t> ());
+    delete old_val;
+    EXPECT_EQ (keys, f1.get_keys ());
+
+    delete f1.set ({"key-42"}, nullptr);
+    EXPECT_EQ (nullptr, f1.get_slot ({"key-42"}));
+    EXPECT_EQ (keys.size () - 1, f1.get_keys ().size ());
+
+    KvpFrameImpl f2 {f1};
+    EXPECT_EQ (0, compare (f1, f2));
+}
+
+/* A key is found by the address of the cached string first, which mustn't
+ * also find it by a view of only the start of that string. */
+TEST_F (KvpFrameTest, KeyPrefixAtSameAddress)
+{
+    KvpFrameImpl small, large;
+    delete small.set ({"abcdef"}, new KvpValue {int64_t{1}});
+    delete large.set ({"abcdef"}, new KvpValue {int64_t{1}});
+    for (int i = 0; i < 100; ++i)
+        delete large.set ({"key-" + std::to_string (i)}, new KvpValue {int64_t{i}});
+
+    auto key = qof_string_cache_insert ("abcdef");
+    for (auto frame : {&small, &large})
+    {
+        EXPECT_NE (nullptr, frame->get_slot ({std::string_view {key, 6}}));
+        EXPECT_EQ (nullptr, frame->get_slot ({std::string_view {key, 3}}));
+    }
+    qof_string_cache_remove (key);
+}
+
+TEST_F (KvpFrameTest, AddUnsorted)
+{
+    KvpFrameImpl f1, f2;
+    std::vector<std::string> keys;
+    EXPECT_EQ (nullptr, f1.set ({"key-50"}, new KvpValue {INT64_C(-1)}));
+    for (int i = 99; i >= 0; --i)
+    {
+        auto key = "key-" + std::to_string (i);
+        f1.add_unsorted (key, new KvpValue {(int64_t)i});
+        delete f2.set ({key}, new KvpValue {(int64_t)i});
+        keys.push_back (key);
+    }
+    /* A repeated key keeps the last value added. */
+    f1.add_unsorted ("key-7", new KvpValue {INT64_C(-7)});
+    delete f2.set ({"key-7"}, new KvpValue {INT64_C(-7)});
+    f1.sort_added ();
+
+    std::sort (keys.begin (), keys.end ());
+    EXPECT_EQ (keys, f1.get_keys ());
+    EXPECT_EQ (50, f1.get_slot ({"key-50"})->get<int64_t> ());
+    EXPECT_EQ (-7, f1.get_slot ({"key-7"})->get<int64_t> ());
+    EXPECT_EQ (0, compare (f1, f2));
+
+    /* Nothing to do when they came in order. */
+    KvpFrameImpl f3;
+    for (const auto& key : keys)
+        f3.add_unsorted (key, new KvpValue {INT64_C(1)});
+    f3.sort_added ();
+    EXPECT_EQ (keys, f3.get_keys ());
+}
+
+TEST_F (KvpFrameTest, GetSlotKeys)
+{
+    std::string top {"top"};
+    EXPECT_EQ (t_int_val, t_root.get_slot ({"top", "first"}));
+    EXPECT_EQ (t_str_val, t_root.get_slot ({top, "third"}));
+    EXPECT_EQ (nullptr, t_root.get_slot ({"top", "first", "deeper"}));
+    EXPECT_EQ (nullptr, t_root.get_slot ({"top", "fourth"}));
+    EXPECT_EQ (nullptr, t_root.get_slot (KvpKeys {}));
+}
+
+TEST_F (KvpFrameTest, Generation)
+{
+    KvpFrameImpl f1;
+    auto gen = f1.generation ();
+    EXPECT_NE (gen, t_root.generation ());
+    EXPECT_EQ (nullptr, f1.get_slot ({"key"}));
+    EXPECT_EQ (gen, f1.generation ());
+
+    f1.set ({"key"}, new KvpValue {(int64_t)1});
+    EXPECT_NE (gen, f1.generation ());
+    gen = f1.generation ();
+    KvpFrameImpl f2 {f1};
+    EXPECT_NE (gen, f2.generation ());
+    delete f1.set ({"key"}, nullptr);
+    EXPECT_NE (gen, f1.generation ());
+}
+
 TEST_F (KvpFrameTest, Empty)
 {
     KvpFrameImpl f1, f2;
@@ -227,3 +374,138 @@ TEST (KvpFrameTestForEachPrefix, for_each_prefix_2)
             EXPECT_EQ(value->get_type(), KvpValue::Type::INT64);
         }, count);
 }
+
+/* Whether the test was run with -m perf, as the GLib tests' benchmarks
+ * are; googletest leaves arguments it doesn't know alone. */
+static bool
+perf_requested ()
+{
+    auto args = ::testing::internal::GetArgvs ();
+    for (size_t i = 1; i < args.size (); ++i)
+        if (args[i] == "-mperf" ||
+            (args[i] == "-m" && i + 1 < args.size () && args[i + 1] == "perf"))
+            return true;
+    return false;
+}
+
+struct CStrLess
+{
+    bool operator() (const char* a, const char* b) const
+    {
+        return std::strcmp (a, b) < 0;
+    }
+};
+
+/* Only run with -m perf: the memory a frame takes per slot and what
+ * building and searching frames of a few sizes costs, with set and with
+ * add_unsorted, next to the std::map of cached keys frames used to be. */
+TEST (KvpFrameBenchmark, MemoryAndLookup)
+{
+    if (!perf_requested ())
+        return;
+
+    using clock = std::chrono::steady_clock;
+    using duration = std::chrono::duration<double, std::nano>;
+    using OldFrame = std::map<const char*, KvpValue*, CStrLess>;
+    const size_t n_frames = 20000;
+    std::mt19937 rng {42};
+
+    for (size_t n_slots : {3, 8, 40})
+    {
+        std::vector<std::string> keys;
+        for (size_t i = 0; i < n_slots; ++i)
+            keys.push_back ("benchmark-key-" + std::to_string (i));
+        std::vector<std::vector<size_t>> orders (n_frames);
+        for (auto& order : orders)
+        {
+            for (size_t i = 0; i < n_slots; ++i)
+                order.push_back (i);
+            std::shuffle (order.begin (), order.end (), rng);
+        }
+        /* Keep the keys in the string cache throughout. */
+        KvpFrameImpl pin;
+        for (const auto& key : keys)
+            pin.set ({key}, new KvpValue {INT64_C(0)});
+        std::vector<const char*> cached;
+        for (const auto& key : keys)
+            cached.push_back (qof_string_cache_insert (key.c_str ()));
+
+        std::vector<KvpFrameImpl*> frames;
+        frames.reserve (n_frames);
+        allocated_bytes = 0;
+        count_allocations = true;
+        auto start = clock::now ();
+        for (const auto& order : orders)
+        {
+            auto frame = new KvpFrameImpl;
+            for (auto i : order)
+                delete frame->set ({keys[i]}, new KvpValue {(int64_t)i});
+            frames.push_back (frame);
+        }
+        duration set_time = clock::now () - start;
+        count_allocations = false;
+        auto bytes = allocated_bytes.load ();
+
+        start = clock::now ();
+        for (const auto& order : orders)
+        {
+            KvpFrameImpl frame;
+            for (auto i : order)
+                frame.add_unsorted (keys[i], new KvpValue {(int64_t)i});
+            frame.sort_added ();
+        }
+        duration bulk_time = clock::now () - start;
+
+        std::vector<OldFrame*> old_frames;
+        old_frames.reserve (n_frames);
+        allocated_bytes = 0;
+        count_allocations = true;
+        for (const auto& order : orders)
+        {
+            auto frame = new OldFrame;
+            for (auto i : order)
+                frame->emplace (cached[i], new KvpValue {(int64_t)i});
+            old_frames.push_back (frame);
+        }
+        count_allocations = false;
+        auto old_bytes = allocated_bytes.load ();
+
+        /* Copies of the keys, so that no lookup is won by the pointer. */
+        std::vector<std::string> probes {keys};
+        size_t found = 0;
+        start = clock::now ();
+        for (auto frame : frames)
+            for (const auto& probe : probes)
+                found += frame->get_slot ({probe}) != nullptr;
+        duration lookup_time = clock::now () - start;
+        EXPECT_EQ (n_frames * n_slots, found);
+
+        found = 0;
+        start = clock::now ();
+        for (auto frame : old_frames)
+            for (const auto& probe : probes)
+                found += frame->find (probe.c_str ()) != frame->end ();
+        duration old_lookup_time = clock::now () - start;
+        EXPECT_EQ (n_frames * n_slots, found);
+
+        auto n_total = static_cast<double> (n_frames * n_slots);
+        std::cout << n_slots << " slots: "
+                  << bytes / n_total << " bytes/slot (map "
+                  << old_bytes / n_total << "), set "
+                  << set_time.count () / n_total << " ns/slot, add_unsorted "
+                  << bulk_time.count () / n_total << " ns/slot, lookup "
+                  << lookup_time.count () / n_total << " ns (map "
+                  << old_lookup_time.count () / n_total << " ns)" << std::endl;
+
+        for (auto frame : frames)
+            delete frame;
+        for (auto frame : old_frames)
+        {
+            for (auto& slot : *frame)
+                delete slot.second;
+            delete frame;
+        }
+        for (auto key : cached)
+            qof_string_cache_remove (key);
+    }
+}
@@ -23,8 +23,14 @@
 #include <glib.h>
 
 #include <config.h>
+#include <string.h>
+#include <algorithm>
 #include "qof.h"
+#include "qofquery.hpp"
+#include "qofquery-p.h"
 #include "cashobjects.h"
+#include "Account.hpp"
+#include "Query.h"
 #include "Transaction.h"
 #include "TransLog.h"
 #include "gnc-engine.h"
@@ -64,6 +70,153 @@ test_trans_query (Transaction *trans, gpointer data)
     return 0;
 }
 
+/* A query for an account's splits over a range of dates is driven by the
+ * account's splits, and finds what looking through them does. */
+static void
+test_account_date_query (Account *acc, QofBook *book)
+{
+    const auto& splits = xaccAccountGetSplits (acc);
+    time64 start, end;
+    guint expected = 0;
+
+    if (splits.empty ())
+        return;
+
+    start = xaccTransGetDate (xaccSplitGetParent (splits[splits.size () / 3]));
+    end = xaccTransGetDate (xaccSplitGetParent (splits[2 * splits.size () / 3]));
+    for (auto split : splits)
+    {
+        auto date = xaccTransGetDate (xaccSplitGetParent (split));
+        if (date >= start && date <= end)
+            ++expected;
+    }
+
+    QofQuery *q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    xaccQueryAddSingleAccountMatch (q, acc, QOF_QUERY_AND);
+    xaccQueryAddDateMatchTT (q, TRUE, start, TRUE, end, QOF_QUERY_AND);
+
+    gchar *plan = qof_query_explain (q);
+    if (!strstr (plan, "index \"account splits\""))
+        failure_args ("query plan", __FILE__, __LINE__,
+                      "account index not used:\n%s", plan);
+    g_free (plan);
+
+    GList *list = qof_query_run (q);
+    if (g_list_length (list) != expected)
+        failure_args ("account date query", __FILE__, __LINE__,
+                      "%u splits found, %u expected", g_list_length (list),
+                      expected);
+    else
+        success ("account date query");
+    for (GList *node = list; node; node = node->next)
+        if (xaccSplitGetAccount (GNC_SPLIT (node->data)) != acc)
+        {
+            failure ("split of another account found");
+            break;
+        }
+    qof_query_destroy (q);
+}
+
+/* Trimming to max_results picks the same splits, in the same order, as
+ * sorting all of them and taking the last ones. */
+static void
+test_max_results (QofBook *book)
+{
+    QofQuery *q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+
+    QofQueryResults all = qof_query_run_results (q);
+    int keep = all.size () / 4;
+    qof_query_set_max_results (q, keep);
+
+    const auto& last = qof_query_run_results (q);
+    if (last.size () != static_cast<size_t>(keep) ||
+        !std::equal (last.begin (), last.end (), all.end () - keep))
+    {
+        failure ("max results aren't the last of the sorted results");
+        qof_query_destroy (q);
+        return;
+    }
+
+    GList *list = qof_query_last_run (q);
+    for (auto split : last)
+    {
+        if (!list || list->data != split)
+        {
+            failure ("results list differs from results vector");
+            qof_query_destroy (q);
+            return;
+        }
+        list = list->next;
+    }
+
+    /* Without a sort, which ones are kept mustn't depend on the order the
+     * matches happened to be found in. */
+    qof_query_set_sort_order (q, nullptr, nullptr, nullptr);
+    qof_query_set_max_results (q, -1);
+    QofQueryResults by_guid = qof_query_run_results (q);
+    std::sort (by_guid.begin (), by_guid.end (), [](gpointer a, gpointer b)
+               { return guid_compare (qof_instance_get_guid (a),
+                                      qof_instance_get_guid (b)) < 0; });
+    qof_query_set_max_results (q, keep);
+    const auto& unsorted = qof_query_run_results (q);
+    if (unsorted.size () != static_cast<size_t>(keep) ||
+        !std::equal (unsorted.begin (), unsorted.end (), by_guid.end () - keep))
+    {
+        failure ("unsorted max results aren't the last by GUID");
+        qof_query_destroy (q);
+        return;
+    }
+    success ("max results");
+    qof_query_destroy (q);
+}
+
+static void
+check_parallel_query (QofQuery *q, const char *what)
+{
+    QofQueryResults serial = qof_query_run_results (q);
+    qof_query_set_parallel (q, TRUE);
+    const auto& parallel = qof_query_run_results (q);
+    if (parallel != serial)
+        failure_args ("parallel query", __FILE__, __LINE__,
+                      "%s: results differ", what);
+    else
+        success_args ("parallel query", __FILE__, __LINE__, "%s", what);
+    qof_query_set_parallel (q, FALSE);
+}
+
+static void
+test_parallel_query (QofBook *book)
+{
+    /* The book is far too small for the thread pool otherwise. */
+    qof_query_set_parallel_limits (1, 4);
+
+    QofQuery *q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    xaccQueryAddValueMatch (q, gnc_numeric_zero (), QOF_NUMERIC_MATCH_CREDIT,
+                            QOF_COMPARE_GT, QOF_QUERY_AND);
+    xaccQueryAddDescriptionMatch (q, "a", FALSE, FALSE, QOF_COMPARE_CONTAINS,
+                                  QOF_QUERY_OR);
+    check_parallel_query (q, "whole collection");
+    qof_query_destroy (q);
+
+    /* Checking what an account's index hands out. */
+    auto root = gnc_book_get_root_account (book);
+    gnc_account_foreach_descendant (root, [book](Account *acc)
+    {
+        QofQuery *q = qof_query_create_for (GNC_ID_SPLIT);
+        qof_query_set_book (q, book);
+        xaccQueryAddSingleAccountMatch (q, acc, QOF_QUERY_AND);
+        xaccQueryAddValueMatch (q, gnc_numeric_zero (), QOF_NUMERIC_MATCH_DEBIT,
+                                QOF_COMPARE_GT, QOF_QUERY_AND);
+        check_parallel_query (q, xaccAccountGetName (acc));
+        qof_query_destroy (q);
+    });
+
+    qof_query_set_parallel_limits (0, 0);
+}
+
 static void
 run_test (void)
 {
@@ -78,6 +231,10 @@ run_test (void)
     add_random_transactions_to_book (book, 20);
 
     xaccAccountTreeForEachTransaction (root, test_trans_query, book);
+    gnc_account_foreach_descendant (root, [book](Account *acc)
+                                    { test_account_date_query (acc, book); });
+    test_max_results (book);
+    test_parallel_query (book);
 
     qof_session_destroy (session);
 }
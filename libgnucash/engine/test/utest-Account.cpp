@@ -19,6 +19,7 @@
  * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
  * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
  ********************************************************************/
+#include <algorithm>
 #include <cstddef>
 #include <glib.h>
 
@@ -1630,6 +1631,219 @@ test_xaccAccountRecomputeBalance (Fixture *fixture, gconstpointer pData)
     g_assert_true (!priv->balance_dirty);
 }
 
+/* Compare the running balances left in the splits by whatever mix of
+ * incremental updates has happened with a from-scratch summation. */
+static void
+check_running_balances (AccountPrivate *priv)
+{
+    gnc_numeric bal = priv->starting_balance;
+    gnc_numeric noc_bal = priv->starting_noclosing_balance;
+    gnc_numeric clr_bal = priv->starting_cleared_balance;
+    gnc_numeric rec_bal = priv->starting_reconciled_balance;
+    for (auto split : priv->splits)
+    {
+        gnc_numeric amt = xaccSplitGetAmount (split);
+        char recn = xaccSplitGetReconcile (split);
+        bal = gnc_numeric_add_fixed (bal, amt);
+        if (recn != NREC)
+            clr_bal = gnc_numeric_add_fixed (clr_bal, amt);
+        if (recn == YREC || recn == FREC)
+            rec_bal = gnc_numeric_add_fixed (rec_bal, amt);
+        if (!xaccTransGetIsClosingTxn (xaccSplitGetParent (split)))
+            noc_bal = gnc_numeric_add_fixed (noc_bal, amt);
+        g_assert_true (gnc_numeric_eq (xaccSplitGetBalance (split), bal));
+        g_assert_true (gnc_numeric_eq (xaccSplitGetNoclosingBalance (split), noc_bal));
+        g_assert_true (gnc_numeric_eq (xaccSplitGetClearedBalance (split), clr_bal));
+        g_assert_true (gnc_numeric_eq (xaccSplitGetReconciledBalance (split), rec_bal));
+    }
+    g_assert_true (gnc_numeric_eq (priv->balance, bal));
+    g_assert_true (gnc_numeric_eq (priv->noclosing_balance, noc_bal));
+    g_assert_true (gnc_numeric_eq (priv->cleared_balance, clr_bal));
+    g_assert_true (gnc_numeric_eq (priv->reconciled_balance, rec_bal));
+}
+
+static time64
+random_date (GRand *rand)
+{
+    return gnc_time (NULL) - g_rand_int_range (rand, 0, 60) * 24 * 3600;
+}
+
+static gnc_numeric
+random_amount (GRand *rand)
+{
+    return gnc_numeric_create (g_rand_int_range (rand, -100000, 100000), 100);
+}
+
+static void
+set_random_amount (Transaction *txn, GRand *rand)
+{
+    gnc_numeric amount = random_amount (rand);
+    Split *split = xaccTransGetSplit (txn, 0);
+    Split *other = xaccTransGetSplit (txn, 1);
+    xaccTransBeginEdit (txn);
+    xaccSplitSetAmount (split, amount);
+    xaccSplitSetValue (split, amount);
+    xaccSplitSetAmount (other, gnc_numeric_neg (amount));
+    xaccSplitSetValue (other, gnc_numeric_neg (amount));
+    xaccTransCommitEdit (txn);
+}
+
+static Transaction*
+make_random_txn (Account *acct, Account *other, GRand *rand)
+{
+    QofBook *book = gnc_account_get_book (acct);
+    Transaction *txn = xaccMallocTransaction (book);
+    Split *split = xaccMallocSplit (book);
+    Split *other_split = xaccMallocSplit (book);
+    xaccTransBeginEdit (txn);
+    xaccTransSetCurrency (txn, xaccAccountGetCommodity (acct));
+    xaccTransSetDatePostedSecsNormalized (txn, random_date (rand));
+    xaccSplitSetParent (split, txn);
+    xaccSplitSetAccount (split, acct);
+    xaccSplitSetParent (other_split, txn);
+    xaccSplitSetAccount (other_split, other);
+    xaccTransCommitEdit (txn);
+    set_random_amount (txn, rand);
+    return txn;
+}
+
+/* Apply random edit sequences and check after each edit that the
+ * incrementally maintained running balances match a full recompute. */
+static void
+test_xaccAccountRecomputeBalance_incremental (Fixture *fixture, gconstpointer pData)
+{
+    QofBook *book = gnc_account_get_book (fixture->acct);
+    gnc_commodity *curr = gnc_commodity_new (book, "US Dollar", "CURRENCY",
+                                             "USD", "0", 100);
+    Account *acct = xaccMallocAccount (book);
+    Account *other = xaccMallocAccount (book);
+    AccountPrivate *priv = fixture->func->get_private (acct);
+    const char recns[] = {NREC, CREC, YREC, FREC};
+    std::vector<Transaction*> txns;
+    GRand *rand = g_rand_new_with_seed (20261017);
+
+    gnc_account_append_child (fixture->acct, acct);
+    gnc_account_append_child (fixture->acct, other);
+    xaccAccountSetCommodity (acct, curr);
+    xaccAccountSetCommodity (other, curr);
+    for (int i = 0; i < 50; ++i)
+        txns.push_back (make_random_txn (acct, other, rand));
+
+    for (int i = 0; i < 500; ++i)
+    {
+        size_t idx = g_rand_int_range (rand, 0, txns.size());
+        Transaction *txn = txns[idx];
+        Split *split = xaccTransFindSplitByAccount (txn, acct);
+        switch (g_rand_int_range (rand, 0, 7))
+        {
+        case 0:
+            txns.push_back (make_random_txn (acct, other, rand));
+            break;
+        case 1:
+            set_random_amount (txn, rand);
+            break;
+        case 2:
+            xaccSplitSetReconcile (split, recns[g_rand_int_range (rand, 0, 4)]);
+            break;
+        case 3:
+            xaccTransBeginEdit (txn);
+            xaccTransSetDatePostedSecsNormalized (txn, random_date (rand));
+            xaccTransCommitEdit (txn);
+            break;
+        case 4:
+            if (txns.size() < 10)
+                break;
+            xaccTransBeginEdit (txn);
+            xaccTransDestroy (txn);
+            xaccTransCommitEdit (txn);
+            txns.erase (txns.begin() + idx);
+            break;
+        case 5:
+            xaccTransSetIsClosingTxn (txn, !xaccTransGetIsClosingTxn (txn));
+            break;
+        case 6:
+            /* Several edits while the account is open */
+            xaccAccountBeginEdit (acct);
+            set_random_amount (txn, rand);
+            xaccSplitSetReconcile (split, recns[g_rand_int_range (rand, 0, 4)]);
+            set_random_amount (txns[g_rand_int_range (rand, 0, txns.size())], rand);
+            xaccAccountCommitEdit (acct);
+            break;
+        }
+        xaccAccountSortSplits (acct, FALSE);
+        xaccAccountRecomputeBalance (acct);
+        g_assert_true (!priv->balance_dirty);
+        check_running_balances (priv);
+    }
+    g_rand_free (rand);
+}
+
+static void
+insert_random_splits (Account *acct, int count, GRand *rand)
+{
+    QofBook *book = gnc_account_get_book (acct);
+    for (int i = 0; i < count; ++i)
+    {
+        Transaction *txn = xaccMallocTransaction (book);
+        Split *split = xaccMallocSplit (book);
+        gnc_numeric amount = random_amount (rand);
+        xaccTransBeginEdit (txn);
+        xaccTransSetCurrency (txn, xaccAccountGetCommodity (acct));
+        xaccTransSetDatePostedSecs (txn, gnc_time (NULL) -
+                                    g_rand_int_range (rand, 0, 3650 * 24 * 3600));
+        xaccSplitSetParent (split, txn);
+        xaccSplitSetAmount (split, amount);
+        xaccSplitSetValue (split, amount);
+        gnc_account_insert_split (acct, split);
+        /* xaccTransCommitEdit () does a bunch of scrubbing that we don't need */
+        qof_commit_edit (QOF_INSTANCE (txn));
+    }
+}
+
+/* Benchmark, run with -m perf: insert 100k splits into one account one
+ * by one, then again inside an edit block where they are appended and
+ * merged in by a single xaccAccountSortSplits. */
+static void
+test_gnc_account_insert_split_perf (Fixture *fixture, gconstpointer pData)
+{
+    const int num_splits = 100000;
+    QofBook *book = gnc_account_get_book (fixture->acct);
+    gnc_commodity *curr = gnc_commodity_new (book, "US Dollar", "CURRENCY",
+                                             "USD", "0", 100);
+    Account *single = xaccMallocAccount (book);
+    Account *bulk = xaccMallocAccount (book);
+    GRand *rand = g_rand_new_with_seed (20261017);
+    GTimer *timer = g_timer_new ();
+
+    gnc_account_append_child (fixture->acct, single);
+    gnc_account_append_child (fixture->acct, bulk);
+    xaccAccountSetCommodity (single, curr);
+    xaccAccountSetCommodity (bulk, curr);
+
+    g_timer_start (timer);
+    insert_random_splits (single, num_splits, rand);
+    xaccAccountRecomputeBalance (single);
+    g_test_minimized_result (g_timer_elapsed (timer, NULL),
+                             "%d single split inserts: %.3fs", num_splits,
+                             g_timer_elapsed (timer, NULL));
+
+    g_timer_start (timer);
+    xaccAccountBeginEdit (bulk);
+    insert_random_splits (bulk, num_splits, rand);
+    xaccAccountCommitEdit (bulk);
+    g_test_minimized_result (g_timer_elapsed (timer, NULL),
+                             "%d bulk split inserts: %.3fs", num_splits,
+                             g_timer_elapsed (timer, NULL));
+
+    AccountPrivate *priv = fixture->func->get_private (bulk);
+    g_assert_cmpuint (priv->splits.size(), ==, num_splits);
+    g_assert_true (std::is_sorted (priv->splits.begin(), priv->splits.end(),
+                                   [](auto a, auto b)
+                                   { return xaccSplitOrder (a, b) < 0; }));
+    g_timer_destroy (timer);
+    g_rand_free (rand);
+}
+
 /* xaccAccountOrder
 int
 xaccAccountOrder (const Account *aa, const Account *ab)// C: 11 in 3 */
@@ -2256,6 +2470,42 @@ test_xaccAccountGetBalanceAsOfDate (Fixture *fixture, gconstpointer pData)
                                          (gnc_time (NULL) - offset));
     dval = gnc_numeric_to_double (val);
     g_assert_cmpfloat (dval, == , dbal);
+
+    /* The binary search must agree with a linear scan at and around
+     * every posted date, including splits sharing a date. */
+    AccountPrivate *priv = fixture->func->get_private (fixture->acct);
+    for (auto split : priv->splits)
+    {
+        auto posted = xaccTransGetDate (xaccSplitGetParent (split));
+        for (auto date : {posted - 1, posted, posted + 1})
+        {
+            gnc_numeric expected = gnc_numeric_zero ();
+            for (auto it = priv->splits.rbegin(); it != priv->splits.rend(); ++it)
+                if (xaccTransGetDate (xaccSplitGetParent (*it)) < date)
+                {
+                    expected = xaccSplitGetBalance (*it);
+                    break;
+                }
+            val = xaccAccountGetBalanceAsOfDate (fixture->acct, date);
+            g_assert_true (gnc_numeric_eq (val, expected));
+        }
+    }
+
+    /* Taking a split out and putting it back keeps the cached dates in
+     * step with the splits instead of dropping them. */
+    auto check_dates = [priv]()
+    {
+        g_assert_cmpuint (priv->split_dates.size (), ==, priv->splits.size ());
+        for (size_t i = 0; i < priv->splits.size (); ++i)
+            g_assert_cmpint (priv->split_dates[i], ==,
+                             xaccTransGetDate (xaccSplitGetParent (priv->splits[i])));
+    };
+    check_dates ();
+    auto split = priv->splits[priv->splits.size () / 2];
+    g_assert_true (gnc_account_remove_split (fixture->acct, split));
+    check_dates ();
+    g_assert_true (gnc_account_insert_split (fixture->acct, split));
+    check_dates ();
 }
 /* xaccAccountGetPresentBalance
 gnc_numeric
@@ -2866,6 +3116,9 @@ test_suite_account (void)
     GNC_TEST_ADD (suitename, "gnc account insert & remove split", Fixture, NULL, setup, test_gnc_account_insert_remove_split,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccount Insert and Remove Lot", Fixture, &good_data, setup, test_xaccAccountInsertRemoveLot,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountRecomputeBalance", Fixture, &some_data, setup, test_xaccAccountRecomputeBalance,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountRecomputeBalance incremental", Fixture, NULL, setup, test_xaccAccountRecomputeBalance_incremental,  teardown );
+    if (g_test_perf ())
+        GNC_TEST_ADD (suitename, "gnc account insert split perf", Fixture, NULL, setup, test_gnc_account_insert_split_perf,  teardown );
     GNC_TEST_ADD_FUNC (suitename, "xaccAccountOrder", test_xaccAccountOrder );
     GNC_TEST_ADD (suitename, "qofAccountSetParent", Fixture, &some_data, setup, test_qofAccountSetParent,  teardown );
     GNC_TEST_ADD (suitename, "gnc account append/remove child", Fixture, NULL, setup, test_gnc_account_append_remove_child,  teardown );
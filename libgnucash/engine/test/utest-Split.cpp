@@ -1125,6 +1125,18 @@ test_xaccSplitOrder (Fixture *fixture, gconstpointer pData)
     split->parent->date_posted = gnc_time (NULL);
     o_split->parent->date_posted = split->parent->date_posted;
 
+    /* The strings are written directly below, so the sort keys their
+     * setters would drop have to be dropped here.
+     */
+    auto order = [&]()
+    {
+        xaccTransClearSortKey (txn);
+        xaccTransClearSortKey (o_txn);
+        xaccSplitClearSortKey (split);
+        xaccSplitClearSortKey (o_split);
+        return xaccSplitOrder (split, o_split);
+    };
+
     /* The book_use_split_action_for_num_field book option hasn't been set so it
      * should sort on tran-num, so xaccTransOrder_num_action returns -1.
      */
@@ -1132,13 +1144,62 @@ test_xaccSplitOrder (Fixture *fixture, gconstpointer pData)
     split->action = "5";
     o_split->parent->num = "124";
     o_split->action = "6";
-    g_assert_cmpint (xaccSplitOrder (split, o_split), ==, -1);
+    g_assert_cmpint (order (), ==, -1);
 
     /* Reverse, so xaccTransOrder_num_action returns +1.
      */
     split->parent->num = "124";
     o_split->parent->num = "123";
+    g_assert_cmpint (order (), ==, +1);
+
+    /* Leading numbers compare numerically, then the rest of the string.
+     */
+    split->parent->num = "10";
+    o_split->parent->num = "9";
+    g_assert_cmpint (order (), ==, +1);
+    o_split->parent->num = "10b";
+    split->parent->num = "10a";
+    g_assert_cmpint (order (), ==, -1);
+    split->parent->num = "abc";
+    g_assert_cmpint (order (), ==, +1);
+
+    /* Then the date entered and the description.
+     */
+    {
+        auto desc = split->parent->description;
+        auto o_desc = o_split->parent->description;
+        split->parent->num = o_split->parent->num = "123";
+        o_split->parent->date_entered = split->parent->date_entered;
+        split->parent->description = "apple";
+        o_split->parent->description = "banana";
+        g_assert_cmpint (order (), ==, -1);
+        split->parent->description = "cherry";
+        g_assert_cmpint (order (), ==, +1);
+        split->parent->description = desc;
+        o_split->parent->description = o_desc;
+    }
+
+    /* The setters drop the keys built from the strings they change.
+     */
+    g_assert_cmpint (order (), ==, qof_instance_guid_compare (txn, o_txn));
+    xaccTransSetNum (txn, "200");
     g_assert_cmpint (xaccSplitOrder (split, o_split), ==, +1);
+    xaccTransSetNum (txn, "2");
+    g_assert_cmpint (xaccSplitOrder (split, o_split), ==, -1);
+    xaccTransSetNum (txn, "123");
+    xaccTransSetDescription (txn, "zebra");
+    g_assert_cmpint (xaccSplitOrder (split, o_split), ==, +1);
+    xaccTransSetDescription (txn, "");
+    g_assert_cmpint (xaccSplitOrder (split, o_split), ==,
+                     qof_instance_guid_compare (txn, o_txn));
+
+    /* The book option can be passed in instead of being looked up.
+     */
+    xaccTransSetNum (txn, "200");
+    g_assert_cmpint (xaccSplitOrderActionForNum (split, o_split, FALSE), ==, +1);
+    g_assert_cmpint (xaccSplitOrderActionForNum (split, o_split, TRUE), ==, -1);
+    xaccTransSetNum (txn, "124");
+    o_split->parent->num = "123";
 
     /* Now set the book_use_split_action_for_num_field book option so it will
      * sort on split-action, so xaccTransOrder_num_action returns -1, initially.
@@ -1153,10 +1214,10 @@ test_xaccSplitOrder (Fixture *fixture, gconstpointer pData)
     qof_book_commit_edit (book);
     g_assert_true(qof_book_use_split_action_for_num_field(xaccSplitGetBook(split)) == TRUE);
 
-    g_assert_cmpint (xaccSplitOrder (split, o_split), ==, -1);
+    g_assert_cmpint (order (), ==, -1);
 
     split->action = "7";
-    g_assert_cmpint (xaccSplitOrder (split, o_split), ==, +1);
+    g_assert_cmpint (order (), ==, +1);
 
     /* Revert settings for the rest of the test */
     o_split->action = NULL;
@@ -1170,46 +1231,46 @@ test_xaccSplitOrder (Fixture *fixture, gconstpointer pData)
     g_assert_true(qof_book_use_split_action_for_num_field(xaccSplitGetBook(split)) == FALSE);
     split->parent = NULL;
     /* This should return > 0 because o_split has no memo string */
-    g_assert_cmpint (xaccSplitOrder (split, o_split), >, 0);
+    g_assert_cmpint (order (), >, 0);
     o_split->memo = "baz";
-    g_assert_cmpint (xaccSplitOrder (split, o_split), <, 0);
+    g_assert_cmpint (order (), <, 0);
     /* This should return > 0 because o_split has no action string */
     o_split->memo = split->memo;
-    g_assert_cmpint (xaccSplitOrder (split, o_split), >, 0);
+    g_assert_cmpint (order (), >, 0);
     o_split->action = "waldo";
-    g_assert_cmpint (xaccSplitOrder (split, o_split), <, 0);
+    g_assert_cmpint (order (), <, 0);
 
     o_split->action = split->action;
     o_split->reconciled = NREC;
-    g_assert_cmpint (xaccSplitOrder (split, o_split), ==, 1);
+    g_assert_cmpint (order (), ==, 1);
     split->reconciled = CREC;
-    g_assert_cmpint (xaccSplitOrder (split, o_split), ==, -1);
+    g_assert_cmpint (order (), ==, -1);
 
     split->reconciled = o_split->reconciled = YREC;
     o_split->amount = gnc_numeric_create (300, 1000);
-    g_assert_cmpint (xaccSplitOrder (split, o_split), ==, 1);
+    g_assert_cmpint (order (), ==, 1);
     o_split->amount = gnc_numeric_create (400, 1000);
-    g_assert_cmpint (xaccSplitOrder (split, o_split), ==, -1);
+    g_assert_cmpint (order (), ==, -1);
 
     o_split->amount = split->amount;
     o_split->value = gnc_numeric_create (100, 240);
-    g_assert_cmpint (xaccSplitOrder (split, o_split), ==, 1);
+    g_assert_cmpint (order (), ==, 1);
     o_split->value = gnc_numeric_create (200, 240);
-    g_assert_cmpint (xaccSplitOrder (split, o_split), ==, -1);
+    g_assert_cmpint (order (), ==, -1);
 
     o_split->value = split->value;
     /* Make sure that it doesn't crash if o_split->date_reconciled == NULL */
-    g_assert_cmpint (xaccSplitOrder (split, o_split), ==, 1);
+    g_assert_cmpint (order (), ==, 1);
     o_split->date_reconciled = gnc_time(NULL);
     o_split->date_reconciled -= 50;
-    g_assert_cmpint (xaccSplitOrder (split, o_split), ==, 1);
+    g_assert_cmpint (order (), ==, 1);
     o_split->date_reconciled += 100;
-    g_assert_cmpint (xaccSplitOrder (split, o_split), ==, -1);
+    g_assert_cmpint (order (), ==, -1);
 
     o_split->date_reconciled = split->date_reconciled;
     o_split->date_reconciled = split->date_reconciled;
 
-    g_assert_cmpint (xaccSplitOrder (split, o_split), ==,
+    g_assert_cmpint (order (), ==,
                      qof_instance_guid_compare (split, o_split));
 
     /* so that it won't assert during teardown */
@@ -791,6 +791,104 @@ gnc_pricedb_add_price(GNCPriceDB *db, GNCPrice *p)// C: 7 in 7 SCM: 1  Local: 0:
 test_gnc_pricedb_add_price (Fixture *fixture, gconstpointer pData)
 {
 }*/
+/* gnc_pricedb_add_prices
+guint
+gnc_pricedb_add_prices(GNCPriceDB *db, GNCPrice **prices, size_t num_prices)
+*/
+typedef struct
+{
+    int db_adds;
+    guint db_added_prices;
+    int price_adds;
+    int price_removes;
+} AddPricesEvents;
+
+static void
+add_prices_event_handler (QofInstance *entity, QofEventId event_type,
+                          gpointer user_data, gpointer event_data)
+{
+    AddPricesEvents *events = user_data;
+
+    if (GNC_IS_PRICEDB (entity) && event_type == QOF_EVENT_ADD)
+    {
+        ++events->db_adds;
+        events->db_added_prices += g_list_length (event_data);
+    }
+    else if (GNC_IS_PRICE (entity) && event_type == QOF_EVENT_ADD)
+        ++events->price_adds;
+    else if (GNC_IS_PRICE (entity) && event_type == QOF_EVENT_REMOVE)
+        ++events->price_removes;
+}
+
+static void
+test_gnc_pricedb_add_prices (PriceDBFixture *fixture, gconstpointer pData)
+{
+    GNCPriceDB *db = fixture->pricedb;
+    Commodities *c = fixture->com;
+    QofBook *book = qof_instance_get_book (QOF_INSTANCE (db));
+    AddPricesEvents events = {0, 0, 0, 0};
+    GNCPrice *prices[8];
+    GNCPrice *p;
+    gint handler;
+
+    /* Replaces the user price of 12/4/09, Finance::Quote takes precedence. */
+    prices[0] = construct_price (book, c->usd, c->aud, gnc_dmy2time64 (12, 4, 2009),
+                                 PRICE_SOURCE_FQ, gnc_numeric_create (1, 1));
+    /* The price editor's price of 14/4/09 wins over the user price. */
+    prices[1] = construct_price (book, c->usd, c->aud, gnc_dmy2time64 (14, 4, 2009),
+                                 PRICE_SOURCE_USER_PRICE, gnc_numeric_create (2, 1));
+    prices[2] = construct_price (book, c->usd, c->aud, gnc_dmy2time64 (14, 4, 2009),
+                                 PRICE_SOURCE_EDIT_DLG, gnc_numeric_create (3, 1));
+    /* Of two Finance::Quote prices of 15/4/09 the last one wins. */
+    prices[3] = construct_price (book, c->usd, c->aud, gnc_dmy2time64 (15, 4, 2009),
+                                 PRICE_SOURCE_FQ, gnc_numeric_create (4, 1));
+    prices[4] = construct_price (book, c->usd, c->aud, gnc_dmy2time64 (15, 4, 2009),
+                                 PRICE_SOURCE_FQ, gnc_numeric_create (5, 1));
+    /* Lose to the Finance::Quote prices already there, the second one to
+     * the AUD in USD price of the day. */
+    prices[5] = construct_price (book, c->usd, c->aud, gnc_dmy2time64 (11, 4, 2009),
+                                 PRICE_SOURCE_TEMP, gnc_numeric_create (6, 1));
+    prices[6] = construct_price (book, c->usd, c->aud, gnc_dmy2time64 (20, 7, 2011),
+                                 PRICE_SOURCE_USER_PRICE, gnc_numeric_create (7, 1));
+    /* Starts a new series. */
+    prices[7] = construct_price (book, c->amzn, c->eur, gnc_dmy2time64 (2, 1, 2020),
+                                 PRICE_SOURCE_FQ, gnc_numeric_create (8, 1));
+
+    handler = qof_event_register_handler (add_prices_event_handler, &events);
+    g_assert_cmpint (gnc_pricedb_add_prices (db, prices, G_N_ELEMENTS (prices)), ==, 4);
+    qof_event_unregister_handler (handler);
+    for (guint i = 0; i < G_N_ELEMENTS (prices); ++i)
+        gnc_price_unref (prices[i]);
+
+    g_assert_cmpint (events.db_adds, ==, 1);
+    g_assert_cmpint (events.db_added_prices, ==, 4);
+    g_assert_cmpint (events.price_adds, ==, 0);
+    g_assert_cmpint (events.price_removes, ==, 1);
+    g_assert_cmpint (gnc_pricedb_get_num_prices (db), ==, 45);
+
+    p = gnc_pricedb_lookup_day_t64 (db, c->usd, c->aud, gnc_dmy2time64 (12, 4, 2009));
+    g_assert_cmpint (gnc_price_get_value (p).num, ==, 1);
+    gnc_price_unref (p);
+    p = gnc_pricedb_lookup_day_t64 (db, c->usd, c->aud, gnc_dmy2time64 (14, 4, 2009));
+    g_assert_cmpint (gnc_price_get_value (p).num, ==, 3);
+    gnc_price_unref (p);
+    p = gnc_pricedb_lookup_day_t64 (db, c->usd, c->aud, gnc_dmy2time64 (15, 4, 2009));
+    g_assert_cmpint (gnc_price_get_value (p).num, ==, 5);
+    gnc_price_unref (p);
+    p = gnc_pricedb_lookup_day_t64 (db, c->usd, c->aud, gnc_dmy2time64 (11, 4, 2009));
+    g_assert_cmpint (gnc_price_get_source (p), ==, PRICE_SOURCE_FQ);
+    gnc_price_unref (p);
+    p = gnc_pricedb_lookup_latest (db, c->amzn, c->eur);
+    g_assert_cmpint (gnc_price_get_value (p).num, ==, 8);
+    gnc_price_unref (p);
+
+    /* The series stays in order. */
+    p = gnc_pricedb_lookup_nearest_before_t64 (db, c->usd, c->aud,
+                                               gnc_dmy2time64 (16, 4, 2009));
+    g_assert_cmpint (gnc_price_get_value (p).num, ==, 5);
+    gnc_price_unref (p);
+}
+
 /* remove_price
 static gboolean
 remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup)// Local: 4:0:0
@@ -941,6 +1039,48 @@ test_gnc_pricedb_lookup_latest (PriceDBFixture *fixture, gconstpointer pData)
     gnc_price_unref(price);
     gnc_price_unref(price2);
 }
+
+/* A bulk update appends prices as they come, oldest first here; a lookup
+ * before it's over must still see the series in order. */
+static void
+test_gnc_pricedb_lookup_in_bulk_update (PriceDBFixture *fixture, gconstpointer pData)
+{
+    QofBook *book = qof_instance_get_book (fixture->pricedb);
+    GNCPriceDB *db = fixture->pricedb;
+    gnc_commodity *com = gnc_commodity_new (book, "BULK", "BENCH", "BULK", "", 1);
+    time64 start = gnc_dmy2time64 (1, 1, 2020);
+    GNCPrice *price;
+    int day;
+
+    gnc_pricedb_set_bulk_update (db, TRUE);
+    for (day = 0; day < 10; ++day)
+    {
+        GNCPrice *p = construct_price (book, com, fixture->com->usd,
+                                       start + day * 86400, PRICE_SOURCE_FQ,
+                                       gnc_numeric_create (100 + day, 100));
+        gnc_pricedb_add_price (db, p);
+        gnc_price_unref (p);
+    }
+
+    price = gnc_pricedb_lookup_latest (db, com, fixture->com->usd);
+    g_assert_cmpint (gnc_price_get_time64 (price), ==, start + 9 * 86400);
+    gnc_price_unref (price);
+    price = gnc_pricedb_lookup_nearest_before_t64 (db, com, fixture->com->usd,
+                                                   start + 4 * 86400 + 3600);
+    g_assert_cmpint (gnc_price_get_time64 (price), ==, start + 4 * 86400);
+    gnc_price_unref (price);
+
+    /* Appending after a lookup puts the series out of order again. */
+    price = construct_price (book, com, fixture->com->usd, start - 86400,
+                             PRICE_SOURCE_FQ, gnc_numeric_create (99, 100));
+    gnc_pricedb_add_price (db, price);
+    gnc_price_unref (price);
+    price = gnc_pricedb_lookup_nearest_before_t64 (db, com, fixture->com->usd,
+                                                   start - 3600);
+    g_assert_cmpint (gnc_price_get_time64 (price), ==, start - 86400);
+    gnc_price_unref (price);
+    gnc_pricedb_set_bulk_update (db, FALSE);
+}
 // Not Used
 /* lookup_latest
 static void
@@ -1118,6 +1258,48 @@ test_gnc_pricedb_get_prices (PriceDBFixture *fixture, gconstpointer pData)
     g_assert_cmpint(g_list_length(prices), ==, 5);
     gnc_price_list_destroy(prices);
 }
+/* gnc_pricedb_snapshot_new
+GNCPriceSnapshot *
+gnc_pricedb_snapshot_new (GNCPriceDB *db, const gnc_commodity *c)
+*/
+static void
+test_gnc_pricedb_snapshot (PriceDBFixture *fixture, gconstpointer pData)
+{
+    GNCPriceSnapshot *snapshot = gnc_pricedb_snapshot_new(fixture->pricedb,
+                                                          fixture->com->gbp);
+    GNCPrice *price, *prev = NULL;
+    int i, n = gnc_price_snapshot_length(snapshot);
+
+    g_assert_cmpint(n, ==, gnc_pricedb_num_prices(fixture->pricedb,
+                                                  fixture->com->gbp));
+    for (i = 0; i < n; ++i)
+    {
+        price = gnc_price_snapshot_nth(snapshot, i);
+        g_assert_true(gnc_price_get_commodity(price) == fixture->com->gbp);
+        if (prev)
+            g_assert_cmpint(gnc_price_get_time64(prev), >=,
+                            gnc_price_get_time64(price));
+        g_assert_cmpint(gnc_price_snapshot_index(snapshot, price), ==, i);
+        prev = price;
+    }
+    g_assert_null(gnc_price_snapshot_nth(snapshot, n));
+    g_assert_null(gnc_price_snapshot_nth(snapshot, -1));
+
+    /* The snapshot keeps its prices after they leave the pricedb. */
+    price = gnc_price_snapshot_nth(snapshot, 0);
+    gnc_pricedb_remove_price(fixture->pricedb, price);
+    g_assert_cmpint(gnc_price_snapshot_length(snapshot), ==, n);
+    g_assert_cmpint(gnc_price_snapshot_index(snapshot, price), ==, 0);
+    g_assert_cmpint(gnc_price_snapshot_index(snapshot,
+                                             gnc_price_snapshot_nth(snapshot, 1)),
+                    ==, 1);
+    gnc_price_snapshot_free(snapshot);
+
+    snapshot = gnc_pricedb_snapshot_new(fixture->pricedb, fixture->com->gbp);
+    g_assert_cmpint(gnc_price_snapshot_length(snapshot), ==, n - 1);
+    g_assert_cmpint(gnc_price_snapshot_index(snapshot, price), ==, -1);
+    gnc_price_snapshot_free(snapshot);
+}
 /* gnc_pricedb_lookup_day_t64
 GNCPrice *
 gnc_pricedb_lookup_day_t64(GNCPriceDB *db,// C: 4 in 2 SCM: 2 in 1 Local: 1:0:0
@@ -1489,6 +1671,60 @@ test_gnc_pricedb_get_nearest_before_price (PriceDBFixture *fixture, gconstpointe
     g_assert_cmpint(result.denom, ==, 1331);
 }
 
+static void
+test_gnc_pricedb_chained_conversion (PriceDBFixture *fixture, gconstpointer pData)
+{
+    GNCPriceDB *db = fixture->pricedb;
+    QofBook *book = qof_instance_get_book (QOF_INSTANCE (db));
+    gnc_commodity *a = gnc_commodity_new (book, "A", "TEST", "A", "", 100);
+    gnc_commodity *b = gnc_commodity_new (book, "B", "TEST", "B", "", 100);
+    gnc_commodity *c = gnc_commodity_new (book, "C", "TEST", "C", "", 100);
+    gnc_commodity *d = gnc_commodity_new (book, "D", "TEST", "D", "", 100);
+    time64 t = gnc_dmy2time64 (15, 8, 2011);
+    GNCPrice *direct;
+    gnc_numeric result;
+
+    gnc_pricedb_add_price (db, construct_price (book, a, b, t, PRICE_SOURCE_FQ,
+                                                gnc_numeric_create (2, 1)));
+    gnc_pricedb_add_price (db, construct_price (book, c, b, t, PRICE_SOURCE_FQ,
+                                                gnc_numeric_create (1, 3)));
+    gnc_pricedb_add_price (db, construct_price (book, c, d, t, PRICE_SOURCE_FQ,
+                                                gnc_numeric_create (5, 1)));
+
+    /* A to D takes three prices, one more than the default allows. */
+    g_assert_cmpint (gnc_pricedb_get_max_conversion_hops (db), ==, 2);
+    result = gnc_pricedb_get_nearest_price (db, a, d, t);
+    g_assert_true (gnc_numeric_zero_p (result));
+
+    gnc_pricedb_set_max_conversion_hops (db, 3);
+    result = gnc_pricedb_get_nearest_price (db, a, d, t);
+    g_assert_cmpint (result.num, ==, 30);
+    g_assert_cmpint (result.denom, ==, 1);
+    result = gnc_pricedb_get_nearest_before_price (db, d, a, t);
+    g_assert_cmpint (result.num, ==, 1);
+    g_assert_cmpint (result.denom, ==, 30);
+
+    /* Adding, changing and removing prices replaces cached conversions. */
+    direct = construct_price (book, a, d, t, PRICE_SOURCE_FQ,
+                              gnc_numeric_create (7, 1));
+    gnc_pricedb_add_price (db, direct);
+    result = gnc_pricedb_get_nearest_price (db, a, d, t);
+    g_assert_cmpint (result.num, ==, 7);
+    g_assert_cmpint (result.denom, ==, 1);
+
+    gnc_price_set_value (direct, gnc_numeric_create (8, 1));
+    result = gnc_pricedb_get_nearest_price (db, a, d, t);
+    g_assert_cmpint (result.num, ==, 8);
+
+    gnc_pricedb_remove_price (db, direct);
+    result = gnc_pricedb_get_nearest_price (db, a, d, t);
+    g_assert_cmpint (result.num, ==, 30);
+
+    gnc_pricedb_set_max_conversion_hops (db, 1);
+    result = gnc_pricedb_get_nearest_price (db, a, c, t);
+    g_assert_true (gnc_numeric_zero_p (result));
+}
+
 /* gnc_pricedb_foreach_price
 gboolean
 gnc_pricedb_foreach_price(GNCPriceDB *db,// C: 2 in 2  Local: 6:0:0
@@ -1531,6 +1767,219 @@ test_gnc_pricedb_foreach_price (PriceDBFixture *fixture, gconstpointer pData)
     g_list_free_full (lst, g_free);
 }
 
+/* Benchmark, run with -m perf: load 5M daily prices of 800 commodities in
+ * US Dollars and time looking them up. */
+static void
+test_gnc_pricedb_lookup_perf (PriceDBFixture *fixture, gconstpointer pData)
+{
+    const int num_commodities = 800;
+    const int num_days = 6250;
+    const int num_lookups = 100000;
+    const time64 start = 946728000; /* 2000-01-01 12:00 UTC */
+    QofBook *book = qof_instance_get_book (fixture->pricedb);
+    GNCPriceDB *db = fixture->pricedb;
+    gnc_commodity **coms = g_new0 (gnc_commodity*, num_commodities);
+    GRand *rand = g_rand_new_with_seed (20261017);
+    GTimer *timer = g_timer_new ();
+    int found = 0;
+
+    for (int i = 0; i < num_commodities; ++i)
+    {
+        gchar *mnemonic = g_strdup_printf ("BM%04d", i);
+        coms[i] = gnc_commodity_new (book, mnemonic, "BENCH", mnemonic, "", 1);
+        g_free (mnemonic);
+    }
+
+    g_timer_start (timer);
+    gnc_pricedb_set_bulk_update (db, TRUE);
+    for (int i = 0; i < num_commodities; ++i)
+        for (int day = 0; day < num_days; ++day)
+        {
+            GNCPrice *p = construct_price (book, coms[i], fixture->com->usd,
+                                           start + day * 86400,
+                                           PRICE_SOURCE_FQ,
+                                           gnc_numeric_create (1000 + day, 100));
+            gnc_pricedb_add_price (db, p);
+            gnc_price_unref (p);
+        }
+    gnc_pricedb_set_bulk_update (db, FALSE);
+    g_test_minimized_result (g_timer_elapsed (timer, NULL),
+                             "load %d prices: %.3fs", num_commodities * num_days,
+                             g_timer_elapsed (timer, NULL));
+
+    g_timer_start (timer);
+    for (int i = 0; i < num_lookups; ++i)
+    {
+        gnc_commodity *com = coms[g_rand_int_range (rand, 0, num_commodities)];
+        time64 t = start + g_rand_int_range (rand, 0, num_days * 86400);
+        GNCPrice *p = gnc_pricedb_lookup_nearest_in_time64 (db, com,
+                                                            fixture->com->usd, t);
+        found += p != NULL;
+        gnc_price_unref (p);
+    }
+    g_test_minimized_result (g_timer_elapsed (timer, NULL),
+                             "%d nearest in time lookups: %.3fs", num_lookups,
+                             g_timer_elapsed (timer, NULL));
+
+    g_timer_start (timer);
+    for (int i = 0; i < num_lookups; ++i)
+    {
+        gnc_commodity *com = coms[g_rand_int_range (rand, 0, num_commodities)];
+        time64 t = start + g_rand_int_range (rand, 0, num_days * 86400);
+        GNCPrice *p = gnc_pricedb_lookup_nearest_before_t64 (db, com,
+                                                             fixture->com->usd, t);
+        found += p != NULL;
+        gnc_price_unref (p);
+    }
+    g_test_minimized_result (g_timer_elapsed (timer, NULL),
+                             "%d nearest before lookups: %.3fs", num_lookups,
+                             g_timer_elapsed (timer, NULL));
+
+    g_timer_start (timer);
+    for (int i = 0; i < num_lookups; ++i)
+    {
+        gnc_commodity *com = coms[g_rand_int_range (rand, 0, num_commodities)];
+        GNCPrice *p = gnc_pricedb_lookup_latest (db, com, fixture->com->usd);
+        found += p != NULL;
+        gnc_price_unref (p);
+    }
+    g_test_minimized_result (g_timer_elapsed (timer, NULL),
+                             "%d latest lookups: %.3fs", num_lookups,
+                             g_timer_elapsed (timer, NULL));
+
+    g_timer_start (timer);
+    for (int i = 0; i < num_lookups / 100; ++i)
+    {
+        gnc_commodity *com = coms[g_rand_int_range (rand, 0, num_commodities)];
+        time64 t = start + g_rand_int_range (rand, 0, num_days * 86400);
+        PriceList *prices =
+            gnc_pricedb_lookup_nearest_before_any_currency_t64 (db, com, t);
+        found += prices != NULL;
+        gnc_price_list_destroy (prices);
+    }
+    g_test_minimized_result (g_timer_elapsed (timer, NULL),
+                             "%d nearest before any currency lookups: %.3fs",
+                             num_lookups / 100, g_timer_elapsed (timer, NULL));
+
+    g_assert_cmpint (found, ==, 3 * num_lookups + num_lookups / 100);
+    g_assert_cmpint (gnc_pricedb_get_num_prices (db), ==,
+                     42 + num_commodities * num_days);
+
+    g_timer_destroy (timer);
+    g_rand_free (rand);
+    g_free (coms);
+}
+
+/* Daily prices of the commodities from first_day on, in random order. */
+static GNCPrice **
+make_import_prices (QofBook *book, gnc_commodity **coms, int num_commodities,
+                    gnc_commodity *currency, time64 start, int first_day,
+                    int num_days, GRand *rand)
+{
+    int num_prices = num_commodities * num_days;
+    GNCPrice **prices = g_new (GNCPrice*, num_prices);
+
+    for (int i = 0; i < num_commodities; ++i)
+        for (int day = 0; day < num_days; ++day)
+            prices[i * num_days + day] =
+                construct_price (book, coms[i], currency,
+                                 start + (first_day + day) * 86400,
+                                 PRICE_SOURCE_FQ,
+                                 gnc_numeric_create (1000 + first_day + day, 100));
+
+    for (int i = num_prices - 1; i > 0; --i)
+    {
+        int j = g_rand_int_range (rand, 0, i + 1);
+        GNCPrice *tmp = prices[i];
+        prices[i] = prices[j];
+        prices[j] = tmp;
+    }
+    return prices;
+}
+
+static gnc_commodity **
+make_import_commodities (QofBook *book, const char *name_space,
+                         int num_commodities)
+{
+    gnc_commodity **coms = g_new0 (gnc_commodity*, num_commodities);
+
+    for (int i = 0; i < num_commodities; ++i)
+    {
+        gchar *mnemonic = g_strdup_printf ("%s%04d", name_space, i);
+        coms[i] = gnc_commodity_new (book, mnemonic, name_space, mnemonic, "", 1);
+        g_free (mnemonic);
+    }
+    return coms;
+}
+
+/* Benchmark, run with -m perf: import 1M daily prices of 400 commodities in
+ * US Dollars in random order one by one and in one batch, then import 1M
+ * more in a batch, half of which replace the first ones. */
+static void
+test_gnc_pricedb_add_prices_perf (PriceDBFixture *fixture, gconstpointer pData)
+{
+    const int num_commodities = 400;
+    const int num_days = 2500;
+    const int num_prices = num_commodities * num_days;
+    const time64 start = 946728000; /* 2000-01-01 12:00 UTC */
+    QofBook *book = qof_instance_get_book (fixture->pricedb);
+    GNCPriceDB *db = fixture->pricedb;
+    gnc_commodity *usd = fixture->com->usd;
+    gnc_commodity **single_coms = make_import_commodities (book, "SINGLE",
+                                                           num_commodities);
+    gnc_commodity **batch_coms = make_import_commodities (book, "BATCH",
+                                                          num_commodities);
+    GRand *rand = g_rand_new_with_seed (20261017);
+    GTimer *timer = g_timer_new ();
+    GNCPrice **prices;
+    guint added;
+
+    prices = make_import_prices (book, single_coms, num_commodities, usd,
+                                 start, 0, num_days, rand);
+    g_timer_start (timer);
+    for (int i = 0; i < num_prices; ++i)
+    {
+        gnc_pricedb_add_price (db, prices[i]);
+        gnc_price_unref (prices[i]);
+    }
+    g_test_minimized_result (g_timer_elapsed (timer, NULL),
+                             "add %d prices one by one: %.3fs", num_prices,
+                             g_timer_elapsed (timer, NULL));
+    g_free (prices);
+
+    prices = make_import_prices (book, batch_coms, num_commodities, usd,
+                                 start, 0, num_days, rand);
+    g_timer_start (timer);
+    added = gnc_pricedb_add_prices (db, prices, num_prices);
+    g_test_minimized_result (g_timer_elapsed (timer, NULL),
+                             "add %d prices in a batch: %.3fs", num_prices,
+                             g_timer_elapsed (timer, NULL));
+    g_assert_cmpint (added, ==, num_prices);
+    for (int i = 0; i < num_prices; ++i)
+        gnc_price_unref (prices[i]);
+    g_free (prices);
+
+    prices = make_import_prices (book, batch_coms, num_commodities, usd,
+                                 start, num_days / 2, num_days, rand);
+    g_timer_start (timer);
+    added = gnc_pricedb_add_prices (db, prices, num_prices);
+    g_test_minimized_result (g_timer_elapsed (timer, NULL),
+                             "add %d prices in a batch replacing half: %.3fs",
+                             num_prices, g_timer_elapsed (timer, NULL));
+    g_assert_cmpint (added, ==, num_prices);
+    for (int i = 0; i < num_prices; ++i)
+        gnc_price_unref (prices[i]);
+    g_free (prices);
+
+    g_assert_cmpint (gnc_pricedb_get_num_prices (db), ==,
+                     42 + 2 * num_prices + num_prices / 2);
+
+    g_timer_destroy (timer);
+    g_rand_free (rand);
+    g_free (single_coms);
+    g_free (batch_coms);
+}
+
 /* pricedb_foreach_pricelist
 static void
 pricedb_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)// Local: 0:1:0
@@ -1744,6 +2193,7 @@ GNC_TEST_ADD (suitename, "gnc price list equal", PriceDBFixture, NULL, setup, te
 // GNC_TEST_ADD (suitename, "insert or replace price", Fixture, NULL, setup, test_insert_or_replace_price, teardown);
 // GNC_TEST_ADD (suitename, "add price", Fixture, NULL, setup, test_add_price, teardown);
 // GNC_TEST_ADD (suitename, "gnc pricedb add price", Fixture, NULL, setup, test_gnc_pricedb_add_price, teardown);
+    GNC_TEST_ADD (suitename, "gnc pricedb add prices", PriceDBFixture, NULL, setup, test_gnc_pricedb_add_prices, teardown);
 // GNC_TEST_ADD (suitename, "remove price", Fixture, NULL, setup, test_remove_price, teardown);
 // GNC_TEST_ADD (suitename, "gnc pricedb remove price", Fixture, NULL, setup, test_gnc_pricedb_remove_price, teardown);
 // GNC_TEST_ADD (suitename, "check one price date", Fixture, NULL, setup, test_check_one_price_date, teardown);
@@ -1753,6 +2203,7 @@ GNC_TEST_ADD (suitename, "gnc price list equal", PriceDBFixture, NULL, setup, te
 // GNC_TEST_ADD (suitename, "price list from hashtable", Fixture, NULL, setup, test_price_list_from_hashtable, teardown);
 // GNC_TEST_ADD (suitename, "pricedb get prices internal", Fixture, NULL, setup, test_pricedb_get_prices_internal, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb lookup latest", PriceDBFixture, NULL, setup, test_gnc_pricedb_lookup_latest, teardown);
+    GNC_TEST_ADD (suitename, "gnc pricedb lookup in bulk update", PriceDBFixture, NULL, setup, test_gnc_pricedb_lookup_in_bulk_update, teardown);
 // GNC_TEST_ADD (suitename, "price uses commodity", Fixture, NULL, setup, test_price_uses_commodity, teardown);
 // GNC_TEST_ADD (suitename, "is in list", Fixture, NULL, setup, test_is_in_list, teardown);
 // GNC_TEST_ADD (suitename, "latest before", Fixture, NULL, setup, test_latest_before, teardown);
@@ -1765,6 +2216,7 @@ GNC_TEST_ADD (suitename, "gnc price list equal", PriceDBFixture, NULL, setup, te
 // GNC_TEST_ADD (suitename, "hash values helper", PriceDBFixture, NULL, setup, test_hash_values_helper, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb has prices", PriceDBFixture, NULL, setup, test_gnc_pricedb_has_prices, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb get prices", PriceDBFixture, NULL, setup, test_gnc_pricedb_get_prices, teardown);
+    GNC_TEST_ADD (suitename, "gnc pricedb snapshot", PriceDBFixture, NULL, setup, test_gnc_pricedb_snapshot, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb lookup day", PriceDBFixture, NULL, setup, test_gnc_pricedb_lookup_day_t64, teardown);
 // GNC_TEST_ADD (suitename, "lookup nearest in time", Fixture, NULL, setup, test_lookup_nearest_in_time, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb lookup nearest in time", PriceDBFixture, NULL, setup, test_gnc_pricedb_lookup_nearest_in_time64, teardown);
@@ -1779,12 +2231,17 @@ GNC_TEST_ADD (suitename, "gnc price list equal", PriceDBFixture, NULL, setup, te
     GNC_TEST_ADD (suitename, "gnc pricedb get latest price", PriceDBFixture, NULL, setup, test_gnc_pricedb_get_latest_price, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb get nearest price", PriceDBFixture, NULL, setup, test_gnc_pricedb_get_nearest_price, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb get nearest before price", PriceDBFixture, NULL, setup, test_gnc_pricedb_get_nearest_before_price, teardown);
+    GNC_TEST_ADD (suitename, "gnc pricedb chained conversion", PriceDBFixture, NULL, setup, test_gnc_pricedb_chained_conversion, teardown);
 // GNC_TEST_ADD (suitename, "pricedb foreach pricelist", Fixture, NULL, setup, test_pricedb_foreach_pricelist, teardown);
 // GNC_TEST_ADD (suitename, "pricedb foreach currencies hash", Fixture, NULL, setup, test_pricedb_foreach_currencies_hash, teardown);
 // GNC_TEST_ADD (suitename, "unstable price traversal", Fixture, NULL, setup, test_unstable_price_traversal, teardown);
 // GNC_TEST_ADD (suitename, "compare kvpairs by commodity key", Fixture, NULL, setup, test_compare_kvpairs_by_commodity_key, teardown);
 // GNC_TEST_ADD (suitename, "stable price traversal", Fixture, NULL, setup, test_stable_price_traversal, teardown);
 GNC_TEST_ADD (suitename, "gnc pricedb foreach price", PriceDBFixture, NULL, setup, test_gnc_pricedb_foreach_price, teardown);
+if (g_test_perf ())
+    GNC_TEST_ADD (suitename, "gnc pricedb lookup perf", PriceDBFixture, NULL, setup, test_gnc_pricedb_lookup_perf, teardown);
+if (g_test_perf ())
+    GNC_TEST_ADD (suitename, "gnc pricedb add prices perf", PriceDBFixture, NULL, setup, test_gnc_pricedb_add_prices_perf, teardown);
 // GNC_TEST_ADD (suitename, "add price to list", Fixture, NULL, setup, test_add_price_to_list, teardown);
 // GNC_TEST_ADD (suitename, "gnc price fixup legacy commods", Fixture, NULL, setup, test_gnc_price_fixup_legacy_commods, teardown);
 // GNC_TEST_ADD (suitename, "gnc price print", Fixture, NULL, setup, test_gnc_price_print, teardown);